@@ -0,0 +1,90 @@
+/**
+  ******************************************************************************
+  * @file           : atomic_ops.h
+  * @brief          : 32位原子操作 (LDREX/STREX)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 供主循环与中断共享的计数器/索引使用, 不关中断
+  * Cortex-M4 在异常进入/返回时清除独占监视器, 被中断打断的 STREX 必定失败
+  * 并重试, 因此单核上可以保证任意嵌套深度下的正确性
+  *
+  * 非ARM编译器 (主机构建, 见 Host/) 改用 GCC __atomic 内建函数
+  *
+  ******************************************************************************
+  */
+
+#ifndef __ATOMIC_OPS_H
+#define __ATOMIC_OPS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include <stdint.h>
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  比较并交换
+  * @param  ptr 目标地址
+  * @param  expected 期望的旧值
+  * @param  desired 新值
+  * @retval 1=交换成功 0=当前值不等于 expected
+  */
+static inline uint8_t Atomic_Cas32(volatile uint32_t *ptr, uint32_t expected, uint32_t desired)
+{
+#if !(defined(__arm__) || defined(__CC_ARM) || defined(__ARMCC_VERSION))
+    return __atomic_compare_exchange_n(ptr, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST) ? 1 : 0;
+#else
+    do {
+        if (__LDREXW(ptr) != expected) {
+            __CLREX();
+            return 0;
+        }
+    } while (__STREXW(desired, ptr) != 0);
+
+    return 1;
+#endif
+}
+
+/**
+  * @brief  原子加法
+  * @param  ptr 目标地址
+  * @param  value 加数
+  * @retval 相加后的新值
+  */
+static inline uint32_t Atomic_Add32(volatile uint32_t *ptr, uint32_t value)
+{
+#if !(defined(__arm__) || defined(__CC_ARM) || defined(__ARMCC_VERSION))
+    return __atomic_add_fetch(ptr, value, __ATOMIC_SEQ_CST);
+#else
+    uint32_t result;
+
+    do {
+        result = __LDREXW(ptr) + value;
+    } while (__STREXW(result, ptr) != 0);
+
+    return result;
+#endif
+}
+
+/**
+  * @brief  原子减法
+  * @param  ptr 目标地址
+  * @param  value 减数
+  * @retval 相减后的新值
+  */
+static inline uint32_t Atomic_Sub32(volatile uint32_t *ptr, uint32_t value)
+{
+    return Atomic_Add32(ptr, (uint32_t)0 - value);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ATOMIC_OPS_H */
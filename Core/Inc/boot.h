@@ -0,0 +1,172 @@
+/**
+  ******************************************************************************
+  * @file           : boot.h
+  * @brief          : 启动编排头文件 (ESP8266/WiFi/MQTT 快速启动 + 启动时间线)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 冷启动到第一次发布的时间主要花在等待上: 模块启动、入网、DHCP、连代理。
+  * 只有一条AT串口, 命令本身无法并行, 这里做两件事:
+  *   - 等待期间做别的事: ESP8266_Delay 的等待钩子运行后台任务 (传感器采样),
+  *     DHT11 的1s上电稳定期与模块启动重叠, 不再阻塞
+  *   - 跳过模块上已经成立的状态:
+  *       WiFi  只复位了MCU, 模块仍连着同一个AP       -> 保持 (kept)
+  *             模块刚上电, 有上次的BSSID/地址缓存      -> CIPSTA + CWJAP 指定BSSID (fast)
+  *             模块刚上电, 凭据与上次一致 (CWAUTOCONN) -> 等模块自动重连 (auto)
+  *             其他 (或 fast 失败)                     -> DHCP + CWJAP 入网 (join)
+  *       MQTT  模块仍连着同一个代理 (MQTTCONN? 状态>=4)   -> 不再配置/连接 (kept)
+  *             其他                                    -> USERCFG/CONNCFG/CONN (connect)
+  *     "一致" 用凭据/代理参数的哈希判断, 记录在配置存储中 (boot.wifi_sig /
+  *     boot.mqtt_sig), 只在入网/连接成功且参数变化时写入
+  *
+  * 用法 (main.c):
+  *   Boot_Init(App_BootBackground);                  // 尽早调用, 记录 "init"
+  *   ...传感器初始化...  Boot_Mark(BOOT_STAGE_SENSORS);
+  *   Boot_Wifi(&huart3, ssid, password);             // 记录 "esp" / "wifi"
+  *   Boot_Mqtt(&userConfig, host, port, keepAlive, topics, n);  // "mqtt" / "sub"
+  *   Boot_Finish();                                  // 取消等待钩子
+  *   ...第一次发布成功后 Boot_Mark(BOOT_STAGE_PUBLISH), 打印时间线
+  *
+  * - 时间为复位后的 HAL_GetTick (ms), 每个阶段只记录第一次
+  * - 总时长计入健康指标 boot.ms; stm32/prof/query 收到 "boot" 时发布 JSON
+  * - 订阅总是重新发送: 重复订阅代理只更新QoS, 同时建立本地订阅列表
+  *
+  ******************************************************************************
+  */
+
+#ifndef __BOOT_H
+#define __BOOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "esp8266.h"
+#include "esp8266_mqtt.h"
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 模块就绪后等待自动重连的最长时间 (ms), 超时后改用 CWJAP */
+#ifndef BOOT_AUTOCONN_WAIT_MS
+#define BOOT_AUTOCONN_WAIT_MS       6000
+#endif
+
+/* 等待自动重连时查询 CWJAP? 的间隔 (ms) */
+#define BOOT_AUTOCONN_POLL_MS       200
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  启动阶段 (按顺序)
+  */
+typedef enum {
+    BOOT_STAGE_INIT = 0,            /**< "init" Boot_Init */
+    BOOT_STAGE_SENSORS,             /**< "sensors" 传感器注册完成 */
+    BOOT_STAGE_ESP,                 /**< "esp" 模块应答AT */
+    BOOT_STAGE_WIFI,                /**< "wifi" 获得IP */
+    BOOT_STAGE_MQTT,                /**< "mqtt" 连上代理 */
+    BOOT_STAGE_SUB,                 /**< "sub" 订阅完成 */
+    BOOT_STAGE_PUBLISH,             /**< "publish" 第一次发布 */
+    BOOT_STAGE_COUNT
+} Boot_Stage_t;
+
+/**
+  * @brief  WiFi 启动路径
+  */
+typedef enum {
+    BOOT_WIFI_NONE = 0,             /**< 尚未进行 */
+    BOOT_WIFI_KEPT,                 /**< 模块仍连着同一个AP */
+    BOOT_WIFI_AUTO,                 /**< 模块自动重连 */
+    BOOT_WIFI_FAST,                 /**< 缓存的BSSID + 静态地址快速重连 */
+    BOOT_WIFI_JOIN,                 /**< CWJAP 入网 */
+    BOOT_WIFI_FAIL                  /**< 失败 */
+} Boot_WifiPath_t;
+
+/**
+  * @brief  MQTT 启动路径
+  */
+typedef enum {
+    BOOT_MQTT_NONE = 0,             /**< 尚未进行 */
+    BOOT_MQTT_KEPT,                 /**< 模块仍连着同一个代理 */
+    BOOT_MQTT_CONNECT,              /**< 配置并连接 */
+    BOOT_MQTT_FAIL                  /**< 失败 */
+} Boot_MqttPath_t;
+
+/**
+  * @brief  启动时订阅的主题
+  */
+typedef struct {
+    const char *topic;              /**< 主题 */
+    MQTT_QoS_t qos;                 /**< QoS */
+} Boot_Topic_t;
+
+/**
+  * @brief  启动编排句柄
+  */
+typedef struct {
+    uint32_t stamp[BOOT_STAGE_COUNT];   /**< 各阶段完成时间 (ms) */
+    uint8_t marked;                     /**< 已记录的阶段 (按位) */
+    uint8_t wifiPath;                   /**< Boot_WifiPath_t */
+    uint8_t mqttPath;                   /**< Boot_MqttPath_t */
+    uint32_t totalMs;                   /**< 到第一次发布的时间 (指标 boot.ms) */
+    uint32_t backgroundRuns;            /**< 等待期间运行后台任务的次数 */
+    void (*background)(void);           /**< 后台任务 */
+} Boot_Handle_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern Boot_Handle_t boot;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  开始记录时间线, 设置模块等待期间的后台任务
+  * @param  background: 后台任务 (可为NULL), 须能在任意AT等待中重入主循环的采样部分
+  */
+void Boot_Init(void (*background)(void));
+
+/**
+  * @brief  记录阶段完成时间 (只记录第一次); PUBLISH 时打印时间线
+  */
+void Boot_Mark(Boot_Stage_t stage);
+
+/**
+  * @brief  阶段是否已记录
+  */
+uint8_t Boot_IsMarked(Boot_Stage_t stage);
+
+/**
+  * @brief  初始化模块并接入WiFi, 能保持或自动重连时不发 CWJAP, 有缓存时快速重连
+  * @retval ESP8266_Status_t 获得IP时返回 ESP8266_OK
+  */
+ESP8266_Status_t Boot_Wifi(UART_HandleTypeDef *huart, const char *ssid, const char *password);
+
+/**
+  * @brief  配置并连接代理 (模块仍连着同一个代理时跳过), 然后订阅主题
+  * @note   需先 MQTT_Init; keepAlive 为最终的心跳间隔 (s)
+  * @retval MQTT_Status_t 连上代理时返回 MQTT_OK (个别订阅失败只记录日志)
+  */
+MQTT_Status_t Boot_Mqtt(const MQTT_UserConfig_t *userConfig, const char *host, uint16_t port,
+                        uint16_t keepAlive, const Boot_Topic_t *topics, uint8_t count);
+
+/**
+  * @brief  启动结束, 取消等待钩子
+  */
+void Boot_Finish(void);
+
+/**
+  * @brief  生成JSON: {"boot":{"init":2,"sensors":15,"esp":340,"wifi":2950,"mqtt":3120,
+  *         "sub":3300,"publish":3410,"wifi_path":"auto","mqtt_path":"connect","bg":812}}
+  * @note   未到达的阶段不输出
+  * @retval int 写入长度, 缓冲区不足时返回0
+  */
+int Boot_FormatJson(char *buf, uint16_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BOOT_H */
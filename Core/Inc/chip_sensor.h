@@ -0,0 +1,126 @@
+/**
+  ******************************************************************************
+  * @file           : chip_sensor.h
+  * @brief          : 片内传感器驱动头文件 (VREFINT + 内部温度传感器)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * ADC1 以扫描 + 连续转换模式循环采集 VREFINT 与内部温度传感器,
+  * DMA2_Stream4 循环写入缓冲区, 关闭了DMA半传输/传输完成中断,
+  * 整个过程不占用CPU; 读取时只对缓冲区做一次平均和换算
+  *
+  * - VDDA = 3300mV * VREFINT_CAL / VREFINT_DATA (出厂校准值在30°C, 3.3V下测得)
+  * - 芯片温度使用出厂 TS_CAL1(30°C) / TS_CAL2(110°C) 两点校准
+  *
+  * 光敏传感器在 ADC3 上 (PF7只能接ADC3), 与 ADC1 独立工作,
+  * 每次读取光照时用这里测得的 VDDA 做比例修正
+  *
+  ******************************************************************************
+  */
+
+#ifndef __CHIP_SENSOR_H
+#define __CHIP_SENSOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "adc.h"
+#include "log.h"
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 调试开关 */
+#define CHIP_SENSOR_DEBUG_ENABLE    0
+
+/* 扫描通道数 (顺序需与 MX_ADC1_Init 中的Rank一致) */
+#define CHIP_SENSOR_CHANNELS        2
+#define CHIP_SENSOR_RANK_VREFINT    0       /* Rank1: VREFINT */
+#define CHIP_SENSOR_RANK_TEMP       1       /* Rank2: 温度传感器 */
+
+/* 每通道平均的采样数 */
+#define CHIP_SENSOR_AVG_SAMPLES     16
+
+/* 出厂校准值地址 (STM32F40x/41x 数据手册, 与UID同在系统存储区 0x1FFF7A2A~2F) */
+#define CHIP_SENSOR_VREFINT_CAL_ADDR    ((const uint16_t *)(UID_BASE + 0x1AU))
+#define CHIP_SENSOR_TS_CAL1_ADDR        ((const uint16_t *)(UID_BASE + 0x1CU))
+#define CHIP_SENSOR_TS_CAL2_ADDR        ((const uint16_t *)(UID_BASE + 0x1EU))
+
+/* 校准条件 */
+#define CHIP_SENSOR_CAL_VDDA_MV     3300    /* 校准时的VDDA (mV) */
+#define CHIP_SENSOR_TS_CAL1_TEMP    30      /* TS_CAL1 温度 (°C) */
+#define CHIP_SENSOR_TS_CAL2_TEMP    110     /* TS_CAL2 温度 (°C) */
+
+/* VDDA 合理范围 (超出视为采样异常, 使用标称值) */
+#define CHIP_SENSOR_VDDA_MIN_MV     1800
+#define CHIP_SENSOR_VDDA_MAX_MV     3600
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  片内传感器状态枚举
+  */
+typedef enum {
+    CHIP_SENSOR_OK = 0,             /**< 操作成功 */
+    CHIP_SENSOR_ERROR,              /**< 通用错误 */
+    CHIP_SENSOR_NOT_INITIALIZED,    /**< 未初始化 */
+    CHIP_SENSOR_NOT_READY           /**< 尚无有效数据 */
+} ChipSensor_Status_t;
+
+/**
+  * @brief  片内传感器句柄结构体
+  */
+typedef struct {
+    ADC_HandleTypeDef *hadc;        /**< ADC句柄指针 */
+    uint16_t vrefint_raw;           /**< VREFINT 平均原始值 */
+    uint16_t temp_raw;              /**< 温度传感器平均原始值 */
+    uint16_t vdda_mV;               /**< 测得的VDDA (mV) */
+    float temperature;              /**< 芯片温度 (°C) */
+    uint32_t last_update_tick;      /**< 最后更新时间 */
+    uint8_t is_initialized;         /**< 初始化标志 */
+} ChipSensor_Handle_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern ChipSensor_Handle_t chipSensor;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  初始化片内传感器 (启动ADC1循环DMA扫描)
+  * @note   需在 MX_ADC1_Init() 之后调用
+  * @retval ChipSensor_Status_t 操作状态
+  */
+ChipSensor_Status_t ChipSensor_Init(void);
+
+/**
+  * @brief  根据DMA缓冲区更新VDDA与温度 (非阻塞, 仅做平均计算)
+  * @retval ChipSensor_Status_t 操作状态
+  */
+ChipSensor_Status_t ChipSensor_Update(void);
+
+/**
+  * @brief  获取测得的VDDA (自动更新一次)
+  * @retval uint16_t VDDA (mV), 未就绪时返回校准电压3300
+  */
+uint16_t ChipSensor_GetVdda_mV(void);
+
+/**
+  * @brief  获取芯片温度 (自动更新一次)
+  * @retval float 芯片温度 (°C)
+  */
+float ChipSensor_GetTemperature(void);
+
+/**
+  * @brief  调试打印函数
+  * @param  format 格式化字符串
+  */
+void ChipSensor_DebugPrint(const char *format, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CHIP_SENSOR_H */
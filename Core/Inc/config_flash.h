@@ -0,0 +1,47 @@
+/**
+  ******************************************************************************
+  * @file           : config_flash.h
+  * @brief          : 配置存储的内部Flash扇区对 (目标板) 头文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 使用 STM32F407 的 16KB 扇区1 (0x08004000) 和扇区2 (0x08008000)。
+  * MDK-ARM/two.sct 把程序分成扇区0 (向量表与启动代码) 和扇区3~7 两段,
+  * 跳过这两个扇区; 下载程序时 Keil 的 "Erase Sectors" 只擦除用到的扇区,
+  * 配置保留 ("Erase Full Chip" 会清除配置)。
+  *
+  ******************************************************************************
+  */
+
+#ifndef __CONFIG_FLASH_H
+#define __CONFIG_FLASH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "config_store.h"
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 扇区对 */
+#define CONFIG_FLASH_SECTOR_A       FLASH_SECTOR_1
+#define CONFIG_FLASH_SECTOR_B       FLASH_SECTOR_2
+#define CONFIG_FLASH_ADDR_A         0x08004000UL
+#define CONFIG_FLASH_ADDR_B         0x08008000UL
+#define CONFIG_FLASH_SECTOR_SIZE    0x4000UL
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  内部Flash扇区对, 交给 ConfigStore_Init
+  */
+const ConfigStore_Flash_t* ConfigFlash_Get(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CONFIG_FLASH_H */
@@ -0,0 +1,223 @@
+/**
+  ******************************************************************************
+  * @file           : config_store.h
+  * @brief          : Flash 键值配置存储头文件 (日志结构, 双扇区轮换)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * WiFi/MQTT 凭据、采样周期、上报死区等配置以二进制键值记录追加写入一个
+  * Flash 扇区, 满了之后把每个键的最新记录搬到另一个扇区 (压缩), 两个扇区轮流
+  * 擦写, 擦除次数平摊到两个扇区上。
+  *
+  * 扇区布局 (全部按4字节对齐, 擦除状态为 0xFF):
+  *   头部   magic "CFG1" | seq          seq 大的为活动扇区, magic 最后写入
+  *   记录   key(16) len(16) | crc32 | value[len] (补齐到4字节)
+  *          先写 key/len, 再写 value, 最后写 crc; crc 未写或不对的记录被跳过
+  *   空闲   key/len 为 0xFFFFFFFF
+  *
+  * 启动时只遍历记录头建立 RAM 索引 (每个键的最新记录偏移), 再校验各键最新
+  * 记录的 crc, 不解析文本; 读取按索引直接访问映射的 Flash, O(1)。
+  * 掉电保护:
+  *   - 写记录时掉电: crc 未写入, 重启后该记录被跳过, 键保持旧值
+  *   - 压缩时掉电: 新扇区的头部最后写入, 没有头部的扇区不会被选中, 旧扇区仍有效
+  *   - 最新记录 crc 错误 (数据损坏): 重新逐条校验, 取该键最后一条完好的记录
+  *
+  * 用法:
+  *   ConfigStore_Init(ConfigFlash_Get());                    // 目标板: 内部Flash扇区1/2
+  *   ssid = ConfigStore_GetStr(CONFIG_KEY_WIFI_SSID, "AK70"); // 未设置时返回默认值
+  *   ConfigStore_SetU32(CONFIG_KEY_MQTT_PORT, 1883);
+  *   ConfigStore_ApplyJson("{\"wifi.ssid\":\"lab\",\"sample.dht11\":5000}", ...);
+  *
+  * - GetStr 返回的指针指向 Flash 中的记录, 下一次写入 (可能触发压缩) 前有效
+  * - 写入只能在主循环中调用; 压缩要擦除一个扇区 (16KB 约 0.25~0.5s),
+  *   擦除期间 CPU 取指被挂起, 中断也要等擦除结束 (串口接收由DMA继续)
+  * - 主机构建用文件模拟两个扇区 (Host/sim/flash_sim.h), 可以注入掉电
+  *
+  ******************************************************************************
+  */
+
+#ifndef __CONFIG_STORE_H
+#define __CONFIG_STORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "mem_config.h"
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 扇区头部 magic ("CFG1") */
+#define CONFIG_STORE_MAGIC          0x31474643UL
+
+/* 扇区头部与记录头大小 (字节) */
+#define CONFIG_STORE_HEADER_SIZE    8
+#define CONFIG_STORE_RECORD_HEAD    8
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  配置存储状态枚举
+  */
+typedef enum {
+    CONFIG_STORE_OK = 0,            /**< 操作成功 */
+    CONFIG_STORE_ERROR,             /**< Flash 擦写失败 */
+    CONFIG_STORE_NOT_FOUND,         /**< 键未设置 */
+    CONFIG_STORE_INVALID_PARAM,     /**< 无效参数 (键/类型/长度) */
+    CONFIG_STORE_FULL,              /**< 压缩后仍放不下 */
+    CONFIG_STORE_NOT_READY          /**< 未初始化 */
+} ConfigStore_Status_t;
+
+/**
+  * @brief  配置键 (记录中保存的是编号, 只能在末尾追加, 不能调整顺序)
+  */
+typedef enum {
+    CONFIG_KEY_WIFI_SSID = 0,       /**< "wifi.ssid" 字符串 */
+    CONFIG_KEY_WIFI_PASS,           /**< "wifi.pass" 字符串 (查询时隐藏) */
+    CONFIG_KEY_MQTT_HOST,           /**< "mqtt.host" 字符串 */
+    CONFIG_KEY_MQTT_PORT,           /**< "mqtt.port" 整数 */
+    CONFIG_KEY_MQTT_CLIENT_ID,      /**< "mqtt.client_id" 字符串 */
+    CONFIG_KEY_MQTT_USER,           /**< "mqtt.user" 字符串 */
+    CONFIG_KEY_MQTT_PASS,           /**< "mqtt.pass" 字符串 (查询时隐藏) */
+    CONFIG_KEY_SAMPLE_LIGHT,        /**< "sample.light" 光敏采样周期 ms */
+    CONFIG_KEY_SAMPLE_CHIP,         /**< "sample.chip" 片内温度采样周期 ms */
+    CONFIG_KEY_SAMPLE_DHT11,        /**< "sample.dht11" DHT11采样周期 ms */
+    CONFIG_KEY_DEAD_TEMP,           /**< "dead.temp" 温度绝对死区 */
+    CONFIG_KEY_DEAD_HUMI,           /**< "dead.humi" 湿度绝对死区 */
+    CONFIG_KEY_DEAD_LIGHT,          /**< "dead.light" 光照绝对死区 */
+    CONFIG_KEY_DEAD_BOARD_TEMP,     /**< "dead.board_temp" 板温绝对死区 */
+    CONFIG_KEY_BOOT_WIFI_SIG,       /**< "boot.wifi_sig" 模块保存的WiFi凭据签名 (boot.c 维护) */
+    CONFIG_KEY_BOOT_MQTT_SIG,       /**< "boot.mqtt_sig" 模块上MQTT连接参数签名 (boot.c 维护) */
+    CONFIG_KEY_WIFI_BSSID,          /**< "wifi.bssid" 上次入网的AP BSSID (boot.c 维护, 快速重连) */
+    CONFIG_KEY_WIFI_CHANNEL,        /**< "wifi.channel" 上次入网的AP信道 (boot.c 维护) */
+    CONFIG_KEY_WIFI_IP,             /**< "wifi.ip" 上次的地址, 快速重连时作静态IP (boot.c 维护) */
+    CONFIG_KEY_WIFI_GATEWAY,        /**< "wifi.gateway" 上次的网关 (boot.c 维护) */
+    CONFIG_KEY_WIFI_NETMASK,        /**< "wifi.netmask" 上次的子网掩码 (boot.c 维护) */
+    CONFIG_KEY_COUNT
+} ConfigStore_Key_t;
+
+/**
+  * @brief  值类型
+  */
+typedef enum {
+    CONFIG_TYPE_STR = 0,            /**< 字符串 (含结尾 '\0') */
+    CONFIG_TYPE_U32,                /**< 32位无符号整数 */
+    CONFIG_TYPE_FLOAT               /**< 单精度浮点 */
+} ConfigStore_Type_t;
+
+/**
+  * @brief  Flash 扇区对 (由目标板或主机仿真提供)
+  * @note   program 的 offset/len 按4字节对齐, 只能把 1 写成 0
+  */
+typedef struct {
+    uint32_t sectorSize;                                    /**< 每个扇区的字节数 */
+    const uint8_t *(*sector)(uint8_t index);                /**< 扇区的只读映射 */
+    ConfigStore_Status_t (*erase)(uint8_t index);           /**< 擦除扇区 */
+    ConfigStore_Status_t (*program)(uint8_t index, uint32_t offset,
+                                    const void *data, uint32_t len);   /**< 编程 */
+} ConfigStore_Flash_t;
+
+/**
+  * @brief  配置存储句柄
+  */
+typedef struct {
+    const ConfigStore_Flash_t *flash;       /**< Flash 扇区对 */
+    uint8_t ready;                          /**< 已初始化 */
+    uint8_t active;                         /**< 活动扇区 (0/1) */
+    uint32_t seq;                           /**< 活动扇区序号 */
+    uint32_t writeOffset;                   /**< 下一条记录的偏移 */
+    uint16_t index[CONFIG_KEY_COUNT];       /**< 各键最新记录的偏移, 0=未设置 */
+    uint32_t writes;                        /**< 写入记录数 */
+    uint32_t compactions;                   /**< 压缩次数 */
+    uint32_t skipped;                       /**< 启动时跳过的未完成/损坏记录 */
+} ConfigStore_Handle_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern ConfigStore_Handle_t configStore;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  选出活动扇区并建立索引, 两个扇区都无效时格式化扇区0
+  * @param  flash: Flash 扇区对
+  */
+ConfigStore_Status_t ConfigStore_Init(const ConfigStore_Flash_t *flash);
+
+/**
+  * @brief  读取原始值
+  * @param  len: 输出值长度 (可为NULL)
+  * @retval CONFIG_STORE_NOT_FOUND 未设置; 缓冲区不足时返回 INVALID_PARAM
+  */
+ConfigStore_Status_t ConfigStore_Get(ConfigStore_Key_t key, void *buf, uint16_t size, uint16_t *len);
+
+/**
+  * @brief  读取字符串, 未设置时返回 def
+  * @note   返回值指向 Flash 中的记录, 下一次写入前有效
+  */
+const char* ConfigStore_GetStr(ConfigStore_Key_t key, const char *def);
+
+/**
+  * @brief  读取整数, 未设置时返回 def
+  */
+uint32_t ConfigStore_GetU32(ConfigStore_Key_t key, uint32_t def);
+
+/**
+  * @brief  读取浮点数, 未设置时返回 def
+  */
+float ConfigStore_GetFloat(ConfigStore_Key_t key, float def);
+
+/**
+  * @brief  写入原始值 (与当前值相同时不写)
+  * @note   len=0 表示删除, 恢复默认值
+  */
+ConfigStore_Status_t ConfigStore_Set(ConfigStore_Key_t key, const void *data, uint16_t len);
+
+ConfigStore_Status_t ConfigStore_SetStr(ConfigStore_Key_t key, const char *value);
+ConfigStore_Status_t ConfigStore_SetU32(ConfigStore_Key_t key, uint32_t value);
+ConfigStore_Status_t ConfigStore_SetFloat(ConfigStore_Key_t key, float value);
+
+/**
+  * @brief  删除一个键 (恢复默认值)
+  */
+ConfigStore_Status_t ConfigStore_Delete(ConfigStore_Key_t key);
+
+/**
+  * @brief  擦除全部配置 (恢复出厂)
+  */
+ConfigStore_Status_t ConfigStore_Erase(void);
+
+/**
+  * @brief  键名查找
+  * @retval ConfigStore_Key_t 未知键名返回 CONFIG_KEY_COUNT
+  */
+ConfigStore_Key_t ConfigStore_Find(const char *name);
+
+/**
+  * @brief  键名
+  */
+const char* ConfigStore_GetName(ConfigStore_Key_t key);
+
+/**
+  * @brief  按JSON批量写入 (通常来自MQTT)
+  * @note   格式 {"wifi.ssid":"lab","mqtt.port":1883,"dead.temp":0.3,"mqtt.user":null}
+  *         字符串键取字符串值, 整数/浮点键取数字, null 删除该键
+  * @param  reply: 结果 {"set":2,"err":"mqtt.prt"} (可为NULL), err 为第一个失败的键
+  * @retval 成功写入的项数, -1=格式错误 (整个对象先检查, 格式错误时不写入任何项)
+  */
+int ConfigStore_ApplyJson(const char *json, char *reply, uint16_t size);
+
+/**
+  * @brief  已设置的键编码为JSON, 密码显示为 "***"
+  * @retval int 写入长度, 缓冲区不足时返回0
+  */
+int ConfigStore_FormatJson(char *buf, uint16_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CONFIG_STORE_H */
@@ -0,0 +1,49 @@
+/**
+  ******************************************************************************
+  * @file           : control.h
+  * @brief          : 远程控制命令处理头文件 (LED / 蜂鸣器)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 处理 stm32/control 主题的JSON命令, 如 {"led1":true}, 也支持组合:
+  * {"led1":true,"led2":false,"beep":true}。值可以是 true/false 或 1/0。
+  * 从 main.c 的MQTT回调中拆出, 主机构建可以直接驱动。
+  *
+  ******************************************************************************
+  */
+
+#ifndef __CONTROL_H
+#define __CONTROL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include <stdint.h>
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  执行一条控制命令
+  * @param  json 命令JSON (以'\0'结尾)
+  * @retval uint8_t 执行的动作数, 0 表示没有认识的键
+  */
+uint8_t Control_Handle(const char *json);
+
+/**
+  * @brief  JSON解析辅助函数 - 获取布尔值
+  * @param  json: JSON字符串
+  * @param  key: 要查找的键名
+  * @param  value: 输出布尔值 (1=true, 0=false)
+  * @retval 0=成功, -1=未找到键, -2=解析失败
+  */
+int Control_GetBool(const char *json, const char *key, uint8_t *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CONTROL_H */
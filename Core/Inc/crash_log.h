@@ -0,0 +1,182 @@
+/**
+  ******************************************************************************
+  * @file           : crash_log.h
+  * @brief          : 复位保持的故障记录 (.noinit RAM) 头文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * HardFault / Error_Handler 发生时把以下内容写入不被启动代码清零的RAM:
+  *   - 异常栈帧 (R0-R3/R12/LR/PC/xPSR) 与 CFSR/HFSR/MMFAR/BFAR/AFSR
+  *   - 被打断的异常号 (0=主循环) 与应用状态ID (CrashLog_SetState)
+  *   - 日志环形缓冲区最后 CRASH_LOG_TAIL_SIZE 字节
+  * 整个过程只有内存拷贝, 在微秒级完成, 不经过阻塞的串口
+  *
+  * 复位后 CrashLog_Init() 校验记录, 有效时由主循环在 MQTT 连接后
+  * 发布到故障主题, 发布成功再清除
+  *
+  * 记录中的 count 在发布清除前累加, 即连续故障复位的次数; 达到
+  * CRASH_LOG_RESET_LIMIT 后不再复位而是停机, 避免外设初始化等持续性故障
+  * 造成复位循环 (这种情况下设备永远连不上MQTT, 记录也发布不出去)
+  *
+  * 链接配置: 记录位于 .bss.noinit 段 (GCC 为 .noinit), 需要放入 UNINIT 区域,
+  * 否则启动时会被清零 (此时只是检测不到记录, 不影响运行)。
+  * 分散加载文件 MDK-ARM/two.sct 中为 SRAM 末尾 4KB 的 RW_NOINIT 区域:
+  *   RW_NOINIT 0x2001F000 UNINIT 0x00001000 {
+  *     *(.bss.noinit)
+  *   }
+  *
+  ******************************************************************************
+  */
+
+#ifndef __CRASH_LOG_H
+#define __CRASH_LOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "mem_config.h"
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 保存的日志尾部长度 CRASH_LOG_TAIL_SIZE 见 mem_config.h */
+
+/* 记录后立即软复位, 以便尽快发布故障记录 (1:开启 0:停在故障处便于调试器查看) */
+#define CRASH_LOG_RESET_ON_FAULT    1
+
+/* 记录发布前连续故障复位的次数上限, 超过后停在故障处 (初始化中的持续故障不会无限复位);
+ * 连着调试器时总是停住 */
+#define CRASH_LOG_RESET_LIMIT       3
+
+/* 在当前栈顶向上查找异常栈帧的范围 (字) */
+#define CRASH_LOG_FRAME_SEARCH      32
+
+/* 记录有效标志 */
+#define CRASH_LOG_MAGIC             0x43524153UL    /* "CRAS" */
+
+/* 调用者地址 (Error_Handler 中记录出错位置) */
+#if defined(__CC_ARM)
+#define CRASH_LOG_RETURN_ADDRESS()  ((uint32_t)__return_address())
+#else
+#define CRASH_LOG_RETURN_ADDRESS()  ((uint32_t)__builtin_return_address(0))
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  故障原因
+  */
+typedef enum {
+    CRASH_REASON_NONE = 0,          /**< 无记录 */
+    CRASH_REASON_HARDFAULT,         /**< HardFault */
+    CRASH_REASON_MEMMANAGE,         /**< MemManage */
+    CRASH_REASON_BUSFAULT,          /**< BusFault */
+    CRASH_REASON_USAGEFAULT,        /**< UsageFault */
+    CRASH_REASON_ERROR_HANDLER      /**< Error_Handler */
+} CrashLog_Reason_t;
+
+/**
+  * @brief  故障记录 (位于 .noinit RAM)
+  */
+typedef struct {
+    uint32_t magic;                 /**< CRASH_LOG_MAGIC */
+    uint32_t count;                 /**< 记录未被清除前累计的故障次数 */
+    uint8_t reason;                 /**< CrashLog_Reason_t */
+    uint8_t frameValid;             /**< 1=找到了异常栈帧 */
+    uint16_t state;                 /**< 故障时的应用状态ID */
+    uint32_t tick;                  /**< 故障时的 HAL_GetTick() */
+    uint32_t r0, r1, r2, r3;        /**< 异常栈帧 */
+    uint32_t r12, lr, pc, xpsr;
+    uint32_t sp;                    /**< 异常栈帧地址 */
+    uint32_t cfsr;                  /**< SCB->CFSR */
+    uint32_t hfsr;                  /**< SCB->HFSR */
+    uint32_t mmfar;                 /**< SCB->MMFAR */
+    uint32_t bfar;                  /**< SCB->BFAR */
+    uint32_t afsr;                  /**< SCB->AFSR */
+    uint16_t logLen;                /**< 日志尾部有效长度 */
+    uint16_t reserved;
+    uint8_t log[CRASH_LOG_TAIL_SIZE];   /**< 日志尾部 */
+    uint32_t checksum;              /**< 以上内容的校验和 */
+} CrashLog_Record_t;
+
+/**
+  * @brief  故障记录句柄
+  */
+typedef struct {
+    uint8_t pending;                /**< 1=有上次复位前的记录待发布 */
+    uint32_t resetFlags;            /**< 本次复位原因 (RCC->CSR 高字节) */
+    volatile uint16_t state;        /**< 当前应用状态ID */
+} CrashLog_Handle_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern CrashLog_Handle_t crashLog;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  上电后检查故障记录, 读取并清除复位原因标志
+  * @note   应在 LOG_Init() 之后尽早调用
+  */
+void CrashLog_Init(void);
+
+/**
+  * @brief  设置当前应用状态ID, 故障时一并记录
+  * @param  state 状态ID (由应用定义)
+  */
+void CrashLog_SetState(uint16_t state);
+
+/**
+  * @brief  在故障异常中记录现场 (在 xxxFault_Handler 开头调用)
+  * @param  reason 故障原因
+  * @note   CrashLog_ResetAllowed() 为1时复位, 不返回
+  */
+void CrashLog_Fault(CrashLog_Reason_t reason);
+
+/**
+  * @brief  在非异常路径记录现场 (如 Error_Handler), 不复位
+  * @param  reason 故障原因
+  * @param  pc 出错位置 (通常为 CRASH_LOG_RETURN_ADDRESS())
+  */
+void CrashLog_Capture(CrashLog_Reason_t reason, uint32_t pc);
+
+/**
+  * @brief  记录现场后是否应当软复位
+  * @retval uint8_t 1=复位; 0=停在故障处 (关闭了复位、连着调试器或连续故障复位已达上限)
+  */
+uint8_t CrashLog_ResetAllowed(void);
+
+/**
+  * @brief  是否有待发布的故障记录
+  * @retval uint8_t 1=有
+  */
+uint8_t CrashLog_HasRecord(void);
+
+/**
+  * @brief  把故障记录编码为JSON
+  * @param  buf 输出缓冲区
+  * @param  size 缓冲区大小
+  * @retval int 长度, 无记录返回0
+  */
+int CrashLog_FormatReport(char *buf, uint16_t size);
+
+/**
+  * @brief  获取故障前的日志尾部
+  * @param  len 输出长度
+  * @retval const uint8_t* 数据指针 (可能含令牌化日志帧)
+  */
+const uint8_t* CrashLog_GetLog(uint16_t *len);
+
+/**
+  * @brief  发布完成后清除故障记录
+  */
+void CrashLog_Clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CRASH_LOG_H */
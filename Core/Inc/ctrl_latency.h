@@ -0,0 +1,178 @@
+/**
+  ******************************************************************************
+  * @file           : ctrl_latency.h
+  * @brief          : 控制路径时延剖析头文件 (MQTT控制命令 -> GPIO)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 一条 stm32/control 命令从串口到引脚经过的打点:
+  *   IRQ       USART3 中断入口 (每次中断都记, 只作候选起点)
+  *   URC       RxEventCallback 识别出 +MQTTSUBRECV 并拷入消息缓冲区 (采样开始)
+  *   QUEUE     MQTT_ProcessData 取出待处理消息
+  *   DISPATCH  解析完成, 调用 onMessageReceived 之前
+  *   JSON      控制处理函数解析出第一个键值
+  *   GPIO      第一次 HAL_GPIO_WritePin 返回 (采样结束, 记入统计)
+  * 相邻打点之差记为一个阶段 (urc/queue/dispatch/json/gpio), 再加总时延 total。
+  * 打点必须按顺序出现, 乱序或重复的打点被忽略 (同一条消息被解析两次、
+  * 一条命令写多个引脚都只记第一次); 采样未结束 (包括非控制主题的消息)
+  * 又来了新的 URC 时, 旧采样计为未完成。
+  *
+  * 每个阶段用对数-线性直方图统计 (每个2的幂区间再分 8 份, 相对误差 <12.5%),
+  * 内存固定, 可以跑成千上万条命令后取 p50/p99/max。
+  *
+  * 计时源: 目标板为 DWT->CYCCNT (与 prof.h 相同); 主机上为虚拟时钟换算的
+  * 周期数 uwTick * (SystemCoreClock/1000), 只反映线上时间和轮询周期等
+  * 虚拟时间, 同一毫秒内的CPU耗时为0, CPU耗时要在目标板上测。
+  *
+  ******************************************************************************
+  */
+
+#ifndef __CTRL_LATENCY_H
+#define __CTRL_LATENCY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "prof.h"
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 剖析开关 (1:开启 0:打点宏展开为空) */
+#ifndef CTRL_LAT_ENABLE
+#define CTRL_LAT_ENABLE             1
+#endif
+
+/* 每个2的幂区间的细分数 (log2) */
+#define CTRL_LAT_SUB_BITS           3
+
+/* 直方图桶数: 0~7 精确, 之后每个2的幂 8 个桶, 覆盖 32 位 */
+#define CTRL_LAT_BINS               ((32 - CTRL_LAT_SUB_BITS + 1) << CTRL_LAT_SUB_BITS)
+
+/* 报告JSON的最大长度 */
+#define CTRL_LAT_REPORT_SIZE        480
+
+/* 计时源 */
+#ifdef PROF_HOST
+#define CTRL_LAT_NOW()              ((uint32_t)(uwTick * (SystemCoreClock / 1000U)))
+#else
+#define CTRL_LAT_NOW()              PROF_NOW()
+#endif
+
+/* 打点宏 */
+#if CTRL_LAT_ENABLE
+#define CTRL_LAT_IRQ_ENTRY()        CtrlLatency_IrqEntry()
+#define CTRL_LAT_STAMP(point)       CtrlLatency_Stamp(CTRL_LAT_##point)
+#else
+#define CTRL_LAT_IRQ_ENTRY()        ((void)0)
+#define CTRL_LAT_STAMP(point)       ((void)0)
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  打点
+  */
+typedef enum {
+    CTRL_LAT_IRQ = 0,               /**< 串口中断入口 */
+    CTRL_LAT_URC,                   /**< 识别出 +MQTTSUBRECV */
+    CTRL_LAT_QUEUE,                 /**< 主循环取出消息 */
+    CTRL_LAT_DISPATCH,              /**< 调用应用回调前 */
+    CTRL_LAT_JSON,                  /**< JSON解析完成 */
+    CTRL_LAT_GPIO,                  /**< 写引脚完成 */
+    CTRL_LAT_POINT_COUNT
+} CtrlLatency_Point_t;
+
+/**
+  * @brief  阶段 (阶段 i = 打点 i+1 - 打点 i, 最后一项为总时延)
+  */
+typedef enum {
+    CTRL_LAT_STAGE_URC = 0,         /**< 中断入口 -> URC入队 (中断内) */
+    CTRL_LAT_STAGE_QUEUE,           /**< 入队 -> 主循环取出 (排队等待) */
+    CTRL_LAT_STAGE_DISPATCH,        /**< 取出 -> 回调 (URC解析) */
+    CTRL_LAT_STAGE_JSON,            /**< 回调 -> JSON解析完成 */
+    CTRL_LAT_STAGE_GPIO,            /**< JSON -> 写引脚完成 */
+    CTRL_LAT_STAGE_TOTAL,           /**< 中断入口 -> 写引脚完成 */
+    CTRL_LAT_STAGE_COUNT
+} CtrlLatency_Stage_t;
+
+/**
+  * @brief  阶段统计
+  */
+typedef struct {
+    uint32_t count;                 /**< 次数 */
+    uint32_t min;                   /**< 最小值 (周期) */
+    uint32_t max;                   /**< 最大值 (周期) */
+    uint16_t hist[CTRL_LAT_BINS];   /**< 对数-线性直方图, 饱和计数 */
+} CtrlLatency_Stats_t;
+
+/**
+  * @brief  剖析句柄
+  */
+typedef struct {
+    CtrlLatency_Stats_t stages[CTRL_LAT_STAGE_COUNT];  /**< 各阶段统计 */
+    uint32_t stamps[CTRL_LAT_POINT_COUNT];  /**< 当前采样的打点 */
+    uint32_t irqCandidate;          /**< 最近一次中断入口 */
+    uint8_t next;                   /**< 当前采样期待的下一个打点, 0=无采样 */
+    uint32_t incomplete;            /**< 未走到 GPIO 就被新 URC 覆盖的采样 */
+    uint32_t hz;                    /**< 计时源频率 */
+} CtrlLatency_Handle_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern CtrlLatency_Handle_t ctrlLatency;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  清空统计 (计时源由 Prof_Init 使能)
+  */
+void CtrlLatency_Reset(void);
+
+/**
+  * @brief  串口中断入口打点 (USART3_IRQHandler 开头调用)
+  */
+void CtrlLatency_IrqEntry(void);
+
+/**
+  * @brief  路径打点 (URC 开始一次采样, GPIO 结束并记入统计)
+  */
+void CtrlLatency_Stamp(CtrlLatency_Point_t point);
+
+/**
+  * @brief  获取阶段统计
+  */
+void CtrlLatency_GetStats(CtrlLatency_Stage_t stage, CtrlLatency_Stats_t *stats);
+
+/**
+  * @brief  获取阶段名称
+  */
+const char* CtrlLatency_GetName(CtrlLatency_Stage_t stage);
+
+/**
+  * @brief  按直方图估算百分位 (取所在桶的上界, 不超过最大值)
+  * @param  permille 千分位, 500=p50 990=p99
+  * @retval uint32_t 周期数
+  */
+uint32_t CtrlLatency_Percentile(const CtrlLatency_Stats_t *stats, uint16_t permille);
+
+/**
+  * @brief  把各阶段的 p50/p99/max 编码为JSON (单位微秒)
+  * @note   格式 {"n":1000,"incomplete":0,"urc":[p50,p99,max],"queue":[..],...,"total":[..]}
+  * @retval int 长度
+  */
+int CtrlLatency_Format(char *buf, uint16_t size);
+
+/**
+  * @brief  通过日志输出各阶段统计
+  */
+void CtrlLatency_Dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CTRL_LATENCY_H */
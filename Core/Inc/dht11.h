@@ -59,6 +59,9 @@ extern "C" {
 /* 采样间隔 (DHT11最小采样间隔为1秒) */
 #define DHT11_MIN_SAMPLE_INTERVAL_MS    1000
 
+/* 上电稳定时间: 初始化后这段时间内不能读取 (不阻塞, 期间可以做其他初始化) */
+#define DHT11_POWER_UP_MS               1000
+
 /* 调试开关 */
 #define DHT11_DEBUG_ENABLE              0       /* 1:开启调试输出 0:关闭 */
 
@@ -74,7 +77,8 @@ typedef enum {
     DHT11_ERROR_CHECKSUM,       /* 校验和错误 */
     DHT11_ERROR_NO_RESPONSE,    /* 传感器无响应 */
     DHT11_ERROR_NOT_READY,      /* 采样间隔不足 */
-    DHT11_ERROR_INVALID_DATA    /* 数据无效 */
+    DHT11_ERROR_INVALID_DATA,   /* 数据无效 */
+    DHT11_BUSY                  /* 分步读取中, 起始信号尚未结束 */
 } DHT11_Status_t;
 
 /**
@@ -105,6 +109,9 @@ typedef struct {
     GPIO_TypeDef *port;         /* GPIO端口 */
     uint16_t pin;               /* GPIO引脚 */
     DHT11_Data_t data;          /* 传感器数据 */
+    uint32_t startTick;         /* 分步读取: 起始信号开始时间 (ms) */
+    uint32_t readyTick;         /* 上电稳定的时间 (ms) */
+    uint8_t reading;            /* 分步读取: 1=起始信号进行中 */
     uint8_t initialized;        /* 初始化标志 */
 } DHT11_Handle_t;
 
@@ -143,6 +150,22 @@ DHT11_Status_t DHT11_Read(float *temperature, float *humidity);
   */
 DHT11_Status_t DHT11_ReadRaw(DHT11_RawData_t *rawData);
 
+/**
+  * @brief  分步读取第1步: 发出起始信号后立即返回 (非阻塞)
+  * @note   起始信号需保持18ms以上, 期间CPU可处理其他任务,
+  *         之后调用 DHT11_FinishRead() 完成读取
+  * @retval DHT11_Status_t 操作状态 (采样间隔不足时返回 DHT11_ERROR_NOT_READY)
+  */
+DHT11_Status_t DHT11_StartRead(void);
+
+/**
+  * @brief  分步读取第2步: 起始信号足够长后接收40位数据
+  * @param  temperature: 温度输出指针 (可为NULL)
+  * @param  humidity: 湿度输出指针 (可为NULL)
+  * @retval DHT11_BUSY=起始信号时间未到, 其余同 DHT11_Read()
+  */
+DHT11_Status_t DHT11_FinishRead(float *temperature, float *humidity);
+
 /**
   * @brief  获取最后一次读取的温度
   * @retval 温度值 (°C)
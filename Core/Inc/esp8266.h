@@ -32,6 +32,7 @@ extern "C" {
 /* Includes ------------------------------------------------------------------*/
 #include "usart.h"
 #include "log.h"
+#include "mem_config.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -43,11 +44,13 @@ extern "C" {
 /* Exported defines ----------------------------------------------------------*/
 
 /* ESP8266 配置 */
-#define ESP8266_RX_BUF_SIZE             2048            /* DMA接收缓冲区大小 */
-#define ESP8266_TX_BUF_SIZE             1024            /* 发送缓冲区大小 */
+/* 接收/发送缓冲区大小见 mem_config.h */
 #define ESP8266_DEFAULT_TIMEOUT         3000            /* 默认超时时间(ms) */
 #define ESP8266_LONG_TIMEOUT            10000           /* 长超时时间(ms) */
 #define ESP8266_CONNECT_TIMEOUT         15000           /* 连接超时时间(ms) */
+#define ESP8266_FAST_JOIN_TIMEOUT       5000            /* 快速重连 (指定BSSID, 静态地址) 超时时间(ms) */
+#define ESP8266_READY_TIMEOUT_MS        3000            /* 初始化时等待模块启动完成 (应答AT) 的最长时间 */
+#define ESP8266_READY_PROBE_MS          50              /* 就绪探测 "AT" 的单次等待 */
 
 /* 最大连接数 */
 #define ESP8266_MAX_CONNECTIONS         5
@@ -55,6 +58,32 @@ extern "C" {
 /* 调试开关 */
 #define ESP8266_DEBUG_ENABLE            1               /* 1:开启调试输出 0:关闭 */
 
+/* AT命令统计 (按命令动词分类, 如 CWJAP / MQTTPUBRAW / CIPSEND) */
+#define ESP8266_STATS_MAX_VERBS         16              /* 统计表容量, 最后一项保留给超出的动词 ("other") */
+#define ESP8266_STATS_VERB_LEN          16              /* 动词最大长度 (含结束符) */
+#define ESP8266_STATS_BINS              10              /* 延时直方图桶数 */
+#define ESP8266_STATS_BIN_BOUNDS        {10, 20, 50, 100, 200, 500, 1000, 2000, 5000}   /* 桶上界(ms), 最后一桶为 >=5000 */
+#define ESP8266_STATS_NO_LATENCY        0xFFFFFFFFUL    /* 无应答延时 (不等待应答的命令) */
+
+/* 模块休眠 (AT+SLEEP): 本轮发布结束且应答都已收到时进入休眠;
+ * Light-sleep 在下一条AT命令前自动唤醒, Modem-sleep 串口始终可用, 进入一次后不再唤醒 */
+#define ESP8266_SLEEP_POLICY            ESP8266_SLEEP_MODEM /* 默认策略, 见 ESP8266_SleepMode_t */
+#define ESP8266_SLEEP_MAX_MS            30000           /* Light-sleep 最长连续休眠, 到期唤醒一次让模块发送MQTT心跳 */
+#define ESP8266_SLEEP_MODEM_KEEPALIVE   240             /* Modem-sleep 下的MQTT心跳(秒), 周期发布已能维持会话 */
+#define ESP8266_WAKE_TIMEOUT_MS         500             /* 唤醒后等待模块应答的超时 */
+#define ESP8266_WAKE_PROBE_MS           20              /* 唤醒探测 "AT" 的单次等待 */
+
+/* 唤醒线 (STM32输出 -> 模块 AT+WAKEUPGPIO 触发引脚), 未接线时 Light-sleep 退化为 Modem-sleep */
+#define ESP8266_WAKE_GPIO_ENABLE        0
+#define ESP8266_WAKE_GPIO_PORT          GPIOB
+#define ESP8266_WAKE_GPIO_PIN           GPIO_PIN_12
+#define ESP8266_WAKE_ESP_GPIO           4               /* 模块侧触发引脚编号 */
+#define ESP8266_WAKE_LEVEL              0               /* 触发电平 */
+
+/* Light-sleep 期间允许STM32进入STOP (模块主动推送的数据首字节会丢失);
+ * 为0时驱动初始化后一直禁止STOP, 主循环空闲只进入 tickless Sleep */
+#define ESP8266_SLEEP_ALLOW_MCU_STOP    0
+
 /* Exported types ------------------------------------------------------------*/
 
 /**
@@ -71,7 +100,8 @@ typedef enum {
     ESP8266_ALREADY_CONNECTED,          /* 已连接 */
     ESP8266_NOT_CONNECTED,              /* 未连接 */
     ESP8266_WIFI_DISCONNECT,            /* WiFi断开 */
-    ESP8266_INVALID_PARAM               /* 无效参数 */
+    ESP8266_INVALID_PARAM,              /* 无效参数 */
+    ESP8266_NO_MEMORY                   /* 共享区不足 */
 } ESP8266_Status_t;
 
 /**
@@ -83,6 +113,15 @@ typedef enum {
     ESP8266_MODE_STA_AP = 3             /* Station + SoftAP模式 */
 } ESP8266_WiFiMode_t;
 
+/**
+  * @brief  ESP8266 休眠模式 (AT+SLEEP 参数)
+  */
+typedef enum {
+    ESP8266_SLEEP_NONE = 0,             /* 不休眠 */
+    ESP8266_SLEEP_LIGHT = 1,            /* Light-sleep, 需要唤醒线 */
+    ESP8266_SLEEP_MODEM = 2             /* Modem-sleep, 串口始终可用, 射频按DTIM开关 */
+} ESP8266_SleepMode_t;
+
 /**
   * @brief  ESP8266 加密方式枚举
   */
@@ -117,7 +156,7 @@ typedef enum {
 typedef struct {
     uint8_t linkId;                     /* 连接ID (多连接模式) */
     uint16_t length;                    /* 数据长度 */
-    uint8_t data[ESP8266_RX_BUF_SIZE];  /* 数据内容 */
+    uint8_t *data;                      /* 数据内容 (共享区, 以'\0'结尾, 只在回调中有效) */
 } ESP8266_RxData_t;
 
 /**
@@ -140,6 +179,37 @@ typedef struct {
     char netmask[16];                   /* 子网掩码 */
 } ESP8266_IPInfo_t;
 
+/**
+  * @brief  快速重连缓存 (上次成功入网的AP与地址)
+  * @note   bssid 为空串表示无效; 信道只记录和上报, CWJAP 没有信道参数,
+  *         指定 BSSID 后模块不再全信道扫描
+  */
+typedef struct {
+    char bssid[18];                     /* AP的BSSID */
+    uint8_t channel;                    /* AP信道 */
+    ESP8266_IPInfo_t lease;             /* 上次的IP/网关/掩码, 快速重连时作为静态地址 */
+} ESP8266_JoinCache_t;
+
+/**
+  * @brief  入网路径
+  */
+typedef enum {
+    ESP8266_JOIN_FAST = 0,              /* 指定BSSID + 静态地址 */
+    ESP8266_JOIN_FULL,                  /* 扫描 + DHCP */
+    ESP8266_JOIN_PATH_COUNT
+} ESP8266_JoinPath_t;
+
+/**
+  * @brief  入网耗时统计 (发出命令到获得IP, 每条路径一项)
+  */
+typedef struct {
+    uint32_t count;                     /* 成功次数 */
+    uint32_t fail;                      /* 失败次数 */
+    uint32_t lastMs;                    /* 最近一次耗时(ms) */
+    uint32_t maxMs;                     /* 最大耗时(ms) */
+    uint32_t totalMs;                   /* 累计耗时(ms) */
+} ESP8266_JoinStats_t;
+
 /**
   * @brief  连接状态结构
   */
@@ -161,6 +231,24 @@ typedef struct {
     volatile uint8_t ready;                  /* 数据就绪标志 */
 } ESP8266_DMA_RxBuffer_t;
 
+/**
+  * @brief  AT命令统计 (每个命令动词一项)
+  * @note   延时为 DMA发送完成 到 收到终止应答 (OK/ERROR/BUSY/期望字符串) 的毫秒数,
+  *         超时的命令不计入直方图
+  */
+typedef struct {
+    char verb[ESP8266_STATS_VERB_LEN];  /* 命令动词 */
+    uint32_t issued;                    /* 发出次数 */
+    uint32_t ok;                        /* 成功 */
+    uint32_t error;                     /* ERROR */
+    uint32_t busy;                      /* busy p... (模块忙) */
+    uint32_t timeout;                   /* 超时 */
+    uint32_t latencyCount;              /* 有应答的次数 */
+    uint32_t latencyTotal;              /* 应答延时累计(ms) */
+    uint32_t latencyMax;                /* 最大应答延时(ms) */
+    uint16_t hist[ESP8266_STATS_BINS];  /* 应答延时直方图, 饱和计数 */
+} ESP8266_CmdStats_t;
+
 /**
   * @brief  ESP8266 句柄结构
   */
@@ -171,12 +259,11 @@ typedef struct {
     uint8_t dmaRxBuffer[ESP8266_RX_BUF_SIZE];   /* DMA接收缓冲区 */
     
     /* 处理缓冲区 */
-    uint8_t rxBuffer[ESP8266_RX_BUF_SIZE];      /* 接收处理缓冲区 */
+    uint8_t rxBuffer[ESP8266_RX_BUF_SIZE + 1];  /* 接收处理缓冲区 (多一个字节给结束符) */
     volatile uint16_t rxLength;                  /* 接收数据长度 */
     volatile uint8_t rxComplete;                 /* 接收完成标志 */
     
-    /* 发送缓冲区 */
-    uint8_t txBuffer[ESP8266_TX_BUF_SIZE];
+    /* 发送状态 (格式化缓冲区在共享区) */
     volatile uint8_t txBusy;                     /* 发送忙标志 */
     
     /* 状态信息 */
@@ -190,6 +277,32 @@ typedef struct {
     /* IP信息 */
     ESP8266_IPInfo_t ipInfo;            /* IP信息 */
     
+    /* 快速重连 */
+    ESP8266_JoinCache_t joinCache;      /* 上次成功入网的AP与地址 */
+    ESP8266_JoinStats_t joinStats[ESP8266_JOIN_PATH_COUNT];    /* 各路径入网耗时 */
+    uint8_t lastJoinPath;               /* 最近一次成功入网的路径 (ESP8266_JoinPath_t) */
+    uint32_t lastJoinMs;                /* 最近一次入网耗时(ms), 指标 wifi.join_ms */
+    uint32_t joinFallbacks;             /* 快速重连失败后改用完整入网的次数 */
+    
+    /* AT命令统计 */
+    volatile uint32_t txDoneTick;       /* 最近一次DMA发送完成时间 */
+    volatile uint32_t rxTick;           /* 最近一次收到数据的时间 */
+    ESP8266_CmdStats_t cmdStats[ESP8266_STATS_MAX_VERBS];  /* 统计表 */
+    uint8_t cmdStatsCount;              /* 统计表已用项数 */
+    uint8_t cmdStatsQuery;              /* 分块导出的下一项 */
+    
+    /* 模块休眠 */
+    ESP8266_SleepMode_t sleepPolicy;    /* 空闲时进入的休眠模式 */
+    volatile uint8_t asleep;            /* 模块当前处于休眠 */
+    uint8_t wakeGpioReady;              /* 已下发 AT+WAKEUPGPIO */
+    uint32_t lastActivity;              /* 最近一次AT命令完成时间 */
+    uint32_t sleepStart;                /* 本次进入休眠的时间 */
+    uint32_t sleepMs;                   /* 累计休眠时间(ms), 唤醒时累加 (Modem-sleep 每轮累加) */
+    uint32_t sleepCount;                /* 进入休眠次数 */
+    
+    /* 等待统计 */
+    uint32_t waitMs;                    /* 累计在 ESP8266_Delay 中等待模块的时间(ms) */
+    
     /* 回调函数 */
     void (*onDataReceived)(ESP8266_RxData_t *data);     /* 数据接收回调 */
     void (*onWifiConnected)(void);                       /* WiFi连接回调 */
@@ -224,6 +337,12 @@ ESP8266_Status_t ESP8266_GetAPInfo(ESP8266_APInfo_t *apInfo);
 ESP8266_Status_t ESP8266_ScanAP(ESP8266_APInfo_t *apList, uint8_t maxCount, uint8_t *foundCount);
 ESP8266_Status_t ESP8266_SetAutoConnect(uint8_t enable);
 
+/* 快速重连: 缓存有效时 CIPSTA 静态地址 + CWJAP 指定BSSID, 失败或无缓存时恢复DHCP并完整入网 */
+ESP8266_Status_t ESP8266_Rejoin(const char *ssid, const char *password);
+ESP8266_Status_t ESP8266_UpdateJoinCache(void);
+uint8_t ESP8266_JoinCacheValid(void);
+int ESP8266_FormatJoinJson(char *buf, uint16_t size);
+
 /* SoftAP模式操作 */
 ESP8266_Status_t ESP8266_SetupAP(const char *ssid, const char *password, 
                                   uint8_t channel, ESP8266_Encryption_t ecn);
@@ -232,6 +351,7 @@ ESP8266_Status_t ESP8266_GetAPConfig(char *ssid, char *password,
 
 /* IP操作 */
 ESP8266_Status_t ESP8266_GetIPInfo(ESP8266_IPInfo_t *ipInfo);
+ESP8266_Status_t ESP8266_GetStationIP(ESP8266_IPInfo_t *ipInfo);
 ESP8266_Status_t ESP8266_SetStationIP(const char *ip, const char *gateway, const char *netmask);
 ESP8266_Status_t ESP8266_SetAPIP(const char *ip, const char *gateway, const char *netmask);
 ESP8266_Status_t ESP8266_EnableDHCP(ESP8266_WiFiMode_t mode, uint8_t enable);
@@ -283,6 +403,28 @@ void ESP8266_ClearBuffer(void);
 uint8_t ESP8266_WaitForResponse(const char *response, uint32_t timeout);
 uint8_t ESP8266_ContainsString(const char *str);
 char* ESP8266_GetResponseBuffer(void);
+void ESP8266_Delay(uint32_t ms);
+uint32_t ESP8266_GetWaitTime(void);
+ESP8266_Status_t ESP8266_SetBaudRate(uint32_t baud);
+void ESP8266_SetWaitHook(void (*hook)(void));
+
+/* AT命令统计 */
+void ESP8266_StatsRecord(const char *verb, ESP8266_Status_t status, uint32_t latency);
+uint32_t ESP8266_GetResponseLatency(uint32_t txDoneTick);
+ESP8266_Status_t ESP8266_GetCmdStats(const char *verb, ESP8266_CmdStats_t *stats);
+uint8_t ESP8266_GetCmdStatsCount(void);
+void ESP8266_ResetCmdStats(void);
+int ESP8266_FormatCmdStats(uint8_t index, char *buf, uint16_t size);
+void ESP8266_StartStatsQuery(void);
+int ESP8266_NextStatsChunk(char *buf, uint16_t size);
+
+/* 模块休眠 */
+ESP8266_Status_t ESP8266_SetSleepPolicy(ESP8266_SleepMode_t mode);
+ESP8266_Status_t ESP8266_Sleep(void);
+ESP8266_Status_t ESP8266_Wake(void);
+void ESP8266_SleepPoll(void);
+uint32_t ESP8266_SleepTimeToNext(void);
+uint16_t ESP8266_SleepKeepAlive(uint16_t defaultKeepAlive);
 
 /* 回调设置函数 */
 void ESP8266_SetOnDataReceived(void (*callback)(ESP8266_RxData_t *data));
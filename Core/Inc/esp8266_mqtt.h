@@ -46,12 +46,7 @@ extern "C" {
 
 /* MQTT配置 */
 #define MQTT_LINK_ID                    0               /* MQTT Link ID (ESP8266只支持0) */
-#define MQTT_CLIENT_ID_MAX_LEN          64              /* Client ID最大长度 */
-#define MQTT_USERNAME_MAX_LEN           64              /* 用户名最大长度 */
-#define MQTT_PASSWORD_MAX_LEN           64              /* 密码最大长度 */
-#define MQTT_TOPIC_MAX_LEN              128             /* 主题最大长度 */
-#define MQTT_MESSAGE_MAX_LEN            1024            /* 消息最大长度 */
-#define MQTT_HOST_MAX_LEN               128             /* Broker地址最大长度 */
+/* 各字符串与消息缓冲区的最大长度见 mem_config.h */
 
 /* MQTT超时配置 */
 #define MQTT_CONNECT_TIMEOUT            10000           /* 连接超时(ms) */
@@ -59,9 +54,6 @@ extern "C" {
 #define MQTT_SUBSCRIBE_TIMEOUT          5000            /* 订阅超时(ms) */
 #define MQTT_DEFAULT_TIMEOUT            3000            /* 默认超时(ms) */
 
-/* MQTT最大订阅主题数 */
-#define MQTT_MAX_SUBSCRIPTIONS          8               /* 最大订阅主题数 */
-
 /* 调试开关 */
 #define MQTT_DEBUG_ENABLE               1               /* 1:开启调试输出 0:关闭 */
 
@@ -140,7 +132,7 @@ typedef struct {
     uint16_t keepAlive;                 /* 心跳间隔(秒) */
     uint8_t disableCleanSession;        /* 禁用清除会话 */
     char lwtTopic[MQTT_TOPIC_MAX_LEN];  /* 遗嘱主题 */
-    char lwtMessage[MQTT_MESSAGE_MAX_LEN]; /* 遗嘱消息 */
+    char lwtMessage[MQTT_LWT_MSG_MAX_LEN]; /* 遗嘱消息 */
     MQTT_QoS_t lwtQos;                  /* 遗嘱QoS */
     uint8_t lwtRetain;                  /* 遗嘱保留标志 */
 } MQTT_ConnConfig_t;
@@ -194,7 +186,8 @@ typedef struct {
     
     /* 异步消息处理 */
     volatile uint8_t msgPending;        /* 消息待处理标志 */
-    uint8_t msgBuffer[512];             /* 消息缓冲区 */
+    volatile uint8_t ackPending;        /* 发布数据已发出, 还没收到 +MQTTPUB 应答 (超时后由接收中断清除) */
+    uint8_t msgBuffer[MQTT_RX_MSG_SIZE];    /* 消息缓冲区 */
     uint16_t msgLen;                    /* 消息长度 */
     
     /* 统计信息 */
@@ -302,6 +295,8 @@ void MQTT_SetOnError(void (*callback)(MQTT_Status_t error));
   * @brief  数据处理函数
   */
 void MQTT_ProcessData(void);
+uint8_t MQTT_ProcessPending(void);
+uint8_t MQTT_HasPending(void);
 void MQTT_ProcessMessage(const char *data, uint16_t len);
 
 /**
@@ -0,0 +1,184 @@
+/**
+  ******************************************************************************
+  * @file           : flicker.h
+  * @brief          : 光照闪烁(频闪)分析模块头文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 对光敏传感器通道进行高速采集并做实数FFT分析, 用于检测
+  * 100/120Hz 工频频闪以及镇流器故障引起的低频闪烁
+  *
+  * 工作流程:
+  *   1. TIM2 更新事件(TRGO) 以固定采样率触发 ADC3 转换
+  *   2. ADC3 通过 DMA2_Stream0 将一整块采样写入缓冲区
+  *   3. 主循环中调用 Flicker_Process() 完成计算:
+  *      - arm_cfft_f32 原地变换 + 拆分求实数序列的幅值谱
+  *      - 提取闪烁频率、闪烁百分比(Percent Flicker)、闪烁指数(Flicker Index)
+  *   4. 只通过MQTT发布特征值, 不发送原始采样
+  *
+  * 采集期间 ADC3 被切换为定时器触发模式, 光敏传感器轮询读取会返回
+  * LIGHT_SENSOR_BUSY, 分析完成后自动恢复为软件触发模式
+  *
+  * FFT耗时使用 DWT 周期计数器测量
+  *
+  ******************************************************************************
+  */
+
+#ifndef __FLICKER_H
+#define __FLICKER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "adc.h"
+#include "log.h"
+#include "mem_config.h"
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 闪烁分析开关 FLICKER_ENABLE 见 mem_config.h */
+
+/* 默认采样参数 (可通过 Flicker_Config() 运行时修改) */
+#define FLICKER_DEFAULT_SAMPLE_RATE_HZ  4000    /* 默认采样率 (Hz) */
+#define FLICKER_DEFAULT_BLOCK_SIZE      FLICKER_MAX_BLOCK_SIZE  /* 默认FFT点数 */
+
+/* 采样参数范围 */
+#define FLICKER_MIN_SAMPLE_RATE_HZ      1000    /* 最低采样率 (Hz) */
+#define FLICKER_MAX_SAMPLE_RATE_HZ      20000   /* 最高采样率 (Hz) */
+#define FLICKER_MIN_BLOCK_SIZE          64      /* 最小FFT点数 */
+/* 最大FFT点数 FLICKER_MAX_BLOCK_SIZE 见 mem_config.h */
+
+/* 频谱峰值搜索下限 (Hz), 低于此频率视为环境光缓慢变化 */
+#define FLICKER_MIN_FREQ_HZ             20
+
+/* 分析周期 (ms) */
+#define FLICKER_CAPTURE_PERIOD_MS       60000
+
+/* 采集超时 (ms) */
+#define FLICKER_CAPTURE_TIMEOUT_MS      2000
+
+/* 调试开关 */
+#define FLICKER_DEBUG_ENABLE            0
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  闪烁分析状态枚举
+  */
+typedef enum {
+    FLICKER_OK = 0,                     /* 操作成功 */
+    FLICKER_ERROR,                      /* 一般错误 */
+    FLICKER_BUSY,                       /* 正在采集 */
+    FLICKER_NOT_READY,                  /* 采集未完成 */
+    FLICKER_TIMEOUT,                    /* 采集超时 */
+    FLICKER_INVALID_PARAM               /* 无效参数 */
+} Flicker_Status_t;
+
+/**
+  * @brief  采集状态枚举
+  */
+typedef enum {
+    FLICKER_STATE_IDLE = 0,             /* 空闲 */
+    FLICKER_STATE_CAPTURING,            /* DMA采集中 */
+    FLICKER_STATE_CAPTURED              /* 采集完成, 等待分析 */
+} Flicker_State_t;
+
+/**
+  * @brief  闪烁分析结果
+  */
+typedef struct {
+    float frequency;                    /* 主闪烁频率 (Hz) */
+    float percent;                      /* 闪烁百分比 (0-100%) */
+    float index;                        /* 闪烁指数 (0-1) */
+    float mean;                         /* 平均光强 (ADC值, 已反转为越大越亮) */
+    uint16_t min;                       /* 最小光强 */
+    uint16_t max;                       /* 最大光强 */
+    uint16_t sampleRate;                /* 本次采样率 (Hz) */
+    uint16_t blockSize;                 /* 本次FFT点数 */
+    uint32_t fftCycles;                 /* FFT+求模耗时 (CPU周期) */
+    uint32_t timestamp;                 /* 分析完成时间 (ms) */
+} Flicker_Result_t;
+
+/**
+  * @brief  闪烁分析句柄
+  */
+typedef struct {
+    ADC_HandleTypeDef *hadc;            /* ADC句柄 */
+    volatile Flicker_State_t state;     /* 采集状态 */
+    uint16_t sampleRate;                /* 采样率 (Hz) */
+    uint16_t blockSize;                 /* FFT点数 */
+    uint32_t captureStart;              /* 采集开始时间 (ms) */
+    Flicker_Result_t result;            /* 最近一次分析结果 */
+    uint8_t resultValid;                /* 结果有效标志 */
+    uint8_t initialized;                /* 初始化标志 */
+} Flicker_Handle_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern Flicker_Handle_t flicker;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  初始化闪烁分析模块 (默认采样参数)
+  * @retval Flicker_Status_t
+  */
+Flicker_Status_t Flicker_Init(void);
+
+/**
+  * @brief  配置采样参数
+  * @param  sampleRate: 采样率 (Hz), 范围 FLICKER_MIN_SAMPLE_RATE_HZ ~ FLICKER_MAX_SAMPLE_RATE_HZ
+  * @param  blockSize: FFT点数, 64/128/256/512/1024 (不超过 FLICKER_MAX_BLOCK_SIZE)
+  * @retval Flicker_Status_t
+  */
+Flicker_Status_t Flicker_Config(uint16_t sampleRate, uint16_t blockSize);
+
+/**
+  * @brief  启动一次高速采集 (非阻塞)
+  * @retval Flicker_Status_t
+  */
+Flicker_Status_t Flicker_StartCapture(void);
+
+/**
+  * @brief  处理采集结果 (在主循环中调用)
+  * @param  result: 结果输出指针 (可为NULL)
+  * @retval FLICKER_OK=本次完成了一次分析, FLICKER_NOT_READY=无新数据
+  */
+Flicker_Status_t Flicker_Process(Flicker_Result_t *result);
+
+/**
+  * @brief  获取最近一次分析结果
+  * @param  result: 结果输出指针
+  * @retval Flicker_Status_t
+  */
+Flicker_Status_t Flicker_GetResult(Flicker_Result_t *result);
+
+/**
+  * @brief  将分析结果格式化为JSON
+  * @param  result: 分析结果
+  * @param  buf: 输出缓冲区
+  * @param  size: 缓冲区大小
+  * @retval 写入长度
+  */
+int Flicker_FormatJson(const Flicker_Result_t *result, char *buf, uint16_t size);
+
+/**
+  * @brief  检查是否正在采集
+  * @retval 1:采集中 0:空闲
+  */
+uint8_t Flicker_IsBusy(void);
+
+/**
+  * @brief  ADC转换完成处理 (由HAL_ADC_ConvCpltCallback调用)
+  * @param  hadc: ADC句柄
+  */
+void Flicker_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FLICKER_H */
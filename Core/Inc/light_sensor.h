@@ -35,15 +35,19 @@ extern "C" {
 #include "main.h"
 #include "adc.h"
 #include "log.h"
+#include "chip_sensor.h"
 
 /* Exported defines ----------------------------------------------------------*/
 
 /* 调试开关 */
 #define LIGHT_SENSOR_DEBUG_ENABLE   0
 
-/* ADC参考电压 (mV) */
+/* ADC参考电压 (mV), 即标称VDDA */
 #define LIGHT_SENSOR_VREF_MV        3300
 
+/* VDDA比例修正开关 (1:用ADC1测得的VDDA修正读数 0:按标称3.3V计算) */
+#define LIGHT_SENSOR_VDDA_COMPENSATION  1
+
 /* ADC分辨率 */
 #define LIGHT_SENSOR_ADC_MAX        4095    /* 12位ADC */
 
@@ -63,7 +67,8 @@ typedef enum {
     LIGHT_SENSOR_ERROR,             /**< 通用错误 */
     LIGHT_SENSOR_NOT_INITIALIZED,   /**< 未初始化 */
     LIGHT_SENSOR_TIMEOUT,           /**< 操作超时 */
-    LIGHT_SENSOR_DMA_ERROR          /**< DMA错误 */
+    LIGHT_SENSOR_DMA_ERROR,         /**< DMA错误 */
+    LIGHT_SENSOR_BUSY               /**< ADC被高速采集占用 */
 } LightSensor_Status_t;
 
 /**
@@ -82,11 +87,13 @@ typedef enum {
   */
 typedef struct {
     ADC_HandleTypeDef *hadc;        /**< ADC句柄指针 */
-    uint16_t current_value;         /**< 当前ADC值 */
+    uint16_t current_value;         /**< 当前ADC值 (已做VDDA比例修正) */
+    uint16_t raw_value;             /**< 未修正的ADC原始值 */
+    uint16_t vdda_mV;               /**< 本次读取时的VDDA (mV) */
     uint16_t filtered_value;        /**< 滤波后的ADC值 */
     uint32_t last_update_tick;      /**< 最后更新时间 */
     uint8_t is_initialized;         /**< 初始化标志 */
-    uint8_t dma_running;            /**< DMA运行标志 (保留) */
+    uint8_t dma_running;            /**< DMA运行标志 (高速采集占用ADC时置1) */
     uint8_t conversion_complete;    /**< 转换完成标志 */
 } LightSensor_Handle_t;
 
@@ -119,6 +126,12 @@ uint16_t LightSensor_GetValue(void);
   */
 uint8_t LightSensor_GetPercent(void);
 
+/**
+  * @brief  获取未经VDDA修正的ADC原始值 (不触发读取)
+  * @retval uint16_t ADC原始值
+  */
+uint16_t LightSensor_GetRawValue(void);
+
 /**
   * @brief  获取电压值 (毫伏)
   * @retval uint32_t 电压值 (mV)
@@ -3,7 +3,7 @@
   * @file           : log.h
   * @brief          : 统一日志库头文件
   * @author         : Antigravity AI
-  * @version        : V1.0.0
+  * @version        : V1.4.0
   ******************************************************************************
   * @attention
   *
@@ -14,17 +14,26 @@
   *   - 模块标签输出
   *   - 时间戳支持
   *   - 全局开关控制
+  *   - 按标签设置运行时级别 (可通过MQTT下发), 先判断级别再格式化
   *   - 单独模块调试开关
+  *   - DMA异步发送: 日志先写入环形缓冲区立即返回, 由USART TX DMA在后台发出
+  *     (多生产者无锁入队, 主循环与中断均可调用; 缓冲区满时丢弃整条并计数)
+  *   - 可插拔出口 (sink): 每条日志只格式化一次, 分发给各出口, 每个出口
+  *     有独立的级别和开关; 内置串口出口与RAM出口, MQTT出口见 log_mqtt.h
   *
   * 使用方法:
   *   1. 包含此头文件: #include "log.h"
-  *   2. 初始化日志: LOG_Init(&huart1);
+  *   2. 初始化日志: LOG_Init(&huart1);  (UART已链接TX DMA时自动启用异步发送)
   *   3. 使用日志宏:
   *      LOG_E("TAG", "Error message: %d", errorCode);
   *      LOG_W("TAG", "Warning message");
   *      LOG_I("TAG", "Info message");
   *      LOG_D("TAG", "Debug message");
   *      LOG_V("TAG", "Verbose message");
+  *   4. 故障路径 (关中断后) 调用 LOG_Flush() 以阻塞方式发出缓冲区剩余内容
+  *   5. 高频日志可改用令牌化宏 LOG_TE/TW/TI/TD/TV (参数相同):
+  *      格式串放入 .logfmt 段, 运行时只写入 格式串地址 + 时间戳 + 参数字,
+  *      不做任何格式化, 由主机端 Tools/log_decode.py 结合ELF还原文本
   *
   ******************************************************************************
   */
@@ -38,9 +47,12 @@ extern "C" {
 
 /* Includes ------------------------------------------------------------------*/
 #include "usart.h"
+#include "atomic_ops.h"
+#include "mem_config.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdint.h>
 
 /* Exported defines ----------------------------------------------------------*/
 
@@ -55,16 +67,41 @@ extern "C" {
 #define LOG_LEVEL_DEBUG                 4   /* 错误 + 警告 + 信息 + 调试 */
 #define LOG_LEVEL_VERBOSE               5   /* 所有日志 */
 
-/* 当前日志级别 (可在此处修改默认级别) */
+/* 编译期级别下限: 高于此级别 (更详细) 的调用点整体编译掉, 运行时也无法打开
+ * 运行时全局级别的默认值也取此值 */
 #define LOG_LEVEL                       LOG_LEVEL_DEBUG
 
+/* 标签级别取此值时跟随全局级别 */
+#define LOG_LEVEL_DEFAULT               0xFF
+
+/* 标签表容量 / 标签名最大长度 */
+#define LOG_MAX_TAGS                    24
+#define LOG_TAG_NAME_LEN                12
+
 /* 日志选项 */
 #define LOG_COLOR_ENABLE                1   /* 启用颜色输出 (仅支持ANSI终端) */
 #define LOG_TIMESTAMP_ENABLE            1   /* 启用时间戳 */
 #define LOG_NEWLINE_AUTO                1   /* 自动添加换行符 */
 
-/* 日志缓冲区大小 */
-#define LOG_BUFFER_SIZE                 256
+/* 日志缓冲区 / 异步发送环形缓冲区 / RAM出口 / 令牌帧的大小见 mem_config.h */
+
+/* 日志出口表容量 */
+#define LOG_MAX_SINKS                   4
+
+/* 内置RAM出口: 保留最近的纯文本日志 */
+#define LOG_RAM_SINK_LEVEL              LOG_LEVEL_INFO
+
+/* 令牌化日志 (1:开启 0:LOG_Tx 宏退化为普通文本日志)
+ * 令牌是32位格式串地址, 64位主机构建由编译选项置0 */
+#ifndef LOG_TOKEN_ENABLE
+#define LOG_TOKEN_ENABLE                1
+#endif
+
+/* 令牌化日志: 单条最多参数个数 */
+#define LOG_TOKEN_MAX_ARGS              8
+
+/* 令牌化日志帧同步字节 (不会出现在ASCII/UTF-8文本中) */
+#define LOG_TOKEN_SYNC                  0xFE
 
 /* ANSI颜色码 */
 #if LOG_COLOR_ENABLE
@@ -92,14 +129,91 @@ extern "C" {
 
 /* Exported types ------------------------------------------------------------*/
 
+/**
+  * @brief  标签级别
+  */
+typedef struct {
+    char name[LOG_TAG_NAME_LEN];        /* 标签名 */
+    volatile uint8_t level;             /* 级别, LOG_LEVEL_DEFAULT=跟随全局 */
+} LOG_Tag_t;
+
+/**
+  * @brief  日志记录类型
+  */
+typedef enum {
+    LOG_RECORD_TEXT = 0,                /* LOG_x 宏输出 */
+    LOG_RECORD_RAW,                     /* LOG_Raw / 模块调试打印, 按 DEBUG 级别分发 */
+    LOG_RECORD_TOKEN                    /* 令牌化日志二进制帧 */
+} LOG_RecordType_t;
+
+/**
+  * @brief  分发给出口的一条日志 (只在 write 回调期间有效)
+  */
+typedef struct {
+    uint8_t type;                       /* LOG_RecordType_t */
+    uint8_t level;                      /* 日志级别 */
+    const char *tag;                    /* 标签, RAW/TOKEN 为NULL */
+    uint32_t timestamp;                 /* 时间戳 (ms) */
+    const char *message;                /* 用户消息, 不含前缀/颜色/换行, TOKEN 为NULL */
+    uint16_t messageLen;                /* 用户消息长度 */
+    const uint8_t *data;                /* 串口格式的完整输出 (TOKEN 为二进制帧) */
+    uint16_t len;                       /* 完整输出长度 */
+} LOG_Record_t;
+
+/**
+  * @brief  令牌化日志中用 LOG_STR() 标记的字符串参数 (调用点栈上, 每条日志一份)
+  */
+typedef struct {
+    uint8_t count;                      /* 已标记个数 */
+    const char *str[LOG_TOKEN_MAX_ARGS];    /* 标记的字符串 */
+} LOG_TokenStrs_t;
+
+/* 出口标志: 接收令牌化日志帧 (只有主机端能解码的出口才设置) */
+#define LOG_SINK_BINARY                 0x01
+
+/**
+  * @brief  日志出口
+  * @note   write 可能在中断中被调用, 不得阻塞, 也不得再调用日志接口
+  */
+typedef struct {
+    const char *name;                   /* 出口名称 */
+    void (*write)(const LOG_Record_t *record);  /* 写入回调 */
+    uint8_t level;                      /* 出口级别, 只接收不高于此级别的日志 */
+    uint8_t flags;                      /* LOG_SINK_xxx */
+    uint8_t enabled;                    /* 开关 */
+} LOG_Sink_t;
+
+/**
+  * @brief  日志统计
+  */
+typedef struct {
+    uint32_t droppedLines;              /* 因缓冲区满丢弃的条数 */
+    uint32_t droppedBytes;              /* 因缓冲区满丢弃的字节数 */
+    uint32_t peakUsage;                 /* 缓冲区最高占用 (字节) */
+    uint32_t dmaTransfers;              /* 启动的DMA发送次数 */
+} LOG_Stats_t;
+
 /**
   * @brief  日志句柄结构
+  * @note   环形缓冲区索引均为自由递增的32位计数, 取模后定位:
+  *         tail <= commitHead <= reserveHead
+  *         [tail, commitHead)        已提交, 等待/正在DMA发送
+  *         [commitHead, reserveHead) 已预留, 生产者正在拷贝
   */
 typedef struct {
     UART_HandleTypeDef *huart;          /* 日志输出UART */
     uint8_t initialized;                /* 初始化标志 */
     uint8_t enabled;                    /* 全局使能标志 */
     uint8_t level;                      /* 当前日志级别 */
+    uint8_t async;                      /* 1=DMA异步发送 0=阻塞发送 */
+    uint8_t sinkLevel;                  /* 已启用出口中的最高级别, 高于此级别不格式化 */
+    volatile uint32_t reserveHead;      /* 生产者预留位置 */
+    volatile uint32_t commitHead;       /* 已提交位置 */
+    volatile uint32_t tail;             /* DMA已发送位置 */
+    volatile uint32_t writers;          /* 正在写入的生产者数 (中断嵌套深度) */
+    volatile uint32_t txBusy;           /* DMA发送中 */
+    volatile uint32_t txLen;            /* 本次DMA发送长度 */
+    LOG_Stats_t stats;                  /* 统计 */
 } LOG_Handle_t;
 
 /* Exported variables --------------------------------------------------------*/
@@ -146,6 +260,71 @@ void LOG_SetEnable(uint8_t enable);
   */
 uint8_t LOG_IsEnabled(void);
 
+/**
+  * @brief  查找标签, 不存在时注册 (跟随全局级别)
+  * @param  tag: 标签名
+  * @retval 标签指针, 标签表已满时返回NULL
+  */
+LOG_Tag_t *LOG_TagGet(const char *tag);
+
+/**
+  * @brief  设置标签级别
+  * @param  tag: 标签名, "*" 表示全局级别
+  * @param  level: 日志级别, LOG_LEVEL_DEFAULT=跟随全局
+  * @retval 1=成功 0=参数无效或标签表已满
+  */
+uint8_t LOG_SetTagLevel(const char *tag, uint8_t level);
+
+/**
+  * @brief  获取标签的生效级别
+  * @param  tag: 标签名
+  * @retval 生效级别 (未设置时为全局级别)
+  */
+uint8_t LOG_GetTagLevel(const char *tag);
+
+/**
+  * @brief  按JSON批量设置级别 (通常来自MQTT)
+  * @note   格式 {"*":"info","ESP8266":4,"MQTT":"debug","DHT11":"default"}
+  *         值可为数字0~5或 none/error/warn/info/debug/verbose/default
+  * @param  json: JSON字符串
+  * @retval 成功设置的项数, -1=格式错误
+  */
+int LOG_SetLevels(const char *json);
+
+/**
+  * @brief  把全局及各标签的生效级别编码为JSON
+  * @note   格式 {"*":3,"ESP8266":4,...}
+  * @param  buf: 输出缓冲区
+  * @param  size: 缓冲区大小
+  * @retval 长度
+  */
+int LOG_FormatLevels(char *buf, uint16_t size);
+
+/**
+  * @brief  判断标签在某级别是否输出 (首次调用后只需一次比较)
+  * @param  cache: 调用点缓存的标签指针 (静态变量, 初始为NULL)
+  * @param  tag: 标签名
+  * @param  level: 日志级别
+  * @retval 1=输出 0=丢弃
+  */
+static inline uint8_t LOG_TagEnabled(LOG_Tag_t **cache, const char *tag, uint8_t level)
+{
+    uint8_t tagLevel;
+    
+    if (*cache == NULL) {
+        *cache = LOG_TagGet(tag);
+        if (*cache == NULL) {
+            return (level <= logHandle.level);
+        }
+    }
+    
+    tagLevel = (*cache)->level;
+    if (tagLevel == LOG_LEVEL_DEFAULT) {
+        tagLevel = logHandle.level;
+    }
+    return (level <= tagLevel);
+}
+
 /**
   * @brief  格式化日志输出 (底层函数)
   * @param  level: 日志级别
@@ -154,6 +333,7 @@ uint8_t LOG_IsEnabled(void);
   * @param  tag: 模块标签
   * @param  format: 格式化字符串
   * @param  ...: 可变参数
+  * @note   不再判断级别, 由 LOG_x 宏先判断, 避免无效格式化
   * @retval None
   */
 void LOG_Print(uint8_t level, const char *color, const char *prefix, 
@@ -167,6 +347,104 @@ void LOG_Print(uint8_t level, const char *color, const char *prefix,
   */
 void LOG_Raw(const char *format, ...);
 
+/**
+  * @brief  原始输出 (va_list版本, 供各模块调试打印函数转发)
+  * @param  format: 格式化字符串
+  * @param  args: 参数列表
+  * @retval None
+  */
+void LOG_VRaw(const char *format, va_list args);
+
+/**
+  * @brief  写入原始字节到串口出口 (不格式化, 不加前缀, 不经过其他出口)
+  * @param  data: 数据指针
+  * @param  len: 数据长度
+  * @retval 1=已写入 0=缓冲区满被丢弃或未初始化
+  */
+uint8_t LOG_Write(const uint8_t *data, uint16_t len);
+
+/**
+  * @brief  写入一条令牌化日志 (由 LOG_Tx 宏判断级别后调用)
+  * @param  level: 日志级别
+  * @param  token: 格式串记录地址 (仅作为ID, 不会被读取)
+  * @param  nargs: 参数个数
+  * @param  args: 参数字
+  * @param  strs: LOG_STR() 标记的字符串, 只有其中指向RAM的随帧发送内容
+  * @retval None
+  */
+void LOG_Token(uint8_t level, const char *token, uint8_t nargs, const uint32_t *args,
+               const LOG_TokenStrs_t *strs);
+
+/**
+  * @brief  阻塞发出缓冲区中所有已提交的日志
+  * @note   用于故障路径 (Error_Handler / HardFault), 关中断时也可调用
+  * @retval None
+  */
+void LOG_Flush(void);
+
+/**
+  * @brief  获取日志统计
+  * @param  stats: 输出指针
+  * @retval None
+  */
+void LOG_GetStats(LOG_Stats_t *stats);
+
+/**
+  * @brief  注册日志出口 (在 LOG_Init 之后调用)
+  * @param  sink: 出口描述, 须在整个运行期间有效
+  * @retval 1=成功 0=出口表已满或参数无效
+  */
+uint8_t LOG_AddSink(LOG_Sink_t *sink);
+
+/**
+  * @brief  设置出口级别
+  * @param  name: 出口名称 ("uart" / "ram" / "mqtt")
+  * @param  level: 级别
+  * @retval 1=成功 0=出口不存在
+  */
+uint8_t LOG_SetSinkLevel(const char *name, uint8_t level);
+
+/**
+  * @brief  开关出口
+  * @param  name: 出口名称
+  * @param  enable: 1=开启 0=关闭
+  * @retval 1=成功 0=出口不存在
+  */
+uint8_t LOG_SetSinkEnable(const char *name, uint8_t enable);
+
+/**
+  * @brief  把一条日志格式化为不带颜色的单行文本 "[时间戳] I/TAG: 消息"
+  * @param  record: 日志记录 (TOKEN 类型不支持)
+  * @param  buf: 输出缓冲区
+  * @param  size: 缓冲区大小
+  * @retval 长度 (不含结束符), 不含换行
+  */
+int LOG_FormatRecord(const LOG_Record_t *record, char *buf, uint16_t size);
+
+/**
+  * @brief  读取RAM出口中最近的日志
+  * @param  dst: 输出缓冲区
+  * @param  size: 最多读取的字节数
+  * @retval 实际读取的字节数
+  */
+uint16_t LOG_RamRead(uint8_t *dst, uint16_t size);
+
+/**
+  * @brief  拷贝缓冲区中最近写入的日志 (无论是否已发出)
+  * @param  dst: 输出缓冲区
+  * @param  size: 最多拷贝的字节数
+  * @retval 实际拷贝的字节数
+  * @note   不加锁, 供故障路径保存现场使用
+  */
+uint16_t LOG_CopyTail(uint8_t *dst, uint16_t size);
+
+/**
+  * @brief  UART发送完成回调 (由 HAL_UART_TxCpltCallback 转发)
+  * @param  huart: 触发回调的UART句柄
+  * @retval None
+  */
+void LOG_TxCpltCallback(UART_HandleTypeDef *huart);
+
 /**
   * @brief  输出十六进制数据
   * @param  tag: 模块标签
@@ -180,10 +458,18 @@ void LOG_HexDump(const char *tag, const uint8_t *data, uint16_t len);
 
 #if LOG_ENABLE
 
+/* 先按标签级别判断, 关闭时不做格式化 */
+#define LOG_AT(level, color, prefix, tag, fmt, ...) do { \
+        static LOG_Tag_t *logTagCache; \
+        if (LOG_TagEnabled(&logTagCache, tag, level)) { \
+            LOG_Print(level, color, prefix, tag, fmt, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
 /* 错误日志 */
 #if (LOG_LEVEL >= LOG_LEVEL_ERROR)
     #define LOG_E(tag, fmt, ...) \
-        LOG_Print(LOG_LEVEL_ERROR, LOG_COLOR_RED, LOG_PREFIX_ERROR, tag, fmt, ##__VA_ARGS__)
+        LOG_AT(LOG_LEVEL_ERROR, LOG_COLOR_RED, LOG_PREFIX_ERROR, tag, fmt, ##__VA_ARGS__)
 #else
     #define LOG_E(tag, fmt, ...) ((void)0)
 #endif
@@ -191,7 +477,7 @@ void LOG_HexDump(const char *tag, const uint8_t *data, uint16_t len);
 /* 警告日志 */
 #if (LOG_LEVEL >= LOG_LEVEL_WARN)
     #define LOG_W(tag, fmt, ...) \
-        LOG_Print(LOG_LEVEL_WARN, LOG_COLOR_YELLOW, LOG_PREFIX_WARN, tag, fmt, ##__VA_ARGS__)
+        LOG_AT(LOG_LEVEL_WARN, LOG_COLOR_YELLOW, LOG_PREFIX_WARN, tag, fmt, ##__VA_ARGS__)
 #else
     #define LOG_W(tag, fmt, ...) ((void)0)
 #endif
@@ -199,7 +485,7 @@ void LOG_HexDump(const char *tag, const uint8_t *data, uint16_t len);
 /* 信息日志 */
 #if (LOG_LEVEL >= LOG_LEVEL_INFO)
     #define LOG_I(tag, fmt, ...) \
-        LOG_Print(LOG_LEVEL_INFO, LOG_COLOR_GREEN, LOG_PREFIX_INFO, tag, fmt, ##__VA_ARGS__)
+        LOG_AT(LOG_LEVEL_INFO, LOG_COLOR_GREEN, LOG_PREFIX_INFO, tag, fmt, ##__VA_ARGS__)
 #else
     #define LOG_I(tag, fmt, ...) ((void)0)
 #endif
@@ -207,7 +493,7 @@ void LOG_HexDump(const char *tag, const uint8_t *data, uint16_t len);
 /* 调试日志 */
 #if (LOG_LEVEL >= LOG_LEVEL_DEBUG)
     #define LOG_D(tag, fmt, ...) \
-        LOG_Print(LOG_LEVEL_DEBUG, LOG_COLOR_CYAN, LOG_PREFIX_DEBUG, tag, fmt, ##__VA_ARGS__)
+        LOG_AT(LOG_LEVEL_DEBUG, LOG_COLOR_CYAN, LOG_PREFIX_DEBUG, tag, fmt, ##__VA_ARGS__)
 #else
     #define LOG_D(tag, fmt, ...) ((void)0)
 #endif
@@ -215,7 +501,7 @@ void LOG_HexDump(const char *tag, const uint8_t *data, uint16_t len);
 /* 详细日志 */
 #if (LOG_LEVEL >= LOG_LEVEL_VERBOSE)
     #define LOG_V(tag, fmt, ...) \
-        LOG_Print(LOG_LEVEL_VERBOSE, LOG_COLOR_WHITE, LOG_PREFIX_VERBOSE, tag, fmt, ##__VA_ARGS__)
+        LOG_AT(LOG_LEVEL_VERBOSE, LOG_COLOR_WHITE, LOG_PREFIX_VERBOSE, tag, fmt, ##__VA_ARGS__)
 #else
     #define LOG_V(tag, fmt, ...) ((void)0)
 #endif
@@ -230,6 +516,127 @@ void LOG_HexDump(const char *tag, const uint8_t *data, uint16_t len);
 
 #endif /* LOG_ENABLE */
 
+/* ========================= 令牌化日志 ========================= */
+
+/*
+ * 帧格式 (小端):
+ *   0xFE | len(1) | token(4) | timestamp(4) | nargs(1) | strMask(1) | args(4 x nargs) | 字符串...
+ *   len     : len 字段之后的字节数
+ *   token   : 格式串记录地址, 记录内容为 "级别字母\x1f标签\x1f格式串"
+ *   strMask : 第i位置1表示第i个参数是 LOG_STR() 标记的RAM字符串, 其内容以 长度(1)+内容
+ *             附在帧尾 (指向Flash的字符串由解码器直接从ELF读取)
+ *
+ * 参数一律按32位字传递: 整数/指针/字符直接传入; 浮点数用 LOG_FLOAT(x) 包装;
+ * RAM中的 %s 字符串用 LOG_STR(s) 标记, 未标记的参数即使数值落在RAM地址范围内
+ * 也只发送数值本身, 不会读取该地址
+ * 标签和格式串必须是字符串字面量
+ */
+
+#if LOG_TOKEN_ENABLE
+
+/* 格式串记录所在段: 不下载到Flash, 只留在ELF中供解码器查表
+ * (GCC 链接脚本标记为 (INFO), Keil 见 MDK-ARM/two.sct 的 LR_LOGFMT) */
+#define LOG_TOKEN_SECTION       __attribute__((section(".logfmt")))
+
+/* 浮点参数: 传递 float 的位模式 */
+#define LOG_FLOAT(x)            LOG_FloatBits((float)(x))
+
+static inline uint32_t LOG_FloatBits(float value)
+{
+    union { float f; uint32_t u; } bits;
+    bits.f = value;
+    return bits.u;
+}
+
+/* 字符串参数: 记入本条日志的标记表 (只能用在 LOG_Tx 的参数中) */
+#define LOG_STR(s)              LOG_TokenStr(&logTokenStrs, (s))
+
+static inline uint32_t LOG_TokenStr(LOG_TokenStrs_t *strs, const char *str)
+{
+    if (strs->count < LOG_TOKEN_MAX_ARGS) {
+        strs->str[strs->count++] = str;
+    }
+    return (uint32_t)(uintptr_t)str;
+}
+
+/* 参数个数 (0~8) */
+#define LOG_TOKEN_NARGS(...) \
+    LOG_TOKEN_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_TOKEN_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+
+/* 逐个参数转为32位字 */
+#define LOG_TOKEN_WORD(x)       ((uint32_t)(uintptr_t)(x))
+#define LOG_TOKEN_W0()
+#define LOG_TOKEN_W1(a)                         LOG_TOKEN_WORD(a)
+#define LOG_TOKEN_W2(a, b)                      LOG_TOKEN_W1(a), LOG_TOKEN_WORD(b)
+#define LOG_TOKEN_W3(a, b, c)                   LOG_TOKEN_W2(a, b), LOG_TOKEN_WORD(c)
+#define LOG_TOKEN_W4(a, b, c, d)                LOG_TOKEN_W3(a, b, c), LOG_TOKEN_WORD(d)
+#define LOG_TOKEN_W5(a, b, c, d, e)             LOG_TOKEN_W4(a, b, c, d), LOG_TOKEN_WORD(e)
+#define LOG_TOKEN_W6(a, b, c, d, e, f)          LOG_TOKEN_W5(a, b, c, d, e), LOG_TOKEN_WORD(f)
+#define LOG_TOKEN_W7(a, b, c, d, e, f, g)       LOG_TOKEN_W6(a, b, c, d, e, f), LOG_TOKEN_WORD(g)
+#define LOG_TOKEN_W8(a, b, c, d, e, f, g, h)    LOG_TOKEN_W7(a, b, c, d, e, f, g), LOG_TOKEN_WORD(h)
+#define LOG_TOKEN_CAT(a, b)     LOG_TOKEN_CAT_(a, b)
+#define LOG_TOKEN_CAT_(a, b)    a##b
+#define LOG_TOKEN_WORDS(...) \
+    LOG_TOKEN_CAT(LOG_TOKEN_W, LOG_TOKEN_NARGS(__VA_ARGS__))(__VA_ARGS__)
+
+#define LOG_TOKEN(level, letter, tag, fmt, ...) do { \
+        static const char LOG_TOKEN_SECTION logTokenFmt[] = letter "\x1f" tag "\x1f" fmt; \
+        static LOG_Tag_t *logTagCache; \
+        if (LOG_TagEnabled(&logTagCache, tag, level)) { \
+            LOG_TokenStrs_t logTokenStrs; \
+            logTokenStrs.count = 0; \
+            { \
+                const uint32_t logTokenArgs[] = { 0, LOG_TOKEN_WORDS(__VA_ARGS__) }; \
+                LOG_Token(level, logTokenFmt, LOG_TOKEN_NARGS(__VA_ARGS__), &logTokenArgs[1], \
+                          &logTokenStrs); \
+            } \
+        } \
+    } while (0)
+
+#if LOG_ENABLE && (LOG_LEVEL >= LOG_LEVEL_ERROR)
+    #define LOG_TE(tag, fmt, ...)   LOG_TOKEN(LOG_LEVEL_ERROR, "E", tag, fmt, ##__VA_ARGS__)
+#else
+    #define LOG_TE(tag, fmt, ...)   ((void)0)
+#endif
+
+#if LOG_ENABLE && (LOG_LEVEL >= LOG_LEVEL_WARN)
+    #define LOG_TW(tag, fmt, ...)   LOG_TOKEN(LOG_LEVEL_WARN, "W", tag, fmt, ##__VA_ARGS__)
+#else
+    #define LOG_TW(tag, fmt, ...)   ((void)0)
+#endif
+
+#if LOG_ENABLE && (LOG_LEVEL >= LOG_LEVEL_INFO)
+    #define LOG_TI(tag, fmt, ...)   LOG_TOKEN(LOG_LEVEL_INFO, "I", tag, fmt, ##__VA_ARGS__)
+#else
+    #define LOG_TI(tag, fmt, ...)   ((void)0)
+#endif
+
+#if LOG_ENABLE && (LOG_LEVEL >= LOG_LEVEL_DEBUG)
+    #define LOG_TD(tag, fmt, ...)   LOG_TOKEN(LOG_LEVEL_DEBUG, "D", tag, fmt, ##__VA_ARGS__)
+#else
+    #define LOG_TD(tag, fmt, ...)   ((void)0)
+#endif
+
+#if LOG_ENABLE && (LOG_LEVEL >= LOG_LEVEL_VERBOSE)
+    #define LOG_TV(tag, fmt, ...)   LOG_TOKEN(LOG_LEVEL_VERBOSE, "V", tag, fmt, ##__VA_ARGS__)
+#else
+    #define LOG_TV(tag, fmt, ...)   ((void)0)
+#endif
+
+#else /* LOG_TOKEN_ENABLE == 0 */
+
+/* 退化为文本日志, 调用处无需修改 */
+#define LOG_FLOAT(x)            ((double)(x))
+#define LOG_STR(s)              (s)
+#define LOG_TE                  LOG_E
+#define LOG_TW                  LOG_W
+#define LOG_TI                  LOG_I
+#define LOG_TD                  LOG_D
+#define LOG_TV                  LOG_V
+
+#endif /* LOG_TOKEN_ENABLE */
+
 #ifdef __cplusplus
 }
 #endif
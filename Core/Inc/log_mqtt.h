@@ -0,0 +1,137 @@
+/**
+  ******************************************************************************
+  * @file           : log_mqtt.h
+  * @brief          : MQTT日志出口头文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 现场节点没有串口线时通过 MQTT 取日志。日志不是逐条发布, 而是:
+  *   - 攒批: 纯文本行追加到批缓冲区, 到达发布间隔或占用超过阈值时
+  *           由主循环一次发布到 <client>/log (ERROR 级别提前发布)
+  *   - 去重: 与上一行 (标签+级别+消息) 相同时只计数, 以
+  *           "(repeated N times)" 后缀改写上一行
+  *   - 限速: 每个标签一个令牌桶, 超出的行丢弃并在批末尾汇总
+  *
+  * 发布失败时本批 (含丢弃汇总) 放回批缓冲区, LOG_MQTT_RETRY_MS 后重试。
+  *
+  * 出口回调只做内存拷贝, 发布只在 LogMqtt_Poll() 中进行; 发布期间
+  * MQTT/ESP8266 自身产生的日志不进入批缓冲区, 不会形成自激。
+  *
+  ******************************************************************************
+  */
+
+#ifndef __LOG_MQTT_H
+#define __LOG_MQTT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "log.h"
+#include "mem_config.h"
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 出口默认级别 */
+#define LOG_MQTT_LEVEL              LOG_LEVEL_INFO
+
+/* 提前发布阈值 (字节, 批缓冲区的2/3: 默认768字节时为512; 批缓冲区大小 LOG_MQTT_BATCH_SIZE 见 mem_config.h) */
+#define LOG_MQTT_FLUSH_THRESHOLD    (LOG_MQTT_BATCH_SIZE * 2 / 3)
+
+/* 发布间隔: 批中最早一行等待的最长时间 (ms) */
+#define LOG_MQTT_INTERVAL_MS        10000
+
+/* 发布失败后重试间隔 (ms), 期间批缓冲区保留 */
+#define LOG_MQTT_RETRY_MS           2000
+
+/* 每标签限速: 突发行数 / 每补充一行的间隔 (ms) */
+#define LOG_MQTT_RATE_BURST         5
+#define LOG_MQTT_RATE_REFILL_MS     2000
+
+/* 限速表容量 (超出的标签共用最后一项) */
+#define LOG_MQTT_MAX_TAGS           12
+
+/* 主题最大长度 */
+#define LOG_MQTT_TOPIC_LEN          64
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  MQTT日志出口统计
+  */
+typedef struct {
+    uint32_t lines;                 /**< 进入批缓冲区的行数 */
+    uint32_t repeats;               /**< 被去重合并的行数 */
+    uint32_t rateLimited;           /**< 被限速丢弃的行数 */
+    uint32_t overflow;              /**< 批缓冲区满丢弃的行数 */
+    uint32_t selfSuppressed;        /**< 发布期间被忽略的行数 */
+    uint32_t publishes;             /**< 发布次数 */
+    uint32_t publishFailures;       /**< 发布失败次数 */
+} LogMqtt_Stats_t;
+
+/**
+  * @brief  每标签限速状态
+  */
+typedef struct {
+    char tag[LOG_TAG_NAME_LEN];     /**< 标签名, 空串表示原始输出 */
+    uint8_t tokens;                 /**< 剩余令牌 */
+    uint32_t refillTick;            /**< 上次补充时间 */
+    uint16_t dropped;               /**< 本批中被丢弃的行数 */
+} LogMqtt_Bucket_t;
+
+/**
+  * @brief  MQTT日志出口句柄
+  */
+typedef struct {
+    LOG_Sink_t sink;                /**< 注册到日志库的出口 */
+    char topic[LOG_MQTT_TOPIC_LEN]; /**< 发布主题 */
+    char batch[LOG_MQTT_BATCH_SIZE];    /**< 批缓冲区 */
+    uint16_t batchLen;              /**< 批缓冲区已用长度 */
+    uint16_t lastLineStart;         /**< 上一行在批中的起始位置 */
+    uint16_t lastLineEnd;           /**< 上一行不含后缀的结束位置 */
+    uint32_t lastHash;              /**< 上一行的哈希 (去重) */
+    uint16_t repeatCount;           /**< 上一行的重复次数 */
+    uint16_t overflowLines;         /**< 本批溢出的行数 */
+    uint32_t firstLineTick;         /**< 批中最早一行的时间 */
+    uint8_t urgent;                 /**< 批中有 ERROR 级别日志 */
+    uint8_t retryPending;           /**< 上次发布失败, 等待重试 */
+    uint32_t retryTick;             /**< 上次发布失败的时间 */
+    volatile uint8_t publishing;    /**< 正在发布 (忽略新日志) */
+    LogMqtt_Bucket_t buckets[LOG_MQTT_MAX_TAGS];    /**< 限速表 */
+    uint8_t bucketCount;            /**< 限速表已用项数 */
+    LogMqtt_Stats_t stats;          /**< 统计 */
+    uint8_t initialized;            /**< 初始化标志 */
+} LogMqtt_Handle_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern LogMqtt_Handle_t logMqtt;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  初始化并注册MQTT日志出口
+  * @param  topic 发布主题, 如 "stm32/log"
+  * @retval uint8_t 1=成功 0=失败
+  */
+uint8_t LogMqtt_Init(const char *topic);
+
+/**
+  * @brief  到期时发布批缓冲区 (在主循环中调用, MQTT未连接时保留)
+  */
+void LogMqtt_Poll(void);
+
+/**
+  * @brief  获取统计
+  * @param  stats 输出指针
+  */
+void LogMqtt_GetStats(LogMqtt_Stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LOG_MQTT_H */
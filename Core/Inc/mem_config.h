@@ -0,0 +1,268 @@
+/**
+  ******************************************************************************
+  * @file           : mem_config.h
+  * @brief          : 内存预算配置 (各模块缓冲区大小)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 所有占用较大的静态缓冲区和临时缓冲区的大小集中在这里, 各模块头文件只引用。
+  * 每项都可以在编译选项中用 -D 覆盖。注释中标明缓冲区的位置: 常驻 (静态)、栈上或共享区。
+  *
+  * 临时缓冲区 (格式化AT命令、MQTT应答分块、收到的消息、FFT工作区等) 不再各自
+  * 静态分配或放在栈上, 而是在用到时从 scratch.h 的共享区按作用域申请,
+  * 用完释放。共享区大小取嵌套使用的峰值, 见 SCRATCH_SIZE。
+  *
+  * 默认值保持各功能原有的上限和保留时长 (主题/消息长度、接收缓冲区、时序保留、FFT点数等)。
+  * RAM 紧张时定义 MEM_PROFILE_LOW=1 选用缩小的一组 (静态区+栈+堆约减半, 代价见下方注释),
+  * 单项仍可以 -D 覆盖。
+  *
+  * 修改后用 Tools/ram_report.py 查看各模块的RAM占用 (主机构建会自动生成)。
+  *
+  ******************************************************************************
+  */
+
+#ifndef __MEM_CONFIG_H
+#define __MEM_CONFIG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 低内存配置 ----------------------------------------------------------------*/
+
+/* 1: 缩小下列缓冲区和保留时长. 主题/Broker地址 128->64, 发布消息 1024->512 (更长的被截断),
+ * 遗嘱消息 1024->128, 接收缓冲区 2048->1024, 时序保留 12小时->6小时, FFT 1024->512点,
+ * 日志缓冲/RAM出口/故障日志尾部减半. 栈不随之变化, 按目标板的栈分析另行调整启动文件 */
+#ifndef MEM_PROFILE_LOW
+#define MEM_PROFILE_LOW                 0
+#endif
+
+#if MEM_PROFILE_LOW
+#ifndef ESP8266_RX_BUF_SIZE
+#define ESP8266_RX_BUF_SIZE             1024
+#endif
+#ifndef ESP8266_TX_BUF_SIZE
+#define ESP8266_TX_BUF_SIZE             320
+#endif
+#ifndef MQTT_HOST_MAX_LEN
+#define MQTT_HOST_MAX_LEN               64
+#endif
+#ifndef MQTT_TOPIC_MAX_LEN
+#define MQTT_TOPIC_MAX_LEN              64
+#endif
+#ifndef MQTT_MESSAGE_MAX_LEN
+#define MQTT_MESSAGE_MAX_LEN            512
+#endif
+#ifndef MQTT_LWT_MSG_MAX_LEN
+#define MQTT_LWT_MSG_MAX_LEN            128
+#endif
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE                   2048
+#endif
+#ifndef LOG_RAM_SINK_SIZE
+#define LOG_RAM_SINK_SIZE               512
+#endif
+#ifndef LOG_MQTT_BATCH_SIZE
+#define LOG_MQTT_BATCH_SIZE             512
+#endif
+#ifndef CRASH_LOG_TAIL_SIZE
+#define CRASH_LOG_TAIL_SIZE             512
+#endif
+#ifndef TIMESERIES_RAW_SIZE
+#define TIMESERIES_RAW_SIZE             16
+#endif
+#ifndef TIMESERIES_TIER0_SIZE
+#define TIMESERIES_TIER0_SIZE           20
+#endif
+#ifndef TIMESERIES_TIER1_SIZE
+#define TIMESERIES_TIER1_SIZE           30
+#endif
+#ifndef TIMESERIES_TIER2_SIZE
+#define TIMESERIES_TIER2_SIZE           24
+#endif
+#ifndef FLICKER_MAX_BLOCK_SIZE
+#define FLICKER_MAX_BLOCK_SIZE          512
+#endif
+#endif /* MEM_PROFILE_LOW */
+
+/* ESP8266 -------------------------------------------------------------------*/
+
+/* DMA接收缓冲区与处理缓冲区 (各一份). 最长的常见应答是 +MQTTSUBRECV 消息
+ * 和 +CWLAP 扫描结果, 2KB 约容纳30个AP */
+#ifndef ESP8266_RX_BUF_SIZE
+#define ESP8266_RX_BUF_SIZE             2048
+#endif
+
+/* 格式化AT命令的临时缓冲区 (共享区). 最长的是带遗嘱主题和遗嘱消息的 MQTTCONNCFG,
+ * 其次是 MQTTUSERCFG (客户端ID/用户名/密码/路径各64字节时约300字节) */
+#ifndef ESP8266_TX_BUF_SIZE
+#define ESP8266_TX_BUF_SIZE             1024
+#endif
+
+/* DMA发送中转缓冲区 (常驻, SRAM). 待发送数据在CCM (栈上) 时分块复制到这里再发送,
+ * 取主循环传感器JSON缓冲区的大小, 使常见发布一次完成 */
+#ifndef ESP8266_TX_BOUNCE_SIZE
+#define ESP8266_TX_BOUNCE_SIZE          256
+#endif
+
+/* ESP8266_HttpGet / ESP8266_HttpPost 请求缓冲区 (共享区) */
+#ifndef ESP8266_HTTP_REQ_SIZE
+#define ESP8266_HTTP_REQ_SIZE           512
+#endif
+
+/* MQTT ----------------------------------------------------------------------*/
+
+#ifndef MQTT_CLIENT_ID_MAX_LEN
+#define MQTT_CLIENT_ID_MAX_LEN          64
+#endif
+#ifndef MQTT_USERNAME_MAX_LEN
+#define MQTT_USERNAME_MAX_LEN           64
+#endif
+#ifndef MQTT_PASSWORD_MAX_LEN
+#define MQTT_PASSWORD_MAX_LEN           64
+#endif
+#ifndef MQTT_HOST_MAX_LEN
+#define MQTT_HOST_MAX_LEN               128
+#endif
+
+/* 主题最大长度 (订阅表每项、遗嘱主题、收到的消息各一份) */
+#ifndef MQTT_TOPIC_MAX_LEN
+#define MQTT_TOPIC_MAX_LEN              128
+#endif
+
+/* 消息最大长度: 收到的消息数据 (共享区) 与 MQTT_PublishF 格式化缓冲区 (共享区) */
+#ifndef MQTT_MESSAGE_MAX_LEN
+#define MQTT_MESSAGE_MAX_LEN            1024
+#endif
+
+/* 遗嘱消息最大长度 (MQTT句柄中一份, 随 MQTTCONNCFG 一起发送) */
+#ifndef MQTT_LWT_MSG_MAX_LEN
+#define MQTT_LWT_MSG_MAX_LEN            MQTT_MESSAGE_MAX_LEN
+#endif
+
+/* 中断中暂存 +MQTTSUBRECV 原始URC的缓冲区 (MQTT句柄中一份) */
+#ifndef MQTT_RX_MSG_SIZE
+#define MQTT_RX_MSG_SIZE                512
+#endif
+
+/* 最大订阅主题数 */
+#ifndef MQTT_MAX_SUBSCRIPTIONS
+#define MQTT_MAX_SUBSCRIPTIONS          8
+#endif
+
+/* 日志 ----------------------------------------------------------------------*/
+
+/* 单条日志格式化缓冲区 (栈上) */
+#ifndef LOG_BUFFER_SIZE
+#define LOG_BUFFER_SIZE                 256
+#endif
+
+/* 异步发送环形缓冲区 (必须为2的幂, DMA源), 115200波特率下4KB约可缓冲350ms的输出 */
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE                   4096
+#endif
+
+/* 内置RAM出口 (必须为2的幂, 0=不使用) */
+#ifndef LOG_RAM_SINK_SIZE
+#define LOG_RAM_SINK_SIZE               1024
+#endif
+
+/* 令牌化日志单帧最大长度 (栈上) */
+#ifndef LOG_TOKEN_FRAME_MAX
+#define LOG_TOKEN_FRAME_MAX             256
+#endif
+
+/* MQTT日志出口批缓冲区 (常驻), 发布时附加统计行的发送缓冲区在共享区 */
+#ifndef LOG_MQTT_BATCH_SIZE
+#define LOG_MQTT_BATCH_SIZE             768
+#endif
+
+/* 指标/剖析/时序应答 --------------------------------------------------------*/
+
+/* 健康报告JSON (共享区) */
+#ifndef METRICS_JSON_SIZE
+#define METRICS_JSON_SIZE               768
+#endif
+
+/* 单个剖析区段JSON (共享区, 32个桶全部非空时约470字节) */
+#ifndef PROF_CHUNK_SIZE
+#define PROF_CHUNK_SIZE                 480
+#endif
+
+/* 时序查询应答分块 (共享区, 单次MQTT发布的最大长度) */
+#ifndef TIMESERIES_CHUNK_SIZE
+#define TIMESERIES_CHUNK_SIZE           512
+#endif
+
+/* 故障记录保存的日志尾部 (复位保持区, 常驻) */
+#ifndef CRASH_LOG_TAIL_SIZE
+#define CRASH_LOG_TAIL_SIZE             1024
+#endif
+
+/* 故障报告JSON (共享区) */
+#ifndef CRASH_LOG_REPORT_SIZE
+#define CRASH_LOG_REPORT_SIZE           512
+#endif
+
+/* 时序存储 ------------------------------------------------------------------*/
+
+/* 各层容量, 每通道 8字节/原始样本 + 20字节/桶 (默认约3.6KB, 最多 TIMESERIES_MAX_SERIES 个通道) */
+#ifndef TIMESERIES_RAW_SIZE
+#define TIMESERIES_RAW_SIZE             32      /* 原始样本 */
+#endif
+#ifndef TIMESERIES_TIER0_SIZE
+#define TIMESERIES_TIER0_SIZE           60      /* 1s  x 60 = 1分钟 */
+#endif
+#ifndef TIMESERIES_TIER1_SIZE
+#define TIMESERIES_TIER1_SIZE           60      /* 1min x 60 = 1小时 */
+#endif
+#ifndef TIMESERIES_TIER2_SIZE
+#define TIMESERIES_TIER2_SIZE           48      /* 15min x 48 = 12小时 */
+#endif
+
+/* 配置存储 ------------------------------------------------------------------*/
+
+/* 单个配置值最大长度 (字符串含结尾'\0'), 读写时的栈上缓冲区 */
+#ifndef CONFIG_VALUE_MAX_LEN
+#define CONFIG_VALUE_MAX_LEN            64
+#endif
+
+/* 配置查询/应答JSON (共享区) */
+#ifndef CONFIG_JSON_SIZE
+#define CONFIG_JSON_SIZE                768
+#endif
+
+/* 频闪分析 ------------------------------------------------------------------*/
+
+/* 闪烁分析开关 (1:开启 0:关闭), 决定共享区大小 */
+#ifndef FLICKER_ENABLE
+#define FLICKER_ENABLE                  1
+#endif
+
+/* 最大FFT点数: 采样缓冲区 (DMA目标, 常驻) 2字节/点, FFT工作区 (共享区, 原地变换) 4字节/点.
+ * 4kHz采样时1024点分辨率约3.9Hz (峰值经抛物线插值), 共享区随之为4KB */
+#ifndef FLICKER_MAX_BLOCK_SIZE
+#define FLICKER_MAX_BLOCK_SIZE          1024
+#endif
+
+/* 共享区 --------------------------------------------------------------------*/
+
+/* 其余使用者的嵌套峰值: 收到的消息 (主题+数据) -> 应用回调 -> MQTT_PublishF 格式化 ->
+ * 格式化AT命令, 另加对齐余量 (默认约3.2KB, 低内存配置约1.5KB) */
+#define SCRATCH_MSG_PEAK                (MQTT_TOPIC_MAX_LEN + 2 * MQTT_MESSAGE_MAX_LEN + ESP8266_TX_BUF_SIZE + 64)
+
+/* 共享区大小: 取频闪FFT工作区 (FLICKER_MAX_BLOCK_SIZE * 4) 与 SCRATCH_MSG_PEAK 中的较大者 */
+#ifndef SCRATCH_SIZE
+#if FLICKER_ENABLE && (FLICKER_MAX_BLOCK_SIZE * 4 > SCRATCH_MSG_PEAK)
+#define SCRATCH_SIZE                    (FLICKER_MAX_BLOCK_SIZE * 4)
+#else
+#define SCRATCH_SIZE                    SCRATCH_MSG_PEAK
+#endif
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MEM_CONFIG_H */
@@ -0,0 +1,69 @@
+/**
+  ******************************************************************************
+  * @file           : mem_region.h
+  * @brief          : 存储区域放置 (CCM RAM / DMA缓冲区)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * STM32F407 的 64KB CCM RAM (0x10000000) 只连在CPU的D总线上: 零等待, 不与DMA
+  * 争用总线, 但 DMA 访问不到。放置规则:
+  *   - CCM_BSS / CCM_DATA: 只由CPU访问的数据 (主栈、时序存储、剖析统计、
+  *     MQTT句柄、RAM日志出口等), 分别用于无初值和有初值的变量
+  *   - DMA_BUFFER: DMA 读写的缓冲区 (ESP8266 句柄中的 dmaRxBuffer、日志环形
+  *     缓冲区、ADC采样缓冲区、共享区), 固定放在 SRAM1/2
+  *   - 其余变量由链接器放在 SRAM1/2
+  *
+  *   static uint8_t logRamRing[LOG_RAM_SINK_SIZE] CCM_BSS;
+  *   static uint8_t logRing[LOG_RING_SIZE] DMA_BUFFER;
+  *
+  * CCM_BSS 变量不要写初值 (ARMCC 的 zero_init 不允许), 启动时由 __main 清零。
+  *
+  * 链接配置见 MDK-ARM/two.sct (Options for Target -> Linker -> Scatter File):
+  * .ccmram / .ccmram.bss (ARMCLANG 为 .bss.ccmram) 和启动文件的 STACK 段放入
+  * RW_IRAM2 (CCM), .dma_buffer (ARMCLANG 为 .bss.dma_buffer) 放入 RW_IRAM1。
+  * 新增段名时 two.sct 要同步, 未列出的段会被 .ANY 放进 RW_IRAM1。构建后用 Tools/ccm_check.py 检查 DMA 调用
+  * 使用的缓冲区没有落在 CCM 中 (主机构建作为 ctest 运行)。
+  *
+  * 栈在CCM中, 栈上的缓冲区不能直接交给DMA: ESP8266_SendDMA 遇到 CCM 地址时
+  * 经 SRAM 中的中转缓冲区分块发送, 其他 DMA 调用只能使用静态缓冲区。
+  *
+  ******************************************************************************
+  */
+
+#ifndef __MEM_REGION_H
+#define __MEM_REGION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 放置属性 (ARMCC5 / ARMCLANG / GCC) */
+#if defined(__CC_ARM)
+#define CCM_DATA                __attribute__((section(".ccmram")))
+#define CCM_BSS                 __attribute__((section(".ccmram.bss"), zero_init))
+#define DMA_BUFFER              __attribute__((section(".dma_buffer"), zero_init))
+#elif defined(__ARMCC_VERSION)
+#define CCM_DATA                __attribute__((section(".ccmram")))
+#define CCM_BSS                 __attribute__((section(".bss.ccmram")))
+#define DMA_BUFFER              __attribute__((section(".bss.dma_buffer")))
+#else
+#define CCM_DATA                __attribute__((section(".ccmram")))
+#define CCM_BSS                 __attribute__((section(".ccmram.bss")))
+#define DMA_BUFFER              __attribute__((section(".dma_buffer")))
+#endif
+
+/* 地址是否在 CCM 中 (DMA 不可访问) */
+#define MEM_IS_CCM(p)           ((uintptr_t)(p) >= CCMDATARAM_BASE && (uintptr_t)(p) <= CCMDATARAM_END)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MEM_REGION_H */
@@ -0,0 +1,186 @@
+/**
+  ******************************************************************************
+  * @file           : metrics.h
+  * @brief          : 设备健康指标注册表头文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 各模块定义自己的指标并在初始化时注册:
+  *   static Metric_t dhtErrors = METRIC_COUNTER_INIT("dht11.err");
+  *   Metrics_Register(&dhtErrors);
+  *   Metrics_Inc(&dhtErrors);            // 原子加1, 主循环与中断均可调用
+  *
+  * 指标类型:
+  *   - 计数器 (counter): 只增不减, 增量上报时发布与上次上报的差值
+  *   - 量值   (gauge)  : 当前值或峰值, 总是发布当前值
+  * 已有的统计变量可直接作为数据源注册 (METRIC_SOURCE_INIT), 上报时读取,
+  * 模块内不需要改动计数代码。
+  *
+  * 主循环每 METRICS_PERIOD_MS 把全部指标编码为紧凑JSON, 以保留消息发布到
+  * <client>/metrics, 发布成功后才更新增量基准, 失败的一轮不会丢失增量:
+  *   {"up":3600,"seq":12,"delta":1,"m":{"mqtt.pub":42,"dht11.err":0,...}}
+  *
+  ******************************************************************************
+  */
+
+#ifndef __METRICS_H
+#define __METRICS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "atomic_ops.h"
+#include "mem_config.h"
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 最大指标数 */
+#define METRICS_MAX                 24
+
+/* 发布周期 (ms) */
+#define METRICS_PERIOD_MS           60000
+
+/* 计数器按增量上报 (1:与上次上报的差值 0:累计值) */
+#define METRICS_REPORT_DELTA        0
+
+/* 主题最大长度 */
+#define METRICS_TOPIC_LEN           64
+
+/* 静态初始化 */
+#define METRIC_COUNTER_INIT(n)      { (n), METRIC_COUNTER, 0, NULL, 0, 0 }
+#define METRIC_GAUGE_INIT(n)        { (n), METRIC_GAUGE, 0, NULL, 0, 0 }
+#define METRIC_SOURCE_INIT(n, t, p) { (n), (t), 0, (p), 0, 0 }
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  指标类型
+  */
+typedef enum {
+    METRIC_COUNTER = 0,             /**< 计数器 */
+    METRIC_GAUGE                    /**< 量值 */
+} Metric_Type_t;
+
+/**
+  * @brief  指标 (由模块定义, 注册后不可释放)
+  */
+typedef struct {
+    const char *name;               /**< 名称, 如 "mqtt.pub" */
+    uint8_t type;                   /**< Metric_Type_t */
+    volatile uint32_t value;        /**< 当前值 (无数据源时) */
+    const volatile uint32_t *source;    /**< 数据源, 非NULL时上报读取此变量 */
+    uint32_t reported;              /**< 上次发布成功时的值 (增量基准) */
+    uint32_t pending;               /**< 本轮编码时的值, 发布成功后成为基准 */
+} Metric_t;
+
+/**
+  * @brief  指标注册表句柄
+  */
+typedef struct {
+    Metric_t *metrics[METRICS_MAX]; /**< 已注册指标 */
+    uint8_t count;                  /**< 已注册数量 */
+    char topic[METRICS_TOPIC_LEN];  /**< 发布主题 */
+    uint32_t lastTick;              /**< 上次发布时间 */
+    uint32_t seq;                   /**< 发布序号 */
+    uint32_t failures;              /**< 发布失败次数 */
+    uint8_t initialized;            /**< 初始化标志 */
+} Metrics_Handle_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern Metrics_Handle_t metrics;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  注册指标 (可在 Metrics_Init 之前调用, 重复注册忽略)
+  * @param  metric 指标
+  * @retval uint8_t 1=成功 0=表满或参数错误
+  */
+uint8_t Metrics_Register(Metric_t *metric);
+
+/**
+  * @brief  计数器原子加1
+  */
+static inline void Metrics_Inc(Metric_t *metric)
+{
+    Atomic_Add32(&metric->value, 1);
+}
+
+/**
+  * @brief  计数器原子加n
+  */
+static inline void Metrics_Add(Metric_t *metric, uint32_t n)
+{
+    Atomic_Add32(&metric->value, n);
+}
+
+/**
+  * @brief  设置量值 (32位对齐写入本身是原子的)
+  */
+static inline void Metrics_Set(Metric_t *metric, uint32_t value)
+{
+    metric->value = value;
+}
+
+/**
+  * @brief  量值取峰值
+  */
+static inline void Metrics_Max(Metric_t *metric, uint32_t value)
+{
+    uint32_t old;
+
+    do {
+        old = metric->value;
+        if (value <= old) {
+            return;
+        }
+    } while (!Atomic_Cas32(&metric->value, old, value));
+}
+
+/**
+  * @brief  读取指标当前值
+  */
+uint32_t Metrics_Get(const Metric_t *metric);
+
+/**
+  * @brief  按名称查找指标
+  * @retval Metric_t* 未找到返回NULL
+  */
+Metric_t* Metrics_Find(const char *name);
+
+/**
+  * @brief  设置发布主题
+  * @param  topic 主题, 如 "stm32/metrics"
+  * @retval uint8_t 1=成功 0=失败
+  */
+uint8_t Metrics_Init(const char *topic);
+
+/**
+  * @brief  把全部指标编码为JSON, 并记下本轮的值
+  * @param  buf 输出缓冲区
+  * @param  size 缓冲区大小
+  * @param  delta 1=计数器发布增量 0=累计值
+  * @retval int 长度, 缓冲区不足返回0
+  */
+int Metrics_Format(char *buf, uint16_t size, uint8_t delta);
+
+/**
+  * @brief  发布成功后把本轮的值作为增量基准
+  */
+void Metrics_Commit(void);
+
+/**
+  * @brief  到期时发布 (在主循环中调用, MQTT未连接时跳过)
+  */
+void Metrics_Poll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __METRICS_H */
@@ -0,0 +1,158 @@
+/**
+  ******************************************************************************
+  * @file           : power.h
+  * @brief          : 低功耗空闲管理头文件 (Sleep/STOP + RTC唤醒定时器)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 主循环算出距下一个截止时间的毫秒数后调用 Power_Idle, 代替固定的 HAL_Delay:
+  *   - 很短的空闲 (< POWER_TICKLESS_MIN_MS): 保持SysTick, 逐拍WFI
+  *   - 较长的空闲: 停掉SysTick, 由RTC唤醒定时器按截止时间唤醒 (tickless Sleep),
+  *     醒来后按RTC亚秒计数补偿 uwTick
+  *   - 无模块持有STOP禁止位且空闲足够长时进入STOP, 醒来后重新切回PLL
+  *
+  * RTC 由 LSI 驱动 (板上没有LSE), 初始化时用 TIM5 CH4 捕获LSI测出实际频率,
+  * 唤醒定时和亚秒计数都按测得的频率换算。
+  *
+  * 唤醒源: Sleep下任何已使能的中断都能唤醒 (USART3空闲线/DMA中断即ESP8266数据);
+  * STOP下 RTC唤醒 (EXTI22) 和 USART3_RX/PB11 下降沿 (EXTI11)。STOP唤醒后
+  * 先运行在HSI上, 期间USART3波特率不对, 触发唤醒的那个字节会丢失。
+  *
+  * 默认配置下不会进入STOP: ESP8266 驱动从 ESP8266_Init 起一直持有
+  * POWER_HOLD_ESP8266 (Modem-sleep 时模块仍随时推送订阅消息, 丢掉首字节
+  * 会丢整条消息), 只有 ESP8266_DeInit 之后, 或接了唤醒线的 Light-sleep 且
+  * ESP8266_SLEEP_ALLOW_MCU_STOP=1 时的模块休眠期间才释放。默认生效的是
+  * tickless Sleep; STOP 路径、PB11/EXTI11 唤醒和 pm.stop 指标为这些配置保留。
+  *
+  ******************************************************************************
+  */
+
+#ifndef __POWER_H
+#define __POWER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 允许进入STOP (0: 只用Sleep) */
+#define POWER_STOP_ENABLE           1
+
+/* 短于此时间保持SysTick逐拍WFI (ms) */
+#define POWER_TICKLESS_MIN_MS       3
+
+/* STOP唤醒需等待PLL锁定, 短于此时间只进Sleep (ms) */
+#define POWER_STOP_MIN_MS           50
+
+/* 单次空闲上限 (ms), 没有登记截止时间的周期任务最多延后这么久 */
+#define POWER_MAX_IDLE_MS           1000
+
+/* LSI 标称频率, 测量失败时使用 (Hz) */
+#define POWER_LSI_NOMINAL_HZ        32000
+
+/* LSI 合理范围 (数据手册 17~47kHz), 超出视为测量失败 */
+#define POWER_LSI_MIN_HZ            17000
+#define POWER_LSI_MAX_HZ            47000
+
+/* RTC异步分频 (PREDIV_A+1), 亚秒计数约为 LSI/32 = 1kHz */
+#define POWER_RTC_ASYNC_DIV         32
+
+/* STOP禁止位 (持有者) */
+#define POWER_HOLD_ESP8266          (1UL << 0)  /**< ESP8266驱动已初始化且需要连续接收 (默认一直持有) */
+#define POWER_HOLD_FLICKER          (1UL << 1)  /**< 频闪采集进行中, 需要TIM2/ADC3 */
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  功耗管理状态
+  */
+typedef enum {
+    POWER_OK = 0,                   /**< 成功 */
+    POWER_ERROR                     /**< 错误 */
+} Power_Status_t;
+
+/**
+  * @brief  空闲模式
+  */
+typedef enum {
+    POWER_MODE_RUN = 0,             /**< 运行 (不空闲) */
+    POWER_MODE_SLEEP,               /**< Sleep, SysTick保持运行 */
+    POWER_MODE_TICKLESS,            /**< Sleep, SysTick停止, RTC唤醒 */
+    POWER_MODE_STOP,                /**< STOP, RTC或USART3_RX唤醒 */
+    POWER_MODE_COUNT
+} Power_Mode_t;
+
+/**
+  * @brief  驻留统计
+  */
+typedef struct {
+    uint32_t ms[POWER_MODE_COUNT];      /**< 各模式累计时间 (ms), RUN在读取时由运行时间推算 */
+    uint32_t entries[POWER_MODE_COUNT]; /**< 各模式进入次数 */
+    uint32_t earlyWakes;                /**< 截止时间前被中断唤醒的次数 */
+} Power_Stats_t;
+
+/**
+  * @brief  功耗管理句柄
+  */
+typedef struct {
+    Power_Stats_t stats;            /**< 驻留统计 */
+    volatile uint32_t stopHold;     /**< STOP禁止位 (POWER_HOLD_xxx) */
+    uint32_t lsiHz;                 /**< 测得的LSI频率 */
+    uint32_t subHz;                 /**< RTC亚秒计数频率 (PREDIV_S+1) */
+    uint32_t residue;               /**< 不足1ms的亚秒计数, 留到下次补偿 */
+    uint8_t rtcReady;               /**< RTC可用 (否则只用逐拍Sleep) */
+    uint8_t initialized;            /**< 初始化标志 */
+} Power_Handle_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern Power_Handle_t power;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  初始化 (测量LSI, 配置RTC亚秒计数与唤醒定时器, 注册驻留指标)
+  * @retval Power_Status_t RTC不可用时返回错误, 此后 Power_Idle 退化为逐拍Sleep
+  */
+Power_Status_t Power_Init(void);
+
+/**
+  * @brief  空闲到截止时间或被中断唤醒
+  * @param  maxMs 距下一个截止时间的毫秒数 (0: 立即返回, 超过上限按上限)
+  * @retval Power_Mode_t 实际使用的模式
+  */
+Power_Mode_t Power_Idle(uint32_t maxMs);
+
+/**
+  * @brief  置STOP禁止位 (可在中断中调用)
+  * @param  mask POWER_HOLD_xxx
+  */
+void Power_HoldStop(uint32_t mask);
+
+/**
+  * @brief  清STOP禁止位 (可在中断中调用)
+  * @param  mask POWER_HOLD_xxx
+  */
+void Power_ReleaseStop(uint32_t mask);
+
+/**
+  * @brief  获取驻留统计 (含推算的RUN时间)
+  * @param  stats 输出
+  */
+void Power_GetStats(Power_Stats_t *stats);
+
+/**
+  * @brief  唤醒中断处理 (RTC_WKUP_IRQHandler / EXTI15_10_IRQHandler 中调用)
+  */
+void Power_WakeupIRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __POWER_H */
@@ -0,0 +1,176 @@
+/**
+  ******************************************************************************
+  * @file           : prof.h
+  * @brief          : DWT周期计数器性能剖析头文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 命名区段 (zone) 计时:
+  *   PROF_BEGIN(ESP_CMD);
+  *   ... 被测代码 ...
+  *   PROF_END(ESP_CMD);
+  * 每个区段统计 次数/最小/最大/平均 以及按 log2 分桶的直方图,
+  * 单位为时钟周期 (第 k 桶表示 [2^k, 2^(k+1)) 个周期)。
+  *
+  * - PROF_BEGIN 在当前作用域声明一个局部起始值, PROF_END 须位于同一函数内,
+  *   有多个返回点时在每个返回前调用 PROF_END; 因为起始值是局部变量,
+  *   同一区段被中断嵌套时也能正确计时
+  * - 区段统计在短暂关中断下更新, 主循环与中断均可使用
+  * - PROF_ENABLE 为0时宏展开为空, 不占用任何代码和时间
+  * - 主机端编译 (非ARM) 时计时源为 clock_gettime(CLOCK_MONOTONIC), 单位为纳秒
+  *
+  * 新增区段: 在 Prof_Zone_t 中加一项, 并在 prof.c 的名称表中按相同顺序加名称
+  *
+  ******************************************************************************
+  */
+
+#ifndef __PROF_H
+#define __PROF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "mem_config.h"
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 剖析开关 (1:开启 0:宏展开为空) */
+#define PROF_ENABLE                 1
+
+/* 直方图桶数 (log2, 覆盖 1 ~ 2^32 个周期) */
+#define PROF_HIST_BINS              32
+
+/* 计时源 */
+#if defined(__arm__) || defined(__CC_ARM) || defined(__ARMCC_VERSION)
+#define PROF_NOW()                  (DWT->CYCCNT)
+#else
+#define PROF_HOST                   1
+#define PROF_NOW()                  Prof_HostNow()
+#endif
+
+/* 区段计时宏 */
+#if PROF_ENABLE
+#define PROF_BEGIN(id)              uint32_t profStart_##id = PROF_NOW()
+#define PROF_END(id)                Prof_Record(PROF_ZONE_##id, PROF_NOW() - profStart_##id)
+#else
+#define PROF_BEGIN(id)              ((void)0)
+#define PROF_END(id)                ((void)0)
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  区段ID
+  */
+typedef enum {
+    PROF_ZONE_ESP_CMD = 0,          /**< ESP8266_SendCommand */
+    PROF_ZONE_MQTT_PUB,             /**< MQTT_Publish */
+    PROF_ZONE_MQTT_PARSE,           /**< MQTT_ParseSubMessage */
+    PROF_ZONE_DHT11_READ,           /**< DHT11_ReadRaw (含20ms起始信号) */
+    PROF_ZONE_DHT11_FRAME,          /**< DHT11_FinishRead 接收40位数据帧 */
+    PROF_ZONE_LIGHT_READ,           /**< LightSensor_Read */
+    PROF_ZONE_LOG_PRINT,            /**< LOG_Print */
+    PROF_ZONE_COUNT
+} Prof_Zone_t;
+
+/**
+  * @brief  区段统计
+  */
+typedef struct {
+    uint32_t count;                 /**< 次数 */
+    uint32_t min;                   /**< 最小值 (周期) */
+    uint32_t max;                   /**< 最大值 (周期) */
+    uint64_t total;                 /**< 累计 (周期), 平均值 = total / count */
+    uint16_t hist[PROF_HIST_BINS];  /**< log2 直方图, 饱和计数 */
+} Prof_Stats_t;
+
+/**
+  * @brief  剖析句柄
+  */
+typedef struct {
+    Prof_Stats_t zones[PROF_ZONE_COUNT];    /**< 各区段统计 */
+    uint32_t hz;                    /**< 计时源频率 (周期/秒) */
+    uint8_t queryZone;              /**< 分块导出的下一个区段, PROF_ZONE_COUNT=无 */
+    uint8_t initialized;            /**< 初始化标志 */
+} Prof_Handle_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern Prof_Handle_t prof;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  使能DWT周期计数器并清空统计
+  */
+void Prof_Init(void);
+
+/**
+  * @brief  清空统计
+  */
+void Prof_Reset(void);
+
+/**
+  * @brief  记录一次区段耗时 (由 PROF_END 调用)
+  * @param  zone 区段ID
+  * @param  cycles 耗时 (周期)
+  */
+void Prof_Record(Prof_Zone_t zone, uint32_t cycles);
+
+/**
+  * @brief  获取区段统计
+  * @param  zone 区段ID
+  * @param  stats 输出指针
+  */
+void Prof_GetStats(Prof_Zone_t zone, Prof_Stats_t *stats);
+
+/**
+  * @brief  获取区段名称
+  */
+const char* Prof_GetName(Prof_Zone_t zone);
+
+/**
+  * @brief  把一个区段编码为JSON
+  * @note   格式 {"zone":"esp_cmd","hz":168000000,"n":12,"min":..,"mean":..,"max":..,
+  *         "hist":{"14":3,"15":9}}, 直方图只列出非空桶, 键为 log2(周期)
+  * @param  zone 区段ID
+  * @param  buf 输出缓冲区
+  * @param  size 缓冲区大小
+  * @retval int 长度
+  */
+int Prof_FormatZone(Prof_Zone_t zone, char *buf, uint16_t size);
+
+/**
+  * @brief  通过日志输出所有区段 (串口/RAM/MQTT出口)
+  */
+void Prof_Dump(void);
+
+/**
+  * @brief  开始分块导出 (MQTT查询), 之后由 Prof_NextChunk 每次取一个区段
+  */
+void Prof_StartQuery(void);
+
+/**
+  * @brief  取下一个区段的JSON (在主循环中调用)
+  * @param  buf 输出缓冲区 (建议 PROF_CHUNK_SIZE)
+  * @param  size 缓冲区大小
+  * @retval int 长度, 0 表示导出结束
+  */
+int Prof_NextChunk(char *buf, uint16_t size);
+
+#ifdef PROF_HOST
+/**
+  * @brief  主机端计时源 (纳秒, 32位回绕)
+  */
+uint32_t Prof_HostNow(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PROF_H */
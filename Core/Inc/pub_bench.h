@@ -0,0 +1,122 @@
+/**
+  ******************************************************************************
+  * @file           : pub_bench.h
+  * @brief          : MQTT发布吞吐基准头文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 按 发布接口 x 载荷长度 x QoS x 波特率 组合连续发布, 每个组合输出一行CSV:
+  *   api,payload,qos,baud,latency_us,sent,ok,elapsed_ms,msgs_s,bytes_s,cpu_busy_pct,at_rt_per_msg
+  *
+  * - msgs_s / bytes_s: 成功的消息数与载荷字节数除以耗时
+  * - cpu_busy_pct: 耗时中不在 ESP8266_Delay 里等待模块的比例。驱动是阻塞式的,
+  *   等待部分在有调度时可以让出, 其余为格式化、缓冲区清零、应答匹配等CPU开销
+  * - at_rt_per_msg: 每条消息的AT往返次数 (AT命令统计表中 issued 的增量,
+  *   MQTTPUBRAW 命令和数据阶段各算一次, 唤醒休眠的模块也计入)
+  * - latency_us: 模块处理延时, 只在主机仿真中设置, 目标板上为 0
+  *
+  * 目标板上由 stm32/prof/query "bench" 触发, 阻塞运行一轮默认扫描, CSV 通过
+  * 日志输出; 主机上由 Host/bench/bench_publish 驱动, 另外扫描仿真模块的处理延时。
+  * 波特率通过 ESP8266_SetBaudRate (AT+UART_CUR) 切换, 扫描结束恢复原波特率。
+  *
+  ******************************************************************************
+  */
+
+#ifndef __PUB_BENCH_H
+#define __PUB_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "esp8266_mqtt.h"
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 基准开关 (载荷缓冲区占用 PUB_BENCH_PAYLOAD_MAX 字节RAM, 默认关闭) */
+#ifndef PUB_BENCH_ENABLE
+#define PUB_BENCH_ENABLE            0
+#endif
+
+/* 最大载荷长度 */
+#define PUB_BENCH_PAYLOAD_MAX       4096
+
+/* 基准主题 */
+#define PUB_BENCH_TOPIC             "stm32/bench"
+
+/* CSV 单行最大长度 */
+#define PUB_BENCH_CSV_SIZE          160
+
+/* 目标板默认扫描: 每个组合的发布次数、载荷长度、波特率 */
+#define PUB_BENCH_DEFAULT_COUNT     20
+#define PUB_BENCH_DEFAULT_SIZES     {16, 64, 256, 1024, 4096}
+#define PUB_BENCH_DEFAULT_BAUDS     {115200, 460800, 921600}
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  发布接口
+  */
+typedef enum {
+    PUB_BENCH_API_PUBLISH = 0,      /**< MQTT_Publish (字符串) */
+    PUB_BENCH_API_RAW,              /**< MQTT_PublishRaw (二进制) */
+    PUB_BENCH_API_COUNT
+} PubBench_Api_t;
+
+/**
+  * @brief  一个扫描组合
+  */
+typedef struct {
+    PubBench_Api_t api;             /**< 发布接口 */
+    uint16_t payload;               /**< 载荷长度 (字节) */
+    MQTT_QoS_t qos;                 /**< QoS */
+    uint32_t baud;                  /**< 波特率, 0: 保持当前 */
+    uint32_t latencyUs;             /**< 模块处理延时 (仅用于报告) */
+    uint16_t count;                 /**< 发布次数 */
+} PubBench_Case_t;
+
+/**
+  * @brief  一个组合的结果
+  */
+typedef struct {
+    uint16_t sent;                  /**< 发布次数 */
+    uint16_t ok;                    /**< 成功次数 */
+    uint32_t elapsedMs;             /**< 总耗时 */
+    uint32_t waitMs;                /**< 其中等待模块的时间 */
+    uint32_t roundTrips;            /**< AT往返次数 */
+} PubBench_Result_t;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  运行一个组合 (阻塞)
+  * @retval MQTT_Status_t 切换波特率失败时返回 MQTT_ERROR, 发布失败只计入结果
+  */
+MQTT_Status_t PubBench_Run(const PubBench_Case_t *bench, PubBench_Result_t *result);
+
+/**
+  * @brief  CSV 表头 (不含换行)
+  */
+const char* PubBench_CsvHeader(void);
+
+/**
+  * @brief  把一个组合的结果编码为CSV行 (不含换行)
+  * @retval int 长度
+  */
+int PubBench_FormatCsv(const PubBench_Case_t *bench, const PubBench_Result_t *result,
+                       char *buf, uint16_t size);
+
+/**
+  * @brief  目标板默认扫描, 结果逐行通过日志输出 (阻塞, 需已连接代理)
+  */
+void PubBench_RunDefault(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PUB_BENCH_H */
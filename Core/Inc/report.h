@@ -0,0 +1,180 @@
+/**
+  ******************************************************************************
+  * @file           : report.h
+  * @brief          : 按例外上报 (Report-by-Exception) 头文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 位于采样与 MQTT_Publish 之间的变化检测层, 每个通道独立配置:
+  *   - absDeadband  : 绝对死区, |新值 - 上次发布值| >= 此值才算变化
+  *   - relDeadband  : 相对死区 (%), |新值 - 上次发布值| >= 上次值 x 此值/100 也算变化
+  *                    两者任一满足即为变化, 配置为0表示不使用
+  *   - minIntervalMs: 两次发布的最小间隔, 间隔内的变化推迟到间隔结束后发布最新值
+  *   - heartbeatMs  : 最长静默时间, 到期时即使无变化也发布一次
+  *
+  * 多个通道同时到期时合并为一条JSON发布; 发布时顺带捎上心跳已过半的
+  * 通道 (REPORT_PIGGYBACK_ENABLE), 减少之后单独的心跳发布
+  *
+  * 每个通道统计 已发布/被抑制/心跳/推迟 次数, 用于调整死区参数
+  *
+  ******************************************************************************
+  */
+
+#ifndef __REPORT_H
+#define __REPORT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "log.h"
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 最大通道数 */
+#define REPORT_MAX_CHANNELS         8
+
+/* 通道键名最大长度 */
+#define REPORT_KEY_MAX_LEN          16
+
+/* 未单独配置的通道使用的默认参数 */
+#define REPORT_DEFAULT_ABS_DEADBAND     0.0f
+#define REPORT_DEFAULT_REL_DEADBAND     1.0f        /* 1% */
+#define REPORT_DEFAULT_MIN_INTERVAL_MS  5000
+#define REPORT_DEFAULT_HEARTBEAT_MS     300000      /* 5分钟 */
+#define REPORT_DEFAULT_DECIMALS         1
+
+/* 发布时捎带心跳已过半的通道 (1:开启 0:关闭) */
+#define REPORT_PIGGYBACK_ENABLE     1
+
+/* 调试开关 */
+#define REPORT_DEBUG_ENABLE         0
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  上报状态枚举
+  */
+typedef enum {
+    REPORT_OK = 0,                  /**< 操作成功 */
+    REPORT_ERROR,                   /**< 通用错误 */
+    REPORT_FULL,                    /**< 通道数已满 */
+    REPORT_NOT_FOUND,               /**< 通道不存在 */
+    REPORT_INVALID_PARAM            /**< 无效参数 */
+} Report_Status_t;
+
+/**
+  * @brief  通道上报参数
+  */
+typedef struct {
+    float absDeadband;              /**< 绝对死区 */
+    float relDeadband;              /**< 相对死区 (%) */
+    uint32_t minIntervalMs;         /**< 最小发布间隔 (ms) */
+    uint32_t heartbeatMs;           /**< 最长静默时间 (ms), 0=不发心跳 */
+    uint8_t decimals;               /**< 发布时的小数位数 */
+} Report_Config_t;
+
+/**
+  * @brief  通道统计
+  */
+typedef struct {
+    uint32_t offered;               /**< 收到的样本数 */
+    uint32_t published;             /**< 发布次数 */
+    uint32_t suppressed;            /**< 在死区内被抑制的样本数 */
+    uint32_t heartbeats;            /**< 因心跳到期而发布的次数 */
+    uint32_t deferred;              /**< 超出死区但因最小间隔被推迟的样本数 */
+} Report_Stats_t;
+
+/**
+  * @brief  通道状态
+  */
+typedef struct {
+    char key[REPORT_KEY_MAX_LEN];   /**< 通道键名 */
+    Report_Config_t config;         /**< 上报参数 */
+    Report_Stats_t stats;           /**< 统计 */
+    float value;                    /**< 最新值 */
+    float lastPublished;            /**< 上次发布的值 */
+    uint32_t lastPublishTick;       /**< 上次发布时间 (ms) */
+    uint8_t hasValue;               /**< 已收到过样本 */
+    uint8_t everPublished;          /**< 已发布过 */
+    uint8_t changed;                /**< 有未发布的变化 */
+} Report_Channel_t;
+
+/**
+  * @brief  上报句柄
+  */
+typedef struct {
+    Report_Channel_t channels[REPORT_MAX_CHANNELS];     /**< 通道表 */
+    uint8_t channelCount;           /**< 通道数 */
+    uint32_t messages;              /**< 已生成的合并消息数 */
+    uint8_t initialized;            /**< 初始化标志 */
+} Report_Handle_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern Report_Handle_t report;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  初始化上报模块
+  * @retval Report_Status_t 操作状态
+  */
+Report_Status_t Report_Init(void);
+
+/**
+  * @brief  配置通道上报参数 (通道不存在时创建)
+  * @param  key 通道键名
+  * @param  config 参数
+  * @retval Report_Status_t 操作状态
+  */
+Report_Status_t Report_Configure(const char *key, const Report_Config_t *config);
+
+/**
+  * @brief  送入一个新样本, 判断是否越过死区
+  * @param  key 通道键名
+  * @param  value 数值
+  * @retval Report_Status_t 操作状态
+  */
+Report_Status_t Report_Offer(const char *key, float value);
+
+/**
+  * @brief  把到期的通道编码为一条JSON (在主循环中调用)
+  * @param  buf 输出缓冲区
+  * @param  size 缓冲区大小
+  * @retval int 长度, 0 表示本次无需发布
+  * @note   返回非0即视为已发布, 内部更新上次发布值与时间
+  */
+int Report_FormatDue(char *buf, uint16_t size);
+
+/**
+  * @brief  获取通道统计
+  * @param  key 通道键名
+  * @param  stats 输出指针
+  * @retval Report_Status_t 操作状态
+  */
+Report_Status_t Report_GetStats(const char *key, Report_Stats_t *stats);
+
+/**
+  * @brief  把所有通道统计编码为JSON
+  * @note   格式 {"temp":[发布,抑制,心跳,推迟],...}
+  * @param  buf 输出缓冲区
+  * @param  size 缓冲区大小
+  * @retval int 长度
+  */
+int Report_FormatStats(char *buf, uint16_t size);
+
+/**
+  * @brief  调试打印函数
+  * @param  format 格式化字符串
+  */
+void Report_DebugPrint(const char *format, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REPORT_H */
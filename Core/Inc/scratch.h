@@ -0,0 +1,89 @@
+/**
+  ******************************************************************************
+  * @file           : scratch.h
+  * @brief          : 临时缓冲区共享区头文件 (按作用域申请/释放)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 一块静态内存按栈的方式分配: 进入作用域时记下位置, 申请若干块, 离开时
+  * 一次释放到记下的位置。嵌套调用 (收到消息 -> 回调 -> 发布 -> 格式化AT命令)
+  * 各自在自己的作用域里申请, 共享同一块内存:
+  *
+  *   Scratch_Mark_t mark = Scratch_Mark();
+  *   char *buf = Scratch_Alloc(MQTT_MESSAGE_MAX_LEN);
+  *   if (buf == NULL) { Scratch_Release(mark); return MQTT_ERROR; }
+  *   ...
+  *   Scratch_Release(mark);      // 每个返回点都要释放
+  *
+  * - 只能在主循环中使用, 中断中申请总是返回 NULL
+  * - 释放到外层的位置会同时释放内层忘记释放的块
+  * - 申请失败返回 NULL 并计入健康指标 scratch.fail, 峰值用量为 scratch.peak
+  *
+  ******************************************************************************
+  */
+
+#ifndef __SCRATCH_H
+#define __SCRATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "mem_config.h"
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 分配粒度 (FFT等浮点缓冲区要求的对齐) */
+#define SCRATCH_ALIGN               8
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  作用域起点 (已用字节数)
+  */
+typedef uint32_t Scratch_Mark_t;
+
+/**
+  * @brief  共享区句柄
+  */
+typedef struct {
+    uint32_t used;                  /**< 当前已用字节数 */
+    uint32_t peak;                  /**< 峰值用量 */
+    uint32_t fail;                  /**< 申请失败次数 */
+} Scratch_Handle_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern Scratch_Handle_t scratch;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  注册健康指标 (scratch.peak / scratch.fail)
+  */
+void Scratch_Init(void);
+
+/**
+  * @brief  记下当前位置, 作为作用域起点
+  */
+Scratch_Mark_t Scratch_Mark(void);
+
+/**
+  * @brief  申请 size 字节 (按 SCRATCH_ALIGN 对齐, 内容未初始化)
+  * @retval void* 空间不足或在中断中调用时返回 NULL
+  */
+void* Scratch_Alloc(uint32_t size);
+
+/**
+  * @brief  释放到作用域起点
+  */
+void Scratch_Release(Scratch_Mark_t mark);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SCRATCH_H */
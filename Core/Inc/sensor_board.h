@@ -0,0 +1,55 @@
+/**
+  ******************************************************************************
+  * @file           : sensor_board.h
+  * @brief          : 板载传感器适配层头文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 把各驱动 (DHT11 / 光敏 / 片内温度) 包装为 SensorHub 描述符并注册,
+  * 新增传感器时在 sensor_board.c 中添加描述符即可, 主循环无需修改
+  *
+  * 同时提供各通道的按例外上报参数
+  *
+  ******************************************************************************
+  */
+
+#ifndef __SENSOR_BOARD_H
+#define __SENSOR_BOARD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "sensor_hub.h"
+#include "report.h"
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 各传感器采样周期 (ms) */
+#define SENSOR_BOARD_LIGHT_PERIOD_MS    1000    /* 光敏传感器 (ADC3) */
+#define SENSOR_BOARD_CHIP_PERIOD_MS     1000    /* 片内温度 (ADC1后台DMA) */
+#define SENSOR_BOARD_DHT11_PERIOD_MS    2000    /* DHT11 (最小间隔1s) */
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  注册所有板载传感器
+  * @note   需在各驱动初始化和 SensorHub_Init() 之后调用
+  * @retval SensorHub_Status_t 第一个失败的注册状态, 全部成功返回 SENSOR_HUB_OK
+  */
+SensorHub_Status_t SensorBoard_RegisterAll(void);
+
+/**
+  * @brief  配置各通道的按例外上报参数 (死区/最小间隔/心跳)
+  * @note   需在 Report_Init() 之后调用
+  * @retval Report_Status_t 操作状态
+  */
+Report_Status_t SensorBoard_ConfigureReport(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SENSOR_BOARD_H */
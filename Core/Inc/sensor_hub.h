@@ -0,0 +1,248 @@
+/**
+  ******************************************************************************
+  * @file           : sensor_hub.h
+  * @brief          : 通用传感器注册与采样调度框架头文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 各传感器驱动以描述符 (SensorHub_Desc_t) 的形式注册:
+  *   - 名称、采样周期、首次采样偏移
+  *   - start    : 启动一次采集 (可为NULL, 非阻塞)
+  *   - complete : 查询采集是否完成, 完成时填充各通道数值
+  *   - channels : 每个通道的键名与小数位数, 可选自定义编码函数
+  *
+  * 调度器 SensorHub_Poll() 在主循环中频繁调用:
+  *   - 每次调用最多启动一个传感器, 且未指定偏移的传感器自动错开
+  *     SENSOR_HUB_STAGGER_MS, 慢速传感器(DHT11起始信号20ms)不会拖住
+  *     快速传感器(ADC)
+  *   - start 之后 complete 返回 SENSOR_HUB_BUSY 时下次再查询, 不阻塞
+  *   - 结果以带时间戳的样本写入统一队列, 供任意编码器/发布者消费,
+  *     同时更新每个通道的最新值表
+  *
+  * 新增传感器只需注册描述符, 无需修改主循环
+  *
+  ******************************************************************************
+  */
+
+#ifndef __SENSOR_HUB_H
+#define __SENSOR_HUB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "log.h"
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 容量配置 */
+#define SENSOR_HUB_MAX_SENSORS      8       /* 最多注册的传感器数 */
+#define SENSOR_HUB_MAX_CHANNELS     4       /* 每个传感器最多通道数 */
+#define SENSOR_HUB_QUEUE_SIZE       32      /* 样本队列长度 (满时覆盖最旧样本) */
+
+/* 自动错峰间隔 (ms), 描述符 phaseMs 为0时按注册序号 x 此值偏移 */
+#define SENSOR_HUB_STAGGER_MS       100
+
+/* 有采集进行中时的轮询间隔 (ms), 供低功耗空闲计算下一次唤醒 */
+#define SENSOR_HUB_PENDING_POLL_MS  5
+
+/* 调试开关 */
+#define SENSOR_HUB_DEBUG_ENABLE     0
+
+/* 无效传感器ID */
+#define SENSOR_HUB_INVALID_ID       0xFF
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  传感器框架状态枚举
+  */
+typedef enum {
+    SENSOR_HUB_OK = 0,              /**< 操作成功 */
+    SENSOR_HUB_ERROR,               /**< 通用错误 / 采集失败 */
+    SENSOR_HUB_BUSY,                /**< 采集尚未完成 */
+    SENSOR_HUB_FULL,                /**< 注册表已满 */
+    SENSOR_HUB_EMPTY,               /**< 队列为空 */
+    SENSOR_HUB_INVALID_PARAM        /**< 无效参数 */
+} SensorHub_Status_t;
+
+/**
+  * @brief  通道编码函数
+  * @param  value 通道数值
+  * @param  buf 输出缓冲区
+  * @param  size 缓冲区大小
+  * @retval int 写入长度 (同snprintf)
+  */
+typedef int (*SensorHub_Encoder_t)(float value, char *buf, uint16_t size);
+
+/**
+  * @brief  通道描述
+  */
+typedef struct {
+    const char *key;                /**< 通道键名 (JSON字段名) */
+    uint8_t decimals;               /**< 默认编码的小数位数 */
+    SensorHub_Encoder_t encode;     /**< 自定义编码函数 (可为NULL) */
+} SensorHub_Channel_t;
+
+/**
+  * @brief  传感器描述符 (由驱动适配层静态定义)
+  */
+typedef struct {
+    const char *name;               /**< 传感器名称 */
+    uint32_t periodMs;              /**< 采样周期 (ms) */
+    uint32_t phaseMs;               /**< 首次采样偏移 (ms), 0=自动错峰 */
+    uint8_t channelCount;           /**< 通道数 */
+    const SensorHub_Channel_t *channels;    /**< 通道描述数组 */
+    SensorHub_Status_t (*start)(void);      /**< 启动采集 (可为NULL) */
+    SensorHub_Status_t (*complete)(float *values);  /**< 完成采集: OK/BUSY/ERROR */
+} SensorHub_Desc_t;
+
+/**
+  * @brief  带时间戳的样本
+  */
+typedef struct {
+    uint32_t timestamp;             /**< 采集完成时间 (ms) */
+    uint8_t sensorId;               /**< 传感器ID (注册序号) */
+    uint8_t channel;                /**< 通道序号 */
+    float value;                    /**< 数值 */
+} SensorHub_Sample_t;
+
+/**
+  * @brief  传感器运行时状态
+  */
+typedef struct {
+    const SensorHub_Desc_t *desc;   /**< 描述符 */
+    uint32_t nextDue;               /**< 下次采样时间 (ms) */
+    uint32_t startTick;             /**< 本次采集启动时间 (ms) */
+    uint8_t pending;                /**< 采集进行中 */
+    uint8_t valid;                  /**< 最新值有效 (最近一次采集成功) */
+    float latest[SENSOR_HUB_MAX_CHANNELS];  /**< 各通道最新值 */
+    uint32_t latestTick;            /**< 最新值时间 (ms) */
+    uint32_t okCount;               /**< 成功次数 */
+    uint32_t errorCount;            /**< 失败次数 */
+} SensorHub_Entry_t;
+
+/**
+  * @brief  传感器框架句柄
+  */
+typedef struct {
+    SensorHub_Entry_t sensors[SENSOR_HUB_MAX_SENSORS];  /**< 注册表 */
+    uint8_t sensorCount;            /**< 已注册数量 */
+    uint8_t nextStart;              /**< 轮询起点 (轮转, 保证公平) */
+    SensorHub_Sample_t queue[SENSOR_HUB_QUEUE_SIZE];    /**< 样本队列 */
+    uint16_t head;                  /**< 写位置 */
+    uint16_t tail;                  /**< 读位置 */
+    uint16_t count;                 /**< 队列中样本数 */
+    uint32_t dropped;               /**< 因队列满被覆盖的样本数 */
+    uint8_t initialized;            /**< 初始化标志 */
+} SensorHub_Handle_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern SensorHub_Handle_t sensorHub;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  初始化传感器框架
+  * @retval SensorHub_Status_t 操作状态
+  */
+SensorHub_Status_t SensorHub_Init(void);
+
+/**
+  * @brief  注册传感器
+  * @param  desc 描述符 (须为静态存储)
+  * @param  id 输出分配的传感器ID (可为NULL)
+  * @retval SensorHub_Status_t 操作状态
+  */
+SensorHub_Status_t SensorHub_Register(const SensorHub_Desc_t *desc, uint8_t *id);
+
+/**
+  * @brief  调度器轮询 (在主循环中频繁调用, 非阻塞)
+  * @retval uint8_t 本次新产生的样本数
+  */
+uint8_t SensorHub_Poll(void);
+
+/**
+  * @brief  距下一次需要调用 SensorHub_Poll 的时间
+  * @retval uint32_t 毫秒; 有到期传感器或队列非空返回0, 未注册传感器返回 UINT32_MAX
+  */
+uint32_t SensorHub_TimeToNext(void);
+
+/**
+  * @brief  从样本队列取出一个样本
+  * @param  sample 样本输出指针
+  * @retval SENSOR_HUB_OK / SENSOR_HUB_EMPTY
+  */
+SensorHub_Status_t SensorHub_Pop(SensorHub_Sample_t *sample);
+
+/**
+  * @brief  获取队列中的样本数
+  * @retval uint16_t 样本数
+  */
+uint16_t SensorHub_QueueCount(void);
+
+/**
+  * @brief  获取某通道最新值
+  * @param  id 传感器ID
+  * @param  channel 通道序号
+  * @param  value 数值输出指针
+  * @retval SENSOR_HUB_OK / SENSOR_HUB_BUSY(尚无有效值) / SENSOR_HUB_INVALID_PARAM
+  */
+SensorHub_Status_t SensorHub_GetLatest(uint8_t id, uint8_t channel, float *value);
+
+/**
+  * @brief  按名称查找传感器
+  * @param  name 传感器名称
+  * @retval uint8_t 传感器ID, 未找到返回 SENSOR_HUB_INVALID_ID
+  */
+uint8_t SensorHub_Find(const char *name);
+
+/**
+  * @brief  获取传感器名称
+  * @param  id 传感器ID
+  * @retval const char* 名称 (无效ID返回"?")
+  */
+const char* SensorHub_GetName(uint8_t id);
+
+/**
+  * @brief  获取通道键名
+  * @param  id 传感器ID
+  * @param  channel 通道序号
+  * @retval const char* 键名 (无效时返回"?")
+  */
+const char* SensorHub_GetKey(uint8_t id, uint8_t channel);
+
+/**
+  * @brief  按通道描述编码一个数值
+  * @param  id 传感器ID
+  * @param  channel 通道序号
+  * @param  value 数值
+  * @param  buf 输出缓冲区
+  * @param  size 缓冲区大小
+  * @retval int 写入长度
+  */
+int SensorHub_EncodeValue(uint8_t id, uint8_t channel, float value, char *buf, uint16_t size);
+
+/**
+  * @brief  将所有有效通道的最新值编码为一个JSON对象
+  * @param  buf 输出缓冲区
+  * @param  size 缓冲区大小
+  * @retval int 写入长度, 无有效数据时返回0
+  */
+int SensorHub_FormatJson(char *buf, uint16_t size);
+
+/**
+  * @brief  调试打印函数
+  * @param  format 格式化字符串
+  */
+void SensorHub_DebugPrint(const char *format, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SENSOR_HUB_H */
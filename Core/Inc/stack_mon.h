@@ -0,0 +1,107 @@
+/**
+  ******************************************************************************
+  * @file           : stack_mon.h
+  * @brief          : 主栈水位监测头文件 (栈填充 + 高水位查询)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 启动时把主栈中尚未使用的部分 (栈底到当前SP减去保护区) 填充为固定图案,
+  * 之后从栈底向上找第一个被改写的字, 其上方即为用过的最大深度。中断与主循环
+  * 共用主栈 (MSP), 高水位包含中断嵌套的占用。
+  *
+  *   StackMon_Init();                // 尽早调用, 之前的栈占用计入保护区
+  *   StackMon_Poll();                // 主循环中调用, 按周期扫描并更新指标
+  *
+  * - 峰值计入健康指标 stack.peak (字节), 剩余不足 STACK_MON_WARN_FREE 时告警一次
+  * - stm32/prof/query 收到 "stack" 时发布 StackMon_FormatJson 的结果
+  * - 栈区间来自链接器: ARMCC 为启动文件 STACK 段的 STACK$$Base/STACK$$Limit,
+  *   GCC 为链接脚本的 _estack/_Min_Stack_Size; 主机构建没有可用的栈区间,
+  *   测试用 StackMon_InitRegion 监测一块数组
+  * - 扫描耗时与剩余空间成正比 (4KB 栈约1000个字), 只在主循环中进行
+  *
+  * 编译期的最坏调用链分析见 Tools/stack_report.py。
+  *
+  ******************************************************************************
+  */
+
+#ifndef __STACK_MON_H
+#define __STACK_MON_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 填充图案 */
+#define STACK_MON_PATTERN           0xCDCDCDCDUL
+
+/* 填充时在当前SP下方留出的保护区 (字节), 避免改写 StackMon_Init 自己的栈帧 */
+#define STACK_MON_GUARD             64
+
+/* 扫描周期 (ms) */
+#ifndef STACK_MON_PERIOD_MS
+#define STACK_MON_PERIOD_MS         1000
+#endif
+
+/* 剩余低于此值 (字节) 时告警 */
+#ifndef STACK_MON_WARN_FREE
+#define STACK_MON_WARN_FREE         512
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  栈监测句柄
+  */
+typedef struct {
+    uint32_t *base;                 /**< 栈底 (最低地址) */
+    uint32_t *top;                  /**< 栈顶 (初始SP, 最高地址) */
+    uint32_t size;                  /**< 栈大小 (字节) */
+    uint32_t peak;                  /**< 已知的最大深度 (字节) */
+    uint32_t lastTick;              /**< 上次扫描时间 */
+    uint8_t warned;                 /**< 已发出低余量告警 */
+} StackMon_Handle_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern StackMon_Handle_t stackMon;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  按链接器给出的主栈区间填充并注册健康指标 (主机构建只注册指标)
+  */
+void StackMon_Init(void);
+
+/**
+  * @brief  监测指定区间 [base, base+size) 并填充其中未使用的部分
+  * @note   当前SP在区间内时只填充到SP下方的保护区, 否则填充整个区间
+  */
+void StackMon_InitRegion(void *base, uint32_t size);
+
+/**
+  * @brief  立即扫描, 返回用过的最大深度 (字节)
+  */
+uint32_t StackMon_HighWater(void);
+
+/**
+  * @brief  按 STACK_MON_PERIOD_MS 周期扫描, 余量不足时告警
+  */
+void StackMon_Poll(void);
+
+/**
+  * @brief  生成JSON: {"stack":{"size":4096,"peak":1320,"free":2776}}
+  * @retval int 写入长度, 缓冲区不足时返回0
+  */
+int StackMon_FormatJson(char *buf, uint16_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STACK_MON_H */
@@ -0,0 +1,219 @@
+/**
+  ******************************************************************************
+  * @file           : timeseries.h
+  * @brief          : 多分辨率时序存储头文件 (原始环 + 级联汇总)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 每个通道 (按键名区分, 如"temp") 占用固定大小的静态存储:
+  *   - 原始样本环     TIMESERIES_RAW_SIZE 个 (时间戳 + 数值)
+  *   - 1s  汇总层     TIMESERIES_TIER0_SIZE 个桶
+  *   - 1min 汇总层    TIMESERIES_TIER1_SIZE 个桶
+  *   - 15min 汇总层   TIMESERIES_TIER2_SIZE 个桶
+  * 每个桶保存 min / max / sum / count, 均值 = sum / count
+  *
+  * 级联方式: 样本只写入原始环和1s层的当前桶; 某层的当前桶关闭时
+  * (新样本落入下一个时间片), 把它的汇总合并进上一层的当前桶。
+  * 每个样本的更新量与层数成正比, 与历史长度无关 (O(1))
+  * 注意上一层的当前桶只包含下层已关闭的桶
+  *
+  * 查询: 通过MQTT发送JSON请求, 结果按块分多次发布:
+  *   请求 {"key":"temp","res":"1m","from":3600,"to":0,"max":60}
+  *        res  : raw / 1s / 1m / 15m
+  *        from : 起点, 距今秒数 (默认为该层可覆盖的全部历史)
+  *        to   : 终点, 距今秒数 (默认0=现在)
+  *        max  : 最多返回点数 (默认 TIMESERIES_DEFAULT_MAX_POINTS)
+  *   应答 {"key":"temp","res":"1m","now":123456,"seq":0,"more":1,
+  *         "pts":[[t,mean,min,max,n],...]}     原始层为 [[t,v],...]
+  *        t 与 now 均为设备毫秒时基 (HAL_GetTick)
+  *
+  ******************************************************************************
+  */
+
+#ifndef __TIMESERIES_H
+#define __TIMESERIES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "log.h"
+#include "mem_config.h"
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 最大通道数 (每通道约 1.6KB) */
+#define TIMESERIES_MAX_SERIES           4
+
+/* 各层容量 TIMESERIES_RAW_SIZE / TIMESERIES_TIERn_SIZE 见 mem_config.h */
+
+/* 各层分辨率 (ms) */
+#define TIMESERIES_TIER0_RES_MS         1000
+#define TIMESERIES_TIER1_RES_MS         60000
+#define TIMESERIES_TIER2_RES_MS         900000
+
+/* 汇总层数 */
+#define TIMESERIES_TIER_COUNT           3
+
+/* 通道键名最大长度 */
+#define TIMESERIES_KEY_MAX_LEN          16
+
+/* 查询默认/最大返回点数 */
+#define TIMESERIES_DEFAULT_MAX_POINTS   60
+#define TIMESERIES_LIMIT_MAX_POINTS     240
+
+/* 调试开关 */
+#define TIMESERIES_DEBUG_ENABLE         0
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  时序存储状态枚举
+  */
+typedef enum {
+    TIMESERIES_OK = 0,              /**< 操作成功 */
+    TIMESERIES_ERROR,               /**< 通用错误 */
+    TIMESERIES_FULL,                /**< 通道数已满 */
+    TIMESERIES_NOT_FOUND,           /**< 通道不存在 */
+    TIMESERIES_BUSY,                /**< 上一个查询尚未发送完 */
+    TIMESERIES_INVALID_PARAM        /**< 无效参数 */
+} TimeSeries_Status_t;
+
+/**
+  * @brief  查询分辨率
+  */
+typedef enum {
+    TIMESERIES_RES_RAW = 0,         /**< 原始样本 */
+    TIMESERIES_RES_1S,              /**< 1秒汇总 */
+    TIMESERIES_RES_1M,              /**< 1分钟汇总 */
+    TIMESERIES_RES_15M              /**< 15分钟汇总 */
+} TimeSeries_Res_t;
+
+/**
+  * @brief  原始样本
+  */
+typedef struct {
+    uint32_t t;                     /**< 时间戳 (ms) */
+    float v;                        /**< 数值 */
+} TimeSeries_Point_t;
+
+/**
+  * @brief  汇总桶
+  */
+typedef struct {
+    uint32_t start;                 /**< 桶起始时间 (ms, 按分辨率对齐) */
+    float min;                      /**< 最小值 */
+    float max;                      /**< 最大值 */
+    float sum;                      /**< 累加和 */
+    uint32_t count;                 /**< 样本数 */
+} TimeSeries_Bucket_t;
+
+/**
+  * @brief  环形索引 (原始环与各汇总层共用)
+  */
+typedef struct {
+    uint16_t head;                  /**< 最新元素位置 */
+    uint16_t used;                  /**< 已使用数量 */
+} TimeSeries_Ring_t;
+
+/**
+  * @brief  单个通道
+  */
+typedef struct {
+    char key[TIMESERIES_KEY_MAX_LEN];                   /**< 通道键名 */
+    TimeSeries_Point_t raw[TIMESERIES_RAW_SIZE];        /**< 原始样本环 */
+    TimeSeries_Bucket_t tier0[TIMESERIES_TIER0_SIZE];   /**< 1s层 */
+    TimeSeries_Bucket_t tier1[TIMESERIES_TIER1_SIZE];   /**< 1min层 */
+    TimeSeries_Bucket_t tier2[TIMESERIES_TIER2_SIZE];   /**< 15min层 */
+    TimeSeries_Ring_t rawRing;                          /**< 原始环索引 */
+    TimeSeries_Ring_t tierRing[TIMESERIES_TIER_COUNT];  /**< 各层索引 */
+    uint32_t total;                                     /**< 累计样本数 */
+} TimeSeries_Series_t;
+
+/**
+  * @brief  查询状态 (分块发送)
+  */
+typedef struct {
+    uint8_t active;                 /**< 查询进行中 */
+    uint8_t series;                 /**< 通道序号 */
+    TimeSeries_Res_t res;           /**< 分辨率 */
+    uint32_t fromTick;              /**< 起点 (ms) */
+    uint32_t toTick;                /**< 终点 (ms) */
+    uint32_t lastT;                 /**< 已发送的最后一个点的时间 */
+    uint8_t started;                /**< 是否已发送过点 */
+    uint16_t remaining;             /**< 剩余可发送点数 */
+    uint16_t seq;                   /**< 块序号 */
+} TimeSeries_Query_t;
+
+/**
+  * @brief  时序存储句柄
+  */
+typedef struct {
+    TimeSeries_Series_t series[TIMESERIES_MAX_SERIES];  /**< 通道存储 */
+    uint8_t seriesCount;            /**< 已创建通道数 */
+    TimeSeries_Query_t query;       /**< 当前查询 */
+    uint32_t rejected;              /**< 因通道满被丢弃的样本数 */
+    uint8_t initialized;            /**< 初始化标志 */
+} TimeSeries_Handle_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern TimeSeries_Handle_t timeSeries;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  初始化时序存储
+  * @retval TimeSeries_Status_t 操作状态
+  */
+TimeSeries_Status_t TimeSeries_Init(void);
+
+/**
+  * @brief  记录一个样本 (通道不存在时自动创建)
+  * @param  key 通道键名
+  * @param  timestamp 时间戳 (ms)
+  * @param  value 数值
+  * @retval TimeSeries_Status_t 操作状态
+  */
+TimeSeries_Status_t TimeSeries_Record(const char *key, uint32_t timestamp, float value);
+
+/**
+  * @brief  读取某分辨率下的一个汇总桶
+  * @param  key 通道键名
+  * @param  res 分辨率 (不可为RAW)
+  * @param  age 0=当前桶, 1=上一个, 以此类推
+  * @param  bucket 输出指针
+  * @retval TimeSeries_Status_t 操作状态
+  */
+TimeSeries_Status_t TimeSeries_GetBucket(const char *key, TimeSeries_Res_t res,
+                                         uint16_t age, TimeSeries_Bucket_t *bucket);
+
+/**
+  * @brief  提交一个查询请求 (JSON, 通常来自MQTT)
+  * @param  json 请求字符串
+  * @retval TimeSeries_Status_t 操作状态
+  */
+TimeSeries_Status_t TimeSeries_RequestQuery(const char *json);
+
+/**
+  * @brief  生成查询应答的下一块
+  * @param  buf 输出缓冲区 (建议 TIMESERIES_CHUNK_SIZE)
+  * @param  size 缓冲区大小
+  * @retval int 本块长度, 0 表示没有待发送的数据
+  */
+int TimeSeries_NextChunk(char *buf, uint16_t size);
+
+/**
+  * @brief  调试打印函数
+  * @param  format 格式化字符串
+  */
+void TimeSeries_DebugPrint(const char *format, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TIMESERIES_H */
@@ -0,0 +1,369 @@
+/**
+  ******************************************************************************
+  * @file           : boot.c
+  * @brief          : 启动编排源文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 签名 (FNV-1a): WiFi 为 ssid/password, MQTT 为 clientId/username/password/
+  * host/port/keepAlive。签名一致只说明模块里保存的是同一组参数, 是否真的连着
+  * 仍以 CWJAP? + CIFSR / MQTTCONN? 的结果为准。
+  *
+  * 快速重连缓存 (wifi.bssid/channel/ip/gateway/netmask) 只在WiFi签名一致时
+  * 加载; 入网方式改变了缓存 (换AP、重新分配地址) 才写回。
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "boot.h"
+#include "config_store.h"
+#include "mem_region.h"
+#include "metrics.h"
+#include "log.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+#define TAG_BOOT                    "BOOT"
+
+/* FNV-1a 32位 */
+#define BOOT_FNV_OFFSET             2166136261UL
+#define BOOT_FNV_PRIME              16777619UL
+
+/* Private variables ---------------------------------------------------------*/
+
+/* 启动编排句柄实例 */
+Boot_Handle_t boot CCM_BSS;
+
+/* 健康指标: 复位到第一次发布 (ms) */
+static Metric_t bootMsMetric = METRIC_SOURCE_INIT("boot.ms", METRIC_GAUGE, &boot.totalMs);
+
+/* 阶段名 (JSON字段名) */
+static const char *const bootStageNames[BOOT_STAGE_COUNT] = {
+    "init", "sensors", "esp", "wifi", "mqtt", "sub", "publish"
+};
+
+/* 路径名 */
+static const char *const bootWifiPathNames[] = { "none", "kept", "auto", "fast", "join", "fail" };
+static const char *const bootMqttPathNames[] = { "none", "kept", "connect", "fail" };
+
+/* Private function prototypes -----------------------------------------------*/
+static void Boot_Background(void);
+static uint32_t Boot_Hash(uint32_t hash, const void *data, uint32_t len);
+static uint32_t Boot_HashStr(uint32_t hash, const char *str);
+static uint8_t Boot_WifiUp(const char *ssid);
+static void Boot_LoadJoinCache(void);
+static void Boot_SaveJoinCache(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  模块等待钩子: 运行后台任务并计数
+  */
+static void Boot_Background(void)
+{
+    boot.backgroundRuns++;
+    if (boot.background != NULL) {
+        boot.background();
+    }
+}
+
+static uint32_t Boot_Hash(uint32_t hash, const void *data, uint32_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    while (len--) {
+        hash ^= *p++;
+        hash *= BOOT_FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+  * @brief  字符串连同结尾 '\0' 计入哈希, 相邻字段不会互相混淆
+  */
+static uint32_t Boot_HashStr(uint32_t hash, const char *str)
+{
+    if (str == NULL) {
+        str = "";
+    }
+    return Boot_Hash(hash, str, (uint32_t)strlen(str) + 1);
+}
+
+/**
+  * @brief  模块是否已连着指定的AP并拿到IP (结果留在 esp8266.ipInfo)
+  */
+static uint8_t Boot_WifiUp(const char *ssid)
+{
+    ESP8266_APInfo_t ap;
+
+    if (ESP8266_GetAPInfo(&ap) != ESP8266_OK || strcmp(ap.ssid, ssid) != 0) {
+        return 0;
+    }
+    if (ESP8266_GetIPInfo(&esp8266.ipInfo) != ESP8266_OK || esp8266.ipInfo.ip[0] == '\0' ||
+        strcmp(esp8266.ipInfo.ip, "0.0.0.0") == 0) {
+        return 0;
+    }
+    return 1;
+}
+
+/**
+  * @brief  从配置存储恢复快速重连缓存 (任一项缺失则缓存无效)
+  */
+static void Boot_LoadJoinCache(void)
+{
+    ESP8266_JoinCache_t *cache = &esp8266.joinCache;
+
+    memset(cache, 0, sizeof(ESP8266_JoinCache_t));
+    strncpy(cache->bssid, ConfigStore_GetStr(CONFIG_KEY_WIFI_BSSID, ""), sizeof(cache->bssid) - 1);
+    cache->channel = (uint8_t)ConfigStore_GetU32(CONFIG_KEY_WIFI_CHANNEL, 0);
+    strncpy(cache->lease.ip, ConfigStore_GetStr(CONFIG_KEY_WIFI_IP, ""), sizeof(cache->lease.ip) - 1);
+    strncpy(cache->lease.gateway, ConfigStore_GetStr(CONFIG_KEY_WIFI_GATEWAY, ""),
+            sizeof(cache->lease.gateway) - 1);
+    strncpy(cache->lease.netmask, ConfigStore_GetStr(CONFIG_KEY_WIFI_NETMASK, ""),
+            sizeof(cache->lease.netmask) - 1);
+    if (!ESP8266_JoinCacheValid()) {
+        memset(cache, 0, sizeof(ESP8266_JoinCache_t));
+    }
+}
+
+/**
+  * @brief  快速重连缓存写回配置存储 (值未变的键不写Flash)
+  */
+static void Boot_SaveJoinCache(void)
+{
+    const ESP8266_JoinCache_t *cache = &esp8266.joinCache;
+
+    if (!ESP8266_JoinCacheValid()) {
+        return;
+    }
+    ConfigStore_SetStr(CONFIG_KEY_WIFI_BSSID, cache->bssid);
+    ConfigStore_SetU32(CONFIG_KEY_WIFI_CHANNEL, cache->channel);
+    ConfigStore_SetStr(CONFIG_KEY_WIFI_IP, cache->lease.ip);
+    ConfigStore_SetStr(CONFIG_KEY_WIFI_GATEWAY, cache->lease.gateway);
+    ConfigStore_SetStr(CONFIG_KEY_WIFI_NETMASK, cache->lease.netmask);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  开始记录时间线并设置等待钩子
+  */
+void Boot_Init(void (*background)(void))
+{
+    memset(&boot, 0, sizeof(boot));
+    boot.background = background;
+    ESP8266_SetWaitHook(Boot_Background);
+    Metrics_Register(&bootMsMetric);
+    Boot_Mark(BOOT_STAGE_INIT);
+}
+
+/**
+  * @brief  记录阶段完成时间
+  */
+void Boot_Mark(Boot_Stage_t stage)
+{
+    if ((uint32_t)stage >= BOOT_STAGE_COUNT || Boot_IsMarked(stage)) {
+        return;
+    }
+    boot.stamp[stage] = HAL_GetTick();
+    boot.marked |= (uint8_t)(1U << stage);
+
+    if (stage == BOOT_STAGE_PUBLISH) {
+        boot.totalMs = boot.stamp[stage];
+        LOG_I(TAG_BOOT, "Timeline (ms): sensors %lu esp %lu wifi %lu (%s) mqtt %lu (%s) sub %lu publish %lu",
+              (unsigned long)boot.stamp[BOOT_STAGE_SENSORS], (unsigned long)boot.stamp[BOOT_STAGE_ESP],
+              (unsigned long)boot.stamp[BOOT_STAGE_WIFI], bootWifiPathNames[boot.wifiPath],
+              (unsigned long)boot.stamp[BOOT_STAGE_MQTT], bootMqttPathNames[boot.mqttPath],
+              (unsigned long)boot.stamp[BOOT_STAGE_SUB], (unsigned long)boot.stamp[BOOT_STAGE_PUBLISH]);
+    }
+}
+
+/**
+  * @brief  阶段是否已记录
+  */
+uint8_t Boot_IsMarked(Boot_Stage_t stage)
+{
+    return (uint32_t)stage < BOOT_STAGE_COUNT && (boot.marked & (1U << stage)) != 0;
+}
+
+/**
+  * @brief  初始化模块并接入WiFi
+  */
+ESP8266_Status_t Boot_Wifi(UART_HandleTypeDef *huart, const char *ssid, const char *password)
+{
+    ESP8266_Status_t status;
+    uint32_t sig;
+    uint32_t start;
+    uint8_t sigMatch;
+
+    if (ssid == NULL) {
+        return ESP8266_INVALID_PARAM;
+    }
+
+    status = ESP8266_Init(huart);
+    if (status != ESP8266_OK) {
+        boot.wifiPath = BOOT_WIFI_FAIL;
+        return status;
+    }
+    Boot_Mark(BOOT_STAGE_ESP);
+
+    sig = Boot_HashStr(Boot_HashStr(BOOT_FNV_OFFSET, ssid), password);
+    sigMatch = (ConfigStore_GetU32(CONFIG_KEY_BOOT_WIFI_SIG, 0) == sig);
+
+    /* 缓存只对同一组凭据有效 */
+    if (sigMatch) {
+        Boot_LoadJoinCache();
+    }
+
+    if (Boot_WifiUp(ssid)) {
+        /* 只复位了MCU */
+        boot.wifiPath = BOOT_WIFI_KEPT;
+    } else if (sigMatch && !ESP8266_JoinCacheValid()) {
+        /* 模块保存的是同一组凭据, 上电后自己会连 (有缓存时快速重连更快, 不等) */
+        start = HAL_GetTick();
+        while (HAL_GetTick() - start < BOOT_AUTOCONN_WAIT_MS) {
+            ESP8266_Delay(BOOT_AUTOCONN_POLL_MS);
+            if (Boot_WifiUp(ssid)) {
+                boot.wifiPath = BOOT_WIFI_AUTO;
+                break;
+            }
+        }
+    }
+
+    if (boot.wifiPath == BOOT_WIFI_NONE) {
+        status = ESP8266_Rejoin(ssid, password);
+        if (status != ESP8266_OK) {
+            boot.wifiPath = BOOT_WIFI_FAIL;
+            return status;
+        }
+        if (esp8266.lastJoinPath == ESP8266_JOIN_FAST) {
+            boot.wifiPath = BOOT_WIFI_FAST;
+        } else {
+            boot.wifiPath = BOOT_WIFI_JOIN;
+            ESP8266_SetAutoConnect(1);
+            ConfigStore_SetU32(CONFIG_KEY_BOOT_WIFI_SIG, sig);
+        }
+    } else {
+        esp8266.wifiConnected = 1;
+        if (esp8266.onWifiConnected) esp8266.onWifiConnected();
+        if (!ESP8266_JoinCacheValid()) {
+            ESP8266_UpdateJoinCache();
+        }
+    }
+    Boot_SaveJoinCache();
+
+    Boot_Mark(BOOT_STAGE_WIFI);
+    LOG_I(TAG_BOOT, "WiFi %s, IP %s", bootWifiPathNames[boot.wifiPath], esp8266.ipInfo.ip);
+    return ESP8266_OK;
+}
+
+/**
+  * @brief  配置并连接代理, 然后订阅主题
+  */
+MQTT_Status_t Boot_Mqtt(const MQTT_UserConfig_t *userConfig, const char *host, uint16_t port,
+                        uint16_t keepAlive, const Boot_Topic_t *topics, uint8_t count)
+{
+    MQTT_Status_t ret;
+    uint32_t sig;
+    uint32_t num;
+    uint8_t i;
+
+    if (userConfig == NULL || host == NULL) {
+        return MQTT_INVALID_PARAM;
+    }
+
+    /* 只保存在本地, 断线重连时使用 */
+    MQTT_SetKeepAlive(keepAlive);
+    MQTT_SetBroker(host, port, 1);
+
+    sig = Boot_HashStr(BOOT_FNV_OFFSET, userConfig->clientId);
+    sig = Boot_HashStr(sig, userConfig->username);
+    sig = Boot_HashStr(sig, userConfig->password);
+    sig = Boot_HashStr(sig, host);
+    num = ((uint32_t)port << 16) | keepAlive;
+    sig = Boot_Hash(sig, &num, sizeof(num));
+
+    /* 模块没有复位过才可能还连着代理 */
+    if (boot.wifiPath == BOOT_WIFI_KEPT && ConfigStore_GetU32(CONFIG_KEY_BOOT_MQTT_SIG, 0) == sig &&
+        MQTT_QueryConnection() == MQTT_OK && mqtt.connected) {
+        boot.mqttPath = BOOT_MQTT_KEPT;
+        memcpy(&mqtt.userConfig, userConfig, sizeof(MQTT_UserConfig_t));
+        if (mqtt.onConnected) mqtt.onConnected();
+    } else {
+        mqtt.connected = 0;
+        ret = MQTT_SetUserConfig(userConfig);
+        if (ret == MQTT_OK) {
+            ret = MQTT_SetConnConfig(&mqtt.connConfig);
+        }
+        if (ret == MQTT_OK) {
+            ret = MQTT_Connect();
+        }
+        if (ret != MQTT_OK) {
+            boot.mqttPath = BOOT_MQTT_FAIL;
+            LOG_E(TAG_BOOT, "MQTT connect failed (%d)", ret);
+            return ret;
+        }
+        boot.mqttPath = BOOT_MQTT_CONNECT;
+        ConfigStore_SetU32(CONFIG_KEY_BOOT_MQTT_SIG, sig);
+    }
+    Boot_Mark(BOOT_STAGE_MQTT);
+    LOG_I(TAG_BOOT, "MQTT %s %s:%u", bootMqttPathNames[boot.mqttPath], host, port);
+
+    for (i = 0; i < count; i++) {
+        if (MQTT_Subscribe(topics[i].topic, topics[i].qos) == MQTT_OK) {
+            LOG_I("MQTT", "Subscribed to %s", topics[i].topic);
+        } else {
+            LOG_E("MQTT", "Subscribe to %s failed!", topics[i].topic);
+        }
+    }
+    Boot_Mark(BOOT_STAGE_SUB);
+    return MQTT_OK;
+}
+
+/**
+  * @brief  取消等待钩子
+  */
+void Boot_Finish(void)
+{
+    ESP8266_SetWaitHook(NULL);
+}
+
+/**
+  * @brief  生成JSON
+  */
+int Boot_FormatJson(char *buf, uint16_t size)
+{
+    int len;
+    int n;
+    uint8_t i;
+
+    if (buf == NULL || size == 0) {
+        return 0;
+    }
+
+    len = snprintf(buf, size, "{\"boot\":{");
+    for (i = 0; i < BOOT_STAGE_COUNT && len > 0 && len < size; i++) {
+        if (Boot_IsMarked((Boot_Stage_t)i)) {
+            n = snprintf(buf + len, size - len, "\"%s\":%lu,", bootStageNames[i],
+                         (unsigned long)boot.stamp[i]);
+            len = (n < 0) ? -1 : len + n;
+        }
+    }
+    if (len > 0 && len < size) {
+        n = snprintf(buf + len, size - len, "\"wifi_path\":\"%s\",\"mqtt_path\":\"%s\",\"bg\":%lu}}",
+                     bootWifiPathNames[boot.wifiPath], bootMqttPathNames[boot.mqttPath],
+                     (unsigned long)boot.backgroundRuns);
+        len = (n < 0) ? -1 : len + n;
+    }
+    if (len < 0 || len >= size) {
+        buf[0] = '\0';
+        return 0;
+    }
+    return len;
+}
+
+/* End of file ---------------------------------------------------------------*/
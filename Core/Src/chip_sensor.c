@@ -0,0 +1,200 @@
+/**
+  ******************************************************************************
+  * @file           : chip_sensor.c
+  * @brief          : 片内传感器驱动源文件 (VREFINT + 内部温度传感器)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * ADC1 连续扫描 VREFINT / TEMPSENSOR, DMA2_Stream4 循环模式写入
+  * chipSensorBuf, 缓冲区始终保存最近 CHIP_SENSOR_AVG_SAMPLES 轮扫描结果
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "chip_sensor.h"
+#include "mem_region.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+#define CHIP_SENSOR_BUF_LEN     (CHIP_SENSOR_CHANNELS * CHIP_SENSOR_AVG_SAMPLES)
+
+/* Private variables ---------------------------------------------------------*/
+
+/* 片内传感器句柄实例 */
+ChipSensor_Handle_t chipSensor = {0};
+
+/* DMA循环缓冲区 (按Rank交错: VREFINT, TEMP, VREFINT, TEMP ...) */
+static volatile uint16_t chipSensorBuf[CHIP_SENSOR_BUF_LEN] DMA_BUFFER;
+
+/* 健康指标: ADC1 溢出 (DMA未及时取走数据, 扫描停止后重新启动) */
+static Metric_t adcOverrunMetric = METRIC_COUNTER_INIT("adc.ovr");
+
+/* Private function prototypes -----------------------------------------------*/
+static uint16_t ChipSensor_Average(uint8_t rank);
+static HAL_StatusTypeDef ChipSensor_StartScan(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  对某一Rank的所有采样求平均
+  * @param  rank 通道在扫描序列中的位置
+  * @retval uint16_t 平均值
+  */
+static uint16_t ChipSensor_Average(uint8_t rank)
+{
+    uint32_t sum = 0;
+
+    for (uint16_t i = rank; i < CHIP_SENSOR_BUF_LEN; i += CHIP_SENSOR_CHANNELS) {
+        sum += chipSensorBuf[i];
+    }
+
+    return (uint16_t)(sum / CHIP_SENSOR_AVG_SAMPLES);
+}
+
+/**
+  * @brief  启动ADC1循环DMA扫描
+  */
+static HAL_StatusTypeDef ChipSensor_StartScan(void)
+{
+    if (HAL_ADC_Start_DMA(chipSensor.hadc, (uint32_t *)chipSensorBuf, CHIP_SENSOR_BUF_LEN) != HAL_OK) {
+        return HAL_ERROR;
+    }
+
+    /* 只需要随时读取最新数据, 关闭半传输/传输完成中断, 避免约每毫秒数次的无用中断 */
+    __HAL_DMA_DISABLE_IT(chipSensor.hadc->DMA_Handle, DMA_IT_HT | DMA_IT_TC);
+    return HAL_OK;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  初始化片内传感器 (启动ADC1循环DMA扫描)
+  */
+ChipSensor_Status_t ChipSensor_Init(void)
+{
+    /* 绑定ADC句柄 */
+    chipSensor.hadc = &hadc1;
+
+    /* 初始化状态变量 */
+    chipSensor.vrefint_raw = 0;
+    chipSensor.temp_raw = 0;
+    chipSensor.vdda_mV = CHIP_SENSOR_CAL_VDDA_MV;
+    chipSensor.temperature = 0.0f;
+    chipSensor.last_update_tick = 0;
+    memset((void *)chipSensorBuf, 0, sizeof(chipSensorBuf));
+
+    /* 启动循环DMA: ADC1连续扫描, 之后无需CPU参与 */
+    if (ChipSensor_StartScan() != HAL_OK) {
+        return CHIP_SENSOR_ERROR;
+    }
+    Metrics_Register(&adcOverrunMetric);
+
+    /* 标记为已初始化 */
+    chipSensor.is_initialized = 1;
+
+    ChipSensor_DebugPrint("[ChipSensor] Initialized, VREFINT_CAL=%u TS_CAL1=%u TS_CAL2=%u\r\n",
+                          *CHIP_SENSOR_VREFINT_CAL_ADDR,
+                          *CHIP_SENSOR_TS_CAL1_ADDR,
+                          *CHIP_SENSOR_TS_CAL2_ADDR);
+
+    return CHIP_SENSOR_OK;
+}
+
+/**
+  * @brief  根据DMA缓冲区更新VDDA与温度
+  */
+ChipSensor_Status_t ChipSensor_Update(void)
+{
+    uint16_t vrefint, temp;
+    uint32_t vdda;
+    int32_t tempAt3v3, cal1, cal2;
+
+    if (!chipSensor.is_initialized) {
+        return CHIP_SENSOR_NOT_INITIALIZED;
+    }
+
+    /* 溢出后ADC不再发出DMA请求, 缓冲区停在旧值, 计数并重新启动扫描 */
+    if (__HAL_ADC_GET_FLAG(chipSensor.hadc, ADC_FLAG_OVR)) {
+        Metrics_Inc(&adcOverrunMetric);
+        HAL_ADC_Stop_DMA(chipSensor.hadc);
+        __HAL_ADC_CLEAR_FLAG(chipSensor.hadc, ADC_FLAG_OVR);
+        ChipSensor_StartScan();
+    }
+
+    vrefint = ChipSensor_Average(CHIP_SENSOR_RANK_VREFINT);
+    temp = ChipSensor_Average(CHIP_SENSOR_RANK_TEMP);
+
+    /* 缓冲区尚未写满一轮 */
+    if (vrefint == 0) {
+        return CHIP_SENSOR_NOT_READY;
+    }
+
+    /* VDDA = 3.3V * VREFINT_CAL / VREFINT_DATA */
+    vdda = (uint32_t)CHIP_SENSOR_CAL_VDDA_MV * (*CHIP_SENSOR_VREFINT_CAL_ADDR) / vrefint;
+    if (vdda < CHIP_SENSOR_VDDA_MIN_MV || vdda > CHIP_SENSOR_VDDA_MAX_MV) {
+        return CHIP_SENSOR_ERROR;
+    }
+
+    /* 温度校准值在VDDA=3.3V下测得, 先把当前读数折算到3.3V */
+    tempAt3v3 = (int32_t)((uint32_t)temp * vdda / CHIP_SENSOR_CAL_VDDA_MV);
+    cal1 = *CHIP_SENSOR_TS_CAL1_ADDR;
+    cal2 = *CHIP_SENSOR_TS_CAL2_ADDR;
+    if (cal2 <= cal1) {
+        return CHIP_SENSOR_ERROR;
+    }
+
+    chipSensor.vrefint_raw = vrefint;
+    chipSensor.temp_raw = temp;
+    chipSensor.vdda_mV = (uint16_t)vdda;
+    chipSensor.temperature = (float)(CHIP_SENSOR_TS_CAL2_TEMP - CHIP_SENSOR_TS_CAL1_TEMP) *
+                             (float)(tempAt3v3 - cal1) / (float)(cal2 - cal1) +
+                             (float)CHIP_SENSOR_TS_CAL1_TEMP;
+    chipSensor.last_update_tick = HAL_GetTick();
+
+    return CHIP_SENSOR_OK;
+}
+
+/**
+  * @brief  获取测得的VDDA (自动更新一次)
+  */
+uint16_t ChipSensor_GetVdda_mV(void)
+{
+    ChipSensor_Update();
+    return chipSensor.vdda_mV;
+}
+
+/**
+  * @brief  获取芯片温度 (自动更新一次)
+  */
+float ChipSensor_GetTemperature(void)
+{
+    ChipSensor_Update();
+    return chipSensor.temperature;
+}
+
+/**
+  * @brief  调试打印函数 - 使用统一日志库
+  */
+void ChipSensor_DebugPrint(const char *format, ...)
+{
+#if CHIP_SENSOR_DEBUG_ENABLE
+    static LOG_Tag_t *logTag;
+    va_list args;
+    
+    /* 先判断标签级别, 关闭时不做格式化 */
+    if (!LOG_TagEnabled(&logTag, "CHIP", LOG_LEVEL_DEBUG)) return;
+    
+    va_start(args, format);
+    LOG_VRaw(format, args);
+    va_end(args);
+#else
+    (void)format;
+#endif
+}
+
+/* End of file ---------------------------------------------------------------*/
@@ -0,0 +1,107 @@
+/**
+  ******************************************************************************
+  * @file           : config_flash.c
+  * @brief          : 配置存储的内部Flash扇区对 (目标板) 源文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 按字编程 (FLASH_TYPEPROGRAM_WORD, 电压范围3, 2.7~3.6V)。F407 只有一个
+  * Flash bank, 擦写期间 CPU 从 Flash 取指会被挂起, 直到操作完成。
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "config_flash.h"
+#include <string.h>
+
+/* Private function prototypes -----------------------------------------------*/
+static const uint8_t* ConfigFlash_Sector(uint8_t index);
+static ConfigStore_Status_t ConfigFlash_Erase(uint8_t index);
+static ConfigStore_Status_t ConfigFlash_Program(uint8_t index, uint32_t offset, const void *data, uint32_t len);
+
+/* Private variables ---------------------------------------------------------*/
+
+static const ConfigStore_Flash_t configFlash = {
+    CONFIG_FLASH_SECTOR_SIZE,
+    ConfigFlash_Sector,
+    ConfigFlash_Erase,
+    ConfigFlash_Program
+};
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  扇区的映射地址
+  */
+static const uint8_t* ConfigFlash_Sector(uint8_t index)
+{
+    return (const uint8_t *)(index ? CONFIG_FLASH_ADDR_B : CONFIG_FLASH_ADDR_A);
+}
+
+/**
+  * @brief  擦除扇区
+  */
+static ConfigStore_Status_t ConfigFlash_Erase(uint8_t index)
+{
+    FLASH_EraseInitTypeDef erase;
+    uint32_t sectorError = 0;
+    HAL_StatusTypeDef status;
+
+    erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+    erase.Banks = FLASH_BANK_1;
+    erase.Sector = index ? CONFIG_FLASH_SECTOR_B : CONFIG_FLASH_SECTOR_A;
+    erase.NbSectors = 1;
+    erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+
+    HAL_FLASH_Unlock();
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR |
+                           FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+    status = HAL_FLASHEx_Erase(&erase, &sectorError);
+    HAL_FLASH_Lock();
+
+    return (status == HAL_OK) ? CONFIG_STORE_OK : CONFIG_STORE_ERROR;
+}
+
+/**
+  * @brief  按字编程并回读校验
+  */
+static ConfigStore_Status_t ConfigFlash_Program(uint8_t index, uint32_t offset, const void *data, uint32_t len)
+{
+    uint32_t address = (uint32_t)ConfigFlash_Sector(index) + offset;
+    const uint8_t *src = (const uint8_t *)data;
+    HAL_StatusTypeDef status = HAL_OK;
+    uint32_t word;
+    uint32_t i;
+
+    if ((offset & 3U) != 0 || (len & 3U) != 0 || offset + len > CONFIG_FLASH_SECTOR_SIZE) {
+        return CONFIG_STORE_INVALID_PARAM;
+    }
+
+    HAL_FLASH_Unlock();
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR |
+                           FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+    for (i = 0; i < len && status == HAL_OK; i += 4) {
+        memcpy(&word, src + i, sizeof(word));
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address + i, word);
+    }
+    HAL_FLASH_Lock();
+
+    if (status != HAL_OK || memcmp((const void *)address, data, len) != 0) {
+        return CONFIG_STORE_ERROR;
+    }
+    return CONFIG_STORE_OK;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  内部Flash扇区对
+  */
+const ConfigStore_Flash_t* ConfigFlash_Get(void)
+{
+    return &configFlash;
+}
+
+/* End of file ---------------------------------------------------------------*/
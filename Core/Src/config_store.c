@@ -0,0 +1,698 @@
+/**
+  ******************************************************************************
+  * @file           : config_store.c
+  * @brief          : Flash 键值配置存储源文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "config_store.h"
+#include "mem_region.h"
+#include "metrics.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+/* 擦除状态的字 */
+#define CONFIG_ERASED               0xFFFFFFFFUL
+
+/* 按4字节补齐 */
+#define CONFIG_ALIGN4(n)            (((uint32_t)(n) + 3U) & ~3U)
+
+/* Private types -------------------------------------------------------------*/
+
+/**
+  * @brief  键描述
+  */
+typedef struct {
+    const char *name;               /**< 键名 (JSON字段名) */
+    uint8_t type;                   /**< ConfigStore_Type_t */
+    uint8_t secret;                 /**< 查询时隐藏 */
+} ConfigStore_KeyDesc_t;
+
+/* Private variables ---------------------------------------------------------*/
+
+/* 键表 (与 ConfigStore_Key_t 顺序一致) */
+static const ConfigStore_KeyDesc_t configKeys[CONFIG_KEY_COUNT] = {
+    { "wifi.ssid",          CONFIG_TYPE_STR,   0 },
+    { "wifi.pass",          CONFIG_TYPE_STR,   1 },
+    { "mqtt.host",          CONFIG_TYPE_STR,   0 },
+    { "mqtt.port",          CONFIG_TYPE_U32,   0 },
+    { "mqtt.client_id",     CONFIG_TYPE_STR,   0 },
+    { "mqtt.user",          CONFIG_TYPE_STR,   0 },
+    { "mqtt.pass",          CONFIG_TYPE_STR,   1 },
+    { "sample.light",       CONFIG_TYPE_U32,   0 },
+    { "sample.chip",        CONFIG_TYPE_U32,   0 },
+    { "sample.dht11",       CONFIG_TYPE_U32,   0 },
+    { "dead.temp",          CONFIG_TYPE_FLOAT, 0 },
+    { "dead.humi",          CONFIG_TYPE_FLOAT, 0 },
+    { "dead.light",         CONFIG_TYPE_FLOAT, 0 },
+    { "dead.board_temp",    CONFIG_TYPE_FLOAT, 0 },
+    { "boot.wifi_sig",      CONFIG_TYPE_U32,   0 },
+    { "boot.mqtt_sig",      CONFIG_TYPE_U32,   0 },
+    { "wifi.bssid",         CONFIG_TYPE_STR,   0 },
+    { "wifi.channel",       CONFIG_TYPE_U32,   0 },
+    { "wifi.ip",            CONFIG_TYPE_STR,   0 },
+    { "wifi.gateway",       CONFIG_TYPE_STR,   0 },
+    { "wifi.netmask",       CONFIG_TYPE_STR,   0 },
+};
+
+/* CRC-32 (0xEDB88320) 半字节查表 */
+static const uint32_t configCrcTable[16] = {
+    0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL,
+    0x76DC4190UL, 0x6B6B51F4UL, 0x4DB26158UL, 0x5005713CUL,
+    0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL,
+    0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL
+};
+
+/* 配置存储句柄实例 */
+ConfigStore_Handle_t configStore CCM_BSS;
+
+/* 健康指标 */
+static Metric_t configCompactMetric = METRIC_SOURCE_INIT("cfg.compact", METRIC_COUNTER, &configStore.compactions);
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t ConfigStore_Crc(uint32_t head, const uint8_t *value, uint16_t len);
+static uint32_t ConfigStore_Word(const uint8_t *sector, uint32_t offset);
+static uint8_t ConfigStore_RecordValid(const uint8_t *sector, uint32_t offset);
+static void ConfigStore_Scan(uint8_t verify);
+static ConfigStore_Status_t ConfigStore_Format(uint8_t index, uint32_t seq);
+static ConfigStore_Status_t ConfigStore_Compact(void);
+static ConfigStore_Status_t ConfigStore_CheckValue(ConfigStore_Key_t key, const void *data, uint16_t len);
+static const char* ConfigStore_ParseString(const char *p, char *out, uint16_t size, uint16_t *len);
+static int ConfigStore_WalkJson(const char *json, uint8_t apply, char *badKey, uint16_t badSize);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  记录的校验值: 覆盖 key/len 与 value, 0xFFFFFFFF 保留给 "未写入"
+  */
+static uint32_t ConfigStore_Crc(uint32_t head, const uint8_t *value, uint16_t len)
+{
+    uint32_t crc = 0xFFFFFFFFUL;
+    uint8_t b;
+    uint16_t i;
+
+    for (i = 0; i < 4 + len; i++) {
+        b = (i < 4) ? (uint8_t)(head >> (8 * i)) : value[i - 4];
+        crc = configCrcTable[(crc ^ b) & 0x0F] ^ (crc >> 4);
+        crc = configCrcTable[(crc ^ (b >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    crc = ~crc;
+    return (crc == CONFIG_ERASED) ? 0 : crc;
+}
+
+/**
+  * @brief  读扇区中的一个字
+  */
+static uint32_t ConfigStore_Word(const uint8_t *sector, uint32_t offset)
+{
+    uint32_t word;
+
+    memcpy(&word, sector + offset, sizeof(word));
+    return word;
+}
+
+/**
+  * @brief  校验一条记录
+  */
+static uint8_t ConfigStore_RecordValid(const uint8_t *sector, uint32_t offset)
+{
+    uint32_t head = ConfigStore_Word(sector, offset);
+    uint32_t crc = ConfigStore_Word(sector, offset + 4);
+
+    return crc != CONFIG_ERASED &&
+           crc == ConfigStore_Crc(head, sector + offset + CONFIG_STORE_RECORD_HEAD, (uint16_t)(head >> 16));
+}
+
+/**
+  * @brief  遍历活动扇区的记录头建立索引
+  * @param  verify: 0=只跳过 crc 未写入的记录, 1=逐条校验 crc
+  */
+static void ConfigStore_Scan(uint8_t verify)
+{
+    const uint8_t *sector = configStore.flash->sector(configStore.active);
+    uint32_t size = configStore.flash->sectorSize;
+    uint32_t offset = CONFIG_STORE_HEADER_SIZE;
+    uint32_t head, total;
+    uint16_t key, len;
+
+    memset(configStore.index, 0, sizeof(configStore.index));
+    configStore.skipped = 0;
+
+    while (offset + CONFIG_STORE_RECORD_HEAD <= size) {
+        head = ConfigStore_Word(sector, offset);
+        if (head == CONFIG_ERASED) {
+            break;
+        }
+
+        key = (uint16_t)(head & 0xFFFF);
+        len = (uint16_t)(head >> 16);
+        total = CONFIG_STORE_RECORD_HEAD + CONFIG_ALIGN4(len);
+        if (len > CONFIG_VALUE_MAX_LEN || offset + total > size) {
+            /* 记录头本身写坏了, 之后的空间不再可信: 下一次写入时压缩 */
+            configStore.skipped++;
+            offset = size;
+            break;
+        }
+
+        if (ConfigStore_Word(sector, offset + 4) == CONFIG_ERASED ||
+            (verify && !ConfigStore_RecordValid(sector, offset))) {
+            configStore.skipped++;
+        } else if (key < CONFIG_KEY_COUNT) {
+            configStore.index[key] = (len > 0) ? (uint16_t)offset : 0;
+        }
+        offset += total;
+    }
+
+    configStore.writeOffset = offset;
+}
+
+/**
+  * @brief  擦除并写入扇区头部 (magic 最后写入)
+  */
+static ConfigStore_Status_t ConfigStore_Format(uint8_t index, uint32_t seq)
+{
+    uint32_t magic = CONFIG_STORE_MAGIC;
+
+    if (configStore.flash->erase(index) != CONFIG_STORE_OK ||
+        configStore.flash->program(index, 4, &seq, 4) != CONFIG_STORE_OK ||
+        configStore.flash->program(index, 0, &magic, 4) != CONFIG_STORE_OK) {
+        return CONFIG_STORE_ERROR;
+    }
+    return CONFIG_STORE_OK;
+}
+
+/**
+  * @brief  把各键的最新记录搬到另一个扇区, 头部最后写入
+  */
+static ConfigStore_Status_t ConfigStore_Compact(void)
+{
+    const uint8_t *src = configStore.flash->sector(configStore.active);
+    uint8_t dst = configStore.active ^ 1U;
+    uint16_t index[CONFIG_KEY_COUNT];
+    uint32_t offset = CONFIG_STORE_HEADER_SIZE;
+    uint32_t seq = configStore.seq + 1;
+    uint32_t magic = CONFIG_STORE_MAGIC;
+    uint32_t total;
+    uint8_t key;
+
+    if (configStore.flash->erase(dst) != CONFIG_STORE_OK) {
+        return CONFIG_STORE_ERROR;
+    }
+
+    memset(index, 0, sizeof(index));
+    for (key = 0; key < CONFIG_KEY_COUNT; key++) {
+        if (configStore.index[key] == 0) {
+            continue;
+        }
+        total = CONFIG_STORE_RECORD_HEAD + CONFIG_ALIGN4(ConfigStore_Word(src, configStore.index[key]) >> 16);
+        if (configStore.flash->program(dst, offset, src + configStore.index[key], total) != CONFIG_STORE_OK) {
+            return CONFIG_STORE_ERROR;
+        }
+        index[key] = (uint16_t)offset;
+        offset += total;
+    }
+
+    if (configStore.flash->program(dst, 4, &seq, 4) != CONFIG_STORE_OK ||
+        configStore.flash->program(dst, 0, &magic, 4) != CONFIG_STORE_OK) {
+        return CONFIG_STORE_ERROR;
+    }
+
+    configStore.active = dst;
+    configStore.seq = seq;
+    configStore.writeOffset = offset;
+    memcpy(configStore.index, index, sizeof(index));
+    configStore.compactions++;
+    LOG_I("CONFIG", "Compacted into sector %u (seq %lu, %lu bytes)", dst,
+          (unsigned long)seq, (unsigned long)offset);
+    return CONFIG_STORE_OK;
+}
+
+/**
+  * @brief  检查值的类型与长度
+  */
+static ConfigStore_Status_t ConfigStore_CheckValue(ConfigStore_Key_t key, const void *data, uint16_t len)
+{
+    if ((uint32_t)key >= CONFIG_KEY_COUNT || len > CONFIG_VALUE_MAX_LEN || (len > 0 && data == NULL)) {
+        return CONFIG_STORE_INVALID_PARAM;
+    }
+    if (len == 0) {
+        return CONFIG_STORE_OK;
+    }
+
+    switch (configKeys[key].type) {
+    case CONFIG_TYPE_STR:
+        return (((const char *)data)[len - 1] == '\0') ? CONFIG_STORE_OK : CONFIG_STORE_INVALID_PARAM;
+    default:
+        return (len == 4) ? CONFIG_STORE_OK : CONFIG_STORE_INVALID_PARAM;
+    }
+}
+
+/**
+  * @brief  解析JSON字符串 (支持 \" \\ \/ 转义)
+  * @retval 结尾引号之后的位置, 格式错误或过长返回 NULL
+  */
+static const char* ConfigStore_ParseString(const char *p, char *out, uint16_t size, uint16_t *len)
+{
+    uint16_t n = 0;
+
+    if (*p++ != '"') return NULL;
+    while (*p != '"') {
+        if (*p == '\0') return NULL;
+        if (*p == '\\') {
+            p++;
+            if (*p != '"' && *p != '\\' && *p != '/') return NULL;
+        }
+        if (n + 1 >= size) return NULL;
+        out[n++] = *p++;
+    }
+    out[n] = '\0';
+    *len = n;
+    return p + 1;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  选出活动扇区并建立索引
+  */
+ConfigStore_Status_t ConfigStore_Init(const ConfigStore_Flash_t *flash)
+{
+    const uint8_t *sector;
+    uint32_t seq[2];
+    uint8_t valid[2];
+    uint8_t i;
+
+    memset(&configStore, 0, sizeof(configStore));
+    if (flash == NULL || flash->sector == NULL || flash->erase == NULL || flash->program == NULL ||
+        flash->sectorSize > 0x10000UL) {
+        return CONFIG_STORE_INVALID_PARAM;
+    }
+    configStore.flash = flash;
+    Metrics_Register(&configCompactMetric);
+
+    for (i = 0; i < 2; i++) {
+        sector = flash->sector(i);
+        valid[i] = (ConfigStore_Word(sector, 0) == CONFIG_STORE_MAGIC);
+        seq[i] = ConfigStore_Word(sector, 4);
+    }
+
+    if (!valid[0] && !valid[1]) {
+        /* 首次使用或恢复出厂后: 格式化扇区0 */
+        if (ConfigStore_Format(0, 1) != CONFIG_STORE_OK) {
+            LOG_E("CONFIG", "Format failed");
+            return CONFIG_STORE_ERROR;
+        }
+        configStore.active = 0;
+        configStore.seq = 1;
+    } else {
+        configStore.active = (valid[1] && (!valid[0] || seq[1] > seq[0])) ? 1 : 0;
+        configStore.seq = seq[configStore.active];
+    }
+
+    /* 快速路径只跳过未写完的记录, 再校验各键的最新记录; 有损坏时逐条校验重建 */
+    ConfigStore_Scan(0);
+    sector = flash->sector(configStore.active);
+    for (i = 0; i < CONFIG_KEY_COUNT; i++) {
+        if (configStore.index[i] != 0 && !ConfigStore_RecordValid(sector, configStore.index[i])) {
+            LOG_W("CONFIG", "Corrupt record for %s, rescanning", configKeys[i].name);
+            ConfigStore_Scan(1);
+            break;
+        }
+    }
+
+    configStore.ready = 1;
+    LOG_I("CONFIG", "Sector %u seq %lu, %lu/%lu bytes used, %lu skipped", configStore.active,
+          (unsigned long)configStore.seq, (unsigned long)configStore.writeOffset,
+          (unsigned long)flash->sectorSize, (unsigned long)configStore.skipped);
+    return CONFIG_STORE_OK;
+}
+
+/**
+  * @brief  读取原始值
+  */
+ConfigStore_Status_t ConfigStore_Get(ConfigStore_Key_t key, void *buf, uint16_t size, uint16_t *len)
+{
+    const uint8_t *sector;
+    uint16_t n;
+
+    if (!configStore.ready) return CONFIG_STORE_NOT_READY;
+    if ((uint32_t)key >= CONFIG_KEY_COUNT) return CONFIG_STORE_INVALID_PARAM;
+    if (configStore.index[key] == 0) return CONFIG_STORE_NOT_FOUND;
+
+    sector = configStore.flash->sector(configStore.active);
+    n = (uint16_t)(ConfigStore_Word(sector, configStore.index[key]) >> 16);
+    if (len) *len = n;
+    if (buf == NULL || n > size) return CONFIG_STORE_INVALID_PARAM;
+
+    memcpy(buf, sector + configStore.index[key] + CONFIG_STORE_RECORD_HEAD, n);
+    return CONFIG_STORE_OK;
+}
+
+/**
+  * @brief  读取字符串
+  */
+const char* ConfigStore_GetStr(ConfigStore_Key_t key, const char *def)
+{
+    if (!configStore.ready || (uint32_t)key >= CONFIG_KEY_COUNT || configStore.index[key] == 0 ||
+        configKeys[key].type != CONFIG_TYPE_STR) {
+        return def;
+    }
+    return (const char *)configStore.flash->sector(configStore.active) +
+           configStore.index[key] + CONFIG_STORE_RECORD_HEAD;
+}
+
+/**
+  * @brief  读取整数
+  */
+uint32_t ConfigStore_GetU32(ConfigStore_Key_t key, uint32_t def)
+{
+    uint32_t value;
+
+    if ((uint32_t)key >= CONFIG_KEY_COUNT || configKeys[key].type != CONFIG_TYPE_U32 ||
+        ConfigStore_Get(key, &value, sizeof(value), NULL) != CONFIG_STORE_OK) {
+        return def;
+    }
+    return value;
+}
+
+/**
+  * @brief  读取浮点数
+  */
+float ConfigStore_GetFloat(ConfigStore_Key_t key, float def)
+{
+    float value;
+
+    if ((uint32_t)key >= CONFIG_KEY_COUNT || configKeys[key].type != CONFIG_TYPE_FLOAT ||
+        ConfigStore_Get(key, &value, sizeof(value), NULL) != CONFIG_STORE_OK) {
+        return def;
+    }
+    return value;
+}
+
+/**
+  * @brief  写入原始值
+  */
+ConfigStore_Status_t ConfigStore_Set(ConfigStore_Key_t key, const void *data, uint16_t len)
+{
+    uint32_t value[CONFIG_ALIGN4(CONFIG_VALUE_MAX_LEN) / 4];
+    const uint8_t *sector;
+    uint32_t head, crc, total, offset;
+    ConfigStore_Status_t status;
+
+    if (!configStore.ready) return CONFIG_STORE_NOT_READY;
+    status = ConfigStore_CheckValue(key, data, len);
+    if (status != CONFIG_STORE_OK) return status;
+
+    /* 与当前值相同时不写, 减少擦写 */
+    sector = configStore.flash->sector(configStore.active);
+    if (configStore.index[key] == 0) {
+        if (len == 0) return CONFIG_STORE_OK;
+    } else if ((ConfigStore_Word(sector, configStore.index[key]) >> 16) == len &&
+               memcmp(sector + configStore.index[key] + CONFIG_STORE_RECORD_HEAD, data, len) == 0) {
+        return CONFIG_STORE_OK;
+    }
+
+    total = CONFIG_STORE_RECORD_HEAD + CONFIG_ALIGN4(len);
+    if (configStore.writeOffset + total > configStore.flash->sectorSize) {
+        if (ConfigStore_Compact() != CONFIG_STORE_OK) {
+            LOG_E("CONFIG", "Compaction failed");
+            return CONFIG_STORE_ERROR;
+        }
+        if (configStore.writeOffset + total > configStore.flash->sectorSize) {
+            return CONFIG_STORE_FULL;
+        }
+    }
+
+    memset(value, 0xFF, sizeof(value));
+    if (len > 0) {
+        memcpy(value, data, len);
+    }
+    head = (uint32_t)key | ((uint32_t)len << 16);
+    crc = ConfigStore_Crc(head, (const uint8_t *)value, len);
+
+    /* key/len -> value -> crc, crc 写入后记录才生效 */
+    offset = configStore.writeOffset;
+    configStore.writeOffset += total;
+    if (configStore.flash->program(configStore.active, offset, &head, 4) != CONFIG_STORE_OK ||
+        (len > 0 && configStore.flash->program(configStore.active, offset + CONFIG_STORE_RECORD_HEAD,
+                                               value, CONFIG_ALIGN4(len)) != CONFIG_STORE_OK) ||
+        configStore.flash->program(configStore.active, offset + 4, &crc, 4) != CONFIG_STORE_OK) {
+        LOG_E("CONFIG", "Write %s failed", configKeys[key].name);
+        return CONFIG_STORE_ERROR;
+    }
+
+    configStore.index[key] = (len > 0) ? (uint16_t)offset : 0;
+    configStore.writes++;
+    return CONFIG_STORE_OK;
+}
+
+ConfigStore_Status_t ConfigStore_SetStr(ConfigStore_Key_t key, const char *value)
+{
+    size_t len = value ? strlen(value) + 1 : 0;
+
+    if (len > CONFIG_VALUE_MAX_LEN) return CONFIG_STORE_INVALID_PARAM;
+    return ConfigStore_Set(key, value, (uint16_t)len);
+}
+
+ConfigStore_Status_t ConfigStore_SetU32(ConfigStore_Key_t key, uint32_t value)
+{
+    if ((uint32_t)key >= CONFIG_KEY_COUNT || configKeys[key].type != CONFIG_TYPE_U32) {
+        return CONFIG_STORE_INVALID_PARAM;
+    }
+    return ConfigStore_Set(key, &value, sizeof(value));
+}
+
+ConfigStore_Status_t ConfigStore_SetFloat(ConfigStore_Key_t key, float value)
+{
+    if ((uint32_t)key >= CONFIG_KEY_COUNT || configKeys[key].type != CONFIG_TYPE_FLOAT) {
+        return CONFIG_STORE_INVALID_PARAM;
+    }
+    return ConfigStore_Set(key, &value, sizeof(value));
+}
+
+/**
+  * @brief  删除一个键
+  */
+ConfigStore_Status_t ConfigStore_Delete(ConfigStore_Key_t key)
+{
+    return ConfigStore_Set(key, NULL, 0);
+}
+
+/**
+  * @brief  擦除全部配置
+  */
+ConfigStore_Status_t ConfigStore_Erase(void)
+{
+    if (!configStore.ready) return CONFIG_STORE_NOT_READY;
+
+    /* 先擦备用扇区, 掉电后两个扇区都无效, 启动时重新格式化 */
+    if (configStore.flash->erase(configStore.active ^ 1U) != CONFIG_STORE_OK ||
+        ConfigStore_Format(configStore.active, configStore.seq + 1) != CONFIG_STORE_OK) {
+        return CONFIG_STORE_ERROR;
+    }
+
+    configStore.seq++;
+    configStore.writeOffset = CONFIG_STORE_HEADER_SIZE;
+    memset(configStore.index, 0, sizeof(configStore.index));
+    LOG_I("CONFIG", "Erased");
+    return CONFIG_STORE_OK;
+}
+
+/**
+  * @brief  键名查找
+  */
+ConfigStore_Key_t ConfigStore_Find(const char *name)
+{
+    uint8_t i;
+
+    if (name == NULL) return CONFIG_KEY_COUNT;
+    for (i = 0; i < CONFIG_KEY_COUNT; i++) {
+        if (strcmp(configKeys[i].name, name) == 0) {
+            return (ConfigStore_Key_t)i;
+        }
+    }
+    return CONFIG_KEY_COUNT;
+}
+
+/**
+  * @brief  键名
+  */
+const char* ConfigStore_GetName(ConfigStore_Key_t key)
+{
+    return ((uint32_t)key < CONFIG_KEY_COUNT) ? configKeys[key].name : "?";
+}
+
+/**
+  * @brief  遍历JSON对象的键值
+  * @param  apply: 0=只检查语法和各值的类型/长度, 1=逐项写入
+  * @param  badKey: 输出第一个失败的键 (调用前置空)
+  * @retval 成功 (或检查通过) 的项数, -1=格式错误
+  */
+static int ConfigStore_WalkJson(const char *json, uint8_t apply, char *badKey, uint16_t badSize)
+{
+    char name[24];
+    char value[CONFIG_VALUE_MAX_LEN];
+    const char *p;
+    char *end;
+    uint16_t len;
+    ConfigStore_Key_t key;
+    ConfigStore_Status_t status;
+    uint32_t u32;
+    float f;
+    int applied = 0;
+
+    if (!json || (p = strchr(json, '{')) == NULL) return -1;
+    p++;
+
+    while (1) {
+        /* 键名 */
+        while (*p == ' ' || *p == ',' || *p == '\r' || *p == '\n' || *p == '\t') p++;
+        if (*p == '}') break;
+        p = ConfigStore_ParseString(p, name, sizeof(name), &len);
+        if (p == NULL) return -1;
+        while (*p == ' ' || *p == ':') p++;
+        key = ConfigStore_Find(name);
+
+        /* 值: 字符串 / 数字 / null */
+        if (*p == '"') {
+            p = ConfigStore_ParseString(p, value, sizeof(value), &len);
+            if (p == NULL) return -1;
+            if (key >= CONFIG_KEY_COUNT || configKeys[key].type != CONFIG_TYPE_STR) {
+                status = CONFIG_STORE_INVALID_PARAM;
+            } else {
+                status = apply ? ConfigStore_Set(key, value, len + 1) :
+                                 ConfigStore_CheckValue(key, value, len + 1);
+            }
+        } else if (strncmp(p, "null", 4) == 0) {
+            p += 4;
+            if (key >= CONFIG_KEY_COUNT) {
+                status = CONFIG_STORE_INVALID_PARAM;
+            } else {
+                status = apply ? ConfigStore_Delete(key) : CONFIG_STORE_OK;
+            }
+        } else if (key < CONFIG_KEY_COUNT && configKeys[key].type == CONFIG_TYPE_U32 && *p >= '0' && *p <= '9') {
+            u32 = (uint32_t)strtoul(p, &end, 10);
+            if (*end == '.' || *end == 'e' || *end == 'E') {
+                status = CONFIG_STORE_INVALID_PARAM;
+            } else {
+                status = apply ? ConfigStore_SetU32(key, u32) : CONFIG_STORE_OK;
+            }
+            p = end;
+        } else if (key < CONFIG_KEY_COUNT && configKeys[key].type == CONFIG_TYPE_FLOAT) {
+            f = strtof(p, &end);
+            if (end == p) return -1;
+            status = apply ? ConfigStore_SetFloat(key, f) : CONFIG_STORE_OK;
+            p = end;
+        } else {
+            status = CONFIG_STORE_INVALID_PARAM;
+        }
+
+        /* 跳过未能解析的数字 */
+        while ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E') p++;
+        if (*p != ',' && *p != '}' && *p != ' ') return -1;
+
+        if (status == CONFIG_STORE_OK) {
+            applied++;
+        } else if (badKey[0] == '\0') {
+            strncpy(badKey, name, badSize - 1);
+            badKey[badSize - 1] = '\0';
+        }
+    }
+
+    return applied;
+}
+
+/**
+  * @brief  按JSON批量写入
+  * @note   先完整检查一遍, 有格式错误时一项也不写, 避免只生效前半部分
+  */
+int ConfigStore_ApplyJson(const char *json, char *reply, uint16_t size)
+{
+    char badKey[24] = "";
+    int applied;
+
+    if (ConfigStore_WalkJson(json, 0, badKey, sizeof(badKey)) < 0) return -1;
+
+    badKey[0] = '\0';
+    applied = ConfigStore_WalkJson(json, 1, badKey, sizeof(badKey));
+    if (applied < 0) return -1;
+
+    if (reply != NULL && size > 0) {
+        if (badKey[0] != '\0') {
+            snprintf(reply, size, "{\"set\":%d,\"err\":\"%s\"}", applied, badKey);
+        } else {
+            snprintf(reply, size, "{\"set\":%d}", applied);
+        }
+    }
+    return applied;
+}
+
+/**
+  * @brief  已设置的键编码为JSON
+  */
+int ConfigStore_FormatJson(char *buf, uint16_t size)
+{
+    char value[CONFIG_VALUE_MAX_LEN];
+    const char *s;
+    uint16_t len = 0;
+    uint8_t i;
+    int n;
+
+    if (!buf || size < 3) return 0;
+
+    buf[len++] = '{';
+    for (i = 0; i < CONFIG_KEY_COUNT; i++) {
+        if (configStore.index[i] == 0) {
+            continue;
+        }
+
+        n = snprintf(buf + len, size - len, "%s\"%s\":", (len > 1) ? "," : "", configKeys[i].name);
+        if (n < 0 || len + n >= size) {
+            buf[0] = '\0';
+            return 0;
+        }
+        len += n;
+
+        switch (configKeys[i].type) {
+        case CONFIG_TYPE_U32:
+            n = snprintf(buf + len, size - len, "%lu",
+                         (unsigned long)ConfigStore_GetU32((ConfigStore_Key_t)i, 0));
+            break;
+        case CONFIG_TYPE_FLOAT:
+            n = snprintf(buf + len, size - len, "%g",
+                         (double)ConfigStore_GetFloat((ConfigStore_Key_t)i, 0.0f));
+            break;
+        default:
+            /* 转义引号和反斜杠 */
+            s = configKeys[i].secret ? "***" : ConfigStore_GetStr((ConfigStore_Key_t)i, "");
+            for (n = 0; *s && n < (int)sizeof(value) - 2; s++) {
+                if (*s == '"' || *s == '\\') value[n++] = '\\';
+                value[n++] = *s;
+            }
+            value[n] = '\0';
+            n = snprintf(buf + len, size - len, "\"%s\"", value);
+            break;
+        }
+        if (n < 0 || len + n >= size) {
+            buf[0] = '\0';
+            return 0;
+        }
+        len += n;
+    }
+
+    if (len + 2 > size) {
+        buf[0] = '\0';
+        return 0;
+    }
+    buf[len++] = '}';
+    buf[len] = '\0';
+    return len;
+}
+
+/* End of file ---------------------------------------------------------------*/
@@ -0,0 +1,101 @@
+/**
+  ******************************************************************************
+  * @file           : control.c
+  * @brief          : 远程控制命令处理源文件 (LED / 蜂鸣器)
+  * @version        : V1.0.0
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "control.h"
+#include "ctrl_latency.h"
+#include "log.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private types -------------------------------------------------------------*/
+
+/**
+  * @brief  键到输出引脚的映射
+  */
+typedef struct {
+    const char *key;                /**< JSON键 */
+    const char *name;               /**< 日志名称 */
+    GPIO_TypeDef *port;             /**< 端口 */
+    uint16_t pin;                   /**< 引脚 */
+} Control_Output_t;
+
+/* Private variables ---------------------------------------------------------*/
+
+static const Control_Output_t controlOutputs[] = {
+    { "led1", "LED1", LED1_GPIO_Port, LED1_Pin },   /* PF9 */
+    { "led2", "LED2", LED2_GPIO_Port, LED2_Pin },   /* PF10 */
+    { "led3", "LED3", LED3_GPIO_Port, LED3_Pin },   /* PE13 */
+    { "led4", "LED4", LED4_GPIO_Port, LED4_Pin },   /* PE14 */
+    { "beep", "BEEP", BEEP_GPIO_Port, BEEP_Pin },   /* PF8 */
+};
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  执行一条控制命令
+  */
+uint8_t Control_Handle(const char *json)
+{
+    uint8_t boolValue;
+    uint8_t actions = 0;
+    uint8_t i;
+
+    if (!json) return 0;
+
+    for (i = 0; i < sizeof(controlOutputs) / sizeof(controlOutputs[0]); i++) {
+        const Control_Output_t *out = &controlOutputs[i];
+
+        if (Control_GetBool(json, out->key, &boolValue) != 0) {
+            continue;
+        }
+        CTRL_LAT_STAMP(JSON);
+
+        HAL_GPIO_WritePin(out->port, out->pin, boolValue ? GPIO_PIN_SET : GPIO_PIN_RESET);
+        CTRL_LAT_STAMP(GPIO);
+
+        LOG_I("Control", "%s -> %s", out->name, boolValue ? "ON" : "OFF");
+        actions++;
+    }
+
+    return actions;
+}
+
+/**
+  * @brief  JSON解析辅助函数 - 获取布尔值
+  */
+int Control_GetBool(const char *json, const char *key, uint8_t *value)
+{
+    if (!json || !key || !value) return -2;
+    
+    /* 构建搜索模式 "key": */
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    
+    char *ptr = strstr(json, pattern);
+    if (!ptr) return -1;  /* 未找到键 */
+    
+    /* 跳过 "key": */
+    ptr += strlen(pattern);
+    
+    /* 跳过空格 */
+    while (*ptr == ' ') ptr++;
+    
+    /* 解析值 */
+    if (strncmp(ptr, "true", 4) == 0 || strncmp(ptr, "1", 1) == 0) {
+        *value = 1;
+        return 0;
+    } else if (strncmp(ptr, "false", 5) == 0 || strncmp(ptr, "0", 1) == 0) {
+        *value = 0;
+        return 0;
+    }
+    
+    return -2;  /* 解析失败 */
+}
+
+/* End of file ---------------------------------------------------------------*/
@@ -0,0 +1,325 @@
+/**
+  ******************************************************************************
+  * @file           : crash_log.c
+  * @brief          : 复位保持的故障记录 (.noinit RAM) 源文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 故障处理函数由编译器生成, 入口处可能已压栈若干寄存器, 因此从当前
+  * MSP 向上查找异常栈帧:
+  *   1. 优先找 EXC_RETURN (0xFFFFFFxx), 编译器压栈的 LR 紧挨在栈帧下方
+  *   2. 找不到时按 xPSR 特征匹配 (T位=1, 保留位[23:20]=0, 异常号合法)
+  * 本工程没有使用 PSP, 只接受返回到 MSP 的 EXC_RETURN
+  * 查找范围不超过栈所在RAM的末尾, 避免在故障处理中再次触发总线错误
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "crash_log.h"
+#include "log.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+/* 不被启动代码清零的段 */
+#if defined(__CC_ARM)
+#define CRASH_LOG_NOINIT    __attribute__((section(".bss.noinit"), zero_init))
+#elif defined(__ARMCC_VERSION)
+#define CRASH_LOG_NOINIT    __attribute__((section(".bss.noinit")))
+#else
+#define CRASH_LOG_NOINIT    __attribute__((section(".noinit")))
+#endif
+
+/* 参与校验的字数 (不含 checksum 本身) */
+#define CRASH_LOG_CHECK_WORDS   (offsetof(CrashLog_Record_t, checksum) / sizeof(uint32_t))
+
+/* SRAM1+SRAM2 末尾 */
+#define CRASH_LOG_SRAM_END      (SRAM1_BASE + 0x20000UL)
+
+/* STM32F407 外设中断数 */
+#define CRASH_LOG_MAX_EXCEPTION (16 + 82)
+
+/* Private variables ---------------------------------------------------------*/
+
+/* 故障记录句柄实例 */
+CrashLog_Handle_t crashLog = {0};
+
+/* 故障记录 (复位保持) */
+static CrashLog_Record_t crashRecord CRASH_LOG_NOINIT;
+
+/* 故障原因名称 */
+static const char * const crashReasonNames[] = {
+    "none", "hardfault", "memmanage", "busfault", "usagefault", "error_handler"
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t CrashLog_Checksum(const CrashLog_Record_t *record);
+static uint8_t CrashLog_IsValid(void);
+static uint8_t CrashLog_IsFrame(const uint32_t *frame);
+static const uint32_t* CrashLog_FindFrame(void);
+static void CrashLog_Save(CrashLog_Reason_t reason, const uint32_t *frame, uint32_t pc);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  计算记录校验和 (逐字移位异或, 故障路径上只需几微秒)
+  */
+static uint32_t CrashLog_Checksum(const CrashLog_Record_t *record)
+{
+    const uint32_t *words = (const uint32_t *)record;
+    uint32_t sum = 0x5A5A5A5AUL;
+    uint32_t i;
+
+    for (i = 0; i < CRASH_LOG_CHECK_WORDS; i++) {
+        sum = ((sum << 5) | (sum >> 27)) ^ words[i];
+    }
+
+    return sum;
+}
+
+/**
+  * @brief  判断记录是否有效 (上电后RAM为随机值, 未配置UNINIT时为0)
+  */
+static uint8_t CrashLog_IsValid(void)
+{
+    return crashRecord.magic == CRASH_LOG_MAGIC &&
+           crashRecord.logLen <= CRASH_LOG_TAIL_SIZE &&
+           crashRecord.checksum == CrashLog_Checksum(&crashRecord);
+}
+
+/**
+  * @brief  判断地址处是否像一个异常栈帧
+  */
+static uint8_t CrashLog_IsFrame(const uint32_t *frame)
+{
+    uint32_t xpsr = frame[7];
+
+    return (xpsr & 0x01F00000UL) == 0x01000000UL &&
+           (xpsr & 0x1FFUL) < CRASH_LOG_MAX_EXCEPTION &&
+           (frame[6] & 1UL) == 0;
+}
+
+/**
+  * @brief  从当前栈顶向上查找异常栈帧
+  * @retval const uint32_t* 栈帧地址, 未找到返回NULL
+  */
+static const uint32_t* CrashLog_FindFrame(void)
+{
+    const uint32_t *sp = (const uint32_t *)__get_MSP();
+    uint32_t end = ((uint32_t)sp >= SRAM1_BASE) ? CRASH_LOG_SRAM_END : CCMDATARAM_END + 1;
+    uint32_t limit = (end - (uint32_t)sp) / sizeof(uint32_t);
+    uint32_t i;
+
+    /* 保证 sp[i + 8] 不越过RAM末尾 */
+    if (limit < 9) {
+        return NULL;
+    }
+    limit -= 8;
+    if (limit > CRASH_LOG_FRAME_SEARCH) {
+        limit = CRASH_LOG_FRAME_SEARCH;
+    }
+
+    /* 1. 编译器压栈的 EXC_RETURN (0xFFFFFFE1/E9/F1/F9) */
+    for (i = 0; i < limit; i++) {
+        if ((sp[i] & 0xFFFFFFE7UL) == 0xFFFFFFE1UL && CrashLog_IsFrame(&sp[i + 1])) {
+            return &sp[i + 1];
+        }
+    }
+
+    /* 2. 按 xPSR 特征匹配 */
+    for (i = 0; i < limit; i++) {
+        if (CrashLog_IsFrame(&sp[i])) {
+            return &sp[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+  * @brief  写入故障记录
+  * @param  frame 异常栈帧, NULL 表示非异常路径
+  * @param  pc 非异常路径时的出错位置
+  */
+static void CrashLog_Save(CrashLog_Reason_t reason, const uint32_t *frame, uint32_t pc)
+{
+    CrashLog_Record_t *rec = &crashRecord;
+    uint32_t count = CrashLog_IsValid() ? rec->count + 1 : 1;
+
+    rec->magic = CRASH_LOG_MAGIC;
+    rec->count = count;
+    rec->reason = (uint8_t)reason;
+    rec->state = crashLog.state;
+    rec->tick = HAL_GetTick();
+    rec->reserved = 0;
+
+    if (frame != NULL) {
+        rec->frameValid = 1;
+        rec->r0 = frame[0];
+        rec->r1 = frame[1];
+        rec->r2 = frame[2];
+        rec->r3 = frame[3];
+        rec->r12 = frame[4];
+        rec->lr = frame[5];
+        rec->pc = frame[6];
+        rec->xpsr = frame[7];
+        rec->sp = (uint32_t)frame;
+    } else {
+        rec->frameValid = 0;
+        rec->r0 = rec->r1 = rec->r2 = rec->r3 = rec->r12 = 0;
+        rec->lr = 0;
+        rec->pc = pc;
+        rec->xpsr = __get_xPSR();
+        rec->sp = __get_MSP();
+    }
+
+    rec->cfsr = SCB->CFSR;
+    rec->hfsr = SCB->HFSR;
+    rec->mmfar = SCB->MMFAR;
+    rec->bfar = SCB->BFAR;
+    rec->afsr = SCB->AFSR;
+
+    rec->logLen = LOG_CopyTail(rec->log, CRASH_LOG_TAIL_SIZE);
+    memset(rec->log + rec->logLen, 0, CRASH_LOG_TAIL_SIZE - rec->logLen);
+
+    rec->checksum = CrashLog_Checksum(rec);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  上电后检查故障记录
+  */
+void CrashLog_Init(void)
+{
+    /* 复位原因标志在 RCC->CSR[31:24], 读取后清除以便下次区分 */
+    crashLog.resetFlags = RCC->CSR & 0xFF000000UL;
+    RCC->CSR |= RCC_CSR_RMVF;
+
+    crashLog.pending = CrashLog_IsValid();
+    if (!crashLog.pending) {
+        return;
+    }
+
+    LOG_W("CRASH", "Reset after %s: pc=0x%08lX lr=0x%08lX cfsr=0x%08lX hfsr=0x%08lX",
+          crashReasonNames[crashRecord.reason < 6 ? crashRecord.reason : 0],
+          (unsigned long)crashRecord.pc, (unsigned long)crashRecord.lr,
+          (unsigned long)crashRecord.cfsr, (unsigned long)crashRecord.hfsr);
+}
+
+/**
+  * @brief  设置当前应用状态ID
+  */
+void CrashLog_SetState(uint16_t state)
+{
+    crashLog.state = state;
+}
+
+/**
+  * @brief  在故障异常中记录现场
+  */
+void CrashLog_Fault(CrashLog_Reason_t reason)
+{
+    CrashLog_Save(reason, CrashLog_FindFrame(), 0);
+
+    if (CrashLog_ResetAllowed()) {
+        NVIC_SystemReset();
+    }
+}
+
+/**
+  * @brief  在非异常路径记录现场
+  */
+void CrashLog_Capture(CrashLog_Reason_t reason, uint32_t pc)
+{
+    CrashLog_Save(reason, NULL, pc);
+}
+
+/**
+  * @brief  记录现场后是否应当软复位
+  */
+uint8_t CrashLog_ResetAllowed(void)
+{
+#if CRASH_LOG_RESET_ON_FAULT
+    /* 调试器已连接: 停住便于查看现场 */
+    if (CoreDebug->DHCSR & CoreDebug_DHCSR_C_DEBUGEN_Msk) {
+        return 0;
+    }
+
+    /* count 为记录发布前累计的故障次数, 刚写入的这次也已计入 */
+    return CrashLog_IsValid() && crashRecord.count <= CRASH_LOG_RESET_LIMIT;
+#else
+    return 0;
+#endif
+}
+
+/**
+  * @brief  是否有待发布的故障记录
+  */
+uint8_t CrashLog_HasRecord(void)
+{
+    return crashLog.pending;
+}
+
+/**
+  * @brief  把故障记录编码为JSON
+  */
+int CrashLog_FormatReport(char *buf, uint16_t size)
+{
+    const CrashLog_Record_t *rec = &crashRecord;
+    int n;
+
+    if (!crashLog.pending || buf == NULL || size == 0) {
+        return 0;
+    }
+
+    n = snprintf(buf, size,
+                 "{\"reason\":\"%s\",\"count\":%lu,\"tick\":%lu,\"state\":%u,\"irq\":%lu,"
+                 "\"frame\":%u,\"pc\":\"0x%08lX\",\"lr\":\"0x%08lX\",\"xpsr\":\"0x%08lX\","
+                 "\"sp\":\"0x%08lX\",\"r0\":\"0x%08lX\",\"r1\":\"0x%08lX\",\"r2\":\"0x%08lX\","
+                 "\"r3\":\"0x%08lX\",\"r12\":\"0x%08lX\",\"cfsr\":\"0x%08lX\",\"hfsr\":\"0x%08lX\","
+                 "\"mmfar\":\"0x%08lX\",\"bfar\":\"0x%08lX\",\"afsr\":\"0x%08lX\",\"rst\":\"0x%02lX\","
+                 "\"log\":%u}",
+                 crashReasonNames[rec->reason < 6 ? rec->reason : 0],
+                 (unsigned long)rec->count, (unsigned long)rec->tick, rec->state,
+                 (unsigned long)(rec->xpsr & 0x1FFUL), rec->frameValid,
+                 (unsigned long)rec->pc, (unsigned long)rec->lr, (unsigned long)rec->xpsr,
+                 (unsigned long)rec->sp, (unsigned long)rec->r0, (unsigned long)rec->r1,
+                 (unsigned long)rec->r2, (unsigned long)rec->r3, (unsigned long)rec->r12,
+                 (unsigned long)rec->cfsr, (unsigned long)rec->hfsr, (unsigned long)rec->mmfar,
+                 (unsigned long)rec->bfar, (unsigned long)rec->afsr,
+                 (unsigned long)(crashLog.resetFlags >> 24), rec->logLen);
+    if (n < 0 || n >= size) {
+        buf[0] = '\0';
+        return 0;
+    }
+
+    return n;
+}
+
+/**
+  * @brief  获取故障前的日志尾部
+  */
+const uint8_t* CrashLog_GetLog(uint16_t *len)
+{
+    if (len != NULL) {
+        *len = crashLog.pending ? crashRecord.logLen : 0;
+    }
+
+    return crashRecord.log;
+}
+
+/**
+  * @brief  清除故障记录
+  */
+void CrashLog_Clear(void)
+{
+    crashRecord.magic = 0;
+    crashLog.pending = 0;
+}
+
+/* End of file ---------------------------------------------------------------*/
@@ -0,0 +1,296 @@
+/**
+  ******************************************************************************
+  * @file           : ctrl_latency.c
+  * @brief          : 控制路径时延剖析源文件 (MQTT控制命令 -> GPIO)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * URC 打点在中断中, 其余在主循环中, 打点和统计都在短暂关中断下进行。
+  * 单个阶段不能超过计时源回绕周期 (168MHz 下约25.5秒)。
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "ctrl_latency.h"
+#include "mem_region.h"
+#include "log.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+/* 前导零计数 */
+#if defined(PROF_HOST)
+#define CTRL_LAT_CLZ(x)         ((uint32_t)__builtin_clz(x))
+#else
+#define CTRL_LAT_CLZ(x)         ((uint32_t)__CLZ(x))
+#endif
+
+#define CTRL_LAT_SUB_COUNT      (1UL << CTRL_LAT_SUB_BITS)
+
+/* Private variables ---------------------------------------------------------*/
+
+/* 剖析句柄实例 */
+CtrlLatency_Handle_t ctrlLatency CCM_BSS;
+
+/* 阶段名称 (与 CtrlLatency_Stage_t 顺序一致) */
+static const char * const ctrlLatencyNames[CTRL_LAT_STAGE_COUNT] = {
+    "urc", "queue", "dispatch", "json", "gpio", "total"
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t CtrlLatency_Bin(uint32_t cycles);
+static uint32_t CtrlLatency_BinUpper(uint32_t bin);
+static void CtrlLatency_Record(CtrlLatency_Stage_t stage, uint32_t cycles);
+static uint32_t CtrlLatency_ToUs(uint32_t cycles);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  桶号: 小于8精确, 之后按最高位所在的2的幂区间再分8份
+  */
+static uint32_t CtrlLatency_Bin(uint32_t cycles)
+{
+    uint32_t k;
+
+    if (cycles < CTRL_LAT_SUB_COUNT) {
+        return cycles;
+    }
+
+    k = 31 - CTRL_LAT_CLZ(cycles);
+    return ((k - CTRL_LAT_SUB_BITS + 1) << CTRL_LAT_SUB_BITS) +
+           ((cycles >> (k - CTRL_LAT_SUB_BITS)) & (CTRL_LAT_SUB_COUNT - 1));
+}
+
+/**
+  * @brief  桶的上界 (含)
+  */
+static uint32_t CtrlLatency_BinUpper(uint32_t bin)
+{
+    uint32_t shift, lower;
+
+    if (bin < CTRL_LAT_SUB_COUNT) {
+        return bin;
+    }
+
+    shift = (bin >> CTRL_LAT_SUB_BITS) - 1;
+    lower = (CTRL_LAT_SUB_COUNT + (bin & (CTRL_LAT_SUB_COUNT - 1))) << shift;
+    return lower + ((1UL << shift) - 1);
+}
+
+/**
+  * @brief  记录一个阶段 (调用者已关中断)
+  */
+static void CtrlLatency_Record(CtrlLatency_Stage_t stage, uint32_t cycles)
+{
+    CtrlLatency_Stats_t *stats = &ctrlLatency.stages[stage];
+    uint32_t bin = CtrlLatency_Bin(cycles);
+
+    stats->count++;
+    if (cycles < stats->min) {
+        stats->min = cycles;
+    }
+    if (cycles > stats->max) {
+        stats->max = cycles;
+    }
+    if (stats->hist[bin] < 0xFFFF) {
+        stats->hist[bin]++;
+    }
+}
+
+/**
+  * @brief  周期换算为微秒
+  */
+static uint32_t CtrlLatency_ToUs(uint32_t cycles)
+{
+    uint32_t hz = ctrlLatency.hz ? ctrlLatency.hz : SystemCoreClock;
+
+    return (uint32_t)((uint64_t)cycles * 1000000ULL / hz);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  清空统计
+  */
+void CtrlLatency_Reset(void)
+{
+    uint32_t primask;
+    uint8_t i;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    memset(&ctrlLatency, 0, sizeof(ctrlLatency));
+    for (i = 0; i < CTRL_LAT_STAGE_COUNT; i++) {
+        ctrlLatency.stages[i].min = 0xFFFFFFFFUL;
+    }
+    ctrlLatency.hz = SystemCoreClock;
+
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  串口中断入口打点
+  */
+void CtrlLatency_IrqEntry(void)
+{
+    ctrlLatency.irqCandidate = CTRL_LAT_NOW();
+}
+
+/**
+  * @brief  路径打点
+  */
+void CtrlLatency_Stamp(CtrlLatency_Point_t point)
+{
+    uint32_t now = CTRL_LAT_NOW();
+    uint32_t primask;
+    uint8_t i;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (point == CTRL_LAT_URC) {
+        if (ctrlLatency.next != 0) {
+            ctrlLatency.incomplete++;
+        }
+        ctrlLatency.stamps[CTRL_LAT_IRQ] = ctrlLatency.irqCandidate;
+        ctrlLatency.stamps[CTRL_LAT_URC] = now;
+        ctrlLatency.next = CTRL_LAT_QUEUE;
+    } else if (ctrlLatency.next != 0 && (uint8_t)point == ctrlLatency.next) {
+        ctrlLatency.stamps[point] = now;
+        ctrlLatency.next++;
+
+        if (point == CTRL_LAT_GPIO) {
+            for (i = 0; i < CTRL_LAT_STAGE_TOTAL; i++) {
+                CtrlLatency_Record((CtrlLatency_Stage_t)i, ctrlLatency.stamps[i + 1] - ctrlLatency.stamps[i]);
+            }
+            CtrlLatency_Record(CTRL_LAT_STAGE_TOTAL, now - ctrlLatency.stamps[CTRL_LAT_IRQ]);
+            ctrlLatency.next = 0;
+        }
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  获取阶段统计
+  */
+void CtrlLatency_GetStats(CtrlLatency_Stage_t stage, CtrlLatency_Stats_t *stats)
+{
+    uint32_t primask;
+
+    if ((uint32_t)stage >= CTRL_LAT_STAGE_COUNT || stats == NULL) {
+        return;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = ctrlLatency.stages[stage];
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  获取阶段名称
+  */
+const char* CtrlLatency_GetName(CtrlLatency_Stage_t stage)
+{
+    return ((uint32_t)stage < CTRL_LAT_STAGE_COUNT) ? ctrlLatencyNames[stage] : "?";
+}
+
+/**
+  * @brief  按直方图估算百分位
+  */
+uint32_t CtrlLatency_Percentile(const CtrlLatency_Stats_t *stats, uint16_t permille)
+{
+    uint32_t rank, seen = 0, upper;
+    uint32_t bin;
+
+    if (stats == NULL || stats->count == 0) {
+        return 0;
+    }
+
+    /* 第 ceil(n * p) 个样本所在的桶 */
+    rank = (uint32_t)(((uint64_t)stats->count * permille + 999) / 1000);
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    for (bin = 0; bin < CTRL_LAT_BINS; bin++) {
+        seen += stats->hist[bin];
+        if (seen >= rank) {
+            upper = CtrlLatency_BinUpper(bin);
+            return (upper < stats->max) ? upper : stats->max;
+        }
+    }
+
+    /* 直方图饱和时计数少于 count */
+    return stats->max;
+}
+
+/**
+  * @brief  编码为JSON
+  */
+int CtrlLatency_Format(char *buf, uint16_t size)
+{
+    CtrlLatency_Stats_t stats;
+    uint8_t i;
+    int len, n;
+
+    if (buf == NULL || size == 0) {
+        return 0;
+    }
+
+    CtrlLatency_GetStats(CTRL_LAT_STAGE_TOTAL, &stats);
+    len = snprintf(buf, size, "{\"n\":%lu,\"incomplete\":%lu", (unsigned long)stats.count,
+                   (unsigned long)ctrlLatency.incomplete);
+    if (len < 0 || len >= size) {
+        buf[0] = '\0';
+        return 0;
+    }
+
+    for (i = 0; i < CTRL_LAT_STAGE_COUNT; i++) {
+        CtrlLatency_GetStats((CtrlLatency_Stage_t)i, &stats);
+        n = snprintf(buf + len, size - len, ",\"%s\":[%lu,%lu,%lu]", ctrlLatencyNames[i],
+                     (unsigned long)CtrlLatency_ToUs(CtrlLatency_Percentile(&stats, 500)),
+                     (unsigned long)CtrlLatency_ToUs(CtrlLatency_Percentile(&stats, 990)),
+                     (unsigned long)CtrlLatency_ToUs(stats.max));
+        if (n < 0 || len + n >= size) {
+            buf[0] = '\0';
+            return 0;
+        }
+        len += n;
+    }
+
+    n = snprintf(buf + len, size - len, "}");
+    if (n < 0 || len + n >= size) {
+        buf[0] = '\0';
+        return 0;
+    }
+
+    return len + n;
+}
+
+/**
+  * @brief  通过日志输出各阶段统计
+  */
+void CtrlLatency_Dump(void)
+{
+    CtrlLatency_Stats_t stats;
+    uint8_t i;
+
+    LOG_I("CTRL", "%-9s %8s %10s %10s %10s  (us, incomplete %lu)", "stage", "n", "p50", "p99", "max",
+          (unsigned long)ctrlLatency.incomplete);
+
+    for (i = 0; i < CTRL_LAT_STAGE_COUNT; i++) {
+        CtrlLatency_GetStats((CtrlLatency_Stage_t)i, &stats);
+        LOG_I("CTRL", "%-9s %8lu %10lu %10lu %10lu", ctrlLatencyNames[i], (unsigned long)stats.count,
+              (unsigned long)CtrlLatency_ToUs(CtrlLatency_Percentile(&stats, 500)),
+              (unsigned long)CtrlLatency_ToUs(CtrlLatency_Percentile(&stats, 990)),
+              (unsigned long)CtrlLatency_ToUs(stats.max));
+    }
+}
+
+/* End of file ---------------------------------------------------------------*/
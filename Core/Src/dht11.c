@@ -21,6 +21,8 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "dht11.h"
+#include "prof.h"
+#include "metrics.h"
 #include <stdio.h>
 #include <stdarg.h>
 
@@ -32,6 +34,13 @@
 #define DWT_LAR         (*(volatile uint32_t*)0xE0001FB0)
 #define SCB_DEMCR       (*(volatile uint32_t*)0xE000EDFC)
 
+/* 计时源: 主机构建没有DWT, 用 prof 的纳秒时钟 (每微秒1000个计数) */
+#ifdef PROF_HOST
+#define DHT11_CYCCNT()  PROF_NOW()
+#else
+#define DHT11_CYCCNT()  DWT_CYCCNT
+#endif
+
 /* Private variables ---------------------------------------------------------*/
 
 /* DHT11句柄实例 */
@@ -40,6 +49,9 @@ DHT11_Handle_t dht11 = {0};
 /* 系统时钟频率 (用于计算延时) */
 static uint32_t dwt_us_tick = 0;
 
+/* 健康指标: 读取失败次数 (不含采样间隔不足) */
+static Metric_t dht11ErrorMetric = METRIC_COUNTER_INIT("dht11.err");
+
 /* Private function prototypes -----------------------------------------------*/
 static void DHT11_DelayInit(void);
 static void DHT11_DelayUs(uint32_t us);
@@ -50,6 +62,9 @@ static void DHT11_SetPinLow(void);
 static uint8_t DHT11_ReadPin(void);
 static DHT11_Status_t DHT11_WaitForLevel(uint8_t level, uint32_t timeout_us, uint32_t *duration);
 static uint8_t DHT11_GetPinNumber(uint16_t pin);
+static DHT11_Status_t DHT11_ReceiveFrame(DHT11_RawData_t *rawData);
+static DHT11_Status_t DHT11_StoreResult(DHT11_Status_t status, const DHT11_RawData_t *rawData,
+                                        float *temperature, float *humidity);
 
 /* Private functions ---------------------------------------------------------*/
 
@@ -58,6 +73,9 @@ static uint8_t DHT11_GetPinNumber(uint16_t pin);
   */
 static void DHT11_DelayInit(void)
 {
+#ifdef PROF_HOST
+    dwt_us_tick = 1000;
+#else
     /* 使能DWT */
     SCB_DEMCR |= 0x01000000;
     
@@ -72,6 +90,7 @@ static void DHT11_DelayInit(void)
     
     /* 计算每微秒的时钟周期数 */
     dwt_us_tick = SystemCoreClock / 1000000;
+#endif
 }
 
 /**
@@ -80,10 +99,10 @@ static void DHT11_DelayInit(void)
   */
 static void DHT11_DelayUs(uint32_t us)
 {
-    uint32_t startTick = DWT_CYCCNT;
+    uint32_t startTick = DHT11_CYCCNT();
     uint32_t delayTicks = us * dwt_us_tick;
     
-    while ((DWT_CYCCNT - startTick) < delayTicks);
+    while ((DHT11_CYCCNT() - startTick) < delayTicks);
 }
 
 /**
@@ -150,7 +169,7 @@ static uint8_t DHT11_ReadPin(void)
   */
 static DHT11_Status_t DHT11_WaitForLevel(uint8_t level, uint32_t timeout_us, uint32_t *duration)
 {
-    uint32_t startTick = DWT_CYCCNT;
+    uint32_t startTick = DHT11_CYCCNT();
     uint32_t timeoutTicks = timeout_us * dwt_us_tick;
     
     /* 
@@ -161,16 +180,16 @@ static DHT11_Status_t DHT11_WaitForLevel(uint8_t level, uint32_t timeout_us, uin
     if (duration != NULL) {
         /* 等待电平变化到目标电平，同时测量当前电平持续时间 */
         while (DHT11_ReadPin() != level) {
-            if ((DWT_CYCCNT - startTick) > timeoutTicks) {
+            if ((DHT11_CYCCNT() - startTick) > timeoutTicks) {
                 return DHT11_ERROR_TIMEOUT;
             }
         }
         /* 计算从开始到电平变化的时间 */
-        *duration = (DWT_CYCCNT - startTick) / dwt_us_tick;
+        *duration = (DHT11_CYCCNT() - startTick) / dwt_us_tick;
     } else {
         /* 只等待电平变化，不测量时间 */
         while (DHT11_ReadPin() != level) {
-            if ((DWT_CYCCNT - startTick) > timeoutTicks) {
+            if ((DHT11_CYCCNT() - startTick) > timeoutTicks) {
                 return DHT11_ERROR_TIMEOUT;
             }
         }
@@ -195,124 +214,19 @@ static uint8_t DHT11_GetPinNumber(uint16_t pin)
     return n;
 }
 
-/* Exported functions --------------------------------------------------------*/
-
 /**
-  * @brief  初始化DHT11传感器 (使用默认引脚)
-  */
-DHT11_Status_t DHT11_Init(void)
-{
-    return DHT11_InitEx(DHT11_GPIO_Port, DHT11_Pin);
-}
-
-/**
-  * @brief  使用自定义引脚初始化DHT11传感器
-  */
-DHT11_Status_t DHT11_InitEx(GPIO_TypeDef *port, uint16_t pin)
-{
-    if (port == NULL) {
-        return DHT11_ERROR;
-    }
-    
-    /* 保存引脚配置 */
-    dht11.port = port;
-    dht11.pin = pin;
-    
-    /* 初始化微秒延时 */
-    DHT11_DelayInit();
-    
-    /* 设置引脚为输出模式并拉高 */
-    DHT11_SetPinOutput();
-    DHT11_SetPinHigh();
-    
-    /* 初始化数据 */
-    dht11.data.temperature = 0.0f;
-    dht11.data.humidity = 0.0f;
-    dht11.data.lastReadTime = 0;
-    dht11.data.lastStatus = DHT11_OK;
-    
-    /* 标记已初始化 */
-    dht11.initialized = 1;
-    
-    /* 等待DHT11上电稳定 (至少1秒) */
-    HAL_Delay(1000);
-    
-#if DHT11_DEBUG_ENABLE
-    DHT11_DebugPrint("DHT11 initialized on GPIO%c Pin%d\r\n", 
-                     'A' + ((uint32_t)(port - GPIOA) / ((uint32_t)GPIOB - (uint32_t)GPIOA)), 
-                     DHT11_GetPinNumber(pin));
-#endif
-    
-    return DHT11_OK;
-}
-
-/**
-  * @brief  读取DHT11传感器数据
-  */
-DHT11_Status_t DHT11_Read(float *temperature, float *humidity)
-{
-    DHT11_RawData_t rawData;
-    DHT11_Status_t status;
-    
-    /* 读取原始数据 */
-    status = DHT11_ReadRaw(&rawData);
-    
-    if (status == DHT11_OK) {
-        /* 转换为浮点数 */
-        dht11.data.temperature = (float)rawData.temperature_int + (float)rawData.temperature_dec * 0.1f;
-        dht11.data.humidity = (float)rawData.humidity_int + (float)rawData.humidity_dec * 0.1f;
-        dht11.data.lastReadTime = HAL_GetTick();
-        
-        /* 输出结果 */
-        if (temperature != NULL) {
-            *temperature = dht11.data.temperature;
-        }
-        if (humidity != NULL) {
-            *humidity = dht11.data.humidity;
-        }
-    }
-    
-    dht11.data.lastStatus = status;
-    return status;
-}
-
-/**
-  * @brief  读取DHT11传感器原始数据
+  * @brief  结束起始信号并接收40位数据帧
+  * @note   调用前总线须已拉低18ms以上
+  * @param  rawData: 原始数据输出指针
+  * @retval DHT11_Status_t 操作状态
   */
-DHT11_Status_t DHT11_ReadRaw(DHT11_RawData_t *rawData)
+static DHT11_Status_t DHT11_ReceiveFrame(DHT11_RawData_t *rawData)
 {
     uint8_t data[5] = {0};
     uint8_t i, j;
     uint32_t highDuration;
     DHT11_Status_t status;
     
-    if (!dht11.initialized) {
-        return DHT11_ERROR;
-    }
-    
-    if (rawData == NULL) {
-        return DHT11_ERROR;
-    }
-    
-    /* 检查采样间隔 */
-    uint32_t currentTick = HAL_GetTick();
-    if ((currentTick - dht11.data.lastReadTime) < DHT11_MIN_SAMPLE_INTERVAL_MS && 
-        dht11.data.lastReadTime != 0) {
-#if DHT11_DEBUG_ENABLE
-        DHT11_DebugPrint("DHT11: Sampling too fast, please wait\r\n");
-#endif
-        return DHT11_ERROR_NOT_READY;
-    }
-    
-    /* ========== 第1步: 主机发送起始信号 ========== */
-    
-    /* 设置为输出模式 */
-    DHT11_SetPinOutput();
-    
-    /* 拉低总线至少18ms */
-    DHT11_SetPinLow();
-    HAL_Delay(20);  /* 20ms确保足够长 */
-    
     /* 释放总线 (拉高) */
     DHT11_SetPinHigh();
     DHT11_DelayUs(DHT11_START_SIGNAL_HIGH_US);
@@ -420,6 +334,200 @@ DHT11_Status_t DHT11_ReadRaw(DHT11_RawData_t *rawData)
     return DHT11_OK;
 }
 
+/**
+  * @brief  保存一次读取结果并转换为浮点数
+  * @param  status: 读取状态
+  * @param  rawData: 原始数据 (status为DHT11_OK时有效)
+  * @param  temperature: 温度输出指针 (可为NULL)
+  * @param  humidity: 湿度输出指针 (可为NULL)
+  * @retval DHT11_Status_t 即传入的status
+  */
+static DHT11_Status_t DHT11_StoreResult(DHT11_Status_t status, const DHT11_RawData_t *rawData,
+                                        float *temperature, float *humidity)
+{
+    if (status == DHT11_OK) {
+        /* 转换为浮点数 */
+        dht11.data.temperature = (float)rawData->temperature_int + (float)rawData->temperature_dec * 0.1f;
+        dht11.data.humidity = (float)rawData->humidity_int + (float)rawData->humidity_dec * 0.1f;
+        dht11.data.lastReadTime = HAL_GetTick();
+        
+        /* 输出结果 */
+        if (temperature != NULL) {
+            *temperature = dht11.data.temperature;
+        }
+        if (humidity != NULL) {
+            *humidity = dht11.data.humidity;
+        }
+    } else if (status != DHT11_ERROR_NOT_READY) {
+        Metrics_Inc(&dht11ErrorMetric);
+    }
+    
+    dht11.data.lastStatus = status;
+    return status;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  初始化DHT11传感器 (使用默认引脚)
+  */
+DHT11_Status_t DHT11_Init(void)
+{
+    return DHT11_InitEx(DHT11_GPIO_Port, DHT11_Pin);
+}
+
+/**
+  * @brief  使用自定义引脚初始化DHT11传感器
+  */
+DHT11_Status_t DHT11_InitEx(GPIO_TypeDef *port, uint16_t pin)
+{
+    if (port == NULL) {
+        return DHT11_ERROR;
+    }
+    
+    /* 保存引脚配置 */
+    dht11.port = port;
+    dht11.pin = pin;
+    
+    /* 初始化微秒延时 */
+    DHT11_DelayInit();
+    Metrics_Register(&dht11ErrorMetric);
+    
+    /* 设置引脚为输出模式并拉高 */
+    DHT11_SetPinOutput();
+    DHT11_SetPinHigh();
+    
+    /* 初始化数据 */
+    dht11.data.temperature = 0.0f;
+    dht11.data.humidity = 0.0f;
+    dht11.data.lastReadTime = 0;
+    dht11.data.lastStatus = DHT11_OK;
+    dht11.startTick = 0;
+    dht11.reading = 0;
+    
+    /* 标记已初始化; 上电稳定 (至少1秒) 前 DHT11_IsReady 返回0, 不在这里等待 */
+    dht11.readyTick = HAL_GetTick() + DHT11_POWER_UP_MS;
+    dht11.initialized = 1;
+    
+#if DHT11_DEBUG_ENABLE
+    DHT11_DebugPrint("DHT11 initialized on GPIO%c Pin%d\r\n", 
+                     'A' + ((uint32_t)(port - GPIOA) / ((uint32_t)GPIOB - (uint32_t)GPIOA)), 
+                     DHT11_GetPinNumber(pin));
+#endif
+    
+    return DHT11_OK;
+}
+
+/**
+  * @brief  读取DHT11传感器数据
+  */
+DHT11_Status_t DHT11_Read(float *temperature, float *humidity)
+{
+    DHT11_RawData_t rawData;
+    
+    /* 读取原始数据 */
+    return DHT11_StoreResult(DHT11_ReadRaw(&rawData), &rawData, temperature, humidity);
+}
+
+/**
+  * @brief  分步读取第1步: 发出起始信号
+  */
+DHT11_Status_t DHT11_StartRead(void)
+{
+    if (!dht11.initialized) {
+        return DHT11_ERROR;
+    }
+    
+    if (dht11.reading) {
+        return DHT11_BUSY;
+    }
+    
+    /* 检查采样间隔 */
+    if (!DHT11_IsReady()) {
+        return DHT11_ERROR_NOT_READY;
+    }
+    
+    /* 拉低总线, 由 DHT11_FinishRead() 在18ms后释放 */
+    DHT11_SetPinOutput();
+    DHT11_SetPinLow();
+    dht11.startTick = HAL_GetTick();
+    dht11.reading = 1;
+    
+    return DHT11_OK;
+}
+
+/**
+  * @brief  分步读取第2步: 接收数据
+  */
+DHT11_Status_t DHT11_FinishRead(float *temperature, float *humidity)
+{
+    DHT11_RawData_t rawData;
+    DHT11_Status_t status;
+    
+    if (!dht11.reading) {
+        return DHT11_ERROR;
+    }
+    
+    /* 与阻塞读取一致, 保持20ms确保足够长 (HAL_GetTick分辨率为1ms) */
+    if ((HAL_GetTick() - dht11.startTick) <= 20) {
+        return DHT11_BUSY;
+    }
+    
+    dht11.reading = 0;
+    
+    PROF_BEGIN(DHT11_FRAME);
+    status = DHT11_ReceiveFrame(&rawData);
+    PROF_END(DHT11_FRAME);
+    
+    return DHT11_StoreResult(status, &rawData, temperature, humidity);
+}
+
+/**
+  * @brief  读取DHT11传感器原始数据
+  */
+DHT11_Status_t DHT11_ReadRaw(DHT11_RawData_t *rawData)
+{
+    DHT11_Status_t status;
+    
+    if (!dht11.initialized) {
+        return DHT11_ERROR;
+    }
+    
+    if (rawData == NULL) {
+        return DHT11_ERROR;
+    }
+    
+    /* 检查采样间隔 */
+    uint32_t currentTick = HAL_GetTick();
+    if ((currentTick - dht11.data.lastReadTime) < DHT11_MIN_SAMPLE_INTERVAL_MS && 
+        dht11.data.lastReadTime != 0) {
+#if DHT11_DEBUG_ENABLE
+        DHT11_DebugPrint("DHT11: Sampling too fast, please wait\r\n");
+#endif
+        return DHT11_ERROR_NOT_READY;
+    }
+    
+    /* 阻塞读取: 等待上电稳定的剩余时间 */
+    if ((int32_t)(dht11.readyTick - currentTick) > 0) {
+        HAL_Delay(dht11.readyTick - currentTick);
+    }
+    
+    /* ========== 第1步: 主机发送起始信号 ========== */
+    PROF_BEGIN(DHT11_READ);
+    
+    /* 设置为输出模式 */
+    DHT11_SetPinOutput();
+    
+    /* 拉低总线至少18ms */
+    DHT11_SetPinLow();
+    HAL_Delay(20);  /* 20ms确保足够长 */
+    
+    status = DHT11_ReceiveFrame(rawData);
+    PROF_END(DHT11_READ);
+    
+    return status;
+}
+
 /**
   * @brief  获取最后一次读取的温度
   */
@@ -450,6 +558,9 @@ DHT11_Status_t DHT11_GetLastStatus(void)
 uint8_t DHT11_IsReady(void)
 {
     uint32_t currentTick = HAL_GetTick();
+    if ((int32_t)(currentTick - dht11.readyTick) < 0) {
+        return 0;
+    }
     return ((currentTick - dht11.data.lastReadTime) >= DHT11_MIN_SAMPLE_INTERVAL_MS) || 
            (dht11.data.lastReadTime == 0);
 }
@@ -482,6 +593,8 @@ const char* DHT11_GetStatusString(DHT11_Status_t status)
             return "Not Ready (sampling too fast)";
         case DHT11_ERROR_INVALID_DATA:
             return "Invalid Data";
+        case DHT11_BUSY:
+            return "Busy (start signal in progress)";
         default:
             return "Unknown Error";
     }
@@ -493,15 +606,15 @@ const char* DHT11_GetStatusString(DHT11_Status_t status)
 void DHT11_DebugPrint(const char *format, ...)
 {
 #if DHT11_DEBUG_ENABLE
-    char buffer[128];
+    static LOG_Tag_t *logTag;
     va_list args;
     
+    /* 先判断标签级别, 关闭时不做格式化 */
+    if (!LOG_TagEnabled(&logTag, "DHT11", LOG_LEVEL_DEBUG)) return;
+    
     va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
+    LOG_VRaw(format, args);
     va_end(args);
-    
-    /* 使用LOG_Raw以兼容原有格式 */
-    LOG_Raw("%s", buffer);
 #else
     (void)format;   /* 避免未使用警告 */
 #endif
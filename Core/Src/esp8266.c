@@ -7,36 +7,115 @@
   */
 
 #include "esp8266.h"
+#include "mem_region.h"
 #include "esp8266_mqtt.h"  /* 用于异步MQTT消息处理 */
+#include "prof.h"
+#include "metrics.h"
+#include "power.h"
+#include "ctrl_latency.h"
+#include "scratch.h"
 
 /* Private variables ---------------------------------------------------------*/
-ESP8266_Handle_t esp8266;
+ESP8266_Handle_t esp8266 DMA_BUFFER;      /* 含 dmaRxBuffer */
+
+/* 等待模块期间调用的后台任务 (启动编排设置, 见 boot.h), 不随 ESP8266_Init 清除 */
+static void (*esp8266WaitHook)(void) = NULL;
+
+/* DMA发送中转缓冲区: 数据在CCM (栈上) 时经此发送 */
+static uint8_t esp8266TxBounce[ESP8266_TX_BOUNCE_SIZE] DMA_BUFFER;
 
 /* Private function prototypes -----------------------------------------------*/
-static void ESP8266_Delay(uint32_t ms);
 static uint8_t ESP8266_ParseIPD(ESP8266_RxData_t *rxData);
+static ESP8266_Status_t ESP8266_TransmitDMA(const uint8_t *data, uint16_t len);
+static void ESP8266_StatsVerb(const char *cmd, char *verb);
+static ESP8266_CmdStats_t* ESP8266_StatsFind(const char *verb, uint8_t create);
+static ESP8266_Status_t ESP8266_WakeByGpio(void);
+static void ESP8266_SleepEnd(void);
+static uint32_t ESP8266_LightSleepLeft(uint32_t now);
+static ESP8266_Status_t ESP8266_WaitReady(void);
+static void ESP8266_CopyQuoted(const char *key, char *out, uint16_t size);
+static void ESP8266_JoinRecord(ESP8266_JoinPath_t path, uint32_t start, uint8_t ok);
+
+/* 健康指标: 上一条订阅消息还未处理就被新消息覆盖的次数 */
+static Metric_t espRxDropMetric = METRIC_COUNTER_INIT("esp.rx_drop");
+
+/* 健康指标: 模块休眠累计时间与次数 */
+static Metric_t espSleepMsMetric = METRIC_SOURCE_INIT("esp.sleep_ms", METRIC_COUNTER, &esp8266.sleepMs);
+static Metric_t espSleepCountMetric = METRIC_SOURCE_INIT("esp.sleep", METRIC_COUNTER, &esp8266.sleepCount);
+
+/* 健康指标: 最近一次入网耗时 (发出命令到获得IP) */
+static Metric_t espJoinMsMetric = METRIC_SOURCE_INIT("wifi.join_ms", METRIC_GAUGE, &esp8266.lastJoinMs);
+
+/* 入网路径名 (JSON字段名) */
+static const char *const esp8266JoinPathNames[ESP8266_JOIN_PATH_COUNT] = { "fast", "full" };
+
+/* AT命令延时直方图桶上界(ms) */
+static const uint32_t esp8266StatsBounds[ESP8266_STATS_BINS - 1] = ESP8266_STATS_BIN_BOUNDS;
 
 /* Debug print - 使用统一日志库 */
 void ESP8266_DebugPrint(const char *format, ...)
 {
 #if ESP8266_DEBUG_ENABLE
-    char buf[256];
+    static LOG_Tag_t *logTag;
     va_list args;
+    
+    /* 先判断标签级别, 关闭时不做格式化 */
+    if (!LOG_TagEnabled(&logTag, "ESP8266", LOG_LEVEL_DEBUG)) return;
+    
     va_start(args, format);
-    vsnprintf(buf, sizeof(buf), format, args);
+    LOG_VRaw(format, args);
     va_end(args);
-    /* 使用LOG_Raw以兼容原有格式 */
-    LOG_Raw("%s", buf);
 #endif
 }
 
-static void ESP8266_Delay(uint32_t ms) { HAL_Delay(ms); }
+/* 等待模块 (轮询间隔), 累计等待时间: 这部分CPU时间在有调度时可以让出;
+ * 设置了后台任务时先运行一次, 剩余的时间再等待 (后台任务不计入等待时间) */
+void ESP8266_Delay(uint32_t ms) {
+    static uint8_t inHook = 0;
+    uint32_t start = HAL_GetTick();
+    uint32_t elapsed;
+    
+    if (esp8266WaitHook != NULL && !inHook) {
+        inHook = 1;
+        esp8266WaitHook();
+        inHook = 0;
+    }
+    
+    elapsed = HAL_GetTick() - start;
+    if (elapsed < ms) {
+        start = HAL_GetTick();
+        HAL_Delay(ms - elapsed);
+        esp8266.waitMs += HAL_GetTick() - start;
+    }
+}
+
+/* 设置等待期间的后台任务, NULL 取消 */
+void ESP8266_SetWaitHook(void (*hook)(void)) { esp8266WaitHook = hook; }
+
+uint32_t ESP8266_GetWaitTime(void) { return esp8266.waitMs; }
 
 /* DMA发送 */
 ESP8266_Status_t ESP8266_SendDMA(const uint8_t *data, uint16_t len)
 {
     if (data == NULL || len == 0) return ESP8266_INVALID_PARAM;
+    if (!MEM_IS_CCM(data)) return ESP8266_TransmitDMA(data, len);
     
+    /* DMA访问不到CCM: 分块复制到中转缓冲区发送 */
+    while (len > 0) {
+        uint16_t chunk = len < ESP8266_TX_BOUNCE_SIZE ? len : ESP8266_TX_BOUNCE_SIZE;
+        ESP8266_Status_t ret;
+        memcpy(esp8266TxBounce, data, chunk);
+        ret = ESP8266_TransmitDMA(esp8266TxBounce, chunk);
+        if (ret != ESP8266_OK) return ret;
+        data += chunk;
+        len -= chunk;
+    }
+    return ESP8266_OK;
+}
+
+/* 启动一次DMA发送并等待完成 (data 必须在 SRAM/Flash 中) */
+static ESP8266_Status_t ESP8266_TransmitDMA(const uint8_t *data, uint16_t len)
+{
     uint32_t timeout = HAL_GetTick();
     while (esp8266.txBusy) {
         if (HAL_GetTick() - timeout > 1000) return ESP8266_TIMEOUT;
@@ -78,6 +157,7 @@ void ESP8266_UART_IdleCallback(UART_HandleTypeDef *huart)
         esp8266.rxBuffer[len] = '\0';
         esp8266.rxLength = len;
         esp8266.rxComplete = 1;
+        esp8266.rxTick = HAL_GetTick();
     }
     ESP8266_StartDMAReceive();
 }
@@ -90,15 +170,23 @@ void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
         esp8266.rxBuffer[Size] = '\0';
         esp8266.rxLength = Size;
         esp8266.rxComplete = 1;
+        esp8266.rxTick = HAL_GetTick();
         
         /* 检测MQTT订阅消息，复制到专用缓冲区等待处理 */
         if (strstr((char *)esp8266.rxBuffer, "+MQTTSUBRECV:") != NULL) {
             extern MQTT_Handle_t mqtt;
-            uint16_t copyLen = Size < 511 ? Size : 511;
+            uint16_t copyLen = Size < sizeof(mqtt.msgBuffer) - 1 ? Size : sizeof(mqtt.msgBuffer) - 1;
+            if (mqtt.msgPending) Metrics_Inc(&espRxDropMetric);
             memcpy(mqtt.msgBuffer, esp8266.rxBuffer, copyLen);
             mqtt.msgBuffer[copyLen] = '\0';
             mqtt.msgLen = copyLen;
             mqtt.msgPending = 1;  /* 设置待处理标志 */
+            CTRL_LAT_STAMP(URC);
+        }
+        
+        /* 超时后迟到的发布应答 */
+        if (mqtt.ackPending && strstr((char *)esp8266.rxBuffer, "+MQTTPUB:") != NULL) {
+            mqtt.ackPending = 0;
         }
         
         ESP8266_StartDMAReceive();
@@ -109,8 +197,12 @@ void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 {
     if (huart == esp8266.huart) {
+        esp8266.txDoneTick = HAL_GetTick();
         esp8266.txBusy = 0;
     }
+
+    /* 日志串口的DMA发送完成 */
+    LOG_TxCpltCallback(huart);
 }
 
 /* 初始化 */
@@ -119,12 +211,22 @@ ESP8266_Status_t ESP8266_Init(UART_HandleTypeDef *huart)
     ESP8266_DebugPrint("[ESP8266] DMA Init...\r\n");
     
     memset(&esp8266, 0, sizeof(ESP8266_Handle_t));
+    esp8266.cmdStatsQuery = ESP8266_STATS_MAX_VERBS;
     esp8266.huart = huart;
+    Metrics_Register(&espRxDropMetric);
+    Metrics_Register(&espSleepMsMetric);
+    Metrics_Register(&espSleepCountMetric);
+    Metrics_Register(&espJoinMsMetric);
+    
+    /* 模块随时可能推送数据 (订阅消息/+IPD), STOP唤醒期间会丢字节, 只允许Sleep;
+     * 只在 DeInit 和 Light-sleep (ESP8266_SLEEP_ALLOW_MCU_STOP) 期间释放 */
+    Power_HoldStop(POWER_HOLD_ESP8266);
     
     ESP8266_StartDMAReceive();
-    ESP8266_Delay(1000);
     
-    if (ESP8266_Test() != ESP8266_OK) {
+    /* 模块与MCU同时上电时还在启动, 应答AT即继续 (代替固定等待1s);
+     * 没有应答可能是还在透传模式, 退出后再试一次 */
+    if (ESP8266_WaitReady() != ESP8266_OK) {
         ESP8266_ExitTransparent();
         ESP8266_Delay(500);
         if (ESP8266_Test() != ESP8266_OK) {
@@ -134,7 +236,11 @@ ESP8266_Status_t ESP8266_Init(UART_HandleTypeDef *huart)
     }
     
     ESP8266_SetEcho(0);
-    ESP8266_SetWiFiMode(ESP8266_MODE_STA);
+    
+    /* 工作模式保存在模块Flash中, 已是Station时不再写入 */
+    ESP8266_WiFiMode_t mode;
+    if (ESP8266_GetWiFiMode(&mode) == ESP8266_OK && mode == ESP8266_MODE_STA) esp8266.wifiMode = mode;
+    else ESP8266_SetWiFiMode(ESP8266_MODE_STA);
     esp8266.initialized = 1;
     ESP8266_DebugPrint("[ESP8266] Init OK\r\n");
     return ESP8266_OK;
@@ -143,12 +249,13 @@ ESP8266_Status_t ESP8266_Init(UART_HandleTypeDef *huart)
 ESP8266_Status_t ESP8266_DeInit(void) {
     HAL_UART_DMAStop(esp8266.huart);
     esp8266.initialized = 0;
+    Power_ReleaseStop(POWER_HOLD_ESP8266);
     return ESP8266_OK;
 }
 
 ESP8266_Status_t ESP8266_Reset(void) {
     ESP8266_Status_t ret = ESP8266_SendCommand("AT+RST\r\n", "ready", ESP8266_LONG_TIMEOUT);
-    if (ret == ESP8266_OK) { ESP8266_Delay(2000); esp8266.wifiConnected = 0; }
+    if (ret == ESP8266_OK) { ESP8266_Delay(2000); esp8266.wifiConnected = 0; ESP8266_SleepEnd(); }
     return ret;
 }
 
@@ -158,7 +265,7 @@ ESP8266_Status_t ESP8266_Test(void) {
 
 ESP8266_Status_t ESP8266_Restore(void) {
     ESP8266_Status_t ret = ESP8266_SendCommand("AT+RESTORE\r\n", "ready", ESP8266_LONG_TIMEOUT);
-    if (ret == ESP8266_OK) { ESP8266_Delay(2000); esp8266.wifiConnected = 0; }
+    if (ret == ESP8266_OK) { ESP8266_Delay(2000); esp8266.wifiConnected = 0; ESP8266_SleepEnd(); }
     return ret;
 }
 
@@ -177,6 +284,24 @@ ESP8266_Status_t ESP8266_GetVersion(char *version, uint16_t maxLen) {
     return ret;
 }
 
+/* 临时修改波特率 (AT+UART_CUR, 不写Flash): 模块按旧波特率回 OK 后切换, 本端随后重配串口 */
+ESP8266_Status_t ESP8266_SetBaudRate(uint32_t baud) {
+    if (baud == 0) return ESP8266_INVALID_PARAM;
+    if (baud == esp8266.huart->Init.BaudRate) return ESP8266_OK;
+
+    ESP8266_Status_t ret = ESP8266_SendCommandF("OK", ESP8266_DEFAULT_TIMEOUT, "AT+UART_CUR=%lu,8,1,0,0\r\n",
+                                                (unsigned long)baud);
+    if (ret != ESP8266_OK) return ret;
+
+    HAL_UART_DMAStop(esp8266.huart);
+    esp8266.huart->Init.BaudRate = baud;
+    if (HAL_UART_Init(esp8266.huart) != HAL_OK) return ESP8266_ERROR;
+    ESP8266_StartDMAReceive();
+    ESP8266_Delay(10);
+    ESP8266_ClearBuffer();
+    return ESP8266_SendCommand("AT\r\n", "OK", ESP8266_DEFAULT_TIMEOUT);
+}
+
 ESP8266_Status_t ESP8266_SetWiFiMode(ESP8266_WiFiMode_t mode) {
     ESP8266_Status_t ret = ESP8266_SendCommandF("OK", ESP8266_DEFAULT_TIMEOUT, "AT+CWMODE=%d\r\n", mode);
     if (ret == ESP8266_OK) esp8266.wifiMode = mode;
@@ -222,9 +347,36 @@ ESP8266_Status_t ESP8266_DisconnectAP(void) {
     return ret;
 }
 
+/* 查询当前连接的AP: +CWJAP:"<ssid>","<bssid>",<channel>,<rssi>, 未连接时回 "No AP" */
 ESP8266_Status_t ESP8266_GetAPInfo(ESP8266_APInfo_t *apInfo) {
     if (!apInfo) return ESP8266_INVALID_PARAM;
-    return ESP8266_SendCommand("AT+CWJAP?\r\n", "OK", ESP8266_DEFAULT_TIMEOUT);
+    memset(apInfo, 0, sizeof(ESP8266_APInfo_t));
+    ESP8266_Status_t ret = ESP8266_SendCommand("AT+CWJAP?\r\n", "OK", ESP8266_DEFAULT_TIMEOUT);
+    if (ret != ESP8266_OK) return ret;
+    
+    char *ptr = strstr((char *)esp8266.rxBuffer, "+CWJAP:\"");
+    if (!ptr) return ESP8266_NOT_CONNECTED;
+    ptr += 8;
+    char *end = strchr(ptr, '"');
+    if (!end) return ESP8266_ERROR;
+    int len = end - ptr; if (len > 32) len = 32;
+    memcpy(apInfo->ssid, ptr, len); apInfo->ssid[len] = '\0';
+    
+    ptr = strstr(end, ",\"");
+    if (ptr) {
+        ptr += 2;
+        end = strchr(ptr, '"');
+        if (end) {
+            len = end - ptr; if (len > 17) len = 17;
+            memcpy(apInfo->mac, ptr, len); apInfo->mac[len] = '\0';
+            if (end[1] == ',') {
+                apInfo->channel = (uint8_t)atoi(end + 2);
+                ptr = strchr(end + 2, ',');
+                if (ptr) apInfo->rssi = (int8_t)atoi(ptr + 1);
+            }
+        }
+    }
+    return ESP8266_OK;
 }
 
 ESP8266_Status_t ESP8266_ScanAP(ESP8266_APInfo_t *apList, uint8_t maxCount, uint8_t *foundCount) {
@@ -237,6 +389,100 @@ ESP8266_Status_t ESP8266_SetAutoConnect(uint8_t enable) {
     return ESP8266_SendCommandF("OK", ESP8266_DEFAULT_TIMEOUT, "AT+CWAUTOCONN=%d\r\n", enable ? 1 : 0);
 }
 
+/* 快速重连: 缓存有效时先用上次的地址作静态IP (省掉DHCP), 再指定BSSID入网 (省掉全信道扫描);
+ * 失败则缓存作废, 恢复DHCP后完整入网, 成功后重新记录缓存。两条路径分别统计到获得IP的耗时 */
+ESP8266_Status_t ESP8266_Rejoin(const char *ssid, const char *password) {
+    ESP8266_JoinCache_t *cache = &esp8266.joinCache;
+    ESP8266_Status_t ret;
+    uint32_t start;
+    
+    if (!ssid) return ESP8266_INVALID_PARAM;
+    if (!password) password = "";
+    
+    if (ESP8266_JoinCacheValid()) {
+        start = HAL_GetTick();
+        ret = ESP8266_SetStationIP(cache->lease.ip, cache->lease.gateway, cache->lease.netmask);
+        if (ret == ESP8266_OK)
+            ret = ESP8266_SendCommandF("OK", ESP8266_FAST_JOIN_TIMEOUT, "AT+CWJAP=\"%s\",\"%s\",\"%s\"\r\n",
+                                       ssid, password, cache->bssid);
+        if (ret == ESP8266_OK) {
+            esp8266.wifiConnected = 1;
+            memcpy(&esp8266.ipInfo, &cache->lease, sizeof(ESP8266_IPInfo_t));
+            ESP8266_JoinRecord(ESP8266_JOIN_FAST, start, 1);
+            if (esp8266.onWifiConnected) esp8266.onWifiConnected();
+            return ESP8266_OK;
+        }
+        ESP8266_JoinRecord(ESP8266_JOIN_FAST, start, 0);
+        LOG_W(TAG_ESP8266, "Fast join via %s failed (%d), full join", cache->bssid, ret);
+        memset(cache, 0, sizeof(ESP8266_JoinCache_t));
+        esp8266.joinFallbacks++;
+    }
+    
+    /* 上次的静态地址保存在模块里, 完整入网前总是恢复DHCP */
+    start = HAL_GetTick();
+    ret = ESP8266_EnableDHCP(ESP8266_MODE_STA, 1);
+    if (ret == ESP8266_OK) ret = ESP8266_ConnectAP(ssid, password);
+    ESP8266_JoinRecord(ESP8266_JOIN_FULL, start, ret == ESP8266_OK);
+    if (ret == ESP8266_OK) ESP8266_UpdateJoinCache();
+    return ret;
+}
+
+/* 从模块读取当前AP的BSSID/信道与地址, 记入快速重连缓存 */
+ESP8266_Status_t ESP8266_UpdateJoinCache(void) {
+    ESP8266_JoinCache_t *cache = &esp8266.joinCache;
+    ESP8266_APInfo_t ap;
+    ESP8266_IPInfo_t lease;
+    ESP8266_Status_t ret;
+    
+    memset(&lease, 0, sizeof(lease));
+    ret = ESP8266_GetAPInfo(&ap);
+    if (ret == ESP8266_OK) ret = ESP8266_GetStationIP(&lease);
+    if (ret != ESP8266_OK || ap.mac[0] == '\0' || lease.ip[0] == '\0' || strcmp(lease.ip, "0.0.0.0") == 0) {
+        memset(cache, 0, sizeof(ESP8266_JoinCache_t));
+        return (ret == ESP8266_OK) ? ESP8266_NOT_CONNECTED : ret;
+    }
+    strcpy(cache->bssid, ap.mac);
+    cache->channel = ap.channel;
+    memcpy(&cache->lease, &lease, sizeof(ESP8266_IPInfo_t));
+    return ESP8266_OK;
+}
+
+uint8_t ESP8266_JoinCacheValid(void) {
+    const ESP8266_JoinCache_t *cache = &esp8266.joinCache;
+    return cache->bssid[0] != '\0' && cache->lease.ip[0] != '\0' &&
+           cache->lease.gateway[0] != '\0' && cache->lease.netmask[0] != '\0';
+}
+
+/* {"wifi":{"path":"fast","bssid":"..","ch":6,"ip":"..","fallback":0,
+ *  "fast":{"n":1,"fail":0,"last":620,"max":620,"mean":620},"full":{...}}} */
+int ESP8266_FormatJoinJson(char *buf, uint16_t size) {
+    const ESP8266_JoinStats_t *stats;
+    int len, n;
+    uint8_t i;
+    
+    if (!buf || size == 0) return 0;
+    len = snprintf(buf, size, "{\"wifi\":{\"path\":\"%s\",\"bssid\":\"%s\",\"ch\":%u,\"ip\":\"%s\",\"fallback\":%lu",
+                   esp8266JoinPathNames[esp8266.lastJoinPath], esp8266.joinCache.bssid,
+                   esp8266.joinCache.channel, esp8266.ipInfo.ip, (unsigned long)esp8266.joinFallbacks);
+    for (i = 0; i < ESP8266_JOIN_PATH_COUNT && len > 0 && len < size; i++) {
+        stats = &esp8266.joinStats[i];
+        n = snprintf(buf + len, size - len, ",\"%s\":{\"n\":%lu,\"fail\":%lu,\"last\":%lu,\"max\":%lu,\"mean\":%lu}",
+                     esp8266JoinPathNames[i], (unsigned long)stats->count, (unsigned long)stats->fail,
+                     (unsigned long)stats->lastMs, (unsigned long)stats->maxMs,
+                     (unsigned long)(stats->count ? stats->totalMs / stats->count : 0));
+        len = (n < 0) ? -1 : len + n;
+    }
+    if (len > 0 && len < size) {
+        n = snprintf(buf + len, size - len, "}}");
+        len = (n < 0) ? -1 : len + n;
+    }
+    if (len <= 0 || len >= size) {
+        buf[0] = '\0';
+        return 0;
+    }
+    return len;
+}
+
 ESP8266_Status_t ESP8266_SetupAP(const char *ssid, const char *password, uint8_t channel, ESP8266_Encryption_t ecn) {
     if (!ssid) return ESP8266_INVALID_PARAM;
     return ESP8266_SendCommandF("OK", ESP8266_DEFAULT_TIMEOUT, "AT+CWSAP=\"%s\",\"%s\",%d,%d\r\n",
@@ -261,6 +507,18 @@ ESP8266_Status_t ESP8266_GetIPInfo(ESP8266_IPInfo_t *ipInfo) {
     return ret;
 }
 
+/* 查询Station地址: +CIPSTA:ip:"..." / +CIPSTA:gateway:"..." / +CIPSTA:netmask:"..." */
+ESP8266_Status_t ESP8266_GetStationIP(ESP8266_IPInfo_t *ipInfo) {
+    if (!ipInfo) return ESP8266_INVALID_PARAM;
+    ESP8266_Status_t ret = ESP8266_SendCommand("AT+CIPSTA?\r\n", "OK", ESP8266_DEFAULT_TIMEOUT);
+    if (ret == ESP8266_OK) {
+        ESP8266_CopyQuoted("+CIPSTA:ip:\"", ipInfo->ip, sizeof(ipInfo->ip));
+        ESP8266_CopyQuoted("+CIPSTA:gateway:\"", ipInfo->gateway, sizeof(ipInfo->gateway));
+        ESP8266_CopyQuoted("+CIPSTA:netmask:\"", ipInfo->netmask, sizeof(ipInfo->netmask));
+    }
+    return ret;
+}
+
 ESP8266_Status_t ESP8266_SetStationIP(const char *ip, const char *gateway, const char *netmask) {
     if (!ip) return ESP8266_INVALID_PARAM;
     if (gateway && netmask)
@@ -361,8 +619,14 @@ ESP8266_Status_t ESP8266_Send(uint8_t linkId, const uint8_t *data, uint16_t len)
     
     ESP8266_ClearBuffer();
     ESP8266_SendDMA(data, len);
+    uint32_t txDone = esp8266.txDoneTick;
     
-    if (ESP8266_WaitForResponse("SEND OK", ESP8266_DEFAULT_TIMEOUT)) return ESP8266_OK;
+    if (ESP8266_WaitForResponse("SEND OK", ESP8266_DEFAULT_TIMEOUT)) {
+        ESP8266_StatsRecord("CIPSEND.data", ESP8266_OK, ESP8266_GetResponseLatency(txDone));
+        return ESP8266_OK;
+    }
+    ESP8266_StatsRecord("CIPSEND.data", ESP8266_ContainsString("SEND FAIL") ? ESP8266_ERROR : ESP8266_TIMEOUT,
+                        ESP8266_GetResponseLatency(txDone));
     return ESP8266_SEND_FAIL;
 }
 
@@ -372,12 +636,18 @@ ESP8266_Status_t ESP8266_SendString(uint8_t linkId, const char *str) {
 }
 
 ESP8266_Status_t ESP8266_SendPrintf(uint8_t linkId, const char *format, ...) {
-    char buf[ESP8266_TX_BUF_SIZE];
+    Scratch_Mark_t mark = Scratch_Mark();
+    char *buf = Scratch_Alloc(ESP8266_TX_BUF_SIZE);
+    ESP8266_Status_t ret = ESP8266_NO_MEMORY;
     va_list args;
-    va_start(args, format);
-    int len = vsnprintf(buf, sizeof(buf), format, args);
-    va_end(args);
-    return len > 0 ? ESP8266_Send(linkId, (uint8_t *)buf, len) : ESP8266_INVALID_PARAM;
+    if (buf) {
+        va_start(args, format);
+        int len = vsnprintf(buf, ESP8266_TX_BUF_SIZE, format, args);
+        va_end(args);
+        ret = len > 0 ? ESP8266_Send(linkId, (uint8_t *)buf, len) : ESP8266_INVALID_PARAM;
+    }
+    Scratch_Release(mark);
+    return ret;
 }
 
 ESP8266_Status_t ESP8266_EnterTransparent(void) {
@@ -408,9 +678,12 @@ ESP8266_Status_t ESP8266_HttpGet(const char *host, uint16_t port, const char *pa
     ESP8266_Status_t ret = ESP8266_Connect(ESP8266_TCP, host, port, NULL);
     if (ret != ESP8266_OK && ret != ESP8266_ALREADY_CONNECTED) return ret;
     
-    char request[512];
-    int len = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n", path, host);
+    Scratch_Mark_t mark = Scratch_Mark();
+    char *request = Scratch_Alloc(ESP8266_HTTP_REQ_SIZE);
+    if (!request) { Scratch_Release(mark); ESP8266_Close(0); return ESP8266_NO_MEMORY; }
+    int len = snprintf(request, ESP8266_HTTP_REQ_SIZE, "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n", path, host);
     ret = ESP8266_Send(0, (uint8_t *)request, len);
+    Scratch_Release(mark);
     
     ESP8266_Delay(2000);
     if (response && esp8266.rxLength > 0) {
@@ -430,11 +703,15 @@ ESP8266_Status_t ESP8266_HttpPost(const char *host, uint16_t port, const char *p
     if (ret != ESP8266_OK && ret != ESP8266_ALREADY_CONNECTED) return ret;
     
     uint16_t bodyLen = body ? strlen(body) : 0;
-    char request[1024];
-    int len = snprintf(request, sizeof(request),
+    Scratch_Mark_t mark = Scratch_Mark();
+    char *request = Scratch_Alloc(ESP8266_HTTP_REQ_SIZE);
+    if (!request) { Scratch_Release(mark); ESP8266_Close(0); return ESP8266_NO_MEMORY; }
+    int len = snprintf(request, ESP8266_HTTP_REQ_SIZE,
         "POST %s HTTP/1.1\r\nHost: %s\r\nContent-Type: %s\r\nContent-Length: %d\r\nConnection: close\r\n\r\n%s",
         path, host, contentType ? contentType : "application/x-www-form-urlencoded", bodyLen, body ? body : "");
-    ret = ESP8266_Send(0, (uint8_t *)request, len);
+    if (len >= ESP8266_HTTP_REQ_SIZE) len = ESP8266_HTTP_REQ_SIZE - 1;
+    ret = len > 0 ? ESP8266_Send(0, (uint8_t *)request, len) : ESP8266_INVALID_PARAM;
+    Scratch_Release(mark);
     
     ESP8266_Delay(2000);
     if (response && esp8266.rxLength > 0) {
@@ -454,28 +731,52 @@ ESP8266_Status_t ESP8266_Ping(const char *host) {
 
 /* 底层AT命令发送 */
 ESP8266_Status_t ESP8266_SendCommand(const char *cmd, const char *expectedResp, uint32_t timeout) {
+    ESP8266_Status_t status;
+    char verb[ESP8266_STATS_VERB_LEN];
+    uint32_t txDone;
     if (!cmd) return ESP8266_INVALID_PARAM;
     
+    /* Light-sleep 时先唤醒 (asleep 在 AT+SLEEP 成功后才置位, 休眠命令本身不会触发唤醒);
+     * Modem-sleep 下串口始终可用, 命令直接发送, 模块保持休眠模式 */
+    if (esp8266.asleep && esp8266.sleepPolicy == ESP8266_SLEEP_LIGHT) ESP8266_Wake();
+    
+    PROF_BEGIN(ESP_CMD);
     ESP8266_ClearBuffer();
     ESP8266_SendDMA((uint8_t *)cmd, strlen(cmd));
+    txDone = esp8266.txDoneTick;
     
-    if (!expectedResp) return ESP8266_OK;
-    if (ESP8266_WaitForResponse(expectedResp, timeout)) return ESP8266_OK;
-    if (ESP8266_ContainsString("ERROR")) return ESP8266_ERROR;
-    if (ESP8266_ContainsString("BUSY")) return ESP8266_BUSY;
-    return ESP8266_TIMEOUT;
+    if (!expectedResp) status = ESP8266_OK;
+    else if (ESP8266_WaitForResponse(expectedResp, timeout)) status = ESP8266_OK;
+    else if (ESP8266_ContainsString("ERROR")) status = ESP8266_ERROR;
+    /* 固件忙时回小写的 "busy p..." (处理中) / "busy s..." (发送中) */
+    else if (ESP8266_ContainsString("busy p") || ESP8266_ContainsString("busy s")) status = ESP8266_BUSY;
+    else status = ESP8266_TIMEOUT;
+    PROF_END(ESP_CMD);
+    
+    /* 按命令动词统计结果与应答延时 */
+    ESP8266_StatsVerb(cmd, verb);
+    ESP8266_StatsRecord(verb, status, expectedResp ? ESP8266_GetResponseLatency(txDone) : ESP8266_STATS_NO_LATENCY);
+    esp8266.lastActivity = HAL_GetTick();
+    return status;
 }
 
 ESP8266_Status_t ESP8266_SendCommandF(const char *expectedResp, uint32_t timeout, const char *format, ...) {
+    Scratch_Mark_t mark = Scratch_Mark();
+    char *cmd = Scratch_Alloc(ESP8266_TX_BUF_SIZE);
+    ESP8266_Status_t ret = ESP8266_NO_MEMORY;
     va_list args;
-    va_start(args, format);
-    vsnprintf((char *)esp8266.txBuffer, ESP8266_TX_BUF_SIZE, format, args);
-    va_end(args);
-    return ESP8266_SendCommand((char *)esp8266.txBuffer, expectedResp, timeout);
+    if (cmd) {
+        va_start(args, format);
+        vsnprintf(cmd, ESP8266_TX_BUF_SIZE, format, args);
+        va_end(args);
+        ret = ESP8266_SendCommand(cmd, expectedResp, timeout);
+    }
+    Scratch_Release(mark);
+    return ret;
 }
 
 void ESP8266_ClearBuffer(void) {
-    memset(esp8266.rxBuffer, 0, ESP8266_RX_BUF_SIZE);
+    memset(esp8266.rxBuffer, 0, sizeof(esp8266.rxBuffer));
     esp8266.rxLength = 0;
     esp8266.rxComplete = 0;
 }
@@ -511,7 +812,12 @@ static uint8_t ESP8266_ParseIPD(ESP8266_RxData_t *rxData) {
     ptr = strchr(ptr, ':');
     if (!ptr) return 0;
     ptr++;
-    uint16_t copyLen = rxData->length < ESP8266_RX_BUF_SIZE - 1 ? rxData->length : ESP8266_RX_BUF_SIZE - 1;
+    /* 只复制本次收到的部分, 数据放在共享区 (由调用者释放) */
+    uint16_t avail = esp8266.rxLength > (uint16_t)(ptr - (char *)esp8266.rxBuffer) ?
+                     esp8266.rxLength - (uint16_t)(ptr - (char *)esp8266.rxBuffer) : 0;
+    uint16_t copyLen = rxData->length < avail ? rxData->length : avail;
+    rxData->data = Scratch_Alloc(copyLen + 1);
+    if (!rxData->data) return 0;
     memcpy(rxData->data, ptr, copyLen);
     rxData->data[copyLen] = '\0';
     return 1;
@@ -529,10 +835,344 @@ void ESP8266_ProcessData(void) {
     }
     
     if (ESP8266_ContainsString("+IPD,")) {
+        Scratch_Mark_t mark = Scratch_Mark();
         ESP8266_RxData_t rxData;
         if (ESP8266_ParseIPD(&rxData) && esp8266.onDataReceived) {
             esp8266.onDataReceived(&rxData);
         }
+        Scratch_Release(mark);
+    }
+}
+
+/* ========== AT命令统计 ========== */
+
+/* 提取命令动词: "AT+CWJAP=..." -> "CWJAP", "ATE0\r\n" -> "ATE0", 非AT命令 -> "raw" */
+static void ESP8266_StatsVerb(const char *cmd, char *verb) {
+    uint8_t i = 0;
+    
+    if (strncmp(cmd, "AT+", 3) == 0) cmd += 3;
+    else if (strncmp(cmd, "AT", 2) != 0) { strcpy(verb, "raw"); return; }
+    
+    while (cmd[i] && cmd[i] != '=' && cmd[i] != '?' && cmd[i] != '\r' && cmd[i] != '\n' &&
+           i < ESP8266_STATS_VERB_LEN - 1) {
+        verb[i] = cmd[i];
+        i++;
+    }
+    verb[i] = '\0';
+}
+
+/* 查找统计项, create=1 时不存在则新建. 前 ESP8266_STATS_MAX_VERBS-1 项给具体动词,
+ * 最后一项保留为 "other", 表满后第一次遇到新动词时清零启用 */
+static ESP8266_CmdStats_t* ESP8266_StatsFind(const char *verb, uint8_t create) {
+    ESP8266_CmdStats_t *stats;
+    uint8_t i;
+    
+    for (i = 0; i < esp8266.cmdStatsCount; i++) {
+        if (strcmp(esp8266.cmdStats[i].verb, verb) == 0) return &esp8266.cmdStats[i];
+    }
+    if (!create) return NULL;
+    
+    if (esp8266.cmdStatsCount >= ESP8266_STATS_MAX_VERBS - 1) {
+        stats = &esp8266.cmdStats[ESP8266_STATS_MAX_VERBS - 1];
+        if (esp8266.cmdStatsCount < ESP8266_STATS_MAX_VERBS) {
+            memset(stats, 0, sizeof(*stats));
+            strcpy(stats->verb, "other");
+            esp8266.cmdStatsCount = ESP8266_STATS_MAX_VERBS;
+        }
+        return stats;
+    }
+    
+    stats = &esp8266.cmdStats[esp8266.cmdStatsCount++];
+    memset(stats, 0, sizeof(*stats));
+    strncpy(stats->verb, verb, ESP8266_STATS_VERB_LEN - 1);
+    stats->verb[ESP8266_STATS_VERB_LEN - 1] = '\0';
+    return stats;
+}
+
+/* 从DMA发送完成到最近一次收到数据的毫秒数 */
+uint32_t ESP8266_GetResponseLatency(uint32_t txDoneTick) {
+    int32_t latency = (int32_t)(esp8266.rxTick - txDoneTick);
+    return latency > 0 ? (uint32_t)latency : 0;
+}
+
+/* 记录一次命令结果, 超时和 ESP8266_STATS_NO_LATENCY 不计入直方图 */
+void ESP8266_StatsRecord(const char *verb, ESP8266_Status_t status, uint32_t latency) {
+    ESP8266_CmdStats_t *stats;
+    uint8_t bin;
+    
+    if (!verb) return;
+    stats = ESP8266_StatsFind(verb, 1);
+    
+    stats->issued++;
+    switch (status) {
+        case ESP8266_OK:      stats->ok++; break;
+        case ESP8266_ERROR:   stats->error++; break;
+        case ESP8266_BUSY:    stats->busy++; break;
+        default:              stats->timeout++; break;
+    }
+    if (status == ESP8266_TIMEOUT || latency == ESP8266_STATS_NO_LATENCY) return;
+    
+    for (bin = 0; bin < ESP8266_STATS_BINS - 1 && latency >= esp8266StatsBounds[bin]; bin++);
+    if (stats->hist[bin] < 0xFFFF) stats->hist[bin]++;
+    stats->latencyCount++;
+    stats->latencyTotal += latency;
+    if (latency > stats->latencyMax) stats->latencyMax = latency;
+}
+
+ESP8266_Status_t ESP8266_GetCmdStats(const char *verb, ESP8266_CmdStats_t *stats) {
+    ESP8266_CmdStats_t *entry;
+    if (!verb || !stats) return ESP8266_INVALID_PARAM;
+    entry = ESP8266_StatsFind(verb, 0);
+    if (!entry) return ESP8266_NOT_FOUND;
+    *stats = *entry;
+    return ESP8266_OK;
+}
+
+uint8_t ESP8266_GetCmdStatsCount(void) { return esp8266.cmdStatsCount; }
+
+void ESP8266_ResetCmdStats(void) {
+    esp8266.cmdStatsCount = 0;
+    esp8266.cmdStatsQuery = ESP8266_STATS_MAX_VERBS;
+}
+
+/* 统计项编码为JSON, hist 各桶上界见 ESP8266_STATS_BIN_BOUNDS */
+int ESP8266_FormatCmdStats(uint8_t index, char *buf, uint16_t size) {
+    const ESP8266_CmdStats_t *stats;
+    int len, n;
+    uint8_t i;
+    
+    if (index >= esp8266.cmdStatsCount || !buf || size == 0) return 0;
+    stats = &esp8266.cmdStats[index];
+    
+    len = snprintf(buf, size,
+                   "{\"verb\":\"%s\",\"n\":%lu,\"ok\":%lu,\"error\":%lu,\"busy\":%lu,\"timeout\":%lu,"
+                   "\"mean\":%lu,\"max\":%lu,\"hist\":[",
+                   stats->verb, (unsigned long)stats->issued, (unsigned long)stats->ok,
+                   (unsigned long)stats->error, (unsigned long)stats->busy, (unsigned long)stats->timeout,
+                   (unsigned long)(stats->latencyCount ? stats->latencyTotal / stats->latencyCount : 0),
+                   (unsigned long)stats->latencyMax);
+    for (i = 0; i < ESP8266_STATS_BINS && len > 0 && len < size; i++) {
+        n = snprintf(buf + len, size - len, i ? ",%u" : "%u", stats->hist[i]);
+        len = (n < 0) ? -1 : len + n;
+    }
+    if (len > 0 && len < size) {
+        n = snprintf(buf + len, size - len, "]}");
+        len = (n < 0) ? -1 : len + n;
+    }
+    if (len <= 0 || len >= size) {
+        buf[0] = '\0';
+        return 0;
+    }
+    return len;
+}
+
+void ESP8266_StartStatsQuery(void) { esp8266.cmdStatsQuery = 0; }
+
+/* 分块导出: 每次一个命令动词, 0 表示结束 */
+int ESP8266_NextStatsChunk(char *buf, uint16_t size) {
+    int len;
+    while (esp8266.cmdStatsQuery < esp8266.cmdStatsCount) {
+        len = ESP8266_FormatCmdStats(esp8266.cmdStatsQuery++, buf, size);
+        if (len > 0) return len;
+    }
+    esp8266.cmdStatsQuery = ESP8266_STATS_MAX_VERBS;
+    return 0;
+}
+
+/* ========== 模块休眠 ========== */
+
+/* 设置空闲时的休眠模式, 没有唤醒线时 Light-sleep 退化为 Modem-sleep */
+ESP8266_Status_t ESP8266_SetSleepPolicy(ESP8266_SleepMode_t mode) {
+    if (mode > ESP8266_SLEEP_MODEM) return ESP8266_INVALID_PARAM;
+#if ESP8266_WAKE_GPIO_ENABLE
+    if (mode == ESP8266_SLEEP_LIGHT) {
+        GPIO_InitTypeDef gpio = {0};
+        HAL_GPIO_WritePin(ESP8266_WAKE_GPIO_PORT, ESP8266_WAKE_GPIO_PIN,
+                          ESP8266_WAKE_LEVEL ? GPIO_PIN_RESET : GPIO_PIN_SET);
+        gpio.Pin = ESP8266_WAKE_GPIO_PIN;
+        gpio.Mode = GPIO_MODE_OUTPUT_PP;
+        gpio.Pull = GPIO_NOPULL;
+        gpio.Speed = GPIO_SPEED_FREQ_LOW;
+        HAL_GPIO_Init(ESP8266_WAKE_GPIO_PORT, &gpio);
+    }
+#else
+    if (mode == ESP8266_SLEEP_LIGHT) {
+        LOG_W(TAG_ESP8266, "No wake line, light-sleep falls back to modem-sleep");
+        mode = ESP8266_SLEEP_MODEM;
+    }
+#endif
+    /* 切换策略前先回到唤醒状态 */
+    if (esp8266.asleep) ESP8266_Wake();
+    esp8266.sleepPolicy = mode;
+    return ESP8266_OK;
+}
+
+/* 进入休眠: 由 ESP8266_SleepPoll 在本轮发布结束、应答都已收到后调用; Modem-sleep 只进入一次 */
+ESP8266_Status_t ESP8266_Sleep(void) {
+    ESP8266_Status_t status;
+    if (esp8266.sleepPolicy == ESP8266_SLEEP_NONE) return ESP8266_OK;
+    if (esp8266.asleep) return ESP8266_OK;
+    
+    if (esp8266.sleepPolicy == ESP8266_SLEEP_LIGHT && !esp8266.wakeGpioReady) {
+        status = ESP8266_SendCommandF("OK", ESP8266_DEFAULT_TIMEOUT, "AT+WAKEUPGPIO=1,%d,%d\r\n",
+                                      ESP8266_WAKE_ESP_GPIO, ESP8266_WAKE_LEVEL);
+        if (status != ESP8266_OK) return status;
+        esp8266.wakeGpioReady = 1;
+    }
+    
+    status = ESP8266_SendCommandF("OK", ESP8266_DEFAULT_TIMEOUT, "AT+SLEEP=%d\r\n", esp8266.sleepPolicy);
+    if (status != ESP8266_OK) return status;
+    
+    esp8266.sleepStart = HAL_GetTick();
+    esp8266.sleepCount++;
+    esp8266.asleep = 1;
+#if ESP8266_SLEEP_ALLOW_MCU_STOP
+    if (esp8266.sleepPolicy == ESP8266_SLEEP_LIGHT) Power_ReleaseStop(POWER_HOLD_ESP8266);
+#endif
+    return ESP8266_OK;
+}
+
+/* 拉唤醒线并用 "AT" 探测, 直到模块应答 (不经过 ESP8266_SendCommand, 避免递归唤醒) */
+static ESP8266_Status_t ESP8266_WakeByGpio(void) {
+    ESP8266_Status_t status = ESP8266_TIMEOUT;
+    uint32_t start = HAL_GetTick();
+    
+    HAL_GPIO_WritePin(ESP8266_WAKE_GPIO_PORT, ESP8266_WAKE_GPIO_PIN,
+                      ESP8266_WAKE_LEVEL ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    while (HAL_GetTick() - start < ESP8266_WAKE_TIMEOUT_MS) {
+        ESP8266_ClearBuffer();
+        ESP8266_SendDMA((const uint8_t *)"AT\r\n", 4);
+        if (ESP8266_WaitForResponse("OK", ESP8266_WAKE_PROBE_MS)) {
+            status = ESP8266_OK;
+            break;
+        }
+    }
+    HAL_GPIO_WritePin(ESP8266_WAKE_GPIO_PORT, ESP8266_WAKE_GPIO_PIN,
+                      ESP8266_WAKE_LEVEL ? GPIO_PIN_RESET : GPIO_PIN_SET);
+    return status;
+}
+
+/* 从应答中取 key 之后到下一个引号的内容, 没有时置空串 */
+static void ESP8266_CopyQuoted(const char *key, char *out, uint16_t size) {
+    char *ptr = strstr((char *)esp8266.rxBuffer, key);
+    char *end;
+    int len;
+    
+    out[0] = '\0';
+    if (!ptr) return;
+    ptr += strlen(key);
+    end = strchr(ptr, '"');
+    if (!end) return;
+    len = end - ptr; if (len > size - 1) len = size - 1;
+    memcpy(out, ptr, len); out[len] = '\0';
+}
+
+/* 记录一次入网耗时 (开始发命令到获得IP) */
+static void ESP8266_JoinRecord(ESP8266_JoinPath_t path, uint32_t start, uint8_t ok) {
+    ESP8266_JoinStats_t *stats = &esp8266.joinStats[path];
+    uint32_t ms = HAL_GetTick() - start;
+    
+    if (!ok) {
+        stats->fail++;
+        return;
+    }
+    stats->count++;
+    stats->lastMs = ms;
+    stats->totalMs += ms;
+    if (ms > stats->maxMs) stats->maxMs = ms;
+    esp8266.lastJoinPath = (uint8_t)path;
+    esp8266.lastJoinMs = ms;
+    LOG_I(TAG_ESP8266, "WiFi joined (%s) in %lu ms", esp8266JoinPathNames[path], (unsigned long)ms);
+}
+
+/* 用 "AT" 探测直到模块应答 (启动期间的输入被忽略), 不计入命令统计 */
+static ESP8266_Status_t ESP8266_WaitReady(void) {
+    uint32_t start = HAL_GetTick();
+    
+    do {
+        ESP8266_ClearBuffer();
+        ESP8266_SendDMA((const uint8_t *)"AT\r\n", 4);
+        if (ESP8266_WaitForResponse("OK", ESP8266_READY_PROBE_MS)) {
+            esp8266.lastActivity = HAL_GetTick();
+            return ESP8266_OK;
+        }
+    } while (HAL_GetTick() - start < ESP8266_READY_TIMEOUT_MS);
+    return ESP8266_TIMEOUT;
+}
+
+/* 唤醒模块, 唤醒到收到第一段应答的延时计入 "WAKE" 统计项 */
+ESP8266_Status_t ESP8266_Wake(void) {
+    ESP8266_Status_t status;
+    uint32_t start;
+    if (!esp8266.asleep) return ESP8266_OK;
+    
+    start = HAL_GetTick();
+    ESP8266_SleepEnd();
+    
+    if (esp8266.sleepPolicy == ESP8266_SLEEP_LIGHT) status = ESP8266_WakeByGpio();
+    else status = ESP8266_SendCommand("AT+SLEEP=0\r\n", "OK", ESP8266_DEFAULT_TIMEOUT);
+    
+    /* rxTick 在IDLE中断中记录, 对 "OK" 这样的短应答与首字节相差不到1ms */
+    ESP8266_StatsRecord("WAKE", status, status == ESP8266_OK ? esp8266.rxTick - start : ESP8266_STATS_NO_LATENCY);
+    esp8266.lastActivity = HAL_GetTick();
+    return status;
+}
+
+/* 累计本次休眠时间并回到唤醒状态 (模块复位后 AT+SLEEP 设置失效, 同样走这里) */
+static void ESP8266_SleepEnd(void) {
+    if (!esp8266.asleep) return;
+    esp8266.sleepMs += HAL_GetTick() - esp8266.sleepStart;
+    esp8266.asleep = 0;
+    Power_HoldStop(POWER_HOLD_ESP8266);
+}
+
+/* Light-sleep 距最长休眠到期的时间, SleepPoll 与 SleepTimeToNext 共用 */
+static uint32_t ESP8266_LightSleepLeft(uint32_t now) {
+    uint32_t elapsed = now - esp8266.sleepStart;
+    return elapsed >= ESP8266_SLEEP_MAX_MS ? 0 : ESP8266_SLEEP_MAX_MS - elapsed;
+}
+
+/* 主循环在本轮发布结束后调用: 没有未完成的发送/应答/订阅消息时立即进入休眠 */
+void ESP8266_SleepPoll(void) {
+    uint32_t now = HAL_GetTick();
+    
+    if (!esp8266.initialized || esp8266.sleepPolicy == ESP8266_SLEEP_NONE) return;
+    
+    if (esp8266.asleep) {
+        /* Light-sleep 下模块的定时器不走, 定期唤醒一次让它补发MQTT心跳 */
+        if (esp8266.sleepPolicy == ESP8266_SLEEP_LIGHT && ESP8266_LightSleepLeft(now) == 0) {
+            ESP8266_Wake();
+        } else if (esp8266.sleepPolicy == ESP8266_SLEEP_MODEM) {
+            /* Modem-sleep 不再唤醒, 休眠时间在这里逐轮累计 */
+            esp8266.sleepMs += now - esp8266.sleepStart;
+            esp8266.sleepStart = now;
+        }
+        return;
+    }
+    
+    if (esp8266.txBusy || mqtt.msgPending || mqtt.ackPending) return;
+    ESP8266_Sleep();
+}
+
+/* 距 ESP8266_SleepPoll 下一次需要动作的时间, 供主循环计算空闲时长 */
+uint32_t ESP8266_SleepTimeToNext(void) {
+    if (!esp8266.initialized || esp8266.sleepPolicy == ESP8266_SLEEP_NONE) return UINT32_MAX;
+    
+    if (esp8266.asleep) {
+        if (esp8266.sleepPolicy != ESP8266_SLEEP_LIGHT) return UINT32_MAX;
+        return ESP8266_LightSleepLeft(HAL_GetTick());
+    }
+    /* 醒着时没有定时: 发送完成、发布应答和订阅消息都由中断唤醒主循环, 本轮结束时再判断;
+     * AT+SLEEP 失败时也等下一轮重试, 不空转 */
+    return UINT32_MAX;
+}
+
+/* 与休眠策略匹配的MQTT心跳(秒): Light-sleep 按最长休眠时间的2倍, 保证每个心跳周期至少唤醒一次 */
+uint16_t ESP8266_SleepKeepAlive(uint16_t defaultKeepAlive) {
+    switch (esp8266.sleepPolicy) {
+    case ESP8266_SLEEP_LIGHT: return (uint16_t)(2 * ESP8266_SLEEP_MAX_MS / 1000);
+    case ESP8266_SLEEP_MODEM: return ESP8266_SLEEP_MODEM_KEEPALIVE;
+    default: return defaultKeepAlive;
     }
 }
 
@@ -25,9 +25,19 @@
   */
 
 #include "esp8266_mqtt.h"
+#include "mem_region.h"
+#include "prof.h"
+#include "metrics.h"
+#include "ctrl_latency.h"
+#include "scratch.h"
 
 /* Private variables ---------------------------------------------------------*/
-MQTT_Handle_t mqtt;
+MQTT_Handle_t mqtt CCM_BSS;
+
+/* 健康指标 (直接读取句柄中的计数) */
+static Metric_t mqttPubMetric = METRIC_SOURCE_INIT("mqtt.pub", METRIC_COUNTER, &mqtt.publishCount);
+static Metric_t mqttRecvMetric = METRIC_SOURCE_INIT("mqtt.recv", METRIC_COUNTER, &mqtt.receiveCount);
+static Metric_t mqttReconnMetric = METRIC_SOURCE_INIT("mqtt.reconn", METRIC_COUNTER, &mqtt.reconnectCount);
 
 /* Private function prototypes -----------------------------------------------*/
 static void MQTT_Delay(uint32_t ms);
@@ -39,19 +49,21 @@ static void MQTT_RemoveSubscription(const char *topic);
 void MQTT_DebugPrint(const char *format, ...)
 {
 #if MQTT_DEBUG_ENABLE
-    char buf[256];
+    static LOG_Tag_t *logTag;
     va_list args;
+    
+    /* 先判断标签级别, 关闭时不做格式化 */
+    if (!LOG_TagEnabled(&logTag, "MQTT", LOG_LEVEL_DEBUG)) return;
+    
     va_start(args, format);
-    vsnprintf(buf, sizeof(buf), format, args);
+    LOG_VRaw(format, args);
     va_end(args);
-    /* 使用LOG_Raw以兼容原有格式 */
-    LOG_Raw("%s", buf);
 #endif
 }
 
 static void MQTT_Delay(uint32_t ms) 
 { 
-    HAL_Delay(ms); 
+    ESP8266_Delay(ms);  /* 计入等待时间 */
 }
 
 /**
@@ -81,6 +93,10 @@ MQTT_Status_t MQTT_Init(void)
     mqtt.state = MQTT_STATE_NOT_INIT;
     mqtt.initialized = 1;
     
+    Metrics_Register(&mqttPubMetric);
+    Metrics_Register(&mqttRecvMetric);
+    Metrics_Register(&mqttReconnMetric);
+    
     MQTT_DebugPrint("[MQTT] Init OK\r\n");
     return MQTT_OK;
 }
@@ -246,7 +262,7 @@ MQTT_Status_t MQTT_SetLWT(const char *topic, const char *message,
     if (!topic || !message) return MQTT_INVALID_PARAM;
     
     strncpy(mqtt.connConfig.lwtTopic, topic, MQTT_TOPIC_MAX_LEN - 1);
-    strncpy(mqtt.connConfig.lwtMessage, message, MQTT_MESSAGE_MAX_LEN - 1);
+    strncpy(mqtt.connConfig.lwtMessage, message, MQTT_LWT_MSG_MAX_LEN - 1);
     mqtt.connConfig.lwtQos = qos;
     mqtt.connConfig.lwtRetain = retain ? 1 : 0;
     
@@ -578,6 +594,7 @@ MQTT_Status_t MQTT_Publish(const char *topic, const char *message,
     if (!topic || !message) return MQTT_INVALID_PARAM;
     
     uint16_t len = strlen(message);
+    PROF_BEGIN(MQTT_PUB);
     
     MQTT_DebugPrint("[MQTT] Publishing to %s (%d bytes): %s\r\n", topic, len, message);
     
@@ -588,36 +605,49 @@ MQTT_Status_t MQTT_Publish(const char *topic, const char *message,
     
     if (ret != ESP8266_OK) {
         MQTT_DebugPrint("[MQTT] PUBRAW prepare failed!\r\n");
+        PROF_END(MQTT_PUB);
         return MQTT_PUBLISH_FAIL;
     }
     
-    /* 发送实际数据 */
+    /* 发送实际数据, 应答到达前模块不休眠 */
     ESP8266_ClearBuffer();
+    mqtt.ackPending = 1;
     ret = ESP8266_SendDMA((uint8_t *)message, len);
     if (ret != ESP8266_OK) {
+        mqtt.ackPending = 0;
         MQTT_DebugPrint("[MQTT] Data send failed!\r\n");
+        PROF_END(MQTT_PUB);
         return MQTT_PUBLISH_FAIL;
     }
+    uint32_t txDone = esp8266.txDoneTick;
     
     /* 等待发送完成 - 检查多种可能的响应 */
     uint32_t startTick = HAL_GetTick();
     while (HAL_GetTick() - startTick < MQTT_PUBLISH_TIMEOUT) {
         if (ESP8266_ContainsString("+MQTTPUB:OK") || 
             ESP8266_ContainsString("OK")) {
+            mqtt.ackPending = 0;
             mqtt.publishCount++;
+            ESP8266_StatsRecord("MQTTPUBRAW.data", ESP8266_OK, ESP8266_GetResponseLatency(txDone));
             MQTT_DebugPrint("[MQTT] Publish OK\r\n");
             if (mqtt.onPublishComplete) mqtt.onPublishComplete(topic);
+            PROF_END(MQTT_PUB);
             return MQTT_OK;
         }
         if (ESP8266_ContainsString("ERROR") || 
             ESP8266_ContainsString("FAIL")) {
+            mqtt.ackPending = 0;
+            ESP8266_StatsRecord("MQTTPUBRAW.data", ESP8266_ERROR, ESP8266_GetResponseLatency(txDone));
             MQTT_DebugPrint("[MQTT] Publish failed!\r\n");
+            PROF_END(MQTT_PUB);
             return MQTT_PUBLISH_FAIL;
         }
-        HAL_Delay(10);
+        ESP8266_Delay(10);
     }
     
+    ESP8266_StatsRecord("MQTTPUBRAW.data", ESP8266_TIMEOUT, 0);
     MQTT_DebugPrint("[MQTT] Publish timeout!\r\n");
+    PROF_END(MQTT_PUB);
     return MQTT_TIMEOUT;
 }
 
@@ -639,10 +669,17 @@ MQTT_Status_t MQTT_PublishData(const char *topic, const uint8_t *data,
     
     /* 对于短数据,转换为字符串发送 */
     if (len < MQTT_MESSAGE_MAX_LEN) {
-        char msgBuf[MQTT_MESSAGE_MAX_LEN];
-        memcpy(msgBuf, data, len);
-        msgBuf[len] = '\0';
-        return MQTT_Publish(topic, msgBuf, qos, retain);
+        Scratch_Mark_t mark = Scratch_Mark();
+        char *msgBuf = Scratch_Alloc(len + 1);
+        if (msgBuf) {
+            MQTT_Status_t ret;
+            memcpy(msgBuf, data, len);
+            msgBuf[len] = '\0';
+            ret = MQTT_Publish(topic, msgBuf, qos, retain);
+            Scratch_Release(mark);
+            return ret;
+        }
+        /* 共享区不足时直接按原始数据发送 */
     }
     
     /* 长数据使用MQTTPUBRAW */
@@ -677,19 +714,27 @@ MQTT_Status_t MQTT_PublishRaw(const char *topic, const uint8_t *data,
         return MQTT_PUBLISH_FAIL;
     }
     
-    /* 发送数据 */
+    /* 发送数据, 应答到达前模块不休眠 */
     ESP8266_ClearBuffer();
+    mqtt.ackPending = 1;
     ret = ESP8266_SendDMA(data, len);
     if (ret != ESP8266_OK) {
+        mqtt.ackPending = 0;
         return MQTT_PUBLISH_FAIL;
     }
+    uint32_t txDone = esp8266.txDoneTick;
     
     /* 等待发送完成 */
     if (!ESP8266_WaitForResponse("+MQTTPUB:OK", MQTT_PUBLISH_TIMEOUT)) {
+        if (ESP8266_ContainsString("FAIL")) mqtt.ackPending = 0;
+        ESP8266_StatsRecord("MQTTPUBRAW.data", ESP8266_ContainsString("FAIL") ? ESP8266_ERROR : ESP8266_TIMEOUT,
+                            ESP8266_GetResponseLatency(txDone));
         MQTT_DebugPrint("[MQTT] PUBRAW failed!\r\n");
         return MQTT_PUBLISH_FAIL;
     }
     
+    ESP8266_StatsRecord("MQTTPUBRAW.data", ESP8266_OK, ESP8266_GetResponseLatency(txDone));
+    mqtt.ackPending = 0;
     mqtt.publishCount++;
     MQTT_DebugPrint("[MQTT] PUBRAW OK\r\n");
     if (mqtt.onPublishComplete) mqtt.onPublishComplete(topic);
@@ -708,13 +753,19 @@ MQTT_Status_t MQTT_PublishRaw(const char *topic, const uint8_t *data,
 MQTT_Status_t MQTT_PublishF(const char *topic, MQTT_QoS_t qos, 
                              uint8_t retain, const char *format, ...)
 {
-    char buf[MQTT_MESSAGE_MAX_LEN];
+    Scratch_Mark_t mark = Scratch_Mark();
+    char *buf = Scratch_Alloc(MQTT_MESSAGE_MAX_LEN);
+    MQTT_Status_t ret;
     va_list args;
+    
+    if (!buf) return MQTT_ERROR;
     va_start(args, format);
-    vsnprintf(buf, sizeof(buf), format, args);
+    vsnprintf(buf, MQTT_MESSAGE_MAX_LEN, format, args);
     va_end(args);
     
-    return MQTT_Publish(topic, buf, qos, retain);
+    ret = MQTT_Publish(topic, buf, qos, retain);
+    Scratch_Release(mark);
+    return ret;
 }
 
 /**
@@ -838,20 +889,24 @@ static MQTT_Status_t MQTT_ParseSubMessage(const char *data)
 {
     /* 解析 +MQTTSUBRECV:<LinkID>,"<topic>",<data_length>,<data> */
     if (!data) return MQTT_ERROR;
+    PROF_BEGIN(MQTT_PARSE);
     
     MQTT_DebugPrint("[MQTT] Parsing SUBRECV message...\r\n");
     
     char *ptr = strstr(data, "+MQTTSUBRECV:");
-    if (!ptr) return MQTT_ERROR;
+    if (!ptr) { PROF_END(MQTT_PARSE); return MQTT_ERROR; }
     
     ptr += 13;  /* 跳过 "+MQTTSUBRECV:" */
     
-    MQTT_Message_t msg;
-    memset(&msg, 0, sizeof(MQTT_Message_t));
+    /* 消息放在共享区, 回调返回后释放 */
+    Scratch_Mark_t mark = Scratch_Mark();
+    MQTT_Message_t *msg = Scratch_Alloc(sizeof(MQTT_Message_t));
+    if (!msg) { PROF_END(MQTT_PARSE); return MQTT_ERROR; }
+    memset(msg, 0, sizeof(MQTT_Message_t));
     
     /* 跳过LinkID和逗号 */
     ptr = strchr(ptr, ',');
-    if (!ptr) return MQTT_ERROR;
+    if (!ptr) { Scratch_Release(mark); PROF_END(MQTT_PARSE); return MQTT_ERROR; }
     ptr++;
     
     /* 提取主题 */
@@ -861,44 +916,74 @@ static MQTT_Status_t MQTT_ParseSubMessage(const char *data)
         if (end) {
             int len = end - ptr;
             if (len >= MQTT_TOPIC_MAX_LEN) len = MQTT_TOPIC_MAX_LEN - 1;
-            strncpy(msg.topic, ptr, len);
+            strncpy(msg->topic, ptr, len);
             ptr = end + 1;
         }
     }
     
     /* 跳过逗号,获取长度 */
     ptr = strchr(ptr, ',');
-    if (!ptr) return MQTT_ERROR;
+    if (!ptr) { Scratch_Release(mark); PROF_END(MQTT_PARSE); return MQTT_ERROR; }
     ptr++;
     
-    msg.dataLen = atoi(ptr);
+    msg->dataLen = atoi(ptr);
     
     /* 跳到数据部分 */
     ptr = strchr(ptr, ',');
-    if (!ptr) return MQTT_ERROR;
+    if (!ptr) { Scratch_Release(mark); PROF_END(MQTT_PARSE); return MQTT_ERROR; }
     ptr++;
     
     /* 复制数据 */
-    uint16_t copyLen = msg.dataLen;
+    uint16_t copyLen = msg->dataLen;
     if (copyLen >= MQTT_MESSAGE_MAX_LEN) copyLen = MQTT_MESSAGE_MAX_LEN - 1;
-    memcpy(msg.data, ptr, copyLen);
-    msg.data[copyLen] = '\0';
+    if (data == (const char *)mqtt.msgBuffer && copyLen > mqtt.msgLen - (uint16_t)(ptr - data)) {
+        copyLen = mqtt.msgLen - (uint16_t)(ptr - data);     /* URC被截断时只复制收到的部分 */
+    }
+    memcpy(msg->data, ptr, copyLen);
+    msg->data[copyLen] = '\0';
     
     MQTT_DebugPrint("[MQTT] Received: topic=%s, len=%d, data=%s\r\n", 
-                    msg.topic, msg.dataLen, msg.data);
+                    msg->topic, msg->dataLen, msg->data);
+    
+    /* 解析耗时, 不含应用回调 */
+    PROF_END(MQTT_PARSE);
     
     /* 调用回调 */
     mqtt.receiveCount++;
     if (mqtt.onMessageReceived) {
         MQTT_DebugPrint("[MQTT] Calling onMessageReceived callback\r\n");
-        mqtt.onMessageReceived(&msg);
+        CTRL_LAT_STAMP(DISPATCH);
+        mqtt.onMessageReceived(msg);
     } else {
         MQTT_DebugPrint("[MQTT] WARNING: onMessageReceived callback is NULL!\r\n");
     }
     
+    Scratch_Release(mark);
     return MQTT_OK;
 }
 
+/**
+  * @brief  分发中断中暂存的订阅消息 (主循环每轮调用, 不等MQTT处理周期)
+  * @retval uint8_t 1=分发了一条消息
+  */
+uint8_t MQTT_ProcessPending(void)
+{
+    if (!mqtt.initialized || !mqtt.msgPending) return 0;
+    
+    mqtt.msgPending = 0;  /* 清除标志 */
+    CTRL_LAT_STAMP(QUEUE);
+    MQTT_ParseSubMessage((char *)mqtt.msgBuffer);
+    return 1;
+}
+
+/**
+  * @brief  是否有待分发的订阅消息 (主循环据此决定能否进入空闲)
+  */
+uint8_t MQTT_HasPending(void)
+{
+    return mqtt.initialized && mqtt.msgPending;
+}
+
 /**
   * @brief  处理MQTT数据 (在主循环中调用)
   */
@@ -907,16 +992,14 @@ void MQTT_ProcessData(void)
     if (!mqtt.initialized) return;
     
     /* 优先处理异步接收到的订阅消息 */
-    if (mqtt.msgPending) {
-        mqtt.msgPending = 0;  /* 清除标志 */
-        MQTT_ParseSubMessage((char *)mqtt.msgBuffer);
-    }
+    MQTT_ProcessPending();
     
     char *respBuf = ESP8266_GetResponseBuffer();
     
     /* 检查连接状态变化 */
     if (strstr(respBuf, "+MQTTDISCONNECTED:")) {
         mqtt.connected = 0;
+        mqtt.ackPending = 0;  /* 连接已断, 不会再有应答 */
         mqtt.state = MQTT_STATE_DISCONNECTED;
         MQTT_DebugPrint("[MQTT] Disconnected event\r\n");
         if (mqtt.onDisconnected) mqtt.onDisconnected();
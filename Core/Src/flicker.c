@@ -0,0 +1,490 @@
+/**
+  ******************************************************************************
+  * @file           : flicker.c
+  * @brief          : 光照闪烁(频闪)分析模块源文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 指标定义 (IES RP-16):
+  *   闪烁百分比 Percent Flicker = 100 * (Max - Min) / (Max + Min)
+  *   闪烁指数   Flicker Index   = 平均值以上部分面积 / 总面积
+  *
+  * 光敏传感器特性为"亮时ADC值小", 计算前先反转为 ADC_MAX - raw,
+  * 与 main.c 中上报的 light 值保持一致
+  *
+  * TIM2 只用作ADC触发源, 直接操作寄存器配置, 不依赖HAL TIM模块
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "flicker.h"
+#include "mem_region.h"
+#include "light_sensor.h"
+#include "power.h"
+#include "scratch.h"
+#include "arm_math.h"
+#include <stdio.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+/* 采集所用ADC通道 (PF7 -> ADC3_IN5, 与MX_ADC3_Init一致) */
+#define FLICKER_ADC_CHANNEL             ADC_CHANNEL_5
+
+/* 高速采集时的ADC采样时间 (ADCCLK=21MHz, 112+12周期约6us) */
+#define FLICKER_ADC_SAMPLETIME          ADC_SAMPLETIME_112CYCLES
+
+/* Private variables ---------------------------------------------------------*/
+
+/* 闪烁分析句柄实例 */
+Flicker_Handle_t flicker = {0};
+
+/* DMA采集缓冲区 */
+static uint16_t flickerSamples[FLICKER_MAX_BLOCK_SIZE] DMA_BUFFER;
+
+/* RFFT实例 */
+static arm_rfft_fast_instance_f32 fftInstance CCM_BSS;
+
+/* 采集前的ADC配置 (采集结束后恢复) */
+static ADC_InitTypeDef adcSavedInit;
+
+/* Private function prototypes -----------------------------------------------*/
+static void Flicker_CycleCounterInit(void);
+static uint32_t Flicker_GetTimerClock(void);
+static void Flicker_TimerStart(uint16_t sampleRate);
+static void Flicker_TimerStop(void);
+static HAL_StatusTypeDef Flicker_ConfigADC(uint8_t timerTrigger);
+static void Flicker_StopCapture(void);
+static void Flicker_SpectrumInPlace(float32_t *buf, uint16_t n);
+static uint8_t Flicker_Analyze(Flicker_Result_t *result);
+static void Flicker_DebugPrint(const char *format, ...);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  使能DWT周期计数器 (用于测量FFT耗时)
+  */
+static void Flicker_CycleCounterInit(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+  * @brief  获取TIM2计数时钟频率
+  * @note   APB1分频不为1时, 定时器时钟为PCLK1的2倍
+  * @retval 定时器时钟 (Hz)
+  */
+static uint32_t Flicker_GetTimerClock(void)
+{
+    uint32_t pclk1 = HAL_RCC_GetPCLK1Freq();
+
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1) {
+        return pclk1 * 2;
+    }
+    return pclk1;
+}
+
+/**
+  * @brief  启动TIM2, 以更新事件作为TRGO输出
+  * @param  sampleRate: 采样率 (Hz)
+  */
+static void Flicker_TimerStart(uint16_t sampleRate)
+{
+    __HAL_RCC_TIM2_CLK_ENABLE();
+
+    TIM2->CR1 = 0;
+    TIM2->PSC = 0;
+    TIM2->ARR = Flicker_GetTimerClock() / sampleRate - 1;
+    TIM2->CR2 = (TIM2->CR2 & ~TIM_CR2_MMS) | TIM_CR2_MMS_1;    /* MMS=010: Update -> TRGO */
+    TIM2->EGR = TIM_EGR_UG;                                     /* 装载PSC/ARR */
+    TIM2->SR = 0;
+    TIM2->CR1 = TIM_CR1_CEN;
+}
+
+/**
+  * @brief  停止TIM2
+  */
+static void Flicker_TimerStop(void)
+{
+    TIM2->CR1 &= ~TIM_CR1_CEN;
+}
+
+/**
+  * @brief  切换ADC触发方式
+  * @param  timerTrigger: 1=TIM2 TRGO触发 0=恢复采集前的配置
+  * @retval HAL_StatusTypeDef
+  */
+static HAL_StatusTypeDef Flicker_ConfigADC(uint8_t timerTrigger)
+{
+    ADC_ChannelConfTypeDef sConfig = {0};
+
+    sConfig.Channel = FLICKER_ADC_CHANNEL;
+    sConfig.Rank = 1;
+
+    if (timerTrigger) {
+        adcSavedInit = flicker.hadc->Init;
+
+        flicker.hadc->Init.ScanConvMode = DISABLE;
+        flicker.hadc->Init.ContinuousConvMode = DISABLE;
+        flicker.hadc->Init.NbrOfConversion = 1;
+        flicker.hadc->Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
+        flicker.hadc->Init.ExternalTrigConv = ADC_EXTERNALTRIGCONV_T2_TRGO;
+        flicker.hadc->Init.DMAContinuousRequests = ENABLE;
+        sConfig.SamplingTime = FLICKER_ADC_SAMPLETIME;
+    } else {
+        flicker.hadc->Init = adcSavedInit;
+        sConfig.SamplingTime = ADC_SAMPLETIME_480CYCLES;
+    }
+
+    if (HAL_ADC_Init(flicker.hadc) != HAL_OK) {
+        return HAL_ERROR;
+    }
+    return HAL_ADC_ConfigChannel(flicker.hadc, &sConfig);
+}
+
+/**
+  * @brief  停止采集 (定时器/ADC/DMA)
+  */
+static void Flicker_StopCapture(void)
+{
+    Flicker_TimerStop();
+    HAL_ADC_Stop_DMA(flicker.hadc);
+    Power_ReleaseStop(POWER_HOLD_FLICKER);
+}
+
+/**
+  * @brief  原地计算实数序列的幅值谱
+  * @note   arm_rfft_fast_f32 需要独立的输出缓冲区, 工作区为 8字节/点。这里拆成
+  *         同样的两步: n/2点复数FFT (arm_cfft_f32 原地) + 拆分, 拆分时成对处理
+  *         k 与 n/2-k 两个频点, 只读写这两个位置, 直接把幅值写回原处, 工作区
+  *         减为 4字节/点。公式与 CMSIS 的 stage_rfft_f32 相同
+  * @param  buf: n 个实数采样, 返回时 buf[0..n/2-1] 为幅值谱 (buf[0] 置0)
+  * @param  n: 点数, 与 fftInstance 初始化时一致
+  */
+static void Flicker_SpectrumInPlace(float32_t *buf, uint16_t n)
+{
+    uint16_t half = n / 2;
+    const float32_t *tw = fftInstance.pTwiddleRFFT;
+
+    arm_cfft_f32(&fftInstance.Sint, buf, 0, 1);
+
+    /* bin0为DC/Nyquist, 不参与峰值搜索 */
+    buf[0] = 0.0f;
+
+    for (uint16_t k = 1; k <= half / 2; k++) {
+        uint16_t j = half - k;
+        float32_t aR = buf[2 * k], aI = buf[2 * k + 1];
+        float32_t bR = buf[2 * j], bI = buf[2 * j + 1];
+        float32_t t1a = bR - aR;
+        float32_t t1b = bI + aI;
+        float32_t re, im, mag;
+
+        /* X[k] = 1/2 * (A + B* + TW[k] * (B* - A)), A=Z[k], B=Z[half-k] */
+        re = 0.5f * (aR + bR + tw[2 * k] * t1a + tw[2 * k + 1] * t1b);
+        im = 0.5f * (aI - bI + tw[2 * k + 1] * t1a - tw[2 * k] * t1b);
+        arm_sqrt_f32(re * re + im * im, &mag);
+        buf[2 * k] = mag;
+
+        if (j != k) {
+            /* X[half-k]: A、B 互换, 差值取反 */
+            re = 0.5f * (bR + aR - tw[2 * j] * t1a + tw[2 * j + 1] * t1b);
+            im = 0.5f * (bI - aI - tw[2 * j + 1] * t1a - tw[2 * j] * t1b);
+            arm_sqrt_f32(re * re + im * im, &mag);
+            buf[2 * j] = mag;
+        }
+    }
+
+    /* 幅值在偶数位置, 压缩到 buf[0..half-1] */
+    for (uint16_t k = 1; k < half; k++) {
+        buf[k] = buf[2 * k];
+    }
+}
+
+/**
+  * @brief  计算闪烁指标
+  * @param  result: 结果输出指针
+  * @retval uint8_t 1=完成 0=共享区不足
+  */
+static uint8_t Flicker_Analyze(Flicker_Result_t *result)
+{
+    uint16_t n = flicker.blockSize;
+    uint16_t bins = n / 2;
+    float32_t sum = 0.0f;
+    float32_t mean;
+    float32_t aboveArea = 0.0f;
+    uint16_t minVal = 0xFFFF;
+    uint16_t maxVal = 0;
+
+    /* FFT工作区在共享区 (原地变换, 变换后为幅值谱) */
+    Scratch_Mark_t mark = Scratch_Mark();
+    float32_t *fftInput = Scratch_Alloc(n * sizeof(float32_t));
+    if (fftInput == NULL) {
+        Scratch_Release(mark);
+        return 0;
+    }
+
+    /* 第1步: 反转为光强并统计最值/均值 */
+    for (uint16_t i = 0; i < n; i++) {
+        uint16_t x = LIGHT_SENSOR_ADC_MAX - (flickerSamples[i] & LIGHT_SENSOR_ADC_MAX);
+        if (x < minVal) minVal = x;
+        if (x > maxVal) maxVal = x;
+        fftInput[i] = (float32_t)x;
+        sum += fftInput[i];
+    }
+    mean = sum / n;
+
+    /* 第2步: 闪烁百分比与闪烁指数 (时域) */
+    for (uint16_t i = 0; i < n; i++) {
+        if (fftInput[i] > mean) {
+            aboveArea += fftInput[i] - mean;
+        }
+    }
+
+    result->mean = mean;
+    result->min = minVal;
+    result->max = maxVal;
+    result->percent = (maxVal + minVal) > 0 ?
+                      100.0f * (float32_t)(maxVal - minVal) / (float32_t)(maxVal + minVal) : 0.0f;
+    result->index = sum > 0.0f ? aboveArea / sum : 0.0f;
+
+    /* 第3步: 去直流后做实数FFT, 测量耗时 */
+    arm_offset_f32(fftInput, -mean, fftInput, n);
+
+    uint32_t startCycles = DWT->CYCCNT;
+    Flicker_SpectrumInPlace(fftInput, n);
+    result->fftCycles = DWT->CYCCNT - startCycles;
+
+    /* 第4步: 在 [FLICKER_MIN_FREQ_HZ, fs/2) 内搜索主峰 */
+    uint32_t startBin = ((uint32_t)FLICKER_MIN_FREQ_HZ * n + flicker.sampleRate - 1) / flicker.sampleRate;
+    if (startBin < 1) startBin = 1;
+    if (startBin >= bins - 1) startBin = bins - 2;
+
+    float32_t peak;
+    uint32_t peakIndex;
+    arm_max_f32(&fftInput[startBin], bins - startBin, &peak, &peakIndex);
+    peakIndex += startBin;
+
+    /* 抛物线插值细化峰值位置 */
+    float32_t delta = 0.0f;
+    if (peakIndex > startBin && peakIndex < bins - 1) {
+        float32_t a = fftInput[peakIndex - 1];
+        float32_t b = fftInput[peakIndex];
+        float32_t c = fftInput[peakIndex + 1];
+        float32_t denom = a - 2.0f * b + c;
+        if (denom != 0.0f) {
+            delta = 0.5f * (a - c) / denom;
+        }
+    }
+
+    result->frequency = ((float32_t)peakIndex + delta) * flicker.sampleRate / n;
+    result->sampleRate = flicker.sampleRate;
+    result->blockSize = n;
+    result->timestamp = HAL_GetTick();
+
+    Scratch_Release(mark);
+    return 1;
+}
+
+/**
+  * @brief  调试打印函数 - 使用统一日志库
+  */
+static void Flicker_DebugPrint(const char *format, ...)
+{
+#if FLICKER_DEBUG_ENABLE
+    static LOG_Tag_t *logTag;
+    va_list args;
+    
+    /* 先判断标签级别, 关闭时不做格式化 */
+    if (!LOG_TagEnabled(&logTag, "FLICKER", LOG_LEVEL_DEBUG)) return;
+    
+    va_start(args, format);
+    LOG_VRaw(format, args);
+    va_end(args);
+#else
+    (void)format;
+#endif
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  初始化闪烁分析模块
+  */
+Flicker_Status_t Flicker_Init(void)
+{
+    flicker.hadc = &hadc3;
+    flicker.state = FLICKER_STATE_IDLE;
+    flicker.resultValid = 0;
+
+    Flicker_CycleCounterInit();
+
+    flicker.initialized = 1;
+
+    return Flicker_Config(FLICKER_DEFAULT_SAMPLE_RATE_HZ, FLICKER_DEFAULT_BLOCK_SIZE);
+}
+
+/**
+  * @brief  配置采样参数
+  */
+Flicker_Status_t Flicker_Config(uint16_t sampleRate, uint16_t blockSize)
+{
+    if (!flicker.initialized) return FLICKER_ERROR;
+    if (flicker.state != FLICKER_STATE_IDLE) return FLICKER_BUSY;
+
+    if (sampleRate < FLICKER_MIN_SAMPLE_RATE_HZ || sampleRate > FLICKER_MAX_SAMPLE_RATE_HZ) {
+        return FLICKER_INVALID_PARAM;
+    }
+
+    /* FFT点数必须为2的幂 */
+    if (blockSize < FLICKER_MIN_BLOCK_SIZE || blockSize > FLICKER_MAX_BLOCK_SIZE ||
+        (blockSize & (blockSize - 1)) != 0) {
+        return FLICKER_INVALID_PARAM;
+    }
+
+    if (arm_rfft_fast_init_f32(&fftInstance, blockSize) != ARM_MATH_SUCCESS) {
+        return FLICKER_INVALID_PARAM;
+    }
+
+    flicker.sampleRate = sampleRate;
+    flicker.blockSize = blockSize;
+
+    Flicker_DebugPrint("[Flicker] fs=%d Hz, N=%d\r\n", sampleRate, blockSize);
+    return FLICKER_OK;
+}
+
+/**
+  * @brief  启动一次高速采集
+  */
+Flicker_Status_t Flicker_StartCapture(void)
+{
+    if (!flicker.initialized) return FLICKER_ERROR;
+    if (flicker.state != FLICKER_STATE_IDLE) return FLICKER_BUSY;
+
+    /* 占用ADC3, 期间光敏传感器轮询读取返回BUSY */
+    lightSensor.dma_running = 1;
+
+    if (Flicker_ConfigADC(1) != HAL_OK) {
+        Flicker_ConfigADC(0);
+        lightSensor.dma_running = 0;
+        return FLICKER_ERROR;
+    }
+
+    flicker.state = FLICKER_STATE_CAPTURING;
+    flicker.captureStart = HAL_GetTick();
+
+    /* TIM2/ADC3在STOP下停止, 采集期间只允许Sleep */
+    Power_HoldStop(POWER_HOLD_FLICKER);
+
+    if (HAL_ADC_Start_DMA(flicker.hadc, (uint32_t *)flickerSamples, flicker.blockSize) != HAL_OK) {
+        Power_ReleaseStop(POWER_HOLD_FLICKER);
+        flicker.state = FLICKER_STATE_IDLE;
+        Flicker_ConfigADC(0);
+        lightSensor.dma_running = 0;
+        return FLICKER_ERROR;
+    }
+
+    /* 最后启动定时器, 第一个TRGO开始转换 */
+    Flicker_TimerStart(flicker.sampleRate);
+
+    Flicker_DebugPrint("[Flicker] Capture started\r\n");
+    return FLICKER_OK;
+}
+
+/**
+  * @brief  处理采集结果
+  */
+Flicker_Status_t Flicker_Process(Flicker_Result_t *result)
+{
+    if (!flicker.initialized) return FLICKER_ERROR;
+
+    if (flicker.state == FLICKER_STATE_CAPTURING) {
+        if (HAL_GetTick() - flicker.captureStart < FLICKER_CAPTURE_TIMEOUT_MS) {
+            return FLICKER_NOT_READY;
+        }
+
+        /* 采集超时: 停止并恢复ADC */
+        Flicker_StopCapture();
+        Flicker_ConfigADC(0);
+        lightSensor.dma_running = 0;
+        flicker.state = FLICKER_STATE_IDLE;
+        Flicker_DebugPrint("[Flicker] Capture timeout!\r\n");
+        return FLICKER_TIMEOUT;
+    }
+
+    if (flicker.state != FLICKER_STATE_CAPTURED) {
+        return FLICKER_NOT_READY;
+    }
+
+    /* 先归还ADC3, 再做计算 */
+    Flicker_ConfigADC(0);
+    lightSensor.dma_running = 0;
+
+    flicker.state = FLICKER_STATE_IDLE;
+    if (!Flicker_Analyze(&flicker.result)) {
+        Flicker_DebugPrint("[Flicker] No scratch memory for FFT!\r\n");
+        return FLICKER_ERROR;
+    }
+    flicker.resultValid = 1;
+
+    Flicker_DebugPrint("[Flicker] f=%.1f Hz, pct=%.2f%%, idx=%.4f, cycles=%lu\r\n",
+                       flicker.result.frequency, flicker.result.percent,
+                       flicker.result.index, (unsigned long)flicker.result.fftCycles);
+
+    if (result) {
+        *result = flicker.result;
+    }
+    return FLICKER_OK;
+}
+
+/**
+  * @brief  获取最近一次分析结果
+  */
+Flicker_Status_t Flicker_GetResult(Flicker_Result_t *result)
+{
+    if (!result) return FLICKER_INVALID_PARAM;
+    if (!flicker.resultValid) return FLICKER_NOT_READY;
+
+    *result = flicker.result;
+    return FLICKER_OK;
+}
+
+/**
+  * @brief  将分析结果格式化为JSON
+  */
+int Flicker_FormatJson(const Flicker_Result_t *result, char *buf, uint16_t size)
+{
+    if (!result || !buf || size == 0) return 0;
+
+    return snprintf(buf, size,
+        "{\"flk_hz\":%.1f,\"flk_pct\":%.2f,\"flk_idx\":%.4f,\"fs\":%u,\"n\":%u,\"fft_cyc\":%lu}",
+        result->frequency, result->percent, result->index,
+        result->sampleRate, result->blockSize, (unsigned long)result->fftCycles);
+}
+
+/**
+  * @brief  检查是否正在采集
+  */
+uint8_t Flicker_IsBusy(void)
+{
+    return flicker.state != FLICKER_STATE_IDLE;
+}
+
+/**
+  * @brief  ADC转换完成处理
+  */
+void Flicker_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    if (hadc != flicker.hadc || flicker.state != FLICKER_STATE_CAPTURING) return;
+
+    /* DMA为循环模式, 整块采满后立即停止, 避免覆盖 */
+    Flicker_StopCapture();
+    flicker.state = FLICKER_STATE_CAPTURED;
+}
+
+/* HAL回调 - ADC DMA整块转换完成 */
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    Flicker_ADC_ConvCpltCallback(hadc);
+}
@@ -11,11 +11,15 @@
   * 本驱动使用ADC3通道5 (PF7引脚) 采集光敏传感器模拟信号
   * 使用轮询模式读取，简单可靠
   *
+  * ADC以VDDA为参考, VDDA偏离3.3V时同一光照下的读数会漂移;
+  * 每次读取后用片内VREFINT测得的VDDA把读数折算到标称3.3V参考
+  *
   ******************************************************************************
   */
 
 /* Includes ------------------------------------------------------------------*/
 #include "light_sensor.h"
+#include "prof.h"
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
@@ -43,6 +47,8 @@ LightSensor_Status_t LightSensor_Init(void)
     
     /* 初始化状态变量 */
     lightSensor.current_value = 0;
+    lightSensor.raw_value = 0;
+    lightSensor.vdda_mV = LIGHT_SENSOR_VREF_MV;
     lightSensor.filtered_value = 0;
     lightSensor.last_update_tick = 0;
     lightSensor.dma_running = 0;
@@ -67,9 +73,17 @@ LightSensor_Status_t LightSensor_Read(void)
         return LIGHT_SENSOR_NOT_INITIALIZED;
     }
     
+    /* ADC正被DMA高速采集占用 (如频闪分析), 保留上一次的值 */
+    if (lightSensor.dma_running) {
+        return LIGHT_SENSOR_BUSY;
+    }
+    
+    PROF_BEGIN(LIGHT_READ);
+    
     /* 启动ADC转换 */
     status = HAL_ADC_Start(lightSensor.hadc);
     if (status != HAL_OK) {
+        PROF_END(LIGHT_READ);
         return LIGHT_SENSOR_ERROR;
     }
     
@@ -77,16 +91,28 @@ LightSensor_Status_t LightSensor_Read(void)
     status = HAL_ADC_PollForConversion(lightSensor.hadc, 100);
     if (status != HAL_OK) {
         HAL_ADC_Stop(lightSensor.hadc);
+        PROF_END(LIGHT_READ);
         return LIGHT_SENSOR_TIMEOUT;
     }
     
     /* 读取转换结果 */
-    lightSensor.current_value = (uint16_t)HAL_ADC_GetValue(lightSensor.hadc);
+    lightSensor.raw_value = (uint16_t)HAL_ADC_GetValue(lightSensor.hadc);
+    
+#if LIGHT_SENSOR_VDDA_COMPENSATION
+    /* 比例修正: raw * VDDA / 3300, 结果等效于在标称参考电压下的读数 */
+    uint32_t corrected;
+    lightSensor.vdda_mV = ChipSensor_GetVdda_mV();
+    corrected = (uint32_t)lightSensor.raw_value * lightSensor.vdda_mV / LIGHT_SENSOR_VREF_MV;
+    lightSensor.current_value = (corrected > LIGHT_SENSOR_ADC_MAX) ? LIGHT_SENSOR_ADC_MAX : (uint16_t)corrected;
+#else
+    lightSensor.current_value = lightSensor.raw_value;
+#endif
     lightSensor.filtered_value = lightSensor.current_value;
     lightSensor.last_update_tick = HAL_GetTick();
     
     /* 停止ADC */
     HAL_ADC_Stop(lightSensor.hadc);
+    PROF_END(LIGHT_READ);
     
     return LIGHT_SENSOR_OK;
 }
@@ -101,6 +127,14 @@ uint16_t LightSensor_GetValue(void)
     return lightSensor.current_value;
 }
 
+/**
+  * @brief  获取未经VDDA修正的ADC原始值
+  */
+uint16_t LightSensor_GetRawValue(void)
+{
+    return lightSensor.raw_value;
+}
+
 /**
   * @brief  获取光照百分比 (0-100%)
   */
@@ -115,8 +149,9 @@ uint8_t LightSensor_GetPercent(void)
   */
 uint32_t LightSensor_GetVoltage_mV(void)
 {
-    uint16_t adc_value = lightSensor.current_value;
-    return (uint32_t)adc_value * LIGHT_SENSOR_VREF_MV / LIGHT_SENSOR_ADC_MAX;
+    /* 原始值对应实际VDDA, 等价于修正值对应标称参考电压 */
+    uint16_t adc_value = lightSensor.raw_value;
+    return (uint32_t)adc_value * lightSensor.vdda_mV / LIGHT_SENSOR_ADC_MAX;
 }
 
 /**
@@ -174,15 +209,15 @@ uint8_t LightSensor_IsInitialized(void)
 void LightSensor_DebugPrint(const char *format, ...)
 {
 #if LIGHT_SENSOR_DEBUG_ENABLE
-    char buffer[128];
+    static LOG_Tag_t *logTag;
     va_list args;
     
+    /* 先判断标签级别, 关闭时不做格式化 */
+    if (!LOG_TagEnabled(&logTag, "LIGHT", LOG_LEVEL_DEBUG)) return;
+    
     va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
+    LOG_VRaw(format, args);
     va_end(args);
-    
-    /* 使用LOG_Raw以兼容原有格式 */
-    LOG_Raw("%s", buffer);
 #else
     (void)format;
 #endif
@@ -3,23 +3,122 @@
   * @file           : log.c
   * @brief          : 统一日志库源文件
   * @author         : Antigravity AI
-  * @version        : V1.0.0
+  * @version        : V1.4.0
   ******************************************************************************
   * @attention
   *
   * 统一日志库实现
   * 为所有驱动提供标准化的调试输出接口
   *
+  * 异步发送:
+  *   生产者用 CAS 在 reserveHead 上预留空间后拷贝数据, 不关中断。
+  *   单核上中断只会嵌套打断, 内层写入者总是先于外层完成, 所以由
+  *   最外层写入者 (writers 减为0) 把 commitHead 推进到 reserveHead,
+  *   此时预留区间内的数据都已拷贝完毕。
+  *   消费者 (启动DMA) 由 txBusy 互斥, DMA完成中断中推进 tail 并
+  *   启动下一段; 跨越缓冲区末尾的数据分两次发送。
+  *
+  * 标签级别:
+  *   每个调用点用静态变量缓存标签表项指针, 首次调用时按名称查找/注册,
+  *   之后只需读取级别比较一次; 级别关闭的日志不会进入格式化。
+  *
+  * 出口分发:
+  *   LOG_Print 只格式化一次, 得到串口格式的整行和其中用户消息的位置,
+  *   依次交给级别满足的出口; 所有出口都不接收的级别直接返回, 不做格式化。
+  *   串口出口写入上面的环形缓冲区, RAM出口保存不带颜色的纯文本行,
+  *   令牌化帧只交给设置了 LOG_SINK_BINARY 的出口 (串口)。
+  *
+  * 令牌化日志:
+  *   只拷贝参数字和时间戳, 格式串记录的地址作为ID, 不做任何格式化。
+  *   运行时无法得知格式串中的转换类型, 只有调用点用 LOG_STR() 标记且
+  *   指向RAM的参数才读取其字符串内容随帧附带; 不按数值猜测, 恰好落在
+  *   RAM地址范围内的整数不会被当作指针读取。
+  *
   ******************************************************************************
   */
 
 #include "log.h"
+#include "mem_region.h"
+#include "prof.h"
+#include "metrics.h"
+#include <stdlib.h>
+
+/* Private defines -----------------------------------------------------------*/
+#define LOG_RING_MASK                   (LOG_RING_SIZE - 1)
+
+/* 消息末尾保留的空间: 颜色复位 + 换行 + 结束符 */
+#define LOG_SUFFIX_RESERVE              (sizeof(LOG_COLOR_RESET) - 1 + 2 + 1)
+
+/* 令牌化日志: 判断 LOG_STR() 标记的字符串是否在片内RAM (SRAM1/SRAM2/CCM), 在Flash中的只发地址 */
+#define LOG_TOKEN_IS_RAM(addr)          (((addr) >= SRAM1_BASE && (addr) < SRAM2_BASE + 0x4000U) || \
+                                         ((addr) >= CCMDATARAM_BASE && (addr) <= CCMDATARAM_END))
+
+/* 令牌化日志帧头长度: sync + len + token + timestamp + nargs + strMask */
+#define LOG_TOKEN_HEADER_SIZE           12
+
+#if (LOG_RING_SIZE & LOG_RING_MASK) != 0
+#error "LOG_RING_SIZE must be a power of 2"
+#endif
+
+#if LOG_RAM_SINK_SIZE
+#define LOG_RAM_MASK                    (LOG_RAM_SINK_SIZE - 1)
+#if (LOG_RAM_SINK_SIZE & LOG_RAM_MASK) != 0
+#error "LOG_RAM_SINK_SIZE must be a power of 2"
+#endif
+#endif
 
 /* Private variables ---------------------------------------------------------*/
 LOG_Handle_t logHandle = {0};
 
+/* 异步发送环形缓冲区 (DMA源, 须位于DMA可访问的SRAM) */
+static uint8_t logRing[LOG_RING_SIZE] DMA_BUFFER;
+
+/* 标签表 (只增不删, 表项地址被调用点缓存) */
+static LOG_Tag_t logTags[LOG_MAX_TAGS] CCM_BSS;
+static volatile uint8_t logTagCount = 0;
+
+/* 出口表 */
+static LOG_Sink_t *logSinks[LOG_MAX_SINKS];
+static uint8_t logSinkCount = 0;
+
+/* 内置串口出口 */
+static void LOG_UartSinkWrite(const LOG_Record_t *record);
+static LOG_Sink_t logUartSink = {
+    "uart", LOG_UartSinkWrite, LOG_LEVEL_VERBOSE, LOG_SINK_BINARY, 1
+};
+
+#if LOG_RAM_SINK_SIZE
+/* 内置RAM出口 (覆盖最旧的内容) */
+static void LOG_RamSinkWrite(const LOG_Record_t *record);
+static LOG_Sink_t logRamSink = {
+    "ram", LOG_RamSinkWrite, LOG_RAM_SINK_LEVEL, 0, 1
+};
+static uint8_t logRamRing[LOG_RAM_SINK_SIZE] CCM_BSS;
+static uint32_t logRamHead = 0;
+#endif
+
+/* 健康指标 */
+static Metric_t logDropMetric = METRIC_SOURCE_INIT("log.drop", METRIC_COUNTER, &logHandle.stats.droppedLines);
+static Metric_t logPeakMetric = METRIC_SOURCE_INIT("log.peak", METRIC_GAUGE, &logHandle.stats.peakUsage);
+
+/* 级别名称, 下标即级别 */
+static const char * const logLevelNames[] = {
+    "none", "error", "warn", "info", "debug", "verbose"
+};
+
 /* Private function prototypes -----------------------------------------------*/
 static uint32_t LOG_GetTimestamp(void);
+static void LOG_RingPublish(void);
+static void LOG_StartTransmit(void);
+static int LOG_Advance(int offset, int n, int limit);
+static LOG_Tag_t *LOG_TagFind(const char *tag, uint8_t len);
+static int LOG_ParseLevel(const char *value, uint8_t *level);
+static void LOG_Dispatch(const LOG_Record_t *record);
+static void LOG_UpdateSinkLevel(void);
+static LOG_Sink_t *LOG_SinkFind(const char *name);
+#if LOG_TOKEN_ENABLE
+static void LOG_PutWord(uint8_t *dst, uint32_t value);
+#endif
 
 /**
   * @brief  初始化日志模块
@@ -30,11 +129,23 @@ void LOG_Init(UART_HandleTypeDef *huart)
 {
     if (!huart) return;
     
+    memset(&logHandle, 0, sizeof(logHandle));
     logHandle.huart = huart;
+    logHandle.async = (huart->hdmatx != NULL) ? 1 : 0;
     logHandle.enabled = 1;
     logHandle.level = LOG_LEVEL;
     logHandle.initialized = 1;
     
+    /* 内置出口 */
+    logSinkCount = 0;
+    LOG_AddSink(&logUartSink);
+#if LOG_RAM_SINK_SIZE
+    LOG_AddSink(&logRamSink);
+#endif
+    
+    Metrics_Register(&logDropMetric);
+    Metrics_Register(&logPeakMetric);
+    
     /* 打印初始化信息 */
     LOG_I("LOG", "Log system initialized (Level: %d)", logHandle.level);
 }
@@ -45,6 +156,7 @@ void LOG_Init(UART_HandleTypeDef *huart)
   */
 void LOG_DeInit(void)
 {
+    LOG_Flush();
     logHandle.initialized = 0;
     logHandle.enabled = 0;
     logHandle.huart = NULL;
@@ -90,6 +202,161 @@ uint8_t LOG_IsEnabled(void)
     return logHandle.enabled;
 }
 
+/**
+  * @brief  查找或注册标签
+  * @param  tag: 标签名
+  * @retval 标签指针, 标签表已满时返回NULL
+  */
+LOG_Tag_t *LOG_TagGet(const char *tag)
+{
+    LOG_Tag_t *entry;
+    uint32_t primask;
+    
+    if (!tag) return NULL;
+    
+    entry = LOG_TagFind(tag, LOG_TAG_NAME_LEN - 1);
+    if (entry) return entry;
+    
+    /* 注册只发生在每个标签首次使用时, 短暂关中断防止主循环与中断重复注册 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    
+    entry = LOG_TagFind(tag, LOG_TAG_NAME_LEN - 1);
+    if (!entry && logTagCount < LOG_MAX_TAGS) {
+        entry = &logTags[logTagCount];
+        strncpy(entry->name, tag, LOG_TAG_NAME_LEN - 1);
+        entry->name[LOG_TAG_NAME_LEN - 1] = '\0';
+        entry->level = LOG_LEVEL_DEFAULT;
+        logTagCount++;
+    }
+    
+    __set_PRIMASK(primask);
+    return entry;
+}
+
+/**
+  * @brief  设置标签级别
+  * @param  tag: 标签名, "*" 表示全局级别
+  * @param  level: 日志级别, LOG_LEVEL_DEFAULT=跟随全局
+  * @retval 1=成功 0=参数无效或标签表已满
+  */
+uint8_t LOG_SetTagLevel(const char *tag, uint8_t level)
+{
+    LOG_Tag_t *entry;
+    
+    if (!tag) return 0;
+    if (level > LOG_LEVEL_VERBOSE && level != LOG_LEVEL_DEFAULT) return 0;
+    
+    if (strcmp(tag, "*") == 0) {
+        if (level == LOG_LEVEL_DEFAULT) level = LOG_LEVEL;
+        logHandle.level = level;
+        return 1;
+    }
+    
+    entry = LOG_TagGet(tag);
+    if (!entry) return 0;
+    
+    entry->level = level;
+    return 1;
+}
+
+/**
+  * @brief  获取标签的生效级别
+  * @param  tag: 标签名
+  * @retval 生效级别
+  */
+uint8_t LOG_GetTagLevel(const char *tag)
+{
+    LOG_Tag_t *entry = tag ? LOG_TagFind(tag, LOG_TAG_NAME_LEN - 1) : NULL;
+    
+    if (!entry || entry->level == LOG_LEVEL_DEFAULT) {
+        return logHandle.level;
+    }
+    return entry->level;
+}
+
+/**
+  * @brief  按JSON批量设置级别
+  * @param  json: JSON字符串
+  * @retval 成功设置的项数, -1=格式错误
+  */
+int LOG_SetLevels(const char *json)
+{
+    char tag[LOG_TAG_NAME_LEN];
+    const char *p, *end;
+    uint8_t level;
+    int applied = 0;
+    
+    if (!json || (p = strchr(json, '{')) == NULL) return -1;
+    p++;
+    
+    while (1) {
+        /* 键名 */
+        while (*p == ' ' || *p == ',' || *p == '\r' || *p == '\n' || *p == '\t') p++;
+        if (*p == '}' || *p == '\0') break;
+        if (*p != '"') return -1;
+        end = strchr(p + 1, '"');
+        if (!end) return -1;
+        
+        memset(tag, 0, sizeof(tag));
+        strncpy(tag, p + 1, ((size_t)(end - p - 1) < sizeof(tag) - 1) ? (size_t)(end - p - 1) : sizeof(tag) - 1);
+        
+        /* 值 */
+        p = end + 1;
+        while (*p == ' ' || *p == ':') p++;
+        if (LOG_ParseLevel(p, &level) != 0) return -1;
+        if (LOG_SetTagLevel(tag, level)) applied++;
+        
+        /* 跳过值本身 */
+        if (*p == '"') {
+            p = strchr(p + 1, '"');
+            if (!p) return -1;
+            p++;
+        } else {
+            while (*p == '-' || (*p >= '0' && *p <= '9')) p++;
+        }
+    }
+    
+    return applied;
+}
+
+/**
+  * @brief  把全局及各标签的生效级别编码为JSON
+  * @param  buf: 输出缓冲区
+  * @param  size: 缓冲区大小
+  * @retval 长度
+  */
+int LOG_FormatLevels(char *buf, uint16_t size)
+{
+    uint16_t len;
+    uint8_t i;
+    int n;
+    
+    if (!buf || size < 3) return 0;
+    
+    n = snprintf(buf, size, "{\"*\":%d", logHandle.level);
+    if (n < 0 || n + 2 > size) {
+        buf[0] = '\0';
+        return 0;
+    }
+    len = n;
+    
+    for (i = 0; i < logTagCount; i++) {
+        uint8_t level = logTags[i].level;
+        
+        if (level == LOG_LEVEL_DEFAULT) level = logHandle.level;
+        n = snprintf(buf + len, size - len, ",\"%s\":%d", logTags[i].name, level);
+        if (n < 0 || len + n + 2 > size) {
+            break;
+        }
+        len += n;
+    }
+    
+    buf[len++] = '}';
+    buf[len] = '\0';
+    return len;
+}
+
 /**
   * @brief  获取时间戳 (毫秒)
   * @retval 当前时间戳
@@ -112,37 +379,45 @@ static uint32_t LOG_GetTimestamp(void)
 void LOG_Print(uint8_t level, const char *color, const char *prefix, 
                const char *tag, const char *format, ...)
 {
-    /* 检查初始化和使能状态 */
+    /* 检查初始化和使能状态 (标签级别已由 LOG_x 宏判断) */
     if (!logHandle.initialized || !logHandle.enabled) return;
-    if (!logHandle.huart) return;
-    
-    /* 检查日志级别 */
-    if (level > logHandle.level) return;
+    if (level > logHandle.sinkLevel) return;
     
     char buffer[LOG_BUFFER_SIZE];
+    int limit = LOG_BUFFER_SIZE - LOG_SUFFIX_RESERVE;
     int offset = 0;
+    int messageStart;
+    LOG_Record_t record;
+    PROF_BEGIN(LOG_PRINT);
+    
+    record.type = LOG_RECORD_TEXT;
+    record.level = level;
+    record.tag = tag;
+    record.timestamp = LOG_GetTimestamp();
     
 #if LOG_COLOR_ENABLE
     /* 添加颜色代码 */
-    offset += snprintf(buffer + offset, LOG_BUFFER_SIZE - offset, "%s", color);
+    offset = LOG_Advance(offset, snprintf(buffer + offset, limit - offset, "%s", color), limit);
 #endif
     
 #if LOG_TIMESTAMP_ENABLE
     /* 添加时间戳 */
-    uint32_t timestamp = LOG_GetTimestamp();
-    offset += snprintf(buffer + offset, LOG_BUFFER_SIZE - offset, 
-                       "[%lu] ", timestamp);
+    offset = LOG_Advance(offset, snprintf(buffer + offset, limit - offset,
+                                          "[%lu] ", (unsigned long)record.timestamp), limit);
 #endif
     
     /* 添加级别前缀和标签 */
-    offset += snprintf(buffer + offset, LOG_BUFFER_SIZE - offset, 
-                       "%s[%s] ", prefix, tag);
+    offset = LOG_Advance(offset, snprintf(buffer + offset, limit - offset,
+                                          "%s[%s] ", prefix, tag), limit);
     
-    /* 添加用户消息 */
+    /* 添加用户消息 (过长时截断, 保证颜色复位和换行仍能输出) */
     va_list args;
+    messageStart = offset;
     va_start(args, format);
-    offset += vsnprintf(buffer + offset, LOG_BUFFER_SIZE - offset, format, args);
+    offset = LOG_Advance(offset, vsnprintf(buffer + offset, limit - offset, format, args), limit);
     va_end(args);
+    record.message = buffer + messageStart;
+    record.messageLen = (uint16_t)(offset - messageStart);
     
 #if LOG_COLOR_ENABLE
     /* 重置颜色 */
@@ -154,8 +429,11 @@ void LOG_Print(uint8_t level, const char *color, const char *prefix,
     offset += snprintf(buffer + offset, LOG_BUFFER_SIZE - offset, "\r\n");
 #endif
     
-    /* 输出到UART */
-    HAL_UART_Transmit(logHandle.huart, (uint8_t *)buffer, offset, HAL_MAX_DELAY);
+    /* 分发给各出口 */
+    record.data = (const uint8_t *)buffer;
+    record.len = (uint16_t)offset;
+    LOG_Dispatch(&record);
+    PROF_END(LOG_PRINT);
 }
 
 /**
@@ -165,18 +443,42 @@ void LOG_Print(uint8_t level, const char *color, const char *prefix,
   * @retval None
   */
 void LOG_Raw(const char *format, ...)
+{
+    va_list args;
+    
+    va_start(args, format);
+    LOG_VRaw(format, args);
+    va_end(args);
+}
+
+/**
+  * @brief  原始输出 (va_list版本)
+  * @param  format: 格式化字符串
+  * @param  args: 参数列表
+  * @retval None
+  */
+void LOG_VRaw(const char *format, va_list args)
 {
     if (!logHandle.initialized || !logHandle.enabled) return;
-    if (!logHandle.huart) return;
+    if (LOG_LEVEL_DEBUG > logHandle.sinkLevel) return;
     
     char buffer[LOG_BUFFER_SIZE];
+    LOG_Record_t record;
     
-    va_list args;
-    va_start(args, format);
     int len = vsnprintf(buffer, LOG_BUFFER_SIZE, format, args);
-    va_end(args);
     
-    HAL_UART_Transmit(logHandle.huart, (uint8_t *)buffer, len, HAL_MAX_DELAY);
+    if (len <= 0) return;
+    if (len > LOG_BUFFER_SIZE - 1) len = LOG_BUFFER_SIZE - 1;
+    
+    record.type = LOG_RECORD_RAW;
+    record.level = LOG_LEVEL_DEBUG;
+    record.tag = NULL;
+    record.timestamp = LOG_GetTimestamp();
+    record.message = buffer;
+    record.messageLen = (uint16_t)len;
+    record.data = (const uint8_t *)buffer;
+    record.len = (uint16_t)len;
+    LOG_Dispatch(&record);
 }
 
 /**
@@ -189,7 +491,8 @@ void LOG_Raw(const char *format, ...)
 void LOG_HexDump(const char *tag, const uint8_t *data, uint16_t len)
 {
     if (!logHandle.initialized || !logHandle.enabled) return;
-    if (!logHandle.huart || !data || len == 0) return;
+    if (!data || len == 0) return;
+    if (LOG_GetTagLevel(tag) < LOG_LEVEL_DEBUG) return;
     
     LOG_D(tag, "HexDump (%d bytes):", len);
     
@@ -213,3 +516,582 @@ void LOG_HexDump(const char *tag, const uint8_t *data, uint16_t len)
         LOG_Raw("%s\r\n", line);
     }
 }
+
+/**
+  * @brief  写入原始字节
+  * @param  data: 数据指针
+  * @param  len: 数据长度
+  * @retval 1=已写入 0=缓冲区满被丢弃或未初始化
+  */
+uint8_t LOG_Write(const uint8_t *data, uint16_t len)
+{
+    uint32_t head, used, offset, first;
+    
+    if (!logHandle.initialized || !logHandle.enabled) return 0;
+    if (!logHandle.huart || !data || len == 0) return 0;
+    
+    if (!logHandle.async) {
+        HAL_UART_Transmit(logHandle.huart, (uint8_t *)data, len, HAL_MAX_DELAY);
+        return 1;
+    }
+    
+    Atomic_Add32(&logHandle.writers, 1);
+    
+    /* 预留空间, 放不下时整条丢弃 (不截断, 避免输出半行) */
+    do {
+        head = logHandle.reserveHead;
+        used = head - logHandle.tail;
+        if (used + len > LOG_RING_SIZE) {
+            Atomic_Add32(&logHandle.stats.droppedLines, 1);
+            Atomic_Add32(&logHandle.stats.droppedBytes, len);
+            LOG_RingPublish();
+            return 0;
+        }
+    } while (!Atomic_Cas32(&logHandle.reserveHead, head, head + len));
+    
+    /* 拷贝, 跨越末尾时分两段 */
+    offset = head & LOG_RING_MASK;
+    first = LOG_RING_SIZE - offset;
+    if (first > len) first = len;
+    memcpy(&logRing[offset], data, first);
+    memcpy(logRing, data + first, len - first);
+    
+    /* 峰值占用仅用于统计, 并发时偶尔少记无妨 */
+    if (used + len > logHandle.stats.peakUsage) {
+        logHandle.stats.peakUsage = used + len;
+    }
+    
+    LOG_RingPublish();
+    return 1;
+}
+
+#if LOG_TOKEN_ENABLE
+/**
+  * @brief  写入一条令牌化日志
+  * @param  level: 日志级别
+  * @param  token: 格式串记录地址
+  * @param  nargs: 参数个数
+  * @param  args: 参数字
+  * @retval None
+  */
+void LOG_Token(uint8_t level, const char *token, uint8_t nargs, const uint32_t *args,
+               const LOG_TokenStrs_t *strs)
+{
+    uint8_t frame[LOG_TOKEN_FRAME_MAX];
+    uint16_t len;
+    uint8_t strMask = 0;
+    uint8_t used = 0;
+    uint8_t i, j;
+    LOG_Record_t record;
+    
+    if (!logHandle.initialized || !logHandle.enabled) return;
+    if (level > logHandle.sinkLevel) return;
+    
+    if (nargs > LOG_TOKEN_MAX_ARGS) nargs = LOG_TOKEN_MAX_ARGS;
+    
+    frame[0] = LOG_TOKEN_SYNC;
+    LOG_PutWord(&frame[2], (uint32_t)(uintptr_t)token);
+    LOG_PutWord(&frame[6], LOG_GetTimestamp());
+    frame[10] = nargs;
+    len = LOG_TOKEN_HEADER_SIZE;
+    
+    for (i = 0; i < nargs; i++) {
+        LOG_PutWord(&frame[len], args[i]);
+        len += 4;
+    }
+    
+    /* 附带标记过的RAM字符串内容, 放不下的部分截断 */
+    for (i = 0; strs != NULL && i < nargs && len < sizeof(frame) - 1; i++) {
+        const char *str = NULL;
+        uint16_t room = sizeof(frame) - 1 - len;
+        uint16_t slen = 0;
+        
+        for (j = 0; j < strs->count; j++) {
+            if (!(used & (1U << j)) && (uint32_t)(uintptr_t)strs->str[j] == args[i]) {
+                used |= (uint8_t)(1U << j);
+                str = strs->str[j];
+                break;
+            }
+        }
+        if (str == NULL || !LOG_TOKEN_IS_RAM(args[i])) continue;
+        
+        while (slen < room && str[slen] != '\0') {
+            frame[len + 1 + slen] = (uint8_t)str[slen];
+            slen++;
+        }
+        frame[len] = (uint8_t)slen;
+        len += 1 + slen;
+        strMask |= (uint8_t)(1U << i);
+    }
+    
+    frame[1] = (uint8_t)(len - 2);
+    frame[11] = strMask;
+    
+    record.type = LOG_RECORD_TOKEN;
+    record.level = level;
+    record.tag = NULL;
+    record.timestamp = 0;
+    record.message = NULL;
+    record.messageLen = 0;
+    record.data = frame;
+    record.len = len;
+    LOG_Dispatch(&record);
+}
+#endif /* LOG_TOKEN_ENABLE */
+
+/**
+  * @brief  阻塞发出缓冲区中所有已提交的日志
+  * @retval None
+  */
+void LOG_Flush(void)
+{
+    uint32_t primask, tail, len, offset;
+    
+    if (!logHandle.initialized || !logHandle.huart || !logHandle.async) return;
+    
+    primask = __get_PRIMASK();
+    __disable_irq();
+    
+    tail = logHandle.tail;
+    
+    /* 终止进行中的DMA, 已被DMA取走的字节不再重发 */
+    if (logHandle.txBusy && logHandle.huart->gState == HAL_UART_STATE_BUSY_TX) {
+        tail += logHandle.txLen - __HAL_DMA_GET_COUNTER(logHandle.huart->hdmatx);
+        HAL_UART_AbortTransmit(logHandle.huart);
+    }
+    
+    while ((len = logHandle.commitHead - tail) != 0) {
+        offset = tail & LOG_RING_MASK;
+        if (len > LOG_RING_SIZE - offset) {
+            len = LOG_RING_SIZE - offset;
+        }
+        HAL_UART_Transmit(logHandle.huart, &logRing[offset], len, HAL_MAX_DELAY);
+        tail += len;
+    }
+    
+    logHandle.tail = tail;
+    logHandle.txBusy = 0;
+    
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  获取日志统计
+  * @param  stats: 输出指针
+  * @retval None
+  */
+void LOG_GetStats(LOG_Stats_t *stats)
+{
+    if (stats) {
+        *stats = logHandle.stats;
+    }
+}
+
+/**
+  * @brief  注册日志出口
+  * @param  sink: 出口描述
+  * @retval 1=成功 0=出口表已满或参数无效
+  */
+uint8_t LOG_AddSink(LOG_Sink_t *sink)
+{
+    if (!sink || !sink->write || logSinkCount >= LOG_MAX_SINKS) return 0;
+    
+    logSinks[logSinkCount++] = sink;
+    LOG_UpdateSinkLevel();
+    return 1;
+}
+
+/**
+  * @brief  设置出口级别
+  * @param  name: 出口名称
+  * @param  level: 级别
+  * @retval 1=成功 0=出口不存在
+  */
+uint8_t LOG_SetSinkLevel(const char *name, uint8_t level)
+{
+    LOG_Sink_t *sink = LOG_SinkFind(name);
+    
+    if (!sink || level > LOG_LEVEL_VERBOSE) return 0;
+    
+    sink->level = level;
+    LOG_UpdateSinkLevel();
+    return 1;
+}
+
+/**
+  * @brief  开关出口
+  * @param  name: 出口名称
+  * @param  enable: 1=开启 0=关闭
+  * @retval 1=成功 0=出口不存在
+  */
+uint8_t LOG_SetSinkEnable(const char *name, uint8_t enable)
+{
+    LOG_Sink_t *sink = LOG_SinkFind(name);
+    
+    if (!sink) return 0;
+    
+    sink->enabled = enable ? 1 : 0;
+    LOG_UpdateSinkLevel();
+    return 1;
+}
+
+/**
+  * @brief  把一条日志格式化为不带颜色的单行文本
+  * @param  record: 日志记录
+  * @param  buf: 输出缓冲区
+  * @param  size: 缓冲区大小
+  * @retval 长度 (不含结束符)
+  */
+int LOG_FormatRecord(const LOG_Record_t *record, char *buf, uint16_t size)
+{
+    static const char levelLetters[] = "-EWIDV";
+    uint16_t msgLen;
+    int n;
+    
+    if (!record || !buf || size == 0) return 0;
+    if (record->type == LOG_RECORD_TOKEN || !record->message) {
+        buf[0] = '\0';
+        return 0;
+    }
+    
+    /* 去掉消息末尾的换行, 由调用者决定行分隔符 */
+    msgLen = record->messageLen;
+    while (msgLen > 0 && (record->message[msgLen - 1] == '\n' || record->message[msgLen - 1] == '\r')) {
+        msgLen--;
+    }
+    
+    if (record->tag) {
+        n = snprintf(buf, size, "[%lu] %c/%s: %.*s", (unsigned long)record->timestamp,
+                     levelLetters[record->level <= LOG_LEVEL_VERBOSE ? record->level : 0],
+                     record->tag, (int)msgLen, record->message);
+    } else {
+        n = snprintf(buf, size, "[%lu] %.*s", (unsigned long)record->timestamp,
+                     (int)msgLen, record->message);
+    }
+    
+    if (n < 0) {
+        buf[0] = '\0';
+        return 0;
+    }
+    return (n < size) ? n : size - 1;
+}
+
+/**
+  * @brief  读取RAM出口中最近的日志
+  * @param  dst: 输出缓冲区
+  * @param  size: 最多读取的字节数
+  * @retval 实际读取的字节数
+  */
+uint16_t LOG_RamRead(uint8_t *dst, uint16_t size)
+{
+#if LOG_RAM_SINK_SIZE
+    uint32_t primask, head, len, offset, first;
+    
+    if (!dst) return 0;
+    
+    primask = __get_PRIMASK();
+    __disable_irq();
+    
+    head = logRamHead;
+    len = size;
+    if (len > LOG_RAM_SINK_SIZE) len = LOG_RAM_SINK_SIZE;
+    if (len > head) len = head;
+    
+    offset = (head - len) & LOG_RAM_MASK;
+    first = LOG_RAM_SINK_SIZE - offset;
+    if (first > len) first = len;
+    memcpy(dst, &logRamRing[offset], first);
+    memcpy(dst + first, logRamRing, len - first);
+    
+    __set_PRIMASK(primask);
+    return (uint16_t)len;
+#else
+    (void)dst;
+    (void)size;
+    return 0;
+#endif
+}
+
+/**
+  * @brief  拷贝最近写入的日志
+  * @param  dst: 输出缓冲区
+  * @param  size: 最多拷贝的字节数
+  * @retval 实际拷贝的字节数
+  */
+uint16_t LOG_CopyTail(uint8_t *dst, uint16_t size)
+{
+    uint32_t head = logHandle.commitHead;
+    uint32_t len = size;
+    uint32_t offset, first;
+    
+    if (dst == NULL) return 0;
+    
+    /* 已发出的字节在被覆盖前仍留在缓冲区中, 可一并取回 */
+    if (len > LOG_RING_SIZE) len = LOG_RING_SIZE;
+    if (len > head) len = head;
+    
+    offset = (head - len) & LOG_RING_MASK;
+    first = LOG_RING_SIZE - offset;
+    if (first > len) first = len;
+    
+    memcpy(dst, &logRing[offset], first);
+    memcpy(dst + first, logRing, len - first);
+    
+    return (uint16_t)len;
+}
+
+/**
+  * @brief  UART发送完成回调
+  * @param  huart: 触发回调的UART句柄
+  * @retval None
+  */
+void LOG_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart != logHandle.huart || !logHandle.txBusy) return;
+    
+    logHandle.tail += logHandle.txLen;
+    logHandle.txBusy = 0;
+    
+    LOG_StartTransmit();
+}
+
+/**
+  * @brief  写入者退出; 最外层写入者负责提交并启动发送
+  * @retval None
+  */
+static void LOG_RingPublish(void)
+{
+    uint32_t commit, reserve;
+    
+    /* 仍有被打断的外层写入者, 由它统一提交 */
+    if (Atomic_Sub32(&logHandle.writers, 1) != 0) return;
+    
+    /* 确保数据拷贝先于提交位置对DMA可见 */
+    __DMB();
+    
+    /* 中间若有中断已提交到更远的位置, CAS失败后重新读取即可 */
+    do {
+        commit = logHandle.commitHead;
+        reserve = logHandle.reserveHead;
+        if (reserve == commit) break;
+    } while (!Atomic_Cas32(&logHandle.commitHead, commit, reserve));
+    
+    LOG_StartTransmit();
+}
+
+/**
+  * @brief  若DMA空闲且有已提交数据, 启动一段DMA发送
+  * @retval None
+  */
+static void LOG_StartTransmit(void)
+{
+    uint32_t tail, len, offset;
+    
+    while (Atomic_Cas32(&logHandle.txBusy, 0, 1)) {
+        tail = logHandle.tail;
+        len = logHandle.commitHead - tail;
+        
+        if (len != 0) {
+            offset = tail & LOG_RING_MASK;
+            if (len > LOG_RING_SIZE - offset) {
+                len = LOG_RING_SIZE - offset;
+            }
+            logHandle.txLen = len;
+            
+            if (HAL_UART_Transmit_DMA(logHandle.huart, &logRing[offset], len) == HAL_OK) {
+                logHandle.stats.dmaTransfers++;
+            } else {
+                /* 外设忙, 留给下一次写入或完成回调重试 */
+                logHandle.txBusy = 0;
+            }
+            return;
+        }
+        
+        /* 释放后再检查一次, 避免错过释放前一刻的提交 */
+        logHandle.txBusy = 0;
+        if (logHandle.commitHead == logHandle.tail) return;
+    }
+}
+
+/**
+  * @brief  累加格式化长度, 截断时停在 limit - 1
+  * @param  offset: 当前长度
+  * @param  n: snprintf 返回值
+  * @param  limit: 可用缓冲区大小
+  * @retval 新长度
+  */
+static int LOG_Advance(int offset, int n, int limit)
+{
+    if (n < 0) return offset;
+    if (offset + n > limit - 1) return limit - 1;
+    return offset + n;
+}
+
+#if LOG_TOKEN_ENABLE
+/**
+  * @brief  按小端写入32位字
+  * @param  dst: 目标地址
+  * @param  value: 数值
+  * @retval None
+  */
+static void LOG_PutWord(uint8_t *dst, uint32_t value)
+{
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+    dst[2] = (uint8_t)(value >> 16);
+    dst[3] = (uint8_t)(value >> 24);
+}
+#endif
+
+/**
+  * @brief  把一条日志交给级别满足的出口
+  * @param  record: 日志记录
+  * @retval None
+  */
+static void LOG_Dispatch(const LOG_Record_t *record)
+{
+    uint8_t i;
+    
+    for (i = 0; i < logSinkCount; i++) {
+        LOG_Sink_t *sink = logSinks[i];
+        
+        if (!sink->enabled || record->level > sink->level) continue;
+        if (record->type == LOG_RECORD_TOKEN && !(sink->flags & LOG_SINK_BINARY)) continue;
+        
+        sink->write(record);
+    }
+}
+
+/**
+  * @brief  重新计算已启用出口中的最高级别
+  * @retval None
+  */
+static void LOG_UpdateSinkLevel(void)
+{
+    uint8_t level = LOG_LEVEL_NONE;
+    uint8_t i;
+    
+    for (i = 0; i < logSinkCount; i++) {
+        if (logSinks[i]->enabled && logSinks[i]->level > level) {
+            level = logSinks[i]->level;
+        }
+    }
+    logHandle.sinkLevel = level;
+}
+
+/**
+  * @brief  按名称查找出口
+  * @param  name: 出口名称
+  * @retval 出口指针, 未找到返回NULL
+  */
+static LOG_Sink_t *LOG_SinkFind(const char *name)
+{
+    uint8_t i;
+    
+    if (!name) return NULL;
+    
+    for (i = 0; i < logSinkCount; i++) {
+        if (strcmp(logSinks[i]->name, name) == 0) {
+            return logSinks[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+  * @brief  串口出口: 写入DMA环形缓冲区
+  * @param  record: 日志记录
+  * @retval None
+  */
+static void LOG_UartSinkWrite(const LOG_Record_t *record)
+{
+    LOG_Write(record->data, record->len);
+}
+
+#if LOG_RAM_SINK_SIZE
+/**
+  * @brief  RAM出口: 追加一行纯文本, 覆盖最旧的内容
+  * @param  record: 日志记录
+  * @retval None
+  */
+static void LOG_RamSinkWrite(const LOG_Record_t *record)
+{
+    char line[LOG_BUFFER_SIZE];
+    uint32_t primask, offset, first;
+    int len;
+    
+    len = LOG_FormatRecord(record, line, sizeof(line) - 1);
+    line[len++] = '\n';
+    
+    /* 只有一次内存拷贝, 关中断时间很短 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    
+    offset = logRamHead & LOG_RAM_MASK;
+    first = LOG_RAM_SINK_SIZE - offset;
+    if (first > (uint32_t)len) first = len;
+    memcpy(&logRamRing[offset], line, first);
+    memcpy(logRamRing, line + first, len - first);
+    logRamHead += len;
+    
+    __set_PRIMASK(primask);
+}
+#endif
+
+/**
+  * @brief  按名称查找标签 (不注册)
+  * @param  tag: 标签名
+  * @param  len: 比较的最大长度
+  * @retval 标签指针, 未找到返回NULL
+  */
+static LOG_Tag_t *LOG_TagFind(const char *tag, uint8_t len)
+{
+    uint8_t count = logTagCount;
+    uint8_t i;
+    
+    for (i = 0; i < count; i++) {
+        if (strncmp(logTags[i].name, tag, len) == 0) {
+            return &logTags[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+  * @brief  解析级别值: 数字或级别名称
+  * @param  value: 值的起始位置 (数字或带引号的名称)
+  * @param  level: 输出级别
+  * @retval 0=成功 -1=无法识别
+  */
+static int LOG_ParseLevel(const char *value, uint8_t *level)
+{
+    uint8_t i;
+    
+    if (*value == '-' || (*value >= '0' && *value <= '9')) {
+        int n = atoi(value);
+        if (n < 0) {
+            *level = LOG_LEVEL_DEFAULT;
+            return 0;
+        }
+        if (n > LOG_LEVEL_VERBOSE) return -1;
+        *level = (uint8_t)n;
+        return 0;
+    }
+    
+    if (*value != '"') return -1;
+    value++;
+    
+    if (strncmp(value, "default\"", 8) == 0) {
+        *level = LOG_LEVEL_DEFAULT;
+        return 0;
+    }
+    
+    for (i = 0; i <= LOG_LEVEL_VERBOSE; i++) {
+        size_t n = strlen(logLevelNames[i]);
+        if (strncmp(value, logLevelNames[i], n) == 0 && value[n] == '"') {
+            *level = i;
+            return 0;
+        }
+    }
+    return -1;
+}
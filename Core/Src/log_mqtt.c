@@ -0,0 +1,430 @@
+/**
+  ******************************************************************************
+  * @file           : log_mqtt.c
+  * @brief          : MQTT日志出口源文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 出口回调可能在中断中执行, 批缓冲区的修改都在短暂关中断下完成
+  * (格式化在关中断之前), 发布时先把批缓冲区拷贝出来再发, 发布期间
+  * 中断仍可继续追加。
+  *
+  * 发布失败时把快照放回批缓冲区前部 (发布期间中断追加的行接在后面,
+  * 放不下的较新行计入溢出), 丢弃计数加回限速表, 下次重试时一并汇总。
+  *
+  * 防自激: 发布在主循环中进行, 期间主循环上下文 (IPSR=0) 产生的日志
+  * 一律忽略, 这些只可能来自 MQTT/ESP8266 驱动本身; 中断中的日志照常收集。
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "log_mqtt.h"
+#include "esp8266_mqtt.h"
+#include "scratch.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+/* 批末尾汇总 (限速/溢出) 预留长度 */
+#define LOG_MQTT_TRAILER_SIZE       128
+
+/* 发布缓冲区 (批缓冲区的快照 + 汇总, 在共享区) */
+#define LOG_MQTT_SEND_SIZE          (LOG_MQTT_BATCH_SIZE + LOG_MQTT_TRAILER_SIZE)
+
+/* FNV-1a */
+#define LOG_MQTT_FNV_OFFSET         2166136261UL
+#define LOG_MQTT_FNV_PRIME          16777619UL
+
+/* Private types -------------------------------------------------------------*/
+
+/* 发布前保存的批状态 (发布失败时恢复) */
+typedef struct {
+    uint16_t lastLineStart;
+    uint16_t lastLineEnd;
+    uint32_t lastHash;
+    uint16_t repeatCount;
+    uint16_t overflowLines;
+    uint32_t firstLineTick;
+    uint8_t urgent;
+} LogMqtt_Saved_t;
+
+/* Private variables ---------------------------------------------------------*/
+
+/* MQTT日志出口句柄实例 */
+LogMqtt_Handle_t logMqtt = {0};
+
+/* Private function prototypes -----------------------------------------------*/
+static void LogMqtt_SinkWrite(const LOG_Record_t *record);
+static uint32_t LogMqtt_Hash(const LOG_Record_t *record);
+static uint8_t LogMqtt_TakeToken(const char *tag);
+static void LogMqtt_Append(const char *line, uint16_t len, uint8_t level, uint32_t hash);
+static void LogMqtt_RewriteRepeat(void);
+static void LogMqtt_Restore(const char *snapshot, uint16_t snapLen, const LogMqtt_Saved_t *saved,
+                            const uint16_t *dropped, uint8_t count);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  计算一行日志的哈希 (级别+标签+消息, 不含时间戳)
+  */
+static uint32_t LogMqtt_Hash(const LOG_Record_t *record)
+{
+    uint32_t hash = LOG_MQTT_FNV_OFFSET;
+    const char *p;
+    uint16_t i;
+
+    hash = (hash ^ record->level) * LOG_MQTT_FNV_PRIME;
+    for (p = record->tag; p != NULL && *p != '\0'; p++) {
+        hash = (hash ^ (uint8_t)*p) * LOG_MQTT_FNV_PRIME;
+    }
+    hash = (hash ^ 0x1F) * LOG_MQTT_FNV_PRIME;
+    for (i = 0; i < record->messageLen; i++) {
+        hash = (hash ^ (uint8_t)record->message[i]) * LOG_MQTT_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/**
+  * @brief  按标签取一个令牌 (关中断下调用)
+  * @retval uint8_t 1=放行 0=限速丢弃
+  */
+static uint8_t LogMqtt_TakeToken(const char *tag)
+{
+    LogMqtt_Bucket_t *bucket = NULL;
+    uint32_t now = HAL_GetTick();
+    uint32_t refill;
+    uint8_t i;
+
+    if (tag == NULL) {
+        tag = "";
+    }
+
+    for (i = 0; i < logMqtt.bucketCount; i++) {
+        if (strncmp(logMqtt.buckets[i].tag, tag, LOG_TAG_NAME_LEN - 1) == 0) {
+            bucket = &logMqtt.buckets[i];
+            break;
+        }
+    }
+
+    if (bucket == NULL) {
+        if (logMqtt.bucketCount < LOG_MQTT_MAX_TAGS) {
+            bucket = &logMqtt.buckets[logMqtt.bucketCount++];
+            strncpy(bucket->tag, tag, LOG_TAG_NAME_LEN - 1);
+            bucket->tag[LOG_TAG_NAME_LEN - 1] = '\0';
+            bucket->tokens = LOG_MQTT_RATE_BURST;
+            bucket->refillTick = now;
+            bucket->dropped = 0;
+        } else {
+            /* 表满时其余标签共用最后一项 */
+            bucket = &logMqtt.buckets[LOG_MQTT_MAX_TAGS - 1];
+        }
+    }
+
+    /* 补充令牌 */
+    if (bucket->tokens >= LOG_MQTT_RATE_BURST) {
+        bucket->refillTick = now;
+    } else {
+        refill = (now - bucket->refillTick) / LOG_MQTT_RATE_REFILL_MS;
+        if (refill > 0) {
+            bucket->tokens = (bucket->tokens + refill >= LOG_MQTT_RATE_BURST) ?
+                             LOG_MQTT_RATE_BURST : (uint8_t)(bucket->tokens + refill);
+            bucket->refillTick += refill * LOG_MQTT_RATE_REFILL_MS;
+        }
+    }
+
+    if (bucket->tokens == 0) {
+        if (bucket->dropped < 0xFFFF) {
+            bucket->dropped++;
+        }
+        logMqtt.stats.rateLimited++;
+        return 0;
+    }
+
+    bucket->tokens--;
+    return 1;
+}
+
+/**
+  * @brief  追加一行到批缓冲区 (关中断下调用)
+  */
+static void LogMqtt_Append(const char *line, uint16_t len, uint8_t level, uint32_t hash)
+{
+    if (logMqtt.batchLen + len + 1 > LOG_MQTT_BATCH_SIZE) {
+        logMqtt.overflowLines++;
+        logMqtt.stats.overflow++;
+        return;
+    }
+
+    if (logMqtt.batchLen == 0) {
+        logMqtt.firstLineTick = HAL_GetTick();
+    }
+
+    logMqtt.lastLineStart = logMqtt.batchLen;
+    memcpy(&logMqtt.batch[logMqtt.batchLen], line, len);
+    logMqtt.lastLineEnd = logMqtt.batchLen + len;
+    logMqtt.batch[logMqtt.lastLineEnd] = '\n';
+    logMqtt.batchLen = logMqtt.lastLineEnd + 1;
+
+    logMqtt.lastHash = hash;
+    logMqtt.repeatCount = 0;
+    if (level == LOG_LEVEL_ERROR) {
+        logMqtt.urgent = 1;
+    }
+    logMqtt.stats.lines++;
+}
+
+/**
+  * @brief  用重复次数后缀改写批中最后一行 (关中断下调用)
+  */
+static void LogMqtt_RewriteRepeat(void)
+{
+    char suffix[32];
+    int n = snprintf(suffix, sizeof(suffix), " (repeated %u times)\n", logMqtt.repeatCount);
+
+    /* 放不下时保留旧的后缀, 次数仍计入统计 */
+    if (n <= 0 || logMqtt.lastLineEnd + n > LOG_MQTT_BATCH_SIZE) {
+        return;
+    }
+
+    memcpy(&logMqtt.batch[logMqtt.lastLineEnd], suffix, n);
+    logMqtt.batchLen = logMqtt.lastLineEnd + n;
+}
+
+/**
+  * @brief  出口回调: 去重, 限速, 追加到批缓冲区
+  */
+static void LogMqtt_SinkWrite(const LOG_Record_t *record)
+{
+    char line[LOG_BUFFER_SIZE];
+    uint32_t hash, primask;
+    int len;
+
+    /* 发布期间主循环上下文的日志来自发布路径本身 */
+    if (logMqtt.publishing && __get_IPSR() == 0) {
+        logMqtt.stats.selfSuppressed++;
+        return;
+    }
+
+    len = LOG_FormatRecord(record, line, sizeof(line));
+    if (len <= 0) {
+        return;
+    }
+    hash = LogMqtt_Hash(record);
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (logMqtt.batchLen > 0 && hash == logMqtt.lastHash) {
+        logMqtt.repeatCount++;
+        logMqtt.stats.repeats++;
+        LogMqtt_RewriteRepeat();
+    } else if (LogMqtt_TakeToken(record->tag)) {
+        LogMqtt_Append(line, (uint16_t)len, record->level, hash);
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  发布失败: 把快照放回批缓冲区并恢复丢弃计数
+  * @param  snapshot 发布前取出的批内容 (不含汇总行)
+  * @param  saved    取出时的去重/时间/紧急状态
+  * @param  dropped  取出时各标签的限速丢弃数
+  */
+static void LogMqtt_Restore(const char *snapshot, uint16_t snapLen, const LogMqtt_Saved_t *saved,
+                            const uint16_t *dropped, uint8_t count)
+{
+    uint16_t keep, lost = 0, i;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    /* 发布期间追加的行接在快照后面, 放不下的按整行丢弃 */
+    keep = logMqtt.batchLen;
+    if (snapLen + keep > LOG_MQTT_BATCH_SIZE) {
+        keep = LOG_MQTT_BATCH_SIZE - snapLen;
+        while (keep > 0 && logMqtt.batch[keep - 1] != '\n') {
+            keep--;
+        }
+        for (i = keep; i < logMqtt.batchLen; i++) {
+            if (logMqtt.batch[i] == '\n') {
+                lost++;
+            }
+        }
+    }
+
+    memmove(&logMqtt.batch[snapLen], logMqtt.batch, keep);
+    memcpy(logMqtt.batch, snapshot, snapLen);
+
+    if (keep > 0 && keep == logMqtt.batchLen) {
+        /* 最后一行仍是发布期间追加的那行 */
+        logMqtt.lastLineStart += snapLen;
+        logMqtt.lastLineEnd += snapLen;
+    } else if (keep == 0) {
+        logMqtt.lastLineStart = saved->lastLineStart;
+        logMqtt.lastLineEnd = saved->lastLineEnd;
+        logMqtt.lastHash = saved->lastHash;
+        logMqtt.repeatCount = saved->repeatCount;
+    } else {
+        logMqtt.lastHash = 0;
+    }
+    logMqtt.batchLen = snapLen + keep;
+
+    logMqtt.firstLineTick = saved->firstLineTick;
+    logMqtt.urgent |= saved->urgent;
+    logMqtt.overflowLines += saved->overflowLines + lost;
+    logMqtt.stats.overflow += lost;
+    for (i = 0; i < count; i++) {
+        uint32_t sum = (uint32_t)logMqtt.buckets[i].dropped + dropped[i];
+        logMqtt.buckets[i].dropped = (sum > 0xFFFF) ? 0xFFFF : (uint16_t)sum;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  初始化并注册MQTT日志出口
+  */
+uint8_t LogMqtt_Init(const char *topic)
+{
+    if (topic == NULL || strlen(topic) >= LOG_MQTT_TOPIC_LEN) {
+        return 0;
+    }
+
+    memset(&logMqtt, 0, sizeof(logMqtt));
+    strcpy(logMqtt.topic, topic);
+
+    logMqtt.sink.name = "mqtt";
+    logMqtt.sink.write = LogMqtt_SinkWrite;
+    logMqtt.sink.level = LOG_MQTT_LEVEL;
+    logMqtt.sink.flags = 0;
+    logMqtt.sink.enabled = 1;
+
+    if (!LOG_AddSink(&logMqtt.sink)) {
+        return 0;
+    }
+
+    logMqtt.initialized = 1;
+    return 1;
+}
+
+/**
+  * @brief  到期时发布批缓冲区
+  */
+void LogMqtt_Poll(void)
+{
+    uint16_t dropped[LOG_MQTT_MAX_TAGS];
+    LogMqtt_Saved_t saved;
+    Scratch_Mark_t mark;
+    char *sendBuf;
+    uint16_t overflow;
+    uint32_t primask;
+    uint16_t batchLen;
+    uint16_t len;
+    uint8_t count;
+    uint8_t i;
+    int n;
+
+    if (!logMqtt.initialized || logMqtt.batchLen == 0) {
+        return;
+    }
+
+    if (!logMqtt.urgent && logMqtt.batchLen < LOG_MQTT_FLUSH_THRESHOLD &&
+        HAL_GetTick() - logMqtt.firstLineTick < LOG_MQTT_INTERVAL_MS) {
+        return;
+    }
+
+    if (logMqtt.retryPending && HAL_GetTick() - logMqtt.retryTick < LOG_MQTT_RETRY_MS) {
+        return;
+    }
+
+    if (!MQTT_IsConnected()) {
+        return;
+    }
+
+    /* 共享区不足时保留批缓冲区, 下次再发 */
+    mark = Scratch_Mark();
+    sendBuf = Scratch_Alloc(LOG_MQTT_SEND_SIZE);
+    if (sendBuf == NULL) {
+        return;
+    }
+
+    /* 1. 取出批缓冲区与本批的丢弃计数 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    batchLen = len = logMqtt.batchLen;
+    memcpy(sendBuf, logMqtt.batch, len);
+    saved.lastLineStart = logMqtt.lastLineStart;
+    saved.lastLineEnd = logMqtt.lastLineEnd;
+    saved.lastHash = logMqtt.lastHash;
+    saved.repeatCount = logMqtt.repeatCount;
+    saved.firstLineTick = logMqtt.firstLineTick;
+    saved.urgent = logMqtt.urgent;
+    saved.overflowLines = logMqtt.overflowLines;
+    overflow = logMqtt.overflowLines;
+    count = logMqtt.bucketCount;
+    for (i = 0; i < count; i++) {
+        dropped[i] = logMqtt.buckets[i].dropped;
+        logMqtt.buckets[i].dropped = 0;
+    }
+
+    logMqtt.batchLen = 0;
+    logMqtt.overflowLines = 0;
+    logMqtt.urgent = 0;
+    logMqtt.lastHash = 0;
+    logMqtt.repeatCount = 0;
+
+    __set_PRIMASK(primask);
+
+    /* 2. 汇总被丢弃的行 */
+    for (i = 0; i < count; i++) {
+        if (dropped[i] == 0) {
+            continue;
+        }
+        n = snprintf(sendBuf + len, LOG_MQTT_SEND_SIZE - len, "-- rate-limited %s: %u\n",
+                     logMqtt.buckets[i].tag[0] ? logMqtt.buckets[i].tag : "raw", dropped[i]);
+        if (n < 0 || len + n >= LOG_MQTT_SEND_SIZE) {
+            break;
+        }
+        len += n;
+    }
+    if (overflow > 0) {
+        n = snprintf(sendBuf + len, LOG_MQTT_SEND_SIZE - len, "-- overflow: %u\n", overflow);
+        if (n > 0 && len + n < LOG_MQTT_SEND_SIZE) {
+            len += n;
+        }
+    }
+
+    /* 3. 发布, 期间主循环上下文的日志不进入批缓冲区 */
+    logMqtt.publishing = 1;
+    if (MQTT_PublishRaw(logMqtt.topic, (const uint8_t *)sendBuf, len, MQTT_QOS_0, 0) == MQTT_OK) {
+        logMqtt.stats.publishes++;
+        logMqtt.retryPending = 0;
+    } else {
+        /* 4. 失败: 整批放回, 稍后连同丢弃汇总一起重试 */
+        logMqtt.stats.publishFailures++;
+        LogMqtt_Restore(sendBuf, batchLen, &saved, dropped, count);
+        logMqtt.retryPending = 1;
+        logMqtt.retryTick = HAL_GetTick();
+    }
+    logMqtt.publishing = 0;
+    Scratch_Release(mark);
+}
+
+/**
+  * @brief  获取统计
+  */
+void LogMqtt_GetStats(LogMqtt_Stats_t *stats)
+{
+    if (stats != NULL) {
+        *stats = logMqtt.stats;
+    }
+}
+
+/* End of file ---------------------------------------------------------------*/
@@ -30,6 +30,24 @@
 #include "dht11.h"       // dht11驱动库
 #include "esp8266_mqtt.h" // esp8266的MQTT驱动库
 #include "light_sensor.h" // 光敏传感器驱动库
+#include "flicker.h"      // 光照频闪分析
+#include "chip_sensor.h"  // 片内VREFINT/温度传感器
+#include "sensor_hub.h"   // 传感器注册与采样调度
+#include "sensor_board.h" // 板载传感器适配层
+#include "timeseries.h"   // 多分辨率时序存储
+#include "crash_log.h"    // 复位保持的故障记录
+#include "log_mqtt.h"     // MQTT日志出口
+#include "prof.h"         // DWT周期计数器性能剖析
+#include "metrics.h"      // 设备健康指标
+#include "power.h"        // 低功耗空闲管理
+#include "control.h"      // 远程控制命令
+#include "ctrl_latency.h" // 控制路径时延剖析
+#include "pub_bench.h"    // 发布吞吐基准
+#include "scratch.h"      // 临时缓冲区共享区
+#include "stack_mon.h"    // 主栈水位监测
+#include "config_store.h" // Flash键值配置存储
+#include "config_flash.h" // 配置存储的内部Flash扇区
+#include "boot.h"         // 启动编排与启动时间线
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -39,6 +57,10 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+/* 默认配置, 配置存储中设置了对应的键时以配置存储为准 (stm32/config/set 远程修改) */
+#define WIFI_SSID_DEFAULT       "AK70"               /* WiFi名称 */
+#define WIFI_PASSWORD_DEFAULT   "204081011"          /* WiFi密码 */
+
 /* MQTT Broker配置 - 请根据实际情况修改 */
 #define MQTT_EXAMPLE_BROKER     "47.107.34.158"    /* 公共测试Broker */
 #define MQTT_EXAMPLE_PORT       1883                 /* 默认MQTT端口 */
@@ -49,6 +71,38 @@
 /* 主题配置 */
 #define MQTT_TOPIC_SENSOR_DATA  "stm32/sensor/data"  /* 传感器数据发布主题 */
 #define MQTT_TOPIC_CONTROL      "stm32/control"      /* 控制命令订阅主题 */
+#define MQTT_TOPIC_FLICKER      "stm32/sensor/flicker" /* 频闪特征发布主题 */
+#define MQTT_TOPIC_TS_QUERY     "stm32/ts/query"     /* 时序查询订阅主题 */
+#define MQTT_TOPIC_TS_DATA      "stm32/ts/data"      /* 时序查询应答主题 */
+
+#define MQTT_TOPIC_REPORT_STATS "stm32/sensor/report_stats" /* 上报抑制统计主题 */
+#define MQTT_TOPIC_LOG_LEVEL    "stm32/log/level"    /* 日志级别设置订阅主题 */
+#define MQTT_TOPIC_LOG_LEVELS   "stm32/log/levels"   /* 当前日志级别发布主题 */
+#define MQTT_TOPIC_LOG          "stm32/log"          /* 远程日志 (攒批发布) */
+#define MQTT_TOPIC_CRASH        "stm32/crash"        /* 上次复位前的故障记录 */
+#define MQTT_TOPIC_CRASH_LOG    "stm32/crash/log"    /* 故障前的日志尾部 */
+#define MQTT_TOPIC_PROF_QUERY   "stm32/prof/query"   /* 性能剖析查询订阅主题 */
+#define MQTT_TOPIC_PROF_DATA    "stm32/prof/data"    /* 性能剖析应答主题 (每区段一条) */
+#define MQTT_TOPIC_AT_STATS     "stm32/esp/stats"    /* AT命令统计主题 (每个命令动词一条) */
+#define MQTT_TOPIC_METRICS      "stm32/metrics"      /* 设备健康指标 (保留消息) */
+#define MQTT_TOPIC_CONFIG_SET   "stm32/config/set"   /* 配置写入/查询订阅主题 */
+#define MQTT_TOPIC_CONFIG_DATA  "stm32/config/data"  /* 配置应答主题 */
+
+#define MQTT_SERVICE_PERIOD_MS      5000    /* 处理MQTT订阅消息的周期 */
+#define REPORT_STATS_PERIOD_MS      600000  /* 上报统计发布周期 (10分钟) */
+#define AT_STATS_PERIOD_MS          300000  /* AT命令统计发布周期 (5分钟) */
+#define MAIN_LOOP_INTERVAL_MS       10      /* 主循环调度间隔 */
+
+/* 时序/剖析/AT统计应答分块缓冲区 (共享区, 每轮申请一次) */
+#define RESP_CHUNK_SIZE             (TIMESERIES_CHUNK_SIZE > PROF_CHUNK_SIZE ? TIMESERIES_CHUNK_SIZE : PROF_CHUNK_SIZE)
+
+/* 应用状态ID, 故障时写入故障记录 */
+#define APP_STATE_INIT              1       /* 初始化 */
+#define APP_STATE_SAMPLE            2       /* 采样与频闪分析 */
+#define APP_STATE_PUBLISH           3       /* 上报发布 */
+#define APP_STATE_MQTT_SERVICE      4       /* 处理订阅消息 */
+#define APP_STATE_TS_QUERY          5       /* 时序查询应答 */
+#define APP_STATE_IDLE              6       /* 主循环低功耗空闲 */
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -59,6 +113,32 @@
 /* Private variables ---------------------------------------------------------*/
 
 /* USER CODE BEGIN PV */
+static uint32_t mqttServiceTick = 0;    /* 上次处理MQTT订阅消息的时间 */
+static uint32_t reportStatsTick = 0;    /* 上次发布上报统计的时间 */
+static uint32_t atStatsTick = 0;        /* 上次发布AT命令统计的时间 */
+static uint8_t logLevelsPending = 0;    /* 日志级别已修改, 待发布当前级别表 */
+static uint8_t ctrlLatencyPending = 0;  /* 待发布控制路径时延统计 */
+static uint8_t stackReportPending = 0;  /* 待发布主栈水位 */
+static uint8_t bootReportPending = 0;   /* 待发布启动时间线 */
+static uint8_t wifiReportPending = 0;   /* 待发布入网路径与耗时 */
+static uint8_t configPending = 0;       /* 待发布配置应答 */
+static uint8_t configRebootPending = 0; /* 配置应答发布后复位 */
+static char configReply[48];            /* 配置写入结果, 为空时发布当前配置 */
+#if PUB_BENCH_ENABLE
+static uint8_t pubBenchPending = 0;     /* 待运行发布吞吐基准 */
+#endif
+#if FLICKER_ENABLE
+static uint32_t flickerLastTick = 0;    /* 上次启动频闪采集的时间 */
+#endif
+
+/* 启动时订阅的主题 */
+static const Boot_Topic_t appTopics[] = {
+	{ MQTT_TOPIC_CONTROL,       MQTT_QOS_1 },
+	{ MQTT_TOPIC_TS_QUERY,      MQTT_QOS_0 },
+	{ MQTT_TOPIC_LOG_LEVEL,     MQTT_QOS_1 },
+	{ MQTT_TOPIC_PROF_QUERY,    MQTT_QOS_0 },
+	{ MQTT_TOPIC_CONFIG_SET,    MQTT_QOS_1 },
+};
 
 /* USER CODE END PV */
 
@@ -72,8 +152,14 @@ void OnMQTTMessageReceived(MQTT_Message_t *message);
 void OnMQTTPublishComplete(const char *topic);
 void OnMQTTError(MQTT_Status_t error);
 
-/* JSON解析辅助函数 */
-static int JSON_GetBoolValue(const char *json, const char *key, uint8_t *value);
+/* 发布上次复位前的故障记录 */
+static void PublishCrashReport(void);
+
+/* 计算本轮可以空闲的时间 */
+static uint32_t App_IdleBudget(uint8_t streaming);
+
+/* 启动期间等待模块时运行的后台任务 */
+static void App_BootBackground(void);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -115,15 +201,54 @@ int main(void)
   MX_USART1_UART_Init();
   MX_USART3_UART_Init();
   MX_ADC3_Init();
+  MX_ADC1_Init();
   /* USER CODE BEGIN 2 */
+	/* 主栈水位监测: 最先填充, 之前的初始化调用已返回, 不计入高水位 */
+	StackMon_Init();
+	
+	/* 启动DWT周期计数器, 各模块的剖析区段从此开始计时 */
+	Prof_Init();
+	CtrlLatency_Reset();
+	
 	/* 初始化统一日志库 */
 	LOG_Init(&huart1);
 	LOG_I("MAIN", "System starting...");
 	
-	/* 初始化DHT11温湿度传感器 */
+	/* 启动时间线; 等待ESP8266期间在后台采样 */
+	Boot_Init(App_BootBackground);
+	
+	/* 配置存储: 只遍历记录头建立索引, 之后的初始化按配置覆盖默认值 */
+	if (ConfigStore_Init(ConfigFlash_Get()) != CONFIG_STORE_OK) {
+		LOG_E("MAIN", "Config store init failed, using defaults");
+	}
+	
+	/* 远程日志出口: 连接前的日志先攒在批缓冲区中 */
+	LogMqtt_Init(MQTT_TOPIC_LOG);
+	
+	/* 健康指标: 各模块在初始化时注册, 主循环定期以保留消息发布 */
+	Metrics_Init(MQTT_TOPIC_METRICS);
+	
+	/* 临时缓冲区共享区 (峰值用量计入健康指标) */
+	Scratch_Init();
+	
+	/* 低功耗空闲: 主循环按下一个截止时间睡眠, 代替固定延时 */
+	Power_Init();
+	
+	/* 检查上次复位前的故障记录 */
+	CrashLog_Init();
+	CrashLog_SetState(APP_STATE_INIT);
+	
+	/* 初始化DHT11温湿度传感器 (上电稳定的1s不阻塞, 与模块启动重叠) */
 	DHT11_Init();
 	LOG_I("MAIN", "DHT11 initialized");
 	
+	/* 初始化片内传感器 (ADC1后台循环扫描VREFINT/温度) */
+	if (ChipSensor_Init() == CHIP_SENSOR_OK) {
+		LOG_I("MAIN", "ChipSensor initialized");
+	} else {
+		LOG_E("MAIN", "ChipSensor init failed!");
+	}
+	
 	/* 初始化光敏传感器 (轮询模式) */
 	if (LightSensor_Init() == LIGHT_SENSOR_OK) {
 		LOG_I("MAIN", "LightSensor initialized");
@@ -131,26 +256,37 @@ int main(void)
 		LOG_E("MAIN", "LightSensor init failed!");
 	}
 	
+	/* 注册传感器并启动错峰调度, 样本同时写入时序存储 */
+	TimeSeries_Init();
+	Report_Init();
+	SensorBoard_ConfigureReport();
+	SensorHub_Init();
+	if (SensorBoard_RegisterAll() == SENSOR_HUB_OK) {
+		LOG_I("MAIN", "%d sensors registered", sensorHub.sensorCount);
+	} else {
+		LOG_E("MAIN", "Sensor registration failed!");
+	}
+	
+#if FLICKER_ENABLE
+	/* 初始化频闪分析 (ADC3 + TIM2触发 + DMA) */
+	if (Flicker_Init() == FLICKER_OK) {
+		LOG_I("MAIN", "Flicker analyzer initialized");
+	} else {
+		LOG_E("MAIN", "Flicker analyzer init failed!");
+	}
+#endif
+	Boot_Mark(BOOT_STAGE_SENSORS);
+	
 	ESP8266_Status_t status;
     
-    /* 初始化ESP8266 */
-    status = ESP8266_Init(&huart3);
-    if (status != ESP8266_OK) {
-        LOG_E("ESP8266", "ESP8266 init failed!");
-    }
-    
-    /* 设置WiFi模式为Station */
-    ESP8266_SetWiFiMode(ESP8266_MODE_STA);
-    
-    /* 连接WiFi */
-    status = ESP8266_ConnectAP("AK70", "204081011");
+    /* 初始化ESP8266并连接WiFi: 模块仍连着或能自动重连时不发CWJAP */
+    status = Boot_Wifi(&huart3, ConfigStore_GetStr(CONFIG_KEY_WIFI_SSID, WIFI_SSID_DEFAULT),
+                       ConfigStore_GetStr(CONFIG_KEY_WIFI_PASS, WIFI_PASSWORD_DEFAULT));
     if (status == ESP8266_OK) {
         LOG_I("ESP8266", "WiFi connected!");
-        
-        /* 获取IP地址 */
-        ESP8266_IPInfo_t ipInfo;
-        ESP8266_GetIPInfo(&ipInfo);
-        LOG_I("ESP8266", "IP: %s", ipInfo.ip);
+        LOG_I("ESP8266", "IP: %s", esp8266.ipInfo.ip);
+    } else if (!ESP8266_IsInitialized()) {
+        LOG_E("ESP8266", "ESP8266 init failed!");
     } else {
         LOG_E("ESP8266", "WiFi connection failed!");
     }
@@ -171,42 +307,31 @@ int main(void)
     /* 3. 配置用户参数 */
     MQTT_UserConfig_t userConfig = {
         .scheme = MQTT_SCHEME_TCP,
-        .clientId = MQTT_EXAMPLE_CLIENT_ID,
-        .username = MQTT_EXAMPLE_USERNAME,
-        .password = MQTT_EXAMPLE_PASSWORD,
         .certKeyId = 0,
         .caId = 0,
         .path = ""
     };
-    ret = MQTT_SetUserConfig(&userConfig);
-    if (ret != MQTT_OK)
-		{
-			LOG_E("MQTT", "Set User Config failed!");
-		}
- 
-    
+    strncpy(userConfig.clientId, ConfigStore_GetStr(CONFIG_KEY_MQTT_CLIENT_ID, MQTT_EXAMPLE_CLIENT_ID),
+            sizeof(userConfig.clientId) - 1);
+    strncpy(userConfig.username, ConfigStore_GetStr(CONFIG_KEY_MQTT_USER, MQTT_EXAMPLE_USERNAME),
+            sizeof(userConfig.username) - 1);
+    strncpy(userConfig.password, ConfigStore_GetStr(CONFIG_KEY_MQTT_PASS, MQTT_EXAMPLE_PASSWORD),
+            sizeof(userConfig.password) - 1);
     
-    /* 6. 配置Broker */
-    ret = MQTT_SetBroker(MQTT_EXAMPLE_BROKER, MQTT_EXAMPLE_PORT, 1);
-		if (ret != MQTT_OK)
-		{
-			LOG_E("MQTT", "Set Broker failed!");
-			////return -1;
-		}
+    /* 4. 模块空闲休眠策略, MQTT心跳与之匹配 */
+    ESP8266_SetSleepPolicy(ESP8266_SLEEP_POLICY);
     
-    /* 7. 连接 */
-    ret = MQTT_Connect();
+    /* 5. 配置并连接Broker (模块仍连着同一个Broker时跳过), 订阅主题 */
+    ret = Boot_Mqtt(&userConfig, ConfigStore_GetStr(CONFIG_KEY_MQTT_HOST, MQTT_EXAMPLE_BROKER),
+                    (uint16_t)ConfigStore_GetU32(CONFIG_KEY_MQTT_PORT, MQTT_EXAMPLE_PORT),
+                    ESP8266_SleepKeepAlive(mqtt.connConfig.keepAlive),
+                    appTopics, sizeof(appTopics) / sizeof(appTopics[0]));
     if (ret == MQTT_OK) {
         LOG_I("MQTT", "Connected to broker!");
-        
-        /* 8. 订阅控制主题 */
-        ret = MQTT_Subscribe(MQTT_TOPIC_CONTROL, MQTT_QOS_1);
-        if (ret == MQTT_OK) {
-            LOG_I("MQTT", "Subscribed to %s", MQTT_TOPIC_CONTROL);
-        } else {
-            LOG_E("MQTT", "Subscribe failed!");
-        }
     }
+    
+    /* 后台采样回到主循环 */
+    Boot_Finish();
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -214,38 +339,190 @@ int main(void)
   while (1)
   {
 		//ESP8266_MainLoop();
-		float temperature, humidity;
-		char buffer[128];
-		uint16_t light_value = 0;
+		char buffer[256];
+		SensorHub_Sample_t sample;
+		uint8_t streaming = 0;  /* 本轮发送了分块应答, 下一块按固定间隔继续 */
+		
+		/* 订阅消息由中断暂存, 醒来后先分发, 不等MQTT处理周期 */
+		CrashLog_SetState(APP_STATE_MQTT_SERVICE);
+		MQTT_ProcessPending();
+		
+		CrashLog_SetState(APP_STATE_SAMPLE);
     
-		/* ========== 读取光敏传感器 ========== */
-		/* LS1传感器特性：亮时ADC值小，暗时ADC值大，所以需要反转 */
-		light_value = 4095 - LightSensor_GetValue();
+#if FLICKER_ENABLE
+		/* ========== 频闪分析 (只发布特征值, 不发送原始采样) ========== */
+		/* 先处理上一轮的采集结果, 同时归还ADC3给光敏传感器 */
+		Flicker_Result_t flickerResult;
+		if (Flicker_Process(&flickerResult) == FLICKER_OK) {
+			Flicker_FormatJson(&flickerResult, buffer, sizeof(buffer));
+			LOG_TI("MQTT", "%s", LOG_STR(buffer));
+			MQTT_Publish(MQTT_TOPIC_FLICKER, buffer, MQTT_QOS_0, 0);
+		}
+#endif
 		
-		/* ========== 读取DHT11温湿度传感器 ========== */
-    DHT11_Status_t dht_status = DHT11_Read(&temperature, &humidity);
+		/* ========== 传感器错峰采样 (不阻塞) ========== */
+		SensorHub_Poll();
 		
-		if (dht_status == DHT11_OK) {
-			/* 构建包含所有传感器数据的JSON */
-			snprintf(buffer, sizeof(buffer), 
-				"{\"temp\":%.1f,\"humi\":%.1f,\"light\":%d}", 
-				temperature, humidity, light_value);
-			LOG_I("MQTT", "%s", buffer);
- 
-        
-        /* 发布到MQTT */
-        MQTT_Publish(MQTT_TOPIC_SENSOR_DATA, buffer, MQTT_QOS_0, 0);
-    } else {
-        /* DHT11读取失败，只发布光照数据 */
-        snprintf(buffer, sizeof(buffer), "{\"light\":%d}", light_value);
-        HAL_UART_Transmit(&huart1, (uint8_t*)buffer, strlen(buffer), 100);
-        HAL_UART_Transmit(&huart1, (uint8_t*)"\r\n", 2, 100);
-        MQTT_Publish(MQTT_TOPIC_SENSOR_DATA, buffer, MQTT_QOS_0, 0);
+		/* 消费统一样本队列: 写入时序存储, 并送入变化检测 */
+		while (SensorHub_Pop(&sample) == SENSOR_HUB_OK) {
+			const char *key = SensorHub_GetKey(sample.sensorId, sample.channel);
+			TimeSeries_Record(key, sample.timestamp, sample.value);
+			Report_Offer(key, sample.value);
+			SensorHub_EncodeValue(sample.sensorId, sample.channel, sample.value, buffer, sizeof(buffer));
+			LOG_TV("SENSOR", "%s.%s=%s @%lu", SensorHub_GetName(sample.sensorId),
+			      SensorHub_GetKey(sample.sensorId, sample.channel), LOG_STR(buffer),
+			      (unsigned long)sample.timestamp);
+		}
+		
+		/* ========== 按例外上报: 只发布越过死区或心跳到期的通道 ========== */
+		CrashLog_SetState(APP_STATE_PUBLISH);
+		if (Report_FormatDue(buffer, sizeof(buffer)) > 0) {
+			LOG_TI("MQTT", "%s", LOG_STR(buffer));
+			if (MQTT_Publish(MQTT_TOPIC_SENSOR_DATA, buffer, MQTT_QOS_0, 0) == MQTT_OK) {
+				Boot_Mark(BOOT_STAGE_PUBLISH);
+			}
+		}
+		
+		/* 周期发布各通道抑制统计, 用于调整死区 */
+		if (HAL_GetTick() - reportStatsTick >= REPORT_STATS_PERIOD_MS) {
+			reportStatsTick = HAL_GetTick();
+			Report_FormatStats(buffer, sizeof(buffer));
+			MQTT_Publish(MQTT_TOPIC_REPORT_STATS, buffer, MQTT_QOS_0, 0);
+		}
+		
+		if (HAL_GetTick() - mqttServiceTick >= MQTT_SERVICE_PERIOD_MS) {
+			mqttServiceTick = HAL_GetTick();
+			CrashLog_SetState(APP_STATE_MQTT_SERVICE);
+			
+			/* 检查连接事件和同步收到的订阅消息 (响应缓冲区只在下一条AT命令时清空, 按发布周期处理) */
+			MQTT_ProcessData();
+			
+			/* 上次复位前的故障记录, 发布成功后清除, 失败则下个周期重试 */
+			if (CrashLog_HasRecord() && MQTT_IsConnected()) {
+				PublishCrashReport();
+			}
+		}
+		
+		/* 远程日志到期时攒批发布 */
+		LogMqtt_Poll();
+		
+		/* 主栈高水位扫描 (余量不足时告警) */
+		StackMon_Poll();
+		
+		/* 健康指标到期时发布 */
+		Metrics_Poll();
+		
+		/* 日志级别修改后回报当前级别表 */
+		if (logLevelsPending) {
+			logLevelsPending = 0;
+			LOG_FormatLevels(buffer, sizeof(buffer));
+			MQTT_Publish(MQTT_TOPIC_LOG_LEVELS, buffer, MQTT_QOS_0, 0);
+			streaming = 1;
+		}
+		
+		/* ========== 时序查询应答 (每轮发送一块) ========== */
+		CrashLog_SetState(APP_STATE_TS_QUERY);
+		Scratch_Mark_t chunkMark = Scratch_Mark();
+		char *chunk = Scratch_Alloc(RESP_CHUNK_SIZE);
+		if (chunk != NULL && TimeSeries_NextChunk(chunk, RESP_CHUNK_SIZE) > 0) {
+			MQTT_Publish(MQTT_TOPIC_TS_DATA, chunk, MQTT_QOS_0, 0);
+			streaming = 1;
+		}
+		
+		/* 性能剖析应答 (每轮发送一个区段) */
+		if (chunk != NULL && Prof_NextChunk(chunk, RESP_CHUNK_SIZE) > 0) {
+			MQTT_Publish(MQTT_TOPIC_PROF_DATA, chunk, MQTT_QOS_0, 0);
+			streaming = 1;
+		}
+		
+		/* 控制路径时延统计 (一条) */
+		if (ctrlLatencyPending) {
+			ctrlLatencyPending = 0;
+			if (chunk != NULL && CtrlLatency_Format(chunk, RESP_CHUNK_SIZE) > 0) {
+				MQTT_Publish(MQTT_TOPIC_PROF_DATA, chunk, MQTT_QOS_0, 0);
+			}
+			streaming = 1;
+		}
+		
+		/* 主栈水位 (一条) */
+		if (stackReportPending) {
+			stackReportPending = 0;
+			if (chunk != NULL && StackMon_FormatJson(chunk, RESP_CHUNK_SIZE) > 0) {
+				MQTT_Publish(MQTT_TOPIC_PROF_DATA, chunk, MQTT_QOS_0, 0);
+			}
+			streaming = 1;
+		}
+		
+		/* 启动时间线 (一条) */
+		if (bootReportPending) {
+			bootReportPending = 0;
+			if (chunk != NULL && Boot_FormatJson(chunk, RESP_CHUNK_SIZE) > 0) {
+				MQTT_Publish(MQTT_TOPIC_PROF_DATA, chunk, MQTT_QOS_0, 0);
+			}
+			streaming = 1;
+		}
+		
+		/* 入网路径与各路径到获得IP的耗时 */
+		if (wifiReportPending) {
+			wifiReportPending = 0;
+			if (chunk != NULL && ESP8266_FormatJoinJson(chunk, RESP_CHUNK_SIZE) > 0) {
+				MQTT_Publish(MQTT_TOPIC_PROF_DATA, chunk, MQTT_QOS_0, 0);
+			}
+			streaming = 1;
+		}
+		
+		/* 配置应答: 写入结果或当前配置 (JSON较长, 单独申请), 需要时发布后复位 */
+		if (configPending) {
+			configPending = 0;
+			if (configReply[0] != '\0') {
+				MQTT_Publish(MQTT_TOPIC_CONFIG_DATA, configReply, MQTT_QOS_1, 0);
+			} else {
+				char *json = Scratch_Alloc(CONFIG_JSON_SIZE);
+				if (json != NULL && ConfigStore_FormatJson(json, CONFIG_JSON_SIZE) > 0) {
+					MQTT_Publish(MQTT_TOPIC_CONFIG_DATA, json, MQTT_QOS_1, 0);
+				}
+			}
+			if (configRebootPending) {
+				LOG_W("CONFIG", "Rebooting to apply config");
+				LOG_Flush();
+				NVIC_SystemReset();
+			}
+		}
+		
+#if PUB_BENCH_ENABLE
+		/* 发布吞吐基准 (阻塞, CSV 输出到日志) */
+		if (pubBenchPending) {
+			pubBenchPending = 0;
+			PubBench_RunDefault();
+		}
+#endif
+		
+		/* 周期发布AT命令统计 (每轮发送一个命令动词) */
+		if (HAL_GetTick() - atStatsTick >= AT_STATS_PERIOD_MS) {
+			atStatsTick = HAL_GetTick();
+			ESP8266_StartStatsQuery();
+		}
+		if (chunk != NULL && ESP8266_NextStatsChunk(chunk, RESP_CHUNK_SIZE) > 0) {
+			MQTT_Publish(MQTT_TOPIC_AT_STATS, chunk, MQTT_QOS_0, 0);
+			streaming = 1;
+		}
+		Scratch_Release(chunkMark);
+    
+#if FLICKER_ENABLE
+    /* 周期性启动一次高速采集, 在下面的延时期间由DMA完成 */
+    if (flickerLastTick == 0 || HAL_GetTick() - flickerLastTick >= FLICKER_CAPTURE_PERIOD_MS) {
+        if (Flicker_StartCapture() == FLICKER_OK) {
+            flickerLastTick = HAL_GetTick();
+        }
     }
-    /* 处理MQTT订阅消息 */
-    MQTT_ProcessData();
+#endif
     
-    HAL_Delay(5000);  /* 每5秒读取一次 */
+    /* 本轮的发布与应答都已完成, ESP8266进入休眠 (Modem-sleep 只在第一轮发送休眠命令) */
+    ESP8266_SleepPoll();
+    
+    /* 睡到下一个截止时间, 期间ESP8266数据等中断会提前唤醒 */
+    CrashLog_SetState(APP_STATE_IDLE);
+    Power_Idle(App_IdleBudget(streaming));
 		
     /* USER CODE END WHILE */
 
@@ -305,6 +582,70 @@ void SystemClock_Config(void)
 
 /* USER CODE BEGIN 4 */
 
+/**
+  * @brief  与周期任务的剩余时间取较小值
+  * @param  budget 当前空闲时间 (ms)
+  * @param  last 任务上次执行时间
+  * @param  period 任务周期 (ms)
+  * @retval uint32_t 较小值, 任务已到期返回0
+  */
+static uint32_t App_Earlier(uint32_t budget, uint32_t last, uint32_t period)
+{
+    uint32_t elapsed = HAL_GetTick() - last;
+
+    if (elapsed >= period) {
+        return 0;
+    }
+    return (period - elapsed < budget) ? period - elapsed : budget;
+}
+
+/**
+  * @brief  计算本轮可以空闲的时间: 取各截止时间的最小值
+  * @param  streaming 本轮发送了分块应答
+  * @retval uint32_t 毫秒, 上限由 Power_Idle 限制
+  * @note   远程日志/健康指标等没有登记截止时间, 最多延后 POWER_MAX_IDLE_MS
+  */
+static uint32_t App_IdleBudget(uint8_t streaming)
+{
+    uint32_t budget = SensorHub_TimeToNext();
+    uint32_t espNext = ESP8266_SleepTimeToNext();
+
+    /* 本轮处理期间又收到订阅消息: 不进入空闲, 下一轮开头立即分发 */
+    if (MQTT_HasPending()) {
+        return 0;
+    }
+
+    if (espNext < budget) {
+        budget = espNext;
+    }
+
+    /* 分块应答需要按原来的主循环间隔继续发送 */
+    if (streaming && budget > MAIN_LOOP_INTERVAL_MS) {
+        budget = MAIN_LOOP_INTERVAL_MS;
+    }
+#if FLICKER_ENABLE
+    /* 采集进行中时按主循环间隔检查是否完成 */
+    if (Flicker_IsBusy() && budget > MAIN_LOOP_INTERVAL_MS) {
+        budget = MAIN_LOOP_INTERVAL_MS;
+    }
+    budget = App_Earlier(budget, flickerLastTick, FLICKER_CAPTURE_PERIOD_MS);
+#endif
+
+    budget = App_Earlier(budget, mqttServiceTick, MQTT_SERVICE_PERIOD_MS);
+    budget = App_Earlier(budget, reportStatsTick, REPORT_STATS_PERIOD_MS);
+    budget = App_Earlier(budget, atStatsTick, AT_STATS_PERIOD_MS);
+
+    return budget;
+}
+
+/**
+  * @brief  启动期间等待ESP8266时运行: 按调度采样, 样本留在队列中由主循环消费
+  */
+static void App_BootBackground(void)
+{
+    SensorHub_Poll();
+}
+
 /**
   * @brief  MQTT连接成功回调
   */
@@ -321,42 +662,6 @@ void OnMQTTDisconnected(void)
     LOG_W("MQTT", "Disconnected callback!");
 }
 
-/**
-  * @brief  JSON解析辅助函数 - 获取布尔值
-  * @param  json: JSON字符串
-  * @param  key: 要查找的键名
-  * @param  value: 输出布尔值 (1=true, 0=false)
-  * @retval 0=成功, -1=未找到键, -2=解析失败
-  */
-static int JSON_GetBoolValue(const char *json, const char *key, uint8_t *value)
-{
-    if (!json || !key || !value) return -2;
-    
-    /* 构建搜索模式 "key": */
-    char pattern[64];
-    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
-    
-    char *ptr = strstr(json, pattern);
-    if (!ptr) return -1;  /* 未找到键 */
-    
-    /* 跳过 "key": */
-    ptr += strlen(pattern);
-    
-    /* 跳过空格 */
-    while (*ptr == ' ') ptr++;
-    
-    /* 解析值 */
-    if (strncmp(ptr, "true", 4) == 0 || strncmp(ptr, "1", 1) == 0) {
-        *value = 1;
-        return 0;
-    } else if (strncmp(ptr, "false", 5) == 0 || strncmp(ptr, "0", 1) == 0) {
-        *value = 0;
-        return 0;
-    }
-    
-    return -2;  /* 解析失败 */
-}
-
 /**
   * @brief  MQTT消息接收回调
   * @param  message: 接收到的消息
@@ -372,50 +677,76 @@ void OnMQTTMessageReceived(MQTT_Message_t *message)
     LOG_D("MQTT", "Topic: %s", message->topic);
     LOG_D("MQTT", "Data: %s", message->data);
     
-    /* 处理控制命令 */
+    /* 处理控制命令, 如 {"led1":true} */
     if (strcmp(message->topic, MQTT_TOPIC_CONTROL) == 0) {
-        uint8_t boolValue;
-        char *jsonData = (char *)message->data;
-        
-        /* ========== LED1控制 (PF9) ========== */
-        /* JSON格式: {"led1":true} 或 {"led1":false} */
-        if (JSON_GetBoolValue(jsonData, "led1", &boolValue) == 0) {
-            HAL_GPIO_WritePin(LED1_GPIO_Port, LED1_Pin, 
-                              boolValue ? GPIO_PIN_SET : GPIO_PIN_RESET);
-            LOG_I("Control", "LED1 -> %s", boolValue ? "ON" : "OFF");
-        }
-        
-        /* ========== LED2控制 (PF10) ========== */
-        /* JSON格式: {"led2":true} 或 {"led2":false} */
-        if (JSON_GetBoolValue(jsonData, "led2", &boolValue) == 0) {
-            HAL_GPIO_WritePin(LED2_GPIO_Port, LED2_Pin, 
-                              boolValue ? GPIO_PIN_SET : GPIO_PIN_RESET);
-            LOG_I("Control", "LED2 -> %s", boolValue ? "ON" : "OFF");
+        Control_Handle((char *)message->data);
+    }
+    
+    /* 处理时序查询, 应答在主循环中分块发布 */
+    if (strcmp(message->topic, MQTT_TOPIC_TS_QUERY) == 0) {
+        TimeSeries_Status_t tsStatus = TimeSeries_RequestQuery((char *)message->data);
+        if (tsStatus != TIMESERIES_OK) {
+            LOG_W("TS", "Query rejected: %d", tsStatus);
         }
-        
-        /* ========== LED3控制 (PE13) ========== */
-        /* JSON格式: {"led3":true} 或 {"led3":false} */
-        if (JSON_GetBoolValue(jsonData, "led3", &boolValue) == 0) {
-            HAL_GPIO_WritePin(LED3_GPIO_Port, LED3_Pin, 
-                              boolValue ? GPIO_PIN_SET : GPIO_PIN_RESET);
-            LOG_I("Control", "LED3 -> %s", boolValue ? "ON" : "OFF");
+    }
+    
+    /* 按标签设置日志级别, 如 {"*":"info","ESP8266":"debug"}, 应答在主循环中发布 */
+    if (strcmp(message->topic, MQTT_TOPIC_LOG_LEVEL) == 0) {
+        if (LOG_SetLevels((char *)message->data) < 0) {
+            LOG_W("LOG", "Invalid level config");
         }
-        
-        /* ========== LED4控制 (PE14) ========== */
-        /* JSON格式: {"led4":true} 或 {"led4":false} */
-        if (JSON_GetBoolValue(jsonData, "led4", &boolValue) == 0) {
-            HAL_GPIO_WritePin(LED4_GPIO_Port, LED4_Pin, 
-                              boolValue ? GPIO_PIN_SET : GPIO_PIN_RESET);
-            LOG_I("Control", "LED4 -> %s", boolValue ? "ON" : "OFF");
+        logLevelsPending = 1;
+    }
+    
+    /* 性能剖析: "log" 输出到日志, "reset" 清空统计, "ctrl" 发布控制路径时延,
+     * "stack" 发布主栈水位, "boot" 发布启动时间线, "wifi" 发布入网耗时, "bench" 运行发布吞吐基准 (PUB_BENCH_ENABLE),
+     * 其余按区段分块发布 */
+    if (strcmp(message->topic, MQTT_TOPIC_PROF_QUERY) == 0) {
+        if (strcmp((char *)message->data, "log") == 0) {
+            Prof_Dump();
+            CtrlLatency_Dump();
+        } else if (strcmp((char *)message->data, "reset") == 0) {
+            Prof_Reset();
+            CtrlLatency_Reset();
+            LOG_I("PROF", "Statistics cleared");
+        } else if (strcmp((char *)message->data, "ctrl") == 0) {
+            ctrlLatencyPending = 1;
+        } else if (strcmp((char *)message->data, "stack") == 0) {
+            stackReportPending = 1;
+        } else if (strcmp((char *)message->data, "boot") == 0) {
+            bootReportPending = 1;
+        } else if (strcmp((char *)message->data, "wifi") == 0) {
+            wifiReportPending = 1;
+#if PUB_BENCH_ENABLE
+        } else if (strcmp((char *)message->data, "bench") == 0) {
+            pubBenchPending = 1;
+#endif
+        } else {
+            Prof_StartQuery();
         }
-        
-        /* ========== 蜂鸣器控制 (PF8) ========== */
-        /* JSON格式: {"beep":true} 或 {"beep":false} */
-        if (JSON_GetBoolValue(jsonData, "beep", &boolValue) == 0) {
-            HAL_GPIO_WritePin(BEEP_GPIO_Port, BEEP_Pin, 
-                              boolValue ? GPIO_PIN_SET : GPIO_PIN_RESET);
-            LOG_I("Control", "BEEP -> %s", boolValue ? "ON" : "OFF");
+    }
+    
+    /* 配置: JSON对象写入 (如 {"wifi.ssid":"lab","sample.dht11":5000}, null 删除),
+     * "get" 查询当前配置, "reset" 恢复出厂, "reboot" 复位使配置生效;
+     * WiFi/MQTT 参数在下次连接时生效, 采样周期与死区在复位后生效 */
+    if (strcmp(message->topic, MQTT_TOPIC_CONFIG_SET) == 0) {
+        configReply[0] = '\0';
+        if (message->data[0] == '{') {
+            if (ConfigStore_ApplyJson((char *)message->data, configReply, sizeof(configReply)) < 0) {
+                LOG_W("CONFIG", "Invalid config JSON");
+                snprintf(configReply, sizeof(configReply), "{\"err\":\"format\"}");
+            }
+        } else if (strcmp((char *)message->data, "reset") == 0) {
+            snprintf(configReply, sizeof(configReply), "{\"reset\":%d}",
+                     ConfigStore_Erase() == CONFIG_STORE_OK);
+        } else if (strcmp((char *)message->data, "reboot") == 0) {
+            snprintf(configReply, sizeof(configReply), "{\"reboot\":1}");
+            configRebootPending = 1;
+        } else if (strcmp((char *)message->data, "get") != 0) {
+            LOG_W("CONFIG", "Unknown command: %s", (char *)message->data);
+            return;
         }
+        configPending = 1;
     }
 }
 
@@ -437,6 +768,38 @@ void OnMQTTError(MQTT_Status_t error)
     LOG_E("MQTT", "Error: %d", error);
 }
 
+/**
+  * @brief  发布上次复位前的故障记录 (JSON摘要 + 日志尾部), 成功后清除记录
+  */
+static void PublishCrashReport(void)
+{
+    Scratch_Mark_t mark = Scratch_Mark();
+    char *report = Scratch_Alloc(CRASH_LOG_REPORT_SIZE);
+    const uint8_t *tail;
+    uint16_t tailLen;
+    
+    if (report == NULL || CrashLog_FormatReport(report, CRASH_LOG_REPORT_SIZE) <= 0) {
+        Scratch_Release(mark);
+        return;
+    }
+    
+    /* 保留消息, 监控端晚于设备上线也能看到 */
+    if (MQTT_Publish(MQTT_TOPIC_CRASH, report, MQTT_QOS_1, 1) != MQTT_OK) {
+        Scratch_Release(mark);
+        return;
+    }
+    Scratch_Release(mark);
+    
+    /* 日志尾部可能含令牌化帧, 原样发布, 由 Tools/log_decode.py 解码 */
+    tail = CrashLog_GetLog(&tailLen);
+    if (tailLen > 0 && MQTT_PublishRaw(MQTT_TOPIC_CRASH_LOG, tail, tailLen, MQTT_QOS_1, 1) != MQTT_OK) {
+        return;
+    }
+    
+    LOG_I("CRASH", "Post-mortem published");
+    CrashLog_Clear();
+}
+
 /* USER CODE END 4 */
 
 /**
@@ -449,6 +812,14 @@ void Error_Handler(void)
   /* User can add his own implementation to report the HAL error return state */
   __disable_irq();
 	LOG_E("Error_Handler", "Error occurrence!");
+  /* 先把现场写入RAM (含上面这条日志), 再阻塞发出串口缓冲区 */
+  CrashLog_Capture(CRASH_REASON_ERROR_HANDLER, CRASH_LOG_RETURN_ADDRESS());
+  LOG_Flush();
+  /* 连续故障复位达到上限 (如外设初始化持续失败) 或连着调试器时停在这里 */
+  if (CrashLog_ResetAllowed())
+  {
+    NVIC_SystemReset();
+  }
   while (1)
   {
   }
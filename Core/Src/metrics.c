@@ -0,0 +1,192 @@
+/**
+  ******************************************************************************
+  * @file           : metrics.c
+  * @brief          : 设备健康指标注册表源文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 注册只在初始化阶段进行, 注册表本身不加锁; 指标值的更新走原子操作,
+  * 编码时逐个读取, 不要求各指标之间是同一时刻的快照。
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "metrics.h"
+#include "esp8266_mqtt.h"
+#include "scratch.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private variables ---------------------------------------------------------*/
+
+/* 指标注册表句柄实例 */
+Metrics_Handle_t metrics = {0};
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  注册指标
+  */
+uint8_t Metrics_Register(Metric_t *metric)
+{
+    uint8_t i;
+
+    if (metric == NULL || metric->name == NULL) {
+        return 0;
+    }
+
+    for (i = 0; i < metrics.count; i++) {
+        if (metrics.metrics[i] == metric) {
+            return 1;
+        }
+    }
+
+    if (metrics.count >= METRICS_MAX) {
+        return 0;
+    }
+
+    metric->reported = Metrics_Get(metric);
+    metric->pending = metric->reported;
+    metrics.metrics[metrics.count++] = metric;
+    return 1;
+}
+
+/**
+  * @brief  读取指标当前值
+  */
+uint32_t Metrics_Get(const Metric_t *metric)
+{
+    return (metric->source != NULL) ? *metric->source : metric->value;
+}
+
+/**
+  * @brief  按名称查找指标
+  */
+Metric_t* Metrics_Find(const char *name)
+{
+    uint8_t i;
+
+    for (i = 0; name != NULL && i < metrics.count; i++) {
+        if (strcmp(metrics.metrics[i]->name, name) == 0) {
+            return metrics.metrics[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+  * @brief  设置发布主题
+  */
+uint8_t Metrics_Init(const char *topic)
+{
+    if (topic == NULL || strlen(topic) >= METRICS_TOPIC_LEN) {
+        return 0;
+    }
+
+    strcpy(metrics.topic, topic);
+    metrics.lastTick = HAL_GetTick();
+    metrics.initialized = 1;
+    return 1;
+}
+
+/**
+  * @brief  把全部指标编码为JSON
+  */
+int Metrics_Format(char *buf, uint16_t size, uint8_t delta)
+{
+    Metric_t *metric;
+    uint32_t value;
+    uint8_t i;
+    int len, n;
+
+    if (buf == NULL || size == 0) {
+        return 0;
+    }
+
+    len = snprintf(buf, size, "{\"up\":%lu,\"seq\":%lu,\"delta\":%u,\"m\":{",
+                   (unsigned long)(HAL_GetTick() / 1000), (unsigned long)metrics.seq, delta ? 1 : 0);
+    if (len < 0 || len >= size) {
+        buf[0] = '\0';
+        return 0;
+    }
+
+    for (i = 0; i < metrics.count; i++) {
+        metric = metrics.metrics[i];
+        metric->pending = Metrics_Get(metric);
+
+        value = metric->pending;
+        if (delta && metric->type == METRIC_COUNTER) {
+            value -= metric->reported;
+        }
+
+        n = snprintf(buf + len, size - len, "%s\"%s\":%lu", i ? "," : "", metric->name, (unsigned long)value);
+        if (n < 0 || len + n >= size) {
+            buf[0] = '\0';
+            return 0;
+        }
+        len += n;
+    }
+
+    n = snprintf(buf + len, size - len, "}}");
+    if (n < 0 || len + n >= size) {
+        buf[0] = '\0';
+        return 0;
+    }
+
+    return len + n;
+}
+
+/**
+  * @brief  发布成功后更新增量基准
+  */
+void Metrics_Commit(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < metrics.count; i++) {
+        metrics.metrics[i]->reported = metrics.metrics[i]->pending;
+    }
+    metrics.seq++;
+}
+
+/**
+  * @brief  到期时发布
+  */
+void Metrics_Poll(void)
+{
+    Scratch_Mark_t mark;
+    char *json;
+    int len;
+
+    if (!metrics.initialized || HAL_GetTick() - metrics.lastTick < METRICS_PERIOD_MS) {
+        return;
+    }
+
+    if (!MQTT_IsConnected()) {
+        return;
+    }
+    metrics.lastTick = HAL_GetTick();
+
+    /* JSON缓冲区在共享区, 发布后释放 */
+    mark = Scratch_Mark();
+    json = Scratch_Alloc(METRICS_JSON_SIZE);
+    len = json ? Metrics_Format(json, METRICS_JSON_SIZE, METRICS_REPORT_DELTA) : 0;
+    if (len <= 0) {
+        metrics.failures++;
+        Scratch_Release(mark);
+        return;
+    }
+
+    /* 保留消息: 看板随时订阅都能拿到最近一次的健康状态 */
+    if (MQTT_PublishRaw(metrics.topic, (const uint8_t *)json, (uint16_t)len, MQTT_QOS_0, 1) == MQTT_OK) {
+        Metrics_Commit();
+    } else {
+        metrics.failures++;
+    }
+    Scratch_Release(mark);
+}
+
+/* End of file ---------------------------------------------------------------*/
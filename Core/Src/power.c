@@ -0,0 +1,481 @@
+/**
+  ******************************************************************************
+  * @file           : power.c
+  * @brief          : 低功耗空闲管理源文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 工程未启用HAL RTC/TIM模块, RTC与TIM5均直接操作寄存器。
+  *
+  * 进入空闲前关中断 (PRIMASK=1) 再检查/配置唤醒源并执行WFI: 挂起的中断
+  * 即使被屏蔽也能唤醒内核, 醒来后先补偿 uwTick 再开中断, 中断服务函数
+  * 里读到的 HAL_GetTick() 已经是补偿后的时间。
+  *
+  * 经过的时间由RTC日历 (时分秒 + 亚秒) 前后两次读数相减得到, 不依赖
+  * 唤醒原因; 不足1ms的部分累积到下一次, 长期不漂移。
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "power.h"
+#include "usart.h"
+#include "atomic_ops.h"
+#include "metrics.h"
+#include "log.h"
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+/* RTC 写保护解锁序列 */
+#define POWER_RTC_KEY1              0xCAU
+#define POWER_RTC_KEY2              0x53U
+
+/* 等待RTC标志的最大轮询次数 (唤醒定时器写允许最多2个RTCCLK) */
+#define POWER_RTC_WAIT_LOOPS        100000U
+
+/* LSI测量: 捕获预分频8, 每次捕获间隔8个LSI周期 */
+#define POWER_LSI_CAPTURE_DIV       8
+#define POWER_LSI_TIMEOUT_MS        10
+
+/* 一天的秒数, RTC时间回绕用 */
+#define POWER_SECONDS_PER_DAY       86400UL
+
+/* Private variables ---------------------------------------------------------*/
+
+/* 功耗管理句柄实例 */
+Power_Handle_t power = {0};
+
+/* 健康指标: 各模式驻留时间 */
+static Metric_t sleepMsMetric = METRIC_SOURCE_INIT("pm.sleep_ms", METRIC_COUNTER, &power.stats.ms[POWER_MODE_SLEEP]);
+static Metric_t ticklessMsMetric = METRIC_SOURCE_INIT("pm.tickless_ms", METRIC_COUNTER, &power.stats.ms[POWER_MODE_TICKLESS]);
+static Metric_t stopMsMetric = METRIC_SOURCE_INIT("pm.stop_ms", METRIC_COUNTER, &power.stats.ms[POWER_MODE_STOP]);
+static Metric_t stopCountMetric = METRIC_SOURCE_INIT("pm.stop", METRIC_COUNTER, &power.stats.entries[POWER_MODE_STOP]);
+static Metric_t earlyWakeMetric = METRIC_SOURCE_INIT("pm.early_wake", METRIC_COUNTER, &power.stats.earlyWakes);
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t Power_MeasureLsi(void);
+static Power_Status_t Power_RtcInit(void);
+static uint8_t Power_RtcWait(uint32_t flag);
+static uint32_t Power_RtcNow(void);
+static void Power_RtcArm(uint32_t ms);
+static uint8_t Power_RtcDisarm(void);
+static uint8_t Power_StopAllowed(uint32_t ms);
+static void Power_EnterStop(void);
+static void Power_SleepTicked(uint32_t ms);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  用TIM5 CH4捕获LSI测量其频率
+  * @retval uint32_t LSI频率 (Hz), 失败返回0
+  */
+static uint32_t Power_MeasureLsi(void)
+{
+    uint32_t timClk, first = 0, second = 0;
+    uint32_t start;
+    uint8_t captured = 0;
+
+    /* APB1预分频不为1时定时器时钟为PCLK1的2倍 */
+    timClk = HAL_RCC_GetPCLK1Freq();
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1) {
+        timClk *= 2;
+    }
+
+    __HAL_RCC_TIM5_CLK_ENABLE();
+    TIM5->CR1 = 0;
+    TIM5->PSC = 0;
+    TIM5->ARR = 0xFFFFFFFFU;
+    TIM5->OR = TIM_OR_TI4_RMP_0;                        /* TI4 <- LSI */
+    TIM5->CCMR2 = TIM_CCMR2_CC4S_0 | TIM_CCMR2_IC4PSC;  /* CC4捕获TI4, 每8个上升沿一次 */
+    TIM5->CCER = TIM_CCER_CC4E;
+    TIM5->EGR = TIM_EGR_UG;
+    TIM5->SR = 0;
+    TIM5->CR1 = TIM_CR1_CEN;
+
+    start = HAL_GetTick();
+    while (captured < 2 && HAL_GetTick() - start < POWER_LSI_TIMEOUT_MS) {
+        if (TIM5->SR & TIM_SR_CC4IF) {
+            /* 读CCR4同时清除CC4IF */
+            if (captured++ == 0) {
+                first = TIM5->CCR4;
+            } else {
+                second = TIM5->CCR4;
+            }
+        }
+    }
+
+    TIM5->CR1 = 0;
+    TIM5->CCER = 0;
+    TIM5->OR = 0;
+    __HAL_RCC_TIM5_CLK_DISABLE();
+
+    if (captured < 2 || second == first) {
+        return 0;
+    }
+
+    return (uint32_t)((uint64_t)timClk * POWER_LSI_CAPTURE_DIV / (second - first));
+}
+
+/**
+  * @brief  等待RTC ISR中的标志置位
+  * @retval uint8_t 1=置位 0=超时
+  */
+static uint8_t Power_RtcWait(uint32_t flag)
+{
+    uint32_t loops = POWER_RTC_WAIT_LOOPS;
+
+    while (!(RTC->ISR & flag)) {
+        if (--loops == 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+  * @brief  RTC切换到LSI, 设置亚秒计数, 使能唤醒中断
+  */
+static Power_Status_t Power_RtcInit(void)
+{
+    uint32_t start;
+
+    /* 开启LSI */
+    __HAL_RCC_LSI_ENABLE();
+    start = HAL_GetTick();
+    while (!__HAL_RCC_GET_FLAG(RCC_FLAG_LSIRDY)) {
+        if (HAL_GetTick() - start > POWER_LSI_TIMEOUT_MS) {
+            return POWER_ERROR;
+        }
+    }
+
+    power.lsiHz = Power_MeasureLsi();
+    if (power.lsiHz < POWER_LSI_MIN_HZ || power.lsiHz > POWER_LSI_MAX_HZ) {
+        power.lsiHz = POWER_LSI_NOMINAL_HZ;
+    }
+    power.subHz = (power.lsiHz + POWER_RTC_ASYNC_DIV / 2) / POWER_RTC_ASYNC_DIV;
+
+    /* 备份域: 时钟源只能在备份域复位后更改 */
+    __HAL_RCC_PWR_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+    if ((RCC->BDCR & RCC_BDCR_RTCSEL) != RCC_BDCR_RTCSEL_1) {
+        if (RCC->BDCR & RCC_BDCR_RTCSEL) {
+            __HAL_RCC_BACKUPRESET_FORCE();
+            __HAL_RCC_BACKUPRESET_RELEASE();
+        }
+        RCC->BDCR |= RCC_BDCR_RTCSEL_1;                 /* RTCSEL=10: LSI */
+    }
+    __HAL_RCC_RTC_ENABLE();
+
+    RTC->WPR = POWER_RTC_KEY1;
+    RTC->WPR = POWER_RTC_KEY2;
+
+    /* 初始化模式下设置分频, 日历值保持不变 */
+    RTC->ISR = 0xFFFFFFFFU;
+    if (!Power_RtcWait(RTC_ISR_INITF)) {
+        RTC->WPR = 0xFF;
+        return POWER_ERROR;
+    }
+    RTC->PRER = power.subHz - 1;
+    RTC->PRER |= (uint32_t)(POWER_RTC_ASYNC_DIV - 1) << RTC_PRER_PREDIV_A_Pos;
+    RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+    RTC->CR |= RTC_CR_BYPSHAD;                          /* 直接读计数器, STOP醒来后无需等待RSF */
+    RTC->ISR &= ~RTC_ISR_INIT;
+    RTC->WPR = 0xFF;
+
+    /* RTC唤醒走EXTI22上升沿 */
+    EXTI->IMR |= EXTI_IMR_MR22;
+    EXTI->RTSR |= EXTI_RTSR_TR22;
+    EXTI->PR = EXTI_PR_PR22;
+    HAL_NVIC_SetPriority(RTC_WKUP_IRQn, 15, 0);
+    HAL_NVIC_EnableIRQ(RTC_WKUP_IRQn);
+
+#if POWER_STOP_ENABLE
+    /* STOP期间PB11下降沿唤醒, 只在进入STOP前后打开EXTI11屏蔽位 */
+    __HAL_RCC_SYSCFG_CLK_ENABLE();
+    SYSCFG->EXTICR[2] = (SYSCFG->EXTICR[2] & ~SYSCFG_EXTICR3_EXTI11) | SYSCFG_EXTICR3_EXTI11_PB;
+    HAL_NVIC_SetPriority(EXTI15_10_IRQn, 15, 0);
+    HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+#endif
+
+    return POWER_OK;
+}
+
+/**
+  * @brief  读取RTC当前时刻 (亚秒计数, 一天内单调)
+  */
+static uint32_t Power_RtcNow(void)
+{
+    uint32_t ssr, tr, sec;
+
+    /* BYPSHAD=1 时直接读计数器, 两次读数一致才说明中间没有进位 */
+    do {
+        ssr = RTC->SSR;
+        tr = RTC->TR;
+    } while (ssr != RTC->SSR || tr != RTC->TR);
+
+    sec = ((tr >> 20) & 0x3U) * 36000U + ((tr >> 16) & 0xFU) * 3600U +
+          ((tr >> 12) & 0x7U) * 600U + ((tr >> 8) & 0xFU) * 60U +
+          ((tr >> 4) & 0x7U) * 10U + (tr & 0xFU);
+
+    /* SSR 从 PREDIV_S 向下计数 */
+    return sec * power.subHz + (power.subHz - 1 - (ssr & RTC_SSR_SS));
+}
+
+/**
+  * @brief  启动RTC唤醒定时器
+  * @param  ms 唤醒时间
+  */
+static void Power_RtcArm(uint32_t ms)
+{
+    /* WUCKSEL=000: RTCCLK/16 */
+    uint32_t wut = (uint32_t)((uint64_t)ms * power.lsiHz / 16 / 1000);
+
+    if (wut == 0) {
+        wut = 1;
+    } else if (wut > 0x10000U) {
+        wut = 0x10000U;
+    }
+
+    RTC->WPR = POWER_RTC_KEY1;
+    RTC->WPR = POWER_RTC_KEY2;
+    RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+    Power_RtcWait(RTC_ISR_WUTWF);
+    RTC->WUTR = wut - 1;
+    RTC->CR &= ~RTC_CR_WUCKSEL;
+    RTC->ISR = ~(RTC_ISR_WUTF | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+    RTC->CR |= RTC_CR_WUTE | RTC_CR_WUTIE;
+    RTC->WPR = 0xFF;
+    EXTI->PR = EXTI_PR_PR22;
+}
+
+/**
+  * @brief  停止RTC唤醒定时器
+  * @retval uint8_t 1=定时已到 0=提前被其他中断唤醒
+  */
+static uint8_t Power_RtcDisarm(void)
+{
+    uint8_t expired = (RTC->ISR & RTC_ISR_WUTF) ? 1 : 0;
+
+    RTC->WPR = POWER_RTC_KEY1;
+    RTC->WPR = POWER_RTC_KEY2;
+    RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+    RTC->ISR = ~(RTC_ISR_WUTF | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+    RTC->WPR = 0xFF;
+    EXTI->PR = EXTI_PR_PR22;
+    HAL_NVIC_ClearPendingIRQ(RTC_WKUP_IRQn);
+
+    return expired;
+}
+
+/**
+  * @brief  判断本次空闲能否进入STOP
+  */
+static uint8_t Power_StopAllowed(uint32_t ms)
+{
+#if POWER_STOP_ENABLE
+    if (ms < POWER_STOP_MIN_MS || power.stopHold != 0) {
+        return 0;
+    }
+
+    /* 串口DMA发送进行中 (日志输出/AT命令), STOP会把传输截断 */
+    if (huart1.gState != HAL_UART_STATE_READY || huart3.gState != HAL_UART_STATE_READY) {
+        return 0;
+    }
+
+    return 1;
+#else
+    (void)ms;
+    return 0;
+#endif
+}
+
+/**
+  * @brief  进入STOP, 醒来后恢复PLL系统时钟
+  */
+static void Power_EnterStop(void)
+{
+    EXTI->FTSR |= EXTI_FTSR_TR11;
+    EXTI->PR = EXTI_PR_PR11;
+    EXTI->IMR |= EXTI_IMR_MR11;
+
+    HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+
+    EXTI->IMR &= ~EXTI_IMR_MR11;
+    EXTI->FTSR &= ~EXTI_FTSR_TR11;
+    EXTI->PR = EXTI_PR_PR11;
+    HAL_NVIC_ClearPendingIRQ(EXTI15_10_IRQn);
+
+    /* 醒来时运行在HSI上; PLL配置/分频/Flash等待周期都保留, 重新打开PLL即可.
+       SysTick已暂停, 这里不能用基于tick的超时 */
+    __HAL_RCC_PLL_ENABLE();
+    while (!__HAL_RCC_GET_FLAG(RCC_FLAG_PLLRDY)) {
+    }
+    __HAL_RCC_SYSCLK_CONFIG(RCC_SYSCLKSOURCE_PLLCLK);
+    while (__HAL_RCC_GET_SYSCLK_SOURCE() != RCC_SYSCLKSOURCE_STATUS_PLLCLK) {
+    }
+}
+
+/**
+  * @brief  保持SysTick, 逐拍WFI直到时间到
+  */
+static void Power_SleepTicked(uint32_t ms)
+{
+    uint32_t start = HAL_GetTick();
+    uint32_t elapsed;
+
+    while (HAL_GetTick() - start < ms) {
+        HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+    }
+
+    elapsed = HAL_GetTick() - start;
+    power.stats.ms[POWER_MODE_SLEEP] += elapsed;
+    power.stats.entries[POWER_MODE_SLEEP]++;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  初始化
+  */
+Power_Status_t Power_Init(void)
+{
+    Power_Status_t status;
+
+    memset(&power.stats, 0, sizeof(power.stats));
+    power.residue = 0;
+
+    status = Power_RtcInit();
+    power.rtcReady = (status == POWER_OK) ? 1 : 0;
+
+    Metrics_Register(&sleepMsMetric);
+    Metrics_Register(&ticklessMsMetric);
+    Metrics_Register(&stopMsMetric);
+    Metrics_Register(&stopCountMetric);
+    Metrics_Register(&earlyWakeMetric);
+
+    power.initialized = 1;
+
+    if (status == POWER_OK) {
+        LOG_I("POWER", "LSI %lu Hz, RTC sub-second %lu Hz", (unsigned long)power.lsiHz,
+              (unsigned long)power.subHz);
+    } else {
+        LOG_W("POWER", "RTC unavailable, ticked sleep only");
+    }
+
+    return status;
+}
+
+/**
+  * @brief  空闲到截止时间或被中断唤醒
+  */
+Power_Mode_t Power_Idle(uint32_t maxMs)
+{
+    Power_Mode_t mode;
+    uint32_t start, counts, elapsed;
+
+    if (maxMs == 0) {
+        return POWER_MODE_RUN;
+    }
+    if (maxMs > POWER_MAX_IDLE_MS) {
+        maxMs = POWER_MAX_IDLE_MS;
+    }
+
+    if (!power.initialized || !power.rtcReady || maxMs < POWER_TICKLESS_MIN_MS) {
+        Power_SleepTicked(maxMs);
+        return POWER_MODE_SLEEP;
+    }
+
+    __disable_irq();
+
+    mode = Power_StopAllowed(maxMs) ? POWER_MODE_STOP : POWER_MODE_TICKLESS;
+    Power_RtcArm(maxMs);
+    start = Power_RtcNow();
+    HAL_SuspendTick();
+
+    if (mode == POWER_MODE_STOP) {
+        Power_EnterStop();
+    } else {
+        HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+    }
+
+    /* 经过的亚秒计数, 跨零点时按一天回绕 */
+    counts = Power_RtcNow() + power.residue - start;
+    if ((int32_t)counts < 0) {
+        counts += POWER_SECONDS_PER_DAY * power.subHz;
+    }
+    elapsed = (uint32_t)((uint64_t)counts * 1000 / power.subHz);
+    power.residue = counts - (uint32_t)((uint64_t)elapsed * power.subHz / 1000);
+
+    if (!Power_RtcDisarm()) {
+        power.stats.earlyWakes++;
+    }
+
+    uwTick += elapsed;
+    HAL_ResumeTick();
+
+    power.stats.ms[mode] += elapsed;
+    power.stats.entries[mode]++;
+
+    __enable_irq();
+
+    return mode;
+}
+
+/**
+  * @brief  置STOP禁止位
+  */
+void Power_HoldStop(uint32_t mask)
+{
+    uint32_t old;
+
+    do {
+        old = power.stopHold;
+    } while (!Atomic_Cas32(&power.stopHold, old, old | mask));
+}
+
+/**
+  * @brief  清STOP禁止位
+  */
+void Power_ReleaseStop(uint32_t mask)
+{
+    uint32_t old;
+
+    do {
+        old = power.stopHold;
+    } while (!Atomic_Cas32(&power.stopHold, old, old & ~mask));
+}
+
+/**
+  * @brief  获取驻留统计
+  */
+void Power_GetStats(Power_Stats_t *stats)
+{
+    uint32_t idle = 0;
+    uint8_t i;
+
+    if (stats == NULL) {
+        return;
+    }
+
+    *stats = power.stats;
+    for (i = POWER_MODE_SLEEP; i < POWER_MODE_COUNT; i++) {
+        idle += stats->ms[i];
+    }
+    stats->ms[POWER_MODE_RUN] = HAL_GetTick() - idle;
+}
+
+/**
+  * @brief  唤醒中断处理
+  */
+void Power_WakeupIRQHandler(void)
+{
+    /* Power_Idle 醒来后已经停止定时器并清除标志, 这里只处理残留的挂起位 */
+    if (RTC->ISR & RTC_ISR_WUTF) {
+        RTC->ISR = ~(RTC_ISR_WUTF | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+    }
+    EXTI->PR = EXTI_PR_PR22 | EXTI_PR_PR11;
+}
+
+/* End of file ---------------------------------------------------------------*/
@@ -0,0 +1,294 @@
+/**
+  ******************************************************************************
+  * @file           : prof.c
+  * @brief          : DWT周期计数器性能剖析源文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * Prof_Record 在关中断下更新一个区段 (约几十个周期), 计数器回绕
+  * (168MHz 下约25.5秒) 对单次不超过一个周期的测量没有影响。
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "prof.h"
+#include "mem_region.h"
+#include "log.h"
+#include <stdio.h>
+#include <string.h>
+#ifdef PROF_HOST
+#include <time.h>
+#endif
+
+/* Private defines -----------------------------------------------------------*/
+
+/* 前导零计数 */
+#if defined(PROF_HOST)
+#define PROF_CLZ(x)             ((uint32_t)__builtin_clz(x))
+#else
+#define PROF_CLZ(x)             ((uint32_t)__CLZ(x))
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+
+/* 剖析句柄实例 */
+Prof_Handle_t prof CCM_BSS;
+
+/* 区段名称 (与 Prof_Zone_t 顺序一致) */
+static const char * const profZoneNames[PROF_ZONE_COUNT] = {
+    "esp_cmd", "mqtt_pub", "mqtt_parse", "dht11_read", "dht11_frame", "light_read", "log_print"
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void Prof_ResetZone(Prof_Stats_t *stats);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  清空一个区段
+  */
+static void Prof_ResetZone(Prof_Stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->min = 0xFFFFFFFFUL;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  使能DWT周期计数器并清空统计
+  */
+void Prof_Init(void)
+{
+#ifdef PROF_HOST
+    prof.hz = 1000000000UL;
+#else
+    /* 使能跟踪, 解锁DWT (F4 上电后LAR锁定), 启动CYCCNT; 不清零, DHT11 用差值计时 */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    *(volatile uint32_t *)(DWT_BASE + 0xFB0UL) = 0xC5ACCE55UL;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    prof.hz = SystemCoreClock;
+#endif
+
+    Prof_Reset();
+    prof.initialized = 1;
+}
+
+/**
+  * @brief  清空统计
+  */
+void Prof_Reset(void)
+{
+    uint32_t primask;
+    uint8_t i;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    for (i = 0; i < PROF_ZONE_COUNT; i++) {
+        Prof_ResetZone(&prof.zones[i]);
+    }
+    prof.queryZone = PROF_ZONE_COUNT;
+
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  记录一次区段耗时
+  */
+void Prof_Record(Prof_Zone_t zone, uint32_t cycles)
+{
+    Prof_Stats_t *stats;
+    uint32_t primask;
+    uint32_t bin;
+
+    if ((uint32_t)zone >= PROF_ZONE_COUNT || !prof.initialized) {
+        return;
+    }
+
+    /* 桶号 = floor(log2(cycles)), 0 周期计入第0桶 */
+    bin = (cycles == 0) ? 0 : 31 - PROF_CLZ(cycles);
+    stats = &prof.zones[zone];
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    stats->count++;
+    stats->total += cycles;
+    if (cycles < stats->min) {
+        stats->min = cycles;
+    }
+    if (cycles > stats->max) {
+        stats->max = cycles;
+    }
+    if (stats->hist[bin] < 0xFFFF) {
+        stats->hist[bin]++;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  获取区段统计
+  */
+void Prof_GetStats(Prof_Zone_t zone, Prof_Stats_t *stats)
+{
+    uint32_t primask;
+
+    if ((uint32_t)zone >= PROF_ZONE_COUNT || stats == NULL) {
+        return;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = prof.zones[zone];
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  获取区段名称
+  */
+const char* Prof_GetName(Prof_Zone_t zone)
+{
+    return ((uint32_t)zone < PROF_ZONE_COUNT) ? profZoneNames[zone] : "?";
+}
+
+/**
+  * @brief  把一个区段编码为JSON
+  */
+int Prof_FormatZone(Prof_Zone_t zone, char *buf, uint16_t size)
+{
+    Prof_Stats_t stats;
+    uint32_t mean;
+    uint8_t first = 1;
+    uint8_t i;
+    int len, n;
+
+    if ((uint32_t)zone >= PROF_ZONE_COUNT || buf == NULL || size == 0) {
+        return 0;
+    }
+
+    Prof_GetStats(zone, &stats);
+    mean = stats.count ? (uint32_t)(stats.total / stats.count) : 0;
+
+    len = snprintf(buf, size,
+                   "{\"zone\":\"%s\",\"hz\":%lu,\"n\":%lu,\"min\":%lu,\"mean\":%lu,\"max\":%lu,\"hist\":{",
+                   profZoneNames[zone], (unsigned long)prof.hz, (unsigned long)stats.count,
+                   (unsigned long)(stats.count ? stats.min : 0), (unsigned long)mean,
+                   (unsigned long)stats.max);
+    if (len < 0 || len >= size) {
+        buf[0] = '\0';
+        return 0;
+    }
+
+    for (i = 0; i < PROF_HIST_BINS; i++) {
+        if (stats.hist[i] == 0) {
+            continue;
+        }
+        n = snprintf(buf + len, size - len, "%s\"%u\":%u", first ? "" : ",", i, stats.hist[i]);
+        if (n < 0 || len + n >= size) {
+            buf[0] = '\0';
+            return 0;
+        }
+        len += n;
+        first = 0;
+    }
+
+    n = snprintf(buf + len, size - len, "}}");
+    if (n < 0 || len + n >= size) {
+        buf[0] = '\0';
+        return 0;
+    }
+
+    return len + n;
+}
+
+/**
+  * @brief  通过日志输出所有区段
+  */
+void Prof_Dump(void)
+{
+    Prof_Stats_t stats;
+    char hist[PROF_HIST_BINS * 8];
+    uint32_t mean, us;
+    uint8_t i, bin;
+    int len, n;
+
+    us = prof.hz / 1000000UL;
+    if (us == 0) {
+        us = 1;
+    }
+
+    LOG_I("PROF", "%-11s %8s %10s %10s %10s  (cycles, %lu/us)", "zone", "n", "min", "mean", "max",
+          (unsigned long)us);
+
+    for (i = 0; i < PROF_ZONE_COUNT; i++) {
+        Prof_GetStats((Prof_Zone_t)i, &stats);
+        if (stats.count == 0) {
+            continue;
+        }
+        mean = (uint32_t)(stats.total / stats.count);
+
+        /* 直方图: 2^k:次数 */
+        len = 0;
+        hist[0] = '\0';
+        for (bin = 0; bin < PROF_HIST_BINS; bin++) {
+            if (stats.hist[bin] == 0) {
+                continue;
+            }
+            n = snprintf(hist + len, sizeof(hist) - len, " %u:%u", bin, stats.hist[bin]);
+            if (n < 0 || len + n >= (int)sizeof(hist)) {
+                break;
+            }
+            len += n;
+        }
+
+        LOG_I("PROF", "%-11s %8lu %10lu %10lu %10lu", profZoneNames[i], (unsigned long)stats.count,
+              (unsigned long)stats.min, (unsigned long)mean, (unsigned long)stats.max);
+        LOG_I("PROF", "  log2 hist:%s", hist);
+    }
+}
+
+/**
+  * @brief  开始分块导出
+  */
+void Prof_StartQuery(void)
+{
+    prof.queryZone = 0;
+}
+
+/**
+  * @brief  取下一个区段的JSON
+  */
+int Prof_NextChunk(char *buf, uint16_t size)
+{
+    int len;
+
+    /* 跳过还没有记录的区段 */
+    while (prof.queryZone < PROF_ZONE_COUNT) {
+        len = prof.zones[prof.queryZone].count ? Prof_FormatZone((Prof_Zone_t)prof.queryZone, buf, size) : 0;
+        prof.queryZone++;
+        if (len > 0) {
+            return len;
+        }
+    }
+
+    return 0;
+}
+
+#ifdef PROF_HOST
+/**
+  * @brief  主机端计时源
+  */
+uint32_t Prof_HostNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+#endif
+
+/* End of file ---------------------------------------------------------------*/
@@ -0,0 +1,206 @@
+/**
+  ******************************************************************************
+  * @file           : pub_bench.c
+  * @brief          : MQTT发布吞吐基准源文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 计时用 HAL_GetTick (毫秒), 等待时间取自 ESP8266_GetWaitTime, 两者同一时基。
+  * 比例和速率用整数运算, 输出固定小数位, 不依赖 printf 的浮点支持。
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "pub_bench.h"
+
+#if PUB_BENCH_ENABLE
+
+#include "esp8266.h"
+#include "log.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private variables ---------------------------------------------------------*/
+
+/* 载荷缓冲区 (多一个字节给 MQTT_Publish 的结束符) */
+static char pubBenchPayload[PUB_BENCH_PAYLOAD_MAX + 1];
+
+/* 接口名称 (与 PubBench_Api_t 顺序一致) */
+static const char * const pubBenchApiNames[PUB_BENCH_API_COUNT] = {
+    "publish", "raw"
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void PubBench_Fill(uint16_t len, uint32_t seq);
+static uint32_t PubBench_RoundTrips(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  生成可打印载荷, 开头8个字符为序号 (十六进制)
+  */
+static void PubBench_Fill(uint16_t len, uint32_t seq)
+{
+    static const char hex[] = "0123456789abcdef";
+    uint16_t i;
+
+    for (i = 0; i < len; i++) {
+        pubBenchPayload[i] = (i < 8) ? hex[(seq >> (28 - 4 * i)) & 0x0F] : (char)('a' + i % 26);
+    }
+    pubBenchPayload[len] = '\0';
+}
+
+/**
+  * @brief  AT命令统计表中所有动词的发出次数之和
+  */
+static uint32_t PubBench_RoundTrips(void)
+{
+    uint32_t total = 0;
+    uint8_t i;
+
+    for (i = 0; i < esp8266.cmdStatsCount; i++) {
+        total += esp8266.cmdStats[i].issued;
+    }
+    return total;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  运行一个组合
+  */
+MQTT_Status_t PubBench_Run(const PubBench_Case_t *bench, PubBench_Result_t *result)
+{
+    uint32_t start, wait, trips;
+    uint16_t len, i;
+    MQTT_Status_t ret;
+
+    if (bench == NULL || result == NULL || bench->api >= PUB_BENCH_API_COUNT) {
+        return MQTT_INVALID_PARAM;
+    }
+
+    memset(result, 0, sizeof(PubBench_Result_t));
+    len = bench->payload;
+    if (len == 0 || len > PUB_BENCH_PAYLOAD_MAX) {
+        return MQTT_INVALID_PARAM;
+    }
+
+    if (bench->baud != 0 && ESP8266_SetBaudRate(bench->baud) != ESP8266_OK) {
+        return MQTT_ERROR;
+    }
+
+    start = HAL_GetTick();
+    wait = ESP8266_GetWaitTime();
+    trips = PubBench_RoundTrips();
+
+    for (i = 0; i < bench->count; i++) {
+        PubBench_Fill(len, i);
+        if (bench->api == PUB_BENCH_API_PUBLISH) {
+            ret = MQTT_Publish(PUB_BENCH_TOPIC, pubBenchPayload, bench->qos, 0);
+        } else {
+            ret = MQTT_PublishRaw(PUB_BENCH_TOPIC, (const uint8_t *)pubBenchPayload, len, bench->qos, 0);
+        }
+        result->sent++;
+        if (ret == MQTT_OK) {
+            result->ok++;
+        }
+    }
+
+    result->elapsedMs = HAL_GetTick() - start;
+    result->waitMs = ESP8266_GetWaitTime() - wait;
+    result->roundTrips = PubBench_RoundTrips() - trips;
+    return MQTT_OK;
+}
+
+/**
+  * @brief  CSV 表头
+  */
+const char* PubBench_CsvHeader(void)
+{
+    return "api,payload,qos,baud,latency_us,sent,ok,elapsed_ms,msgs_s,bytes_s,cpu_busy_pct,at_rt_per_msg";
+}
+
+/**
+  * @brief  编码为CSV行
+  */
+int PubBench_FormatCsv(const PubBench_Case_t *bench, const PubBench_Result_t *result,
+                       char *buf, uint16_t size)
+{
+    uint32_t elapsed, msgs100, bytes, busy10, trips100;
+    int len;
+
+    if (bench == NULL || result == NULL || buf == NULL || size == 0) {
+        return 0;
+    }
+
+    /* 耗时为0 (主机上全部在同一毫秒内) 按1毫秒计 */
+    elapsed = result->elapsedMs ? result->elapsedMs : 1;
+    msgs100 = (uint32_t)((uint64_t)result->ok * 100000ULL / elapsed);
+    bytes = (uint32_t)((uint64_t)result->ok * bench->payload * 1000ULL / elapsed);
+    busy10 = (result->waitMs < elapsed) ? (uint32_t)((uint64_t)(elapsed - result->waitMs) * 1000ULL / elapsed) : 0;
+    trips100 = result->sent ? result->roundTrips * 100UL / result->sent : 0;
+
+    len = snprintf(buf, size, "%s,%u,%u,%lu,%lu,%u,%u,%lu,%lu.%02lu,%lu,%lu.%lu,%lu.%02lu",
+                   pubBenchApiNames[bench->api], bench->payload, (unsigned)bench->qos,
+                   (unsigned long)(bench->baud ? bench->baud : esp8266.huart->Init.BaudRate),
+                   (unsigned long)bench->latencyUs, result->sent, result->ok,
+                   (unsigned long)result->elapsedMs,
+                   (unsigned long)(msgs100 / 100), (unsigned long)(msgs100 % 100),
+                   (unsigned long)bytes,
+                   (unsigned long)(busy10 / 10), (unsigned long)(busy10 % 10),
+                   (unsigned long)(trips100 / 100), (unsigned long)(trips100 % 100));
+    if (len < 0 || len >= size) {
+        buf[0] = '\0';
+        return 0;
+    }
+    return len;
+}
+
+/**
+  * @brief  目标板默认扫描
+  */
+void PubBench_RunDefault(void)
+{
+    static const uint16_t sizes[] = PUB_BENCH_DEFAULT_SIZES;
+    static const uint32_t bauds[] = PUB_BENCH_DEFAULT_BAUDS;
+    uint32_t origBaud = esp8266.huart->Init.BaudRate;
+    PubBench_Case_t bench;
+    PubBench_Result_t result;
+    char csv[PUB_BENCH_CSV_SIZE];
+    uint8_t b, s, q, a;
+
+    LOG_I("BENCH", "%s", PubBench_CsvHeader());
+
+    for (b = 0; b < sizeof(bauds) / sizeof(bauds[0]); b++) {
+        if (ESP8266_SetBaudRate(bauds[b]) != ESP8266_OK) {
+            LOG_W("BENCH", "Baud %lu not accepted, skipped", (unsigned long)bauds[b]);
+            continue;
+        }
+        for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            for (q = MQTT_QOS_0; q <= MQTT_QOS_1; q++) {
+                for (a = 0; a < PUB_BENCH_API_COUNT; a++) {
+                    bench.api = (PubBench_Api_t)a;
+                    bench.payload = sizes[s];
+                    bench.qos = (MQTT_QoS_t)q;
+                    bench.baud = 0;
+                    bench.latencyUs = 0;
+                    bench.count = PUB_BENCH_DEFAULT_COUNT;
+                    if (PubBench_Run(&bench, &result) == MQTT_OK &&
+                        PubBench_FormatCsv(&bench, &result, csv, sizeof(csv)) > 0) {
+                        LOG_I("BENCH", "%s", csv);
+                    }
+                }
+            }
+        }
+    }
+
+    if (ESP8266_SetBaudRate(origBaud) != ESP8266_OK) {
+        LOG_E("BENCH", "Failed to restore baud %lu", (unsigned long)origBaud);
+    }
+}
+
+#endif /* PUB_BENCH_ENABLE */
+
+/* End of file ---------------------------------------------------------------*/
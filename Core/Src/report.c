@@ -0,0 +1,338 @@
+/**
+  ******************************************************************************
+  * @file           : report.c
+  * @brief          : 按例外上报 (Report-by-Exception) 源文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 判断规则:
+  *   - 首个样本总是发布
+  *   - 越过死区的样本置"变化"标志, 满足最小间隔后发布 (发布的是最新值)
+  *   - 心跳到期时无论是否变化都发布
+  *   - 其余样本计入"抑制"
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "report.h"
+#include "mem_region.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+/* Private variables ---------------------------------------------------------*/
+
+/* 上报句柄实例 */
+Report_Handle_t report CCM_BSS;
+
+/* 默认参数 */
+static const Report_Config_t reportDefaultConfig = {
+    .absDeadband = REPORT_DEFAULT_ABS_DEADBAND,
+    .relDeadband = REPORT_DEFAULT_REL_DEADBAND,
+    .minIntervalMs = REPORT_DEFAULT_MIN_INTERVAL_MS,
+    .heartbeatMs = REPORT_DEFAULT_HEARTBEAT_MS,
+    .decimals = REPORT_DEFAULT_DECIMALS,
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static Report_Channel_t* Report_FindChannel(const char *key, uint8_t create);
+static uint8_t Report_ExceedsDeadband(const Report_Channel_t *ch, float value);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  按键名查找通道
+  * @param  create 1=不存在时以默认参数创建
+  * @retval Report_Channel_t* 通道指针, 未找到或已满返回NULL
+  */
+static Report_Channel_t* Report_FindChannel(const char *key, uint8_t create)
+{
+    Report_Channel_t *ch;
+    uint8_t i;
+
+    for (i = 0; i < report.channelCount; i++) {
+        if (strncmp(report.channels[i].key, key, REPORT_KEY_MAX_LEN - 1) == 0) {
+            return &report.channels[i];
+        }
+    }
+
+    if (!create || report.channelCount >= REPORT_MAX_CHANNELS) {
+        return NULL;
+    }
+
+    ch = &report.channels[report.channelCount++];
+    memset(ch, 0, sizeof(*ch));
+    strncpy(ch->key, key, REPORT_KEY_MAX_LEN - 1);
+    ch->config = reportDefaultConfig;
+
+    return ch;
+}
+
+/**
+  * @brief  判断新值相对上次发布值是否越过死区
+  */
+static uint8_t Report_ExceedsDeadband(const Report_Channel_t *ch, float value)
+{
+    float delta = fabsf(value - ch->lastPublished);
+
+    if (ch->config.absDeadband > 0.0f && delta >= ch->config.absDeadband) {
+        return 1;
+    }
+
+    if (ch->config.relDeadband > 0.0f &&
+        delta >= fabsf(ch->lastPublished) * ch->config.relDeadband / 100.0f) {
+        return 1;
+    }
+
+    /* 两种死区都未配置时, 任何变化都上报 */
+    if (ch->config.absDeadband <= 0.0f && ch->config.relDeadband <= 0.0f && delta > 0.0f) {
+        return 1;
+    }
+
+    return 0;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  初始化上报模块
+  */
+Report_Status_t Report_Init(void)
+{
+    memset(&report, 0, sizeof(report));
+    report.initialized = 1;
+
+    Report_DebugPrint("[Report] Initialized\r\n");
+
+    return REPORT_OK;
+}
+
+/**
+  * @brief  配置通道上报参数
+  */
+Report_Status_t Report_Configure(const char *key, const Report_Config_t *config)
+{
+    Report_Channel_t *ch;
+
+    if (key == NULL || config == NULL) {
+        return REPORT_INVALID_PARAM;
+    }
+
+    ch = Report_FindChannel(key, 1);
+    if (ch == NULL) {
+        return REPORT_FULL;
+    }
+
+    ch->config = *config;
+    return REPORT_OK;
+}
+
+/**
+  * @brief  送入一个新样本
+  */
+Report_Status_t Report_Offer(const char *key, float value)
+{
+    Report_Channel_t *ch;
+
+    if (!report.initialized) {
+        return REPORT_ERROR;
+    }
+
+    if (key == NULL) {
+        return REPORT_INVALID_PARAM;
+    }
+
+    ch = Report_FindChannel(key, 1);
+    if (ch == NULL) {
+        return REPORT_FULL;
+    }
+
+    ch->value = value;
+    ch->hasValue = 1;
+    ch->stats.offered++;
+
+    if (!ch->everPublished || Report_ExceedsDeadband(ch, value)) {
+        /* 已有未发布的变化时 (仍在最小间隔内), 本样本只是刷新待发布值 */
+        if (ch->changed) {
+            ch->stats.deferred++;
+        }
+        ch->changed = 1;
+    } else {
+        /* 回到死区内, 撤销尚未发布的变化 */
+        ch->changed = 0;
+        ch->stats.suppressed++;
+    }
+
+    return REPORT_OK;
+}
+
+/**
+  * @brief  把到期的通道编码为一条JSON
+  */
+int Report_FormatDue(char *buf, uint16_t size)
+{
+    uint8_t due[REPORT_MAX_CHANNELS] = {0};
+    uint8_t anyDue = 0;
+    uint32_t now = HAL_GetTick();
+    uint16_t len;
+    uint8_t fields = 0;
+    uint8_t i;
+    int n;
+
+    if (!report.initialized || buf == NULL || size < 3) {
+        return 0;
+    }
+
+    /* 1. 找出到期的通道 */
+    for (i = 0; i < report.channelCount; i++) {
+        Report_Channel_t *ch = &report.channels[i];
+        uint32_t silence = now - ch->lastPublishTick;
+
+        if (!ch->hasValue) {
+            continue;
+        }
+
+        if (ch->changed && (!ch->everPublished || silence >= ch->config.minIntervalMs)) {
+            due[i] = 1;
+        } else if (ch->config.heartbeatMs && silence >= ch->config.heartbeatMs) {
+            due[i] = 2;     /* 心跳 */
+        }
+        anyDue |= due[i];
+    }
+
+    if (!anyDue) {
+        return 0;
+    }
+
+#if REPORT_PIGGYBACK_ENABLE
+    /* 2. 捎带心跳已过半且满足最小间隔的通道 */
+    for (i = 0; i < report.channelCount; i++) {
+        Report_Channel_t *ch = &report.channels[i];
+        uint32_t silence = now - ch->lastPublishTick;
+
+        if (!due[i] && ch->hasValue && ch->config.heartbeatMs &&
+            silence >= ch->config.heartbeatMs / 2 && silence >= ch->config.minIntervalMs) {
+            due[i] = 2;
+        }
+    }
+#endif
+
+    /* 3. 编码, 放不下的通道留到下一次 */
+    buf[0] = '{';
+    len = 1;
+    for (i = 0; i < report.channelCount; i++) {
+        Report_Channel_t *ch = &report.channels[i];
+        char field[40];
+
+        if (!due[i]) {
+            continue;
+        }
+
+        n = snprintf(field, sizeof(field), "%s\"%s\":%.*f", fields ? "," : "",
+                     ch->key, ch->config.decimals, ch->value);
+        if (n < 0 || n >= (int)sizeof(field) || len + n + 2 > size) {
+            continue;
+        }
+        memcpy(buf + len, field, n);
+        len += n;
+        fields++;
+
+        if (due[i] == 2 && !ch->changed) {
+            ch->stats.heartbeats++;
+        }
+        ch->stats.published++;
+        ch->lastPublished = ch->value;
+        ch->lastPublishTick = now;
+        ch->everPublished = 1;
+        ch->changed = 0;
+    }
+
+    if (fields == 0) {
+        buf[0] = '\0';
+        return 0;
+    }
+
+    buf[len++] = '}';
+    buf[len] = '\0';
+    report.messages++;
+
+    return len;
+}
+
+/**
+  * @brief  获取通道统计
+  */
+Report_Status_t Report_GetStats(const char *key, Report_Stats_t *stats)
+{
+    Report_Channel_t *ch;
+
+    if (key == NULL || stats == NULL) {
+        return REPORT_INVALID_PARAM;
+    }
+
+    ch = Report_FindChannel(key, 0);
+    if (ch == NULL) {
+        return REPORT_NOT_FOUND;
+    }
+
+    *stats = ch->stats;
+    return REPORT_OK;
+}
+
+/**
+  * @brief  把所有通道统计编码为JSON
+  */
+int Report_FormatStats(char *buf, uint16_t size)
+{
+    uint16_t len = 0;
+    uint8_t i;
+    int n;
+
+    if (buf == NULL || size < 3) {
+        return 0;
+    }
+
+    buf[len++] = '{';
+    for (i = 0; i < report.channelCount; i++) {
+        const Report_Channel_t *ch = &report.channels[i];
+
+        n = snprintf(buf + len, size - len, "%s\"%s\":[%lu,%lu,%lu,%lu]", i ? "," : "", ch->key,
+                     (unsigned long)ch->stats.published, (unsigned long)ch->stats.suppressed,
+                     (unsigned long)ch->stats.heartbeats, (unsigned long)ch->stats.deferred);
+        if (n < 0 || len + n + 2 > size) {
+            break;
+        }
+        len += n;
+    }
+    buf[len++] = '}';
+    buf[len] = '\0';
+
+    return len;
+}
+
+/**
+  * @brief  调试打印函数 - 使用统一日志库
+  */
+void Report_DebugPrint(const char *format, ...)
+{
+#if REPORT_DEBUG_ENABLE
+    static LOG_Tag_t *logTag;
+    va_list args;
+    
+    /* 先判断标签级别, 关闭时不做格式化 */
+    if (!LOG_TagEnabled(&logTag, "REPORT", LOG_LEVEL_DEBUG)) return;
+    
+    va_start(args, format);
+    LOG_VRaw(format, args);
+    va_end(args);
+#else
+    (void)format;
+#endif
+}
+
+/* End of file ---------------------------------------------------------------*/
@@ -0,0 +1,77 @@
+/**
+  ******************************************************************************
+  * @file           : scratch.c
+  * @brief          : 临时缓冲区共享区源文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "scratch.h"
+#include "mem_region.h"
+#include "metrics.h"
+
+/* Private variables ---------------------------------------------------------*/
+
+/* 共享区 (按 SCRATCH_ALIGN 对齐, 格式化的AT命令等由DMA发送, 不能放在CCM) */
+static uint64_t scratchMem[(SCRATCH_SIZE + sizeof(uint64_t) - 1) / sizeof(uint64_t)] DMA_BUFFER;
+
+/* 共享区句柄实例 */
+Scratch_Handle_t scratch = {0};
+
+/* 健康指标 */
+static Metric_t scratchPeakMetric = METRIC_SOURCE_INIT("scratch.peak", METRIC_GAUGE, &scratch.peak);
+static Metric_t scratchFailMetric = METRIC_SOURCE_INIT("scratch.fail", METRIC_COUNTER, &scratch.fail);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  注册健康指标
+  */
+void Scratch_Init(void)
+{
+    scratch.used = 0;
+    Metrics_Register(&scratchPeakMetric);
+    Metrics_Register(&scratchFailMetric);
+}
+
+/**
+  * @brief  记下当前位置
+  */
+Scratch_Mark_t Scratch_Mark(void)
+{
+    return scratch.used;
+}
+
+/**
+  * @brief  申请
+  */
+void* Scratch_Alloc(uint32_t size)
+{
+    uint32_t aligned = (size + SCRATCH_ALIGN - 1) & ~(uint32_t)(SCRATCH_ALIGN - 1);
+    void *p;
+
+    if (__get_IPSR() != 0 || aligned == 0 || aligned > sizeof(scratchMem) - scratch.used) {
+        scratch.fail++;
+        return NULL;
+    }
+
+    p = (uint8_t *)scratchMem + scratch.used;
+    scratch.used += aligned;
+    if (scratch.used > scratch.peak) {
+        scratch.peak = scratch.used;
+    }
+    return p;
+}
+
+/**
+  * @brief  释放到作用域起点
+  */
+void Scratch_Release(Scratch_Mark_t mark)
+{
+    if (mark < scratch.used) {
+        scratch.used = mark;
+    }
+}
+
+/* End of file ---------------------------------------------------------------*/
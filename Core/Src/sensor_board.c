@@ -0,0 +1,199 @@
+/**
+  ******************************************************************************
+  * @file           : sensor_board.c
+  * @brief          : 板载传感器适配层源文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * - DHT11: start 发出起始信号后立即返回, complete 在20ms后接收数据,
+  *          起始信号期间调度器可以继续采集其他传感器
+  * - 光敏:  单次ADC轮询, 无 start 钩子, 启动后立即完成
+  * - 片内温度: 读取 ADC1 后台DMA缓冲区, 不阻塞
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "sensor_board.h"
+#include "dht11.h"
+#include "light_sensor.h"
+#include "chip_sensor.h"
+#include "config_store.h"
+
+/* Private function prototypes -----------------------------------------------*/
+static SensorHub_Status_t SensorBoard_DHT11Start(void);
+static SensorHub_Status_t SensorBoard_DHT11Complete(float *values);
+static SensorHub_Status_t SensorBoard_LightComplete(float *values);
+static SensorHub_Status_t SensorBoard_ChipComplete(float *values);
+
+/* Private variables ---------------------------------------------------------*/
+
+/* 通道描述 (键名与原JSON字段保持一致) */
+static const SensorHub_Channel_t dht11Channels[] = {
+    { "temp", 1, NULL },
+    { "humi", 1, NULL },
+};
+
+static const SensorHub_Channel_t lightChannels[] = {
+    { "light", 0, NULL },
+};
+
+static const SensorHub_Channel_t chipChannels[] = {
+    { "board_temp", 1, NULL },
+};
+
+/* 传感器描述符 (注册顺序即自动错峰顺序; 采样周期可被配置存储覆盖, 不能为 const) */
+static SensorHub_Desc_t sensorBoardDescs[] = {
+    {
+        .name = "light",
+        .periodMs = SENSOR_BOARD_LIGHT_PERIOD_MS,
+        .channelCount = 1,
+        .channels = lightChannels,
+        .start = NULL,
+        .complete = SensorBoard_LightComplete,
+    },
+    {
+        .name = "chip",
+        .periodMs = SENSOR_BOARD_CHIP_PERIOD_MS,
+        .channelCount = 1,
+        .channels = chipChannels,
+        .start = NULL,
+        .complete = SensorBoard_ChipComplete,
+    },
+    {
+        .name = "dht11",
+        .periodMs = SENSOR_BOARD_DHT11_PERIOD_MS,
+        .phaseMs = DHT11_POWER_UP_MS,       /* 首次采样等上电稳定 */
+        .channelCount = 2,
+        .channels = dht11Channels,
+        .start = SensorBoard_DHT11Start,
+        .complete = SensorBoard_DHT11Complete,
+    },
+};
+
+/* 与 sensorBoardDescs 一一对应的采样周期配置键 */
+static const ConfigStore_Key_t sensorBoardPeriodKeys[] = {
+    CONFIG_KEY_SAMPLE_LIGHT,
+    CONFIG_KEY_SAMPLE_CHIP,
+    CONFIG_KEY_SAMPLE_DHT11,
+};
+
+/* 按例外上报参数 (未列出的通道使用 report.h 中的默认值) */
+static const struct {
+    const char *key;
+    ConfigStore_Key_t deadKey;          /* 覆盖绝对死区的配置键 */
+    Report_Config_t config;
+} sensorBoardReport[] = {
+    /* 键名          配置键                        绝对死区  相对死区%  最小间隔   心跳      小数位 */
+    { "temp",       CONFIG_KEY_DEAD_TEMP,       { 0.5f,    0.0f,      10000,     300000,   1 } },
+    { "humi",       CONFIG_KEY_DEAD_HUMI,       { 2.0f,    0.0f,      10000,     300000,   0 } },
+    { "light",      CONFIG_KEY_DEAD_LIGHT,      { 40.0f,   5.0f,      5000,      300000,   0 } },
+    { "board_temp", CONFIG_KEY_DEAD_BOARD_TEMP, { 1.0f,    0.0f,      30000,     600000,   1 } },
+};
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  DHT11: 发出起始信号
+  */
+static SensorHub_Status_t SensorBoard_DHT11Start(void)
+{
+    return (DHT11_StartRead() == DHT11_OK) ? SENSOR_HUB_OK : SENSOR_HUB_ERROR;
+}
+
+/**
+  * @brief  DHT11: 起始信号结束后接收数据
+  */
+static SensorHub_Status_t SensorBoard_DHT11Complete(float *values)
+{
+    DHT11_Status_t status = DHT11_FinishRead(&values[0], &values[1]);
+
+    if (status == DHT11_BUSY) {
+        return SENSOR_HUB_BUSY;
+    }
+    return (status == DHT11_OK) ? SENSOR_HUB_OK : SENSOR_HUB_ERROR;
+}
+
+/**
+  * @brief  光敏传感器: 单次ADC读取
+  */
+static SensorHub_Status_t SensorBoard_LightComplete(float *values)
+{
+    LightSensor_Status_t status = LightSensor_Read();
+
+    /* 频闪分析占用ADC3时沿用上一次的值 */
+    if (status != LIGHT_SENSOR_OK && status != LIGHT_SENSOR_BUSY) {
+        return SENSOR_HUB_ERROR;
+    }
+
+    /* LS1传感器特性：亮时ADC值小，暗时ADC值大，所以需要反转 */
+    values[0] = (float)(LIGHT_SENSOR_ADC_MAX - lightSensor.current_value);
+    return SENSOR_HUB_OK;
+}
+
+/**
+  * @brief  片内温度: 读取ADC1后台采集结果
+  */
+static SensorHub_Status_t SensorBoard_ChipComplete(float *values)
+{
+    if (ChipSensor_Update() != CHIP_SENSOR_OK) {
+        return SENSOR_HUB_ERROR;
+    }
+
+    values[0] = chipSensor.temperature;
+    return SENSOR_HUB_OK;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  注册所有板载传感器
+  * @note   配置存储中设置了采样周期 (非0) 时覆盖编译期默认值
+  */
+SensorHub_Status_t SensorBoard_RegisterAll(void)
+{
+    SensorHub_Status_t result = SENSOR_HUB_OK;
+    SensorHub_Status_t status;
+    uint32_t periodMs;
+    uint8_t i;
+
+    for (i = 0; i < sizeof(sensorBoardDescs) / sizeof(sensorBoardDescs[0]); i++) {
+        periodMs = ConfigStore_GetU32(sensorBoardPeriodKeys[i], 0);
+        if (periodMs != 0) {
+            sensorBoardDescs[i].periodMs = periodMs;
+        }
+
+        status = SensorHub_Register(&sensorBoardDescs[i], NULL);
+        if (status != SENSOR_HUB_OK && result == SENSOR_HUB_OK) {
+            result = status;
+        }
+    }
+
+    return result;
+}
+
+/**
+  * @brief  配置各通道的按例外上报参数
+  * @note   绝对死区可被配置存储覆盖
+  */
+Report_Status_t SensorBoard_ConfigureReport(void)
+{
+    Report_Status_t result = REPORT_OK;
+    Report_Status_t status;
+    Report_Config_t config;
+    uint8_t i;
+
+    for (i = 0; i < sizeof(sensorBoardReport) / sizeof(sensorBoardReport[0]); i++) {
+        config = sensorBoardReport[i].config;
+        config.absDeadband = ConfigStore_GetFloat(sensorBoardReport[i].deadKey, config.absDeadband);
+        status = Report_Configure(sensorBoardReport[i].key, &config);
+        if (status != REPORT_OK && result == REPORT_OK) {
+            result = status;
+        }
+    }
+
+    return result;
+}
+
+/* End of file ---------------------------------------------------------------*/
@@ -0,0 +1,450 @@
+/**
+  ******************************************************************************
+  * @file           : sensor_hub.c
+  * @brief          : 通用传感器注册与采样调度框架源文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 调度规则:
+  *   1. 先处理所有进行中的采集 (调用complete)
+  *   2. 再从轮转起点开始找第一个到期的空闲传感器, 启动它,
+  *      每次Poll最多启动一个, 避免多个传感器的阻塞部分叠加
+  *   3. 错过多个周期时不补采, 直接对齐到下一个周期
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "sensor_hub.h"
+#include "mem_region.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+/* Private variables ---------------------------------------------------------*/
+
+/* 传感器框架句柄实例 */
+SensorHub_Handle_t sensorHub CCM_BSS;
+
+/* 健康指标: 样本队列溢出 */
+static Metric_t hubDropMetric = METRIC_SOURCE_INIT("hub.drop", METRIC_COUNTER, &sensorHub.dropped);
+
+/* Private function prototypes -----------------------------------------------*/
+static void SensorHub_Push(uint8_t id, uint8_t channel, float value, uint32_t timestamp);
+static uint8_t SensorHub_Complete(uint8_t id, uint32_t now);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  向样本队列写入一个样本 (队列满时覆盖最旧样本)
+  */
+static void SensorHub_Push(uint8_t id, uint8_t channel, float value, uint32_t timestamp)
+{
+    SensorHub_Sample_t *sample = &sensorHub.queue[sensorHub.head];
+
+    sample->timestamp = timestamp;
+    sample->sensorId = id;
+    sample->channel = channel;
+    sample->value = value;
+
+    sensorHub.head = (sensorHub.head + 1) % SENSOR_HUB_QUEUE_SIZE;
+    if (sensorHub.count < SENSOR_HUB_QUEUE_SIZE) {
+        sensorHub.count++;
+    } else {
+        /* 覆盖最旧样本 */
+        sensorHub.tail = (sensorHub.tail + 1) % SENSOR_HUB_QUEUE_SIZE;
+        sensorHub.dropped++;
+    }
+}
+
+/**
+  * @brief  查询一个进行中的采集
+  * @param  id 传感器ID
+  * @param  now 当前时间 (ms)
+  * @retval uint8_t 产生的样本数
+  */
+static uint8_t SensorHub_Complete(uint8_t id, uint32_t now)
+{
+    SensorHub_Entry_t *entry = &sensorHub.sensors[id];
+    const SensorHub_Desc_t *desc = entry->desc;
+    float values[SENSOR_HUB_MAX_CHANNELS];
+    SensorHub_Status_t status;
+    uint8_t ch;
+
+    status = desc->complete(values);
+    if (status == SENSOR_HUB_BUSY) {
+        return 0;
+    }
+
+    entry->pending = 0;
+
+    if (status != SENSOR_HUB_OK) {
+        entry->errorCount++;
+        entry->valid = 0;
+        SensorHub_DebugPrint("[SensorHub] %s read failed (%d)\r\n", desc->name, status);
+        return 0;
+    }
+
+    entry->okCount++;
+    entry->valid = 1;
+    entry->latestTick = now;
+    for (ch = 0; ch < desc->channelCount; ch++) {
+        entry->latest[ch] = values[ch];
+        SensorHub_Push(id, ch, values[ch], now);
+    }
+
+    return desc->channelCount;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  初始化传感器框架
+  */
+SensorHub_Status_t SensorHub_Init(void)
+{
+    memset(&sensorHub, 0, sizeof(sensorHub));
+    sensorHub.initialized = 1;
+    Metrics_Register(&hubDropMetric);
+
+    SensorHub_DebugPrint("[SensorHub] Initialized\r\n");
+
+    return SENSOR_HUB_OK;
+}
+
+/**
+  * @brief  注册传感器
+  */
+SensorHub_Status_t SensorHub_Register(const SensorHub_Desc_t *desc, uint8_t *id)
+{
+    SensorHub_Entry_t *entry;
+    uint32_t phase;
+
+    if (!sensorHub.initialized) {
+        return SENSOR_HUB_ERROR;
+    }
+
+    if (desc == NULL || desc->complete == NULL || desc->name == NULL ||
+        desc->channelCount == 0 || desc->channelCount > SENSOR_HUB_MAX_CHANNELS ||
+        desc->periodMs == 0) {
+        return SENSOR_HUB_INVALID_PARAM;
+    }
+
+    if (sensorHub.sensorCount >= SENSOR_HUB_MAX_SENSORS) {
+        return SENSOR_HUB_FULL;
+    }
+
+    entry = &sensorHub.sensors[sensorHub.sensorCount];
+    memset(entry, 0, sizeof(*entry));
+    entry->desc = desc;
+
+    /* 未指定偏移时按注册序号错峰 */
+    phase = desc->phaseMs ? desc->phaseMs : (uint32_t)sensorHub.sensorCount * SENSOR_HUB_STAGGER_MS;
+    entry->nextDue = HAL_GetTick() + phase;
+
+    if (id != NULL) {
+        *id = sensorHub.sensorCount;
+    }
+
+    SensorHub_DebugPrint("[SensorHub] Registered %s (id=%d, period=%lums, phase=%lums)\r\n",
+                         desc->name, sensorHub.sensorCount,
+                         (unsigned long)desc->periodMs, (unsigned long)phase);
+
+    sensorHub.sensorCount++;
+    return SENSOR_HUB_OK;
+}
+
+/**
+  * @brief  调度器轮询
+  */
+uint8_t SensorHub_Poll(void)
+{
+    uint32_t now = HAL_GetTick();
+    uint8_t produced = 0;
+    uint8_t i, id;
+
+    if (!sensorHub.initialized || sensorHub.sensorCount == 0) {
+        return 0;
+    }
+
+    /* 1. 处理进行中的采集 */
+    for (i = 0; i < sensorHub.sensorCount; i++) {
+        if (sensorHub.sensors[i].pending) {
+            produced += SensorHub_Complete(i, now);
+        }
+    }
+
+    /* 2. 启动一个到期的传感器 (从轮转起点开始, 保证公平) */
+    for (i = 0; i < sensorHub.sensorCount; i++) {
+        SensorHub_Entry_t *entry;
+
+        id = (uint8_t)((sensorHub.nextStart + i) % sensorHub.sensorCount);
+        entry = &sensorHub.sensors[id];
+
+        if (entry->pending || (int32_t)(now - entry->nextDue) < 0) {
+            continue;
+        }
+
+        /* 计算下次采样时间, 落后超过一个周期时不补采 */
+        entry->nextDue += entry->desc->periodMs;
+        if ((int32_t)(now - entry->nextDue) >= 0) {
+            entry->nextDue = now + entry->desc->periodMs;
+        }
+
+        entry->startTick = now;
+        if (entry->desc->start != NULL && entry->desc->start() != SENSOR_HUB_OK) {
+            entry->errorCount++;
+            entry->valid = 0;
+        } else {
+            entry->pending = 1;
+            /* 无需等待的传感器 (如ADC轮询) 立即完成 */
+            produced += SensorHub_Complete(id, now);
+        }
+
+        sensorHub.nextStart = (uint8_t)((id + 1) % sensorHub.sensorCount);
+        break;
+    }
+
+    return produced;
+}
+
+/**
+  * @brief  距下一次需要调用 SensorHub_Poll 的时间
+  */
+uint32_t SensorHub_TimeToNext(void)
+{
+    uint32_t now = HAL_GetTick();
+    uint32_t next = UINT32_MAX;
+    int32_t remain;
+    uint8_t i;
+
+    if (!sensorHub.initialized || sensorHub.sensorCount == 0) {
+        return UINT32_MAX;
+    }
+
+    /* 队列中的样本要在本轮被消费 */
+    if (sensorHub.count > 0) {
+        return 0;
+    }
+
+    for (i = 0; i < sensorHub.sensorCount; i++) {
+        const SensorHub_Entry_t *entry = &sensorHub.sensors[i];
+
+        /* 进行中的采集 (如DHT11起始信号) 没有完成时间, 按固定间隔轮询 */
+        if (entry->pending) {
+            if (next > SENSOR_HUB_PENDING_POLL_MS) {
+                next = SENSOR_HUB_PENDING_POLL_MS;
+            }
+            continue;
+        }
+
+        remain = (int32_t)(entry->nextDue - now);
+        if (remain <= 0) {
+            return 0;
+        }
+        if ((uint32_t)remain < next) {
+            next = (uint32_t)remain;
+        }
+    }
+
+    return next;
+}
+
+/**
+  * @brief  从样本队列取出一个样本
+  */
+SensorHub_Status_t SensorHub_Pop(SensorHub_Sample_t *sample)
+{
+    if (sensorHub.count == 0) {
+        return SENSOR_HUB_EMPTY;
+    }
+
+    if (sample != NULL) {
+        *sample = sensorHub.queue[sensorHub.tail];
+    }
+    sensorHub.tail = (sensorHub.tail + 1) % SENSOR_HUB_QUEUE_SIZE;
+    sensorHub.count--;
+
+    return SENSOR_HUB_OK;
+}
+
+/**
+  * @brief  获取队列中的样本数
+  */
+uint16_t SensorHub_QueueCount(void)
+{
+    return sensorHub.count;
+}
+
+/**
+  * @brief  获取某通道最新值
+  */
+SensorHub_Status_t SensorHub_GetLatest(uint8_t id, uint8_t channel, float *value)
+{
+    const SensorHub_Entry_t *entry;
+
+    if (id >= sensorHub.sensorCount || value == NULL) {
+        return SENSOR_HUB_INVALID_PARAM;
+    }
+
+    entry = &sensorHub.sensors[id];
+    if (channel >= entry->desc->channelCount) {
+        return SENSOR_HUB_INVALID_PARAM;
+    }
+
+    if (!entry->valid) {
+        return SENSOR_HUB_BUSY;
+    }
+
+    *value = entry->latest[channel];
+    return SENSOR_HUB_OK;
+}
+
+/**
+  * @brief  按名称查找传感器
+  */
+uint8_t SensorHub_Find(const char *name)
+{
+    uint8_t i;
+
+    if (name == NULL) {
+        return SENSOR_HUB_INVALID_ID;
+    }
+
+    for (i = 0; i < sensorHub.sensorCount; i++) {
+        if (strcmp(sensorHub.sensors[i].desc->name, name) == 0) {
+            return i;
+        }
+    }
+
+    return SENSOR_HUB_INVALID_ID;
+}
+
+/**
+  * @brief  获取传感器名称
+  */
+const char* SensorHub_GetName(uint8_t id)
+{
+    if (id >= sensorHub.sensorCount) {
+        return "?";
+    }
+    return sensorHub.sensors[id].desc->name;
+}
+
+/**
+  * @brief  获取通道键名
+  */
+const char* SensorHub_GetKey(uint8_t id, uint8_t channel)
+{
+    if (id >= sensorHub.sensorCount || channel >= sensorHub.sensors[id].desc->channelCount) {
+        return "?";
+    }
+    return sensorHub.sensors[id].desc->channels[channel].key;
+}
+
+/**
+  * @brief  按通道描述编码一个数值
+  */
+int SensorHub_EncodeValue(uint8_t id, uint8_t channel, float value, char *buf, uint16_t size)
+{
+    const SensorHub_Channel_t *chDesc;
+
+    if (buf == NULL || size == 0) {
+        return 0;
+    }
+
+    if (id >= sensorHub.sensorCount || channel >= sensorHub.sensors[id].desc->channelCount) {
+        buf[0] = '\0';
+        return 0;
+    }
+
+    chDesc = &sensorHub.sensors[id].desc->channels[channel];
+    if (chDesc->encode != NULL) {
+        return chDesc->encode(value, buf, size);
+    }
+
+    return snprintf(buf, size, "%.*f", chDesc->decimals, value);
+}
+
+/**
+  * @brief  将所有有效通道的最新值编码为一个JSON对象
+  */
+int SensorHub_FormatJson(char *buf, uint16_t size)
+{
+    char field[48];
+    uint16_t len = 0;
+    uint8_t fields = 0;
+    uint8_t id, ch;
+    int n, v;
+
+    if (buf == NULL || size < 3) {
+        return 0;
+    }
+
+    buf[len++] = '{';
+
+    for (id = 0; id < sensorHub.sensorCount; id++) {
+        const SensorHub_Entry_t *entry = &sensorHub.sensors[id];
+
+        if (!entry->valid) {
+            continue;
+        }
+
+        for (ch = 0; ch < entry->desc->channelCount; ch++) {
+            /* 先在临时缓冲区中编码整个字段, 放不下则丢弃该字段 */
+            n = snprintf(field, sizeof(field), "%s\"%s\":",
+                         fields ? "," : "", entry->desc->channels[ch].key);
+            if (n < 0 || n >= (int)sizeof(field)) {
+                continue;
+            }
+            v = SensorHub_EncodeValue(id, ch, entry->latest[ch], field + n, sizeof(field) - n);
+            if (v <= 0 || v >= (int)sizeof(field) - n) {
+                continue;
+            }
+            n += v;
+
+            /* 预留 '}' 和结束符 */
+            if (len + n + 2 > size) {
+                break;
+            }
+            memcpy(buf + len, field, n);
+            len += n;
+            fields++;
+        }
+    }
+
+    if (fields == 0) {
+        buf[0] = '\0';
+        return 0;
+    }
+
+    buf[len++] = '}';
+    buf[len] = '\0';
+    return len;
+}
+
+/**
+  * @brief  调试打印函数 - 使用统一日志库
+  */
+void SensorHub_DebugPrint(const char *format, ...)
+{
+#if SENSOR_HUB_DEBUG_ENABLE
+    static LOG_Tag_t *logTag;
+    va_list args;
+    
+    /* 先判断标签级别, 关闭时不做格式化 */
+    if (!LOG_TagEnabled(&logTag, "HUB", LOG_LEVEL_DEBUG)) return;
+    
+    va_start(args, format);
+    LOG_VRaw(format, args);
+    va_end(args);
+#else
+    (void)format;
+#endif
+}
+
+/* End of file ---------------------------------------------------------------*/
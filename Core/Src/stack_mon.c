@@ -0,0 +1,142 @@
+/**
+  ******************************************************************************
+  * @file           : stack_mon.c
+  * @brief          : 主栈水位监测源文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stack_mon.h"
+#include "metrics.h"
+#include "log.h"
+#include <stdio.h>
+
+/* Private variables ---------------------------------------------------------*/
+
+/* 链接器给出的主栈区间 */
+#if defined(__CC_ARM) || defined(__ARMCC_VERSION)
+extern uint32_t STACK$$Base[];
+extern uint32_t STACK$$Limit[];
+#define STACK_MON_BASE          ((uint32_t *)STACK$$Base)
+#define STACK_MON_LIMIT         ((uint32_t *)STACK$$Limit)
+#elif defined(__GNUC__) && defined(__arm__)
+extern uint32_t _estack[];
+extern uint32_t _Min_Stack_Size[];
+#define STACK_MON_BASE          ((uint32_t *)((uintptr_t)_estack - (uintptr_t)_Min_Stack_Size))
+#define STACK_MON_LIMIT         ((uint32_t *)_estack)
+#endif
+
+/* 栈监测句柄实例 */
+StackMon_Handle_t stackMon = {0};
+
+/* 健康指标 */
+static Metric_t stackPeakMetric = METRIC_SOURCE_INIT("stack.peak", METRIC_GAUGE, &stackMon.peak);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  填充主栈并注册健康指标
+  */
+void StackMon_Init(void)
+{
+#ifdef STACK_MON_BASE
+    StackMon_InitRegion(STACK_MON_BASE, (uint32_t)((uintptr_t)STACK_MON_LIMIT - (uintptr_t)STACK_MON_BASE));
+#endif
+    Metrics_Register(&stackPeakMetric);
+}
+
+/**
+  * @brief  监测指定区间并填充未使用的部分
+  */
+void StackMon_InitRegion(void *base, uint32_t size)
+{
+    volatile uint32_t marker = 0;
+    uintptr_t sp = (uintptr_t)&marker;
+    uint32_t *p;
+    uint32_t *end;
+
+    stackMon.base = (uint32_t *)(((uintptr_t)base + 3U) & ~(uintptr_t)3U);
+    stackMon.top = (uint32_t *)(((uintptr_t)base + size) & ~(uintptr_t)3U);
+    stackMon.size = (uint32_t)((uintptr_t)stackMon.top - (uintptr_t)stackMon.base);
+    stackMon.peak = 0;
+    stackMon.warned = 0;
+
+    /* 正在使用的栈不能改写: SP 在区间内时只填到保护区以下 */
+    end = stackMon.top;
+    if (sp > (uintptr_t)stackMon.base && sp <= (uintptr_t)stackMon.top) {
+        end = (sp - STACK_MON_GUARD > (uintptr_t)stackMon.base) ?
+              (uint32_t *)((sp - STACK_MON_GUARD) & ~(uintptr_t)3U) : stackMon.base;
+    }
+    for (p = stackMon.base; p < end; p++) {
+        *p = STACK_MON_PATTERN;
+    }
+
+    stackMon.peak = StackMon_HighWater();
+    stackMon.lastTick = HAL_GetTick();
+}
+
+/**
+  * @brief  从栈底向上找第一个被改写的字
+  */
+uint32_t StackMon_HighWater(void)
+{
+    const volatile uint32_t *p = stackMon.base;
+    uint32_t used;
+
+    if (p == NULL) {
+        return 0;
+    }
+
+    while (p < stackMon.top && *p == STACK_MON_PATTERN) {
+        p++;
+    }
+
+    used = (uint32_t)((uintptr_t)stackMon.top - (uintptr_t)p);
+    if (used > stackMon.peak) {
+        stackMon.peak = used;
+    }
+    return stackMon.peak;
+}
+
+/**
+  * @brief  周期扫描
+  */
+void StackMon_Poll(void)
+{
+    if (stackMon.base == NULL || HAL_GetTick() - stackMon.lastTick < STACK_MON_PERIOD_MS) {
+        return;
+    }
+    stackMon.lastTick = HAL_GetTick();
+
+    StackMon_HighWater();
+    if (!stackMon.warned && stackMon.size - stackMon.peak < STACK_MON_WARN_FREE) {
+        stackMon.warned = 1;
+        LOG_W("STACK", "Low stack: peak %lu of %lu bytes",
+              (unsigned long)stackMon.peak, (unsigned long)stackMon.size);
+    }
+}
+
+/**
+  * @brief  生成JSON
+  */
+int StackMon_FormatJson(char *buf, uint16_t size)
+{
+    uint32_t peak = StackMon_HighWater();
+    int len;
+
+    if (buf == NULL || size == 0) {
+        return 0;
+    }
+
+    len = snprintf(buf, size, "{\"stack\":{\"size\":%lu,\"peak\":%lu,\"free\":%lu}}",
+                   (unsigned long)stackMon.size, (unsigned long)peak,
+                   (unsigned long)(stackMon.size - peak));
+    if (len < 0 || len >= size) {
+        buf[0] = '\0';
+        return 0;
+    }
+    return len;
+}
+
+/* End of file ---------------------------------------------------------------*/
@@ -0,0 +1,444 @@
+/**
+  ******************************************************************************
+  * @file           : timeseries.c
+  * @brief          : 多分辨率时序存储源文件 (原始环 + 级联汇总)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 所有存储均为静态分配, 内存占用只由头文件中的容量配置决定
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "timeseries.h"
+#include "mem_region.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+/* 应答结尾预留长度: "],\"more\":1}" + 结束符 */
+#define TIMESERIES_CHUNK_TAIL_LEN   16
+
+/* Private variables ---------------------------------------------------------*/
+
+/* 时序存储句柄实例 */
+TimeSeries_Handle_t timeSeries CCM_BSS;
+
+/* 各层分辨率与容量 */
+static const uint32_t tierResMs[TIMESERIES_TIER_COUNT] = {
+    TIMESERIES_TIER0_RES_MS, TIMESERIES_TIER1_RES_MS, TIMESERIES_TIER2_RES_MS
+};
+static const uint16_t tierSize[TIMESERIES_TIER_COUNT] = {
+    TIMESERIES_TIER0_SIZE, TIMESERIES_TIER1_SIZE, TIMESERIES_TIER2_SIZE
+};
+
+/* 分辨率名称 (与 TimeSeries_Res_t 顺序一致) */
+static const char * const resNames[] = { "raw", "1s", "1m", "15m" };
+
+/* Private function prototypes -----------------------------------------------*/
+static TimeSeries_Bucket_t* TimeSeries_TierBuf(TimeSeries_Series_t *s, uint8_t level);
+static void TimeSeries_RingPush(TimeSeries_Ring_t *ring, uint16_t size);
+static uint16_t TimeSeries_RingIndex(const TimeSeries_Ring_t *ring, uint16_t size, uint16_t age);
+static void TimeSeries_TierMerge(TimeSeries_Series_t *s, uint8_t level, uint32_t start,
+                                 float min, float max, float sum, uint32_t count);
+static int TimeSeries_FindSeries(const char *key);
+static int TimeSeries_JsonGetString(const char *json, const char *key, char *out, uint16_t size);
+static int TimeSeries_JsonGetInt(const char *json, const char *key, long *value);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  获取某汇总层的桶数组
+  */
+static TimeSeries_Bucket_t* TimeSeries_TierBuf(TimeSeries_Series_t *s, uint8_t level)
+{
+    switch (level) {
+        case 0:  return s->tier0;
+        case 1:  return s->tier1;
+        default: return s->tier2;
+    }
+}
+
+/**
+  * @brief  环形索引前进一格 (满时覆盖最旧元素)
+  */
+static void TimeSeries_RingPush(TimeSeries_Ring_t *ring, uint16_t size)
+{
+    if (ring->used == 0) {
+        ring->head = 0;
+        ring->used = 1;
+        return;
+    }
+
+    ring->head = (ring->head + 1) % size;
+    if (ring->used < size) {
+        ring->used++;
+    }
+}
+
+/**
+  * @brief  按"距今第几个"取环形数组下标
+  * @param  age 0=最新
+  */
+static uint16_t TimeSeries_RingIndex(const TimeSeries_Ring_t *ring, uint16_t size, uint16_t age)
+{
+    return (uint16_t)((ring->head + size - age) % size);
+}
+
+/**
+  * @brief  把一段汇总合并进某层, 当前桶关闭时级联到上一层
+  * @param  s 通道
+  * @param  level 层号 (0=1s)
+  * @param  start 数据时间 (ms)
+  */
+static void TimeSeries_TierMerge(TimeSeries_Series_t *s, uint8_t level, uint32_t start,
+                                 float min, float max, float sum, uint32_t count)
+{
+    TimeSeries_Bucket_t *buf = TimeSeries_TierBuf(s, level);
+    TimeSeries_Ring_t *ring = &s->tierRing[level];
+    uint32_t bucketStart = start - start % tierResMs[level];
+    TimeSeries_Bucket_t *bucket;
+
+    if (ring->used) {
+        bucket = &buf[ring->head];
+
+        /* 同一时间片 (或迟到的数据) 合并进当前桶 */
+        if ((int32_t)(bucketStart - bucket->start) <= 0) {
+            if (min < bucket->min) bucket->min = min;
+            if (max > bucket->max) bucket->max = max;
+            bucket->sum += sum;
+            bucket->count += count;
+            return;
+        }
+
+        /* 当前桶关闭, 汇总级联到上一层 */
+        if (level + 1 < TIMESERIES_TIER_COUNT) {
+            TimeSeries_TierMerge(s, level + 1, bucket->start,
+                                 bucket->min, bucket->max, bucket->sum, bucket->count);
+        }
+    }
+
+    /* 开启新桶 */
+    TimeSeries_RingPush(ring, tierSize[level]);
+    bucket = &buf[ring->head];
+    bucket->start = bucketStart;
+    bucket->min = min;
+    bucket->max = max;
+    bucket->sum = sum;
+    bucket->count = count;
+}
+
+/**
+  * @brief  按键名查找通道
+  * @retval int 通道序号, 未找到返回-1
+  */
+static int TimeSeries_FindSeries(const char *key)
+{
+    uint8_t i;
+
+    for (i = 0; i < timeSeries.seriesCount; i++) {
+        if (strncmp(timeSeries.series[i].key, key, TIMESERIES_KEY_MAX_LEN - 1) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+  * @brief  JSON解析辅助函数 - 获取字符串值
+  * @retval 0=成功, -1=未找到键
+  */
+static int TimeSeries_JsonGetString(const char *json, const char *key, char *out, uint16_t size)
+{
+    char pattern[24];
+    const char *ptr;
+    uint16_t len = 0;
+
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    ptr = strstr(json, pattern);
+    if (!ptr) return -1;
+
+    ptr += strlen(pattern);
+    while (*ptr == ' ') ptr++;
+    if (*ptr != '"') return -1;
+    ptr++;
+
+    while (*ptr && *ptr != '"' && len < size - 1) {
+        out[len++] = *ptr++;
+    }
+    out[len] = '\0';
+
+    return 0;
+}
+
+/**
+  * @brief  JSON解析辅助函数 - 获取整数值
+  * @retval 0=成功, -1=未找到键
+  */
+static int TimeSeries_JsonGetInt(const char *json, const char *key, long *value)
+{
+    char pattern[24];
+    const char *ptr;
+
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    ptr = strstr(json, pattern);
+    if (!ptr) return -1;
+
+    ptr += strlen(pattern);
+    *value = strtol(ptr, NULL, 10);
+
+    return 0;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  初始化时序存储
+  */
+TimeSeries_Status_t TimeSeries_Init(void)
+{
+    memset(&timeSeries, 0, sizeof(timeSeries));
+    timeSeries.initialized = 1;
+
+    TimeSeries_DebugPrint("[TimeSeries] Initialized, %u bytes\r\n", (unsigned)sizeof(timeSeries));
+
+    return TIMESERIES_OK;
+}
+
+/**
+  * @brief  记录一个样本
+  */
+TimeSeries_Status_t TimeSeries_Record(const char *key, uint32_t timestamp, float value)
+{
+    TimeSeries_Series_t *s;
+    TimeSeries_Point_t *p;
+    int idx;
+
+    if (!timeSeries.initialized) {
+        return TIMESERIES_ERROR;
+    }
+
+    if (key == NULL || key[0] == '\0') {
+        return TIMESERIES_INVALID_PARAM;
+    }
+
+    idx = TimeSeries_FindSeries(key);
+    if (idx < 0) {
+        if (timeSeries.seriesCount >= TIMESERIES_MAX_SERIES) {
+            timeSeries.rejected++;
+            return TIMESERIES_FULL;
+        }
+        idx = timeSeries.seriesCount++;
+        strncpy(timeSeries.series[idx].key, key, TIMESERIES_KEY_MAX_LEN - 1);
+        TimeSeries_DebugPrint("[TimeSeries] New series %s\r\n", key);
+    }
+
+    s = &timeSeries.series[idx];
+
+    /* 原始样本环 */
+    TimeSeries_RingPush(&s->rawRing, TIMESERIES_RAW_SIZE);
+    p = &s->raw[s->rawRing.head];
+    p->t = timestamp;
+    p->v = value;
+
+    /* 1s层, 关闭的桶逐层级联 */
+    TimeSeries_TierMerge(s, 0, timestamp, value, value, value, 1);
+    s->total++;
+
+    return TIMESERIES_OK;
+}
+
+/**
+  * @brief  读取某分辨率下的一个汇总桶
+  */
+TimeSeries_Status_t TimeSeries_GetBucket(const char *key, TimeSeries_Res_t res,
+                                         uint16_t age, TimeSeries_Bucket_t *bucket)
+{
+    TimeSeries_Series_t *s;
+    uint8_t level;
+    int idx;
+
+    if (key == NULL || bucket == NULL || res == TIMESERIES_RES_RAW || res > TIMESERIES_RES_15M) {
+        return TIMESERIES_INVALID_PARAM;
+    }
+
+    idx = TimeSeries_FindSeries(key);
+    if (idx < 0) {
+        return TIMESERIES_NOT_FOUND;
+    }
+
+    s = &timeSeries.series[idx];
+    level = (uint8_t)(res - TIMESERIES_RES_1S);
+    if (age >= s->tierRing[level].used) {
+        return TIMESERIES_NOT_FOUND;
+    }
+
+    *bucket = TimeSeries_TierBuf(s, level)[TimeSeries_RingIndex(&s->tierRing[level], tierSize[level], age)];
+    return TIMESERIES_OK;
+}
+
+/**
+  * @brief  提交一个查询请求
+  */
+TimeSeries_Status_t TimeSeries_RequestQuery(const char *json)
+{
+    TimeSeries_Query_t *q = &timeSeries.query;
+    char key[TIMESERIES_KEY_MAX_LEN];
+    char res[8] = "1m";
+    long from = -1, to = 0, max = TIMESERIES_DEFAULT_MAX_POINTS;
+    uint32_t now = HAL_GetTick();
+    uint8_t r;
+    int idx;
+
+    if (json == NULL || TimeSeries_JsonGetString(json, "key", key, sizeof(key)) != 0) {
+        return TIMESERIES_INVALID_PARAM;
+    }
+
+    idx = TimeSeries_FindSeries(key);
+    if (idx < 0) {
+        return TIMESERIES_NOT_FOUND;
+    }
+
+    TimeSeries_JsonGetString(json, "res", res, sizeof(res));
+    TimeSeries_JsonGetInt(json, "from", &from);
+    TimeSeries_JsonGetInt(json, "to", &to);
+    TimeSeries_JsonGetInt(json, "max", &max);
+
+    for (r = 0; r < sizeof(resNames) / sizeof(resNames[0]); r++) {
+        if (strcmp(res, resNames[r]) == 0) break;
+    }
+    if (r >= sizeof(resNames) / sizeof(resNames[0]) || to < 0 || max <= 0) {
+        return TIMESERIES_INVALID_PARAM;
+    }
+
+    /* 新请求覆盖未发送完的旧请求 */
+    memset(q, 0, sizeof(*q));
+    q->series = (uint8_t)idx;
+    q->res = (TimeSeries_Res_t)r;
+    q->fromTick = (from < 0 || (uint32_t)from * 1000U >= now) ? 0 : now - (uint32_t)from * 1000U;
+    q->toTick = ((uint32_t)to * 1000U >= now) ? 0 : now - (uint32_t)to * 1000U;
+    q->remaining = (uint16_t)((max > TIMESERIES_LIMIT_MAX_POINTS) ? TIMESERIES_LIMIT_MAX_POINTS : max);
+    q->active = 1;
+
+    TimeSeries_DebugPrint("[TimeSeries] Query %s res=%s from=%lu to=%lu\r\n", key, resNames[r],
+                          (unsigned long)q->fromTick, (unsigned long)q->toTick);
+
+    return TIMESERIES_OK;
+}
+
+/**
+  * @brief  生成查询应答的下一块
+  */
+int TimeSeries_NextChunk(char *buf, uint16_t size)
+{
+    TimeSeries_Query_t *q = &timeSeries.query;
+    TimeSeries_Series_t *s;
+    const TimeSeries_Ring_t *ring;
+    uint16_t ringSize;
+    uint16_t len, points = 0;
+    uint8_t more = 0;
+    int32_t age;
+    int n;
+
+    if (!q->active || buf == NULL || size <= TIMESERIES_CHUNK_TAIL_LEN + 64) {
+        return 0;
+    }
+
+    s = &timeSeries.series[q->series];
+    if (q->res == TIMESERIES_RES_RAW) {
+        ring = &s->rawRing;
+        ringSize = TIMESERIES_RAW_SIZE;
+    } else {
+        ring = &s->tierRing[q->res - TIMESERIES_RES_1S];
+        ringSize = tierSize[q->res - TIMESERIES_RES_1S];
+    }
+
+    n = snprintf(buf, size, "{\"key\":\"%s\",\"res\":\"%s\",\"now\":%lu,\"seq\":%u,\"pts\":[",
+                 s->key, resNames[q->res], (unsigned long)HAL_GetTick(), q->seq);
+    if (n < 0 || n >= size) {
+        q->active = 0;
+        return 0;
+    }
+    len = (uint16_t)n;
+
+    /* 从最旧到最新遍历, 以时间戳为游标, 分块期间有新数据写入也不会重复或遗漏 */
+    for (age = (int32_t)ring->used - 1; age >= 0 && q->remaining > 0; age--) {
+        uint16_t i = TimeSeries_RingIndex(ring, ringSize, (uint16_t)age);
+        char item[64];
+        uint32_t t;
+
+        if (q->res == TIMESERIES_RES_RAW) {
+            t = s->raw[i].t;
+        } else {
+            t = TimeSeries_TierBuf(s, q->res - TIMESERIES_RES_1S)[i].start;
+        }
+
+        if (t < q->fromTick || t > q->toTick || (q->started && t <= q->lastT)) {
+            continue;
+        }
+
+        if (q->res == TIMESERIES_RES_RAW) {
+            n = snprintf(item, sizeof(item), "%s[%lu,%.2f]", points ? "," : "",
+                         (unsigned long)t, s->raw[i].v);
+        } else {
+            const TimeSeries_Bucket_t *b = &TimeSeries_TierBuf(s, q->res - TIMESERIES_RES_1S)[i];
+            n = snprintf(item, sizeof(item), "%s[%lu,%.2f,%.2f,%.2f,%lu]", points ? "," : "",
+                         (unsigned long)t, b->sum / (float)b->count, b->min, b->max,
+                         (unsigned long)b->count);
+        }
+        if (n < 0 || n >= (int)sizeof(item)) {
+            continue;
+        }
+
+        /* 本块放不下, 留到下一块 */
+        if (len + n + TIMESERIES_CHUNK_TAIL_LEN > size) {
+            more = 1;
+            break;
+        }
+
+        memcpy(buf + len, item, n);
+        len += n;
+        points++;
+        q->lastT = t;
+        q->started = 1;
+        q->remaining--;
+    }
+
+    n = snprintf(buf + len, size - len, "],\"more\":%d}", more);
+    len += (uint16_t)n;
+
+    q->seq++;
+    if (!more) {
+        q->active = 0;
+    }
+
+    return len;
+}
+
+/**
+  * @brief  调试打印函数 - 使用统一日志库
+  */
+void TimeSeries_DebugPrint(const char *format, ...)
+{
+#if TIMESERIES_DEBUG_ENABLE
+    static LOG_Tag_t *logTag;
+    va_list args;
+    
+    /* 先判断标签级别, 关闭时不做格式化 */
+    if (!LOG_TagEnabled(&logTag, "TS", LOG_LEVEL_DEBUG)) return;
+    
+    va_start(args, format);
+    LOG_VRaw(format, args);
+    va_end(args);
+#else
+    (void)format;
+#endif
+}
+
+/* End of file ---------------------------------------------------------------*/
@@ -0,0 +1,202 @@
+/**
+  ******************************************************************************
+  * @file           : bench_ctrl_latency.c
+  * @brief          : 控制路径时延基准 (stm32/control -> LED1 引脚, 主机仿真)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 用法: bench_ctrl_latency [命令数=2000] [MQTT处理周期ms=5000] [主循环间隔ms=10]
+  *
+  * 云端 (broker_sim) 交替下发 {"led1":true} / {"led1":false}, 设备侧按 main.c
+  * 的节奏运行: 每个主循环间隔一轮, 每轮先用 MQTT_ProcessPending 分发暂存的
+  * 订阅消息, 到了MQTT处理周期再调用 MQTT_ProcessData, 回调中交给 Control_Handle。每条命令等引脚变化后再随机停顿 0~1 个处理周期,
+  * 让命令到达时刻相对处理周期的相位均匀分布。
+  *
+  * 输出 ctrl_latency 各阶段 (中断入口起) 的 p50/p99/max, 以及从云端发布到
+  * 引脚变化的时延 (含代理往返和串口线上时间)。主机上只有虚拟时间,
+  * 中断/解析/JSON/GPIO 各阶段为0, 这些阶段的CPU耗时在目标板上用
+  * stm32/prof/query "ctrl" 读取。
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "host_hal.h"
+#include "usart.h"
+#include "dma.h"
+#include "gpio.h"
+#include "log.h"
+#include "esp8266.h"
+#include "esp8266_mqtt.h"
+#include "esp8266_sim.h"
+#include "broker_sim.h"
+#include "control.h"
+#include "ctrl_latency.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+#define BENCH_TOPIC_CONTROL     "stm32/control"
+
+/* 默认参数 (与 main.c 相同) */
+#define BENCH_DEFAULT_COUNT     2000
+#define BENCH_DEFAULT_SERVICE   5000
+#define BENCH_DEFAULT_LOOP      10
+
+/* Private variables ---------------------------------------------------------*/
+
+static uint32_t benchRng = 12345;
+
+/* Private functions ---------------------------------------------------------*/
+
+static uint32_t Bench_Rand(void)
+{
+    benchRng ^= benchRng << 13;
+    benchRng ^= benchRng >> 17;
+    benchRng ^= benchRng << 5;
+    return benchRng;
+}
+
+static int Bench_Compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+  * @brief  与 main.c 的 OnMQTTMessageReceived 相同的控制分支
+  */
+static void Bench_OnMessage(MQTT_Message_t *message)
+{
+    LOG_I("MQTT", "Message received!");
+    LOG_D("MQTT", "Topic: %s", message->topic);
+    LOG_D("MQTT", "Data: %s", message->data);
+
+    if (strcmp(message->topic, BENCH_TOPIC_CONTROL) == 0) {
+        Control_Handle((char *)message->data);
+    }
+}
+
+static int Bench_Connect(void)
+{
+    Host_UartAttach(&huart1, NULL, NULL);
+    LOG_Init(&huart1);
+
+    EspSim_Init(&huart3, NULL);
+    Host_UartSetIrqHook(&huart3, CtrlLatency_IrqEntry);
+
+    if (ESP8266_Init(&huart3) != ESP8266_OK ||
+        ESP8266_ConnectAP("bench", "bench") != ESP8266_OK ||
+        MQTT_Init() != MQTT_OK ||
+        MQTT_SetUserConfigSimple("stm32", "", "") != MQTT_OK ||
+        MQTT_SetBroker("broker.local", 1883, 1) != MQTT_OK ||
+        MQTT_Connect() != MQTT_OK ||
+        MQTT_Subscribe(BENCH_TOPIC_CONTROL, MQTT_QOS_1) != MQTT_OK) {
+        fprintf(stderr, "bench: bring-up failed\n");
+        return 1;
+    }
+
+    MQTT_SetOnMessageReceived(Bench_OnMessage);
+    return 0;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+    uint32_t count = argc > 1 ? (uint32_t)atoi(argv[1]) : BENCH_DEFAULT_COUNT;
+    uint32_t service = argc > 2 ? (uint32_t)atoi(argv[2]) : BENCH_DEFAULT_SERVICE;
+    uint32_t loop = argc > 3 ? (uint32_t)atoi(argv[3]) : BENCH_DEFAULT_LOOP;
+    uint32_t *cloud;
+    uint32_t serviceTick, start, pause, i;
+    uint32_t lost = 0;
+    CtrlLatency_Stats_t stats;
+    char report[CTRL_LAT_REPORT_SIZE];
+
+    if (count == 0 || service == 0 || loop == 0) {
+        fprintf(stderr, "usage: %s [count] [service_ms] [loop_ms]\n", argv[0]);
+        return 2;
+    }
+
+    Host_Init();
+    MX_GPIO_Init();
+    MX_DMA_Init();
+    MX_USART1_UART_Init();
+    MX_USART3_UART_Init();
+    BrokerSim_Reset();
+
+    if (Bench_Connect()) {
+        return 1;
+    }
+
+    cloud = (uint32_t *)malloc(count * sizeof(uint32_t));
+    CtrlLatency_Reset();
+    serviceTick = HAL_GetTick();
+
+    for (i = 0; i < count; i++) {
+        GPIO_PinState want = (i & 1) ? GPIO_PIN_RESET : GPIO_PIN_SET;
+        const char *cmd = (want == GPIO_PIN_SET) ? "{\"led1\":true}" : "{\"led1\":false}";
+
+        start = HAL_GetTick();
+        BrokerSim_Publish(BENCH_TOPIC_CONTROL, (const uint8_t *)cmd, (uint16_t)strlen(cmd), 1, 0);
+
+        /* 主循环, 直到引脚变化 (最多3个处理周期) */
+        while (HAL_GPIO_ReadPin(LED1_GPIO_Port, LED1_Pin) != want) {
+            if (HAL_GetTick() - start > 3 * service) {
+                lost++;
+                break;
+            }
+            HAL_Delay(loop - 1);
+            MQTT_ProcessPending();
+            if (HAL_GetTick() - serviceTick >= service) {
+                serviceTick = HAL_GetTick();
+                MQTT_ProcessData();
+            }
+        }
+        cloud[i] = HAL_GetTick() - start;
+
+        /* 随机相位 */
+        pause = Bench_Rand() % service;
+        while (pause >= loop) {
+            HAL_Delay(loop - 1);
+            pause -= loop;
+            MQTT_ProcessPending();
+            if (HAL_GetTick() - serviceTick >= service) {
+                serviceTick = HAL_GetTick();
+                MQTT_ProcessData();
+            }
+        }
+    }
+
+    printf("ctrl latency: %lu commands, service %lu ms, loop %lu ms, lost %lu, incomplete %lu\n",
+           (unsigned long)count, (unsigned long)service, (unsigned long)loop,
+           (unsigned long)lost, (unsigned long)ctrlLatency.incomplete);
+    printf("%-9s %8s %10s %10s %10s  (us)\n", "stage", "n", "p50", "p99", "max");
+    for (i = 0; i < CTRL_LAT_STAGE_COUNT; i++) {
+        CtrlLatency_GetStats((CtrlLatency_Stage_t)i, &stats);
+        printf("%-9s %8lu %10lu %10lu %10lu\n", CtrlLatency_GetName((CtrlLatency_Stage_t)i),
+               (unsigned long)stats.count,
+               (unsigned long)((uint64_t)CtrlLatency_Percentile(&stats, 500) * 1000000ULL / SystemCoreClock),
+               (unsigned long)((uint64_t)CtrlLatency_Percentile(&stats, 990) * 1000000ULL / SystemCoreClock),
+               (unsigned long)((uint64_t)stats.max * 1000000ULL / SystemCoreClock));
+    }
+
+    /* 云端发布 -> 引脚: 逐条保存, 精确百分位 */
+    qsort(cloud, count, sizeof(uint32_t), Bench_Compare);
+    printf("%-9s %8lu %10lu %10lu %10lu  (cloud publish -> pin)\n", "cloud", (unsigned long)count,
+           (unsigned long)cloud[(count - 1) / 2] * 1000UL,
+           (unsigned long)cloud[(count * 99 + 99) / 100 - 1] * 1000UL,
+           (unsigned long)cloud[count - 1] * 1000UL);
+
+    CtrlLatency_Format(report, sizeof(report));
+    printf("%s\n", report);
+
+    CtrlLatency_GetStats(CTRL_LAT_STAGE_TOTAL, &stats);
+    free(cloud);
+    EspSim_DeInit();
+    return (lost == 0 && stats.count == count) ? 0 : 1;
+}
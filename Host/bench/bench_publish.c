@@ -0,0 +1,136 @@
+/**
+  ******************************************************************************
+  * @file           : bench_publish.c
+  * @brief          : MQTT发布吞吐扫描基准 (主机仿真)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 用法: bench_publish [每个组合的发布次数=50] > publish.csv
+  *
+  * 真实驱动对接 esp8266_sim, 扫描 发布接口 x 载荷 (16B~4KB) x QoS (0~2)
+  * x 波特率 x 模块处理延时, 每个组合由 PubBench_Run 运行并输出一行CSV
+  * (列含义见 pub_bench.h)。波特率经 AT+UART_CUR 切换, 仿真模块随之改变
+  * 应答的线上时间。
+  *
+  * 主机上CPU开销不占虚拟时间, cpu_busy_pct 只反映驱动不经 ESP8266_Delay
+  * 的忙等; CPU占用以目标板 (stm32/prof/query "bench") 的结果为准。
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "host_hal.h"
+#include "usart.h"
+#include "dma.h"
+#include "gpio.h"
+#include "esp8266.h"
+#include "esp8266_mqtt.h"
+#include "esp8266_sim.h"
+#include "broker_sim.h"
+#include "pub_bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+#define BENCH_DEFAULT_COUNT     50
+
+#define BENCH_ARRAY_SIZE(a)     (sizeof(a) / sizeof((a)[0]))
+
+/* Private variables ---------------------------------------------------------*/
+
+static const uint16_t benchSizes[] = {16, 64, 256, 1024, 4096};
+static const uint32_t benchBauds[] = {115200, 460800, 921600};
+static const uint32_t benchLatencies[] = {500, 5000, 20000};
+
+/* 代理侧收到的基准消息 */
+static uint32_t benchDelivered = 0;
+
+/* Private functions ---------------------------------------------------------*/
+
+static void Bench_Deliver(const char *topic, const uint8_t *payload, uint16_t len,
+                          uint8_t qos, uint8_t retain, void *ctx)
+{
+    benchDelivered++;
+}
+
+static int Bench_Connect(void)
+{
+    EspSim_Init(&huart3, NULL);
+
+    if (ESP8266_Init(&huart3) != ESP8266_OK ||
+        ESP8266_ConnectAP("bench", "bench") != ESP8266_OK ||
+        MQTT_Init() != MQTT_OK ||
+        MQTT_SetUserConfigSimple("stm32", "", "") != MQTT_OK ||
+        MQTT_SetBroker("broker.local", 1883, 1) != MQTT_OK ||
+        MQTT_Connect() != MQTT_OK) {
+        fprintf(stderr, "bench: bring-up failed\n");
+        return 1;
+    }
+
+    BrokerSim_Subscribe(PUB_BENCH_TOPIC, 2, Bench_Deliver, NULL);
+    return 0;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+    uint16_t count = argc > 1 ? (uint16_t)atoi(argv[1]) : BENCH_DEFAULT_COUNT;
+    PubBench_Case_t bench;
+    PubBench_Result_t result;
+    char csv[PUB_BENCH_CSV_SIZE];
+    uint32_t sent = 0, ok = 0;
+    uint8_t b, l, s, q, a;
+
+    if (count == 0) {
+        fprintf(stderr, "usage: %s [count]\n", argv[0]);
+        return 2;
+    }
+
+    Host_Init();
+    MX_GPIO_Init();
+    MX_DMA_Init();
+    MX_USART3_UART_Init();
+    BrokerSim_Reset();
+
+    if (Bench_Connect()) {
+        return 1;
+    }
+
+    printf("%s\n", PubBench_CsvHeader());
+
+    for (b = 0; b < BENCH_ARRAY_SIZE(benchBauds); b++) {
+        for (l = 0; l < BENCH_ARRAY_SIZE(benchLatencies); l++) {
+            espSim.config.cmdLatencyUs = benchLatencies[l];
+            for (s = 0; s < BENCH_ARRAY_SIZE(benchSizes); s++) {
+                for (q = MQTT_QOS_0; q <= MQTT_QOS_2; q++) {
+                    for (a = 0; a < PUB_BENCH_API_COUNT; a++) {
+                        bench.api = (PubBench_Api_t)a;
+                        bench.payload = benchSizes[s];
+                        bench.qos = (MQTT_QoS_t)q;
+                        bench.baud = benchBauds[b];
+                        bench.latencyUs = benchLatencies[l];
+                        bench.count = count;
+
+                        if (PubBench_Run(&bench, &result) != MQTT_OK) {
+                            fprintf(stderr, "bench: baud %lu rejected\n", (unsigned long)bench.baud);
+                            return 1;
+                        }
+                        PubBench_FormatCsv(&bench, &result, csv, sizeof(csv));
+                        printf("%s\n", csv);
+                        sent += result.sent;
+                        ok += result.ok;
+                    }
+                }
+            }
+        }
+    }
+
+    fprintf(stderr, "bench: %lu published, %lu ok, %lu delivered, virtual %lu ms\n",
+            (unsigned long)sent, (unsigned long)ok, (unsigned long)benchDelivered,
+            (unsigned long)HAL_GetTick());
+    EspSim_DeInit();
+    return (ok == sent && benchDelivered == sent) ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+/**
+  ******************************************************************************
+  * @file           : host_cmsis.h
+  * @brief          : 主机构建用的CMSIS编译器层 (代替 cmsis_gcc.h)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 由 CMakeLists.txt 以 -include 强制包含, 先占用 cmsis_gcc.h 的头文件保护宏,
+  * 之后 core_cm4.h 再包含它时整个文件被跳过。cmsis_gcc.h 里的内联汇编只能在
+  * ARM上编译, 这里给出同名的主机实现:
+  *   - PRIMASK / IPSR 是普通变量, 仿真层在模拟中断上下文时设置 hostIpsr
+  *   - 内存屏障映射为 __atomic_thread_fence, WFI/WFE/SEV/NOP 为空操作
+  *   - 不提供 LDREX/STREX, atomic_ops.h 在非ARM编译器上改用 __atomic 内建函数
+  *
+  ******************************************************************************
+  */
+
+#ifndef __HOST_CMSIS_H
+#define __HOST_CMSIS_H
+
+/* 占用 cmsis_gcc.h 的保护宏 */
+#define __CMSIS_GCC_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* CMSIS 编译器相关定义 (与 cmsis_gcc.h 相同) */
+#define __ASM                       __asm
+#define __INLINE                    inline
+#define __STATIC_INLINE             static inline
+#define __STATIC_FORCEINLINE        __attribute__((always_inline)) static inline
+#define __NO_RETURN                 __attribute__((__noreturn__))
+#define __USED                      __attribute__((used))
+#define __WEAK                      __attribute__((weak))
+#define __PACKED                    __attribute__((packed, aligned(1)))
+#define __PACKED_STRUCT             struct __attribute__((packed, aligned(1)))
+#define __PACKED_UNION              union __attribute__((packed, aligned(1)))
+#define __ALIGNED(x)                __attribute__((aligned(x)))
+#define __RESTRICT                  __restrict
+#define __COMPILER_BARRIER()        __asm volatile("" ::: "memory")
+
+/* 空操作 / 低功耗指令: 主机上立即返回 */
+#define __NOP()                     ((void)0)
+#define __WFI()                     ((void)0)
+#define __WFE()                     ((void)0)
+#define __SEV()                     ((void)0)
+
+/* 内存屏障 */
+#define __ISB()                     __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __DSB()                     __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __DMB()                     __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+/* Exported variables --------------------------------------------------------*/
+
+/* 模拟的 PRIMASK (1: 关中断) */
+extern volatile uint32_t hostPrimask;
+
+/* 模拟的 IPSR (0: 线程模式, 否则为当前异常号) */
+extern volatile uint32_t hostIpsr;
+
+/* Exported functions --------------------------------------------------------*/
+
+__STATIC_FORCEINLINE void __enable_irq(void)
+{
+    hostPrimask = 0;
+}
+
+__STATIC_FORCEINLINE void __disable_irq(void)
+{
+    hostPrimask = 1;
+}
+
+__STATIC_FORCEINLINE uint32_t __get_PRIMASK(void)
+{
+    return hostPrimask;
+}
+
+__STATIC_FORCEINLINE void __set_PRIMASK(uint32_t priMask)
+{
+    hostPrimask = priMask & 1UL;
+}
+
+__STATIC_FORCEINLINE uint32_t __get_IPSR(void)
+{
+    return hostIpsr;
+}
+
+__STATIC_FORCEINLINE uint32_t __REV(uint32_t value)
+{
+    return __builtin_bswap32(value);
+}
+
+__STATIC_FORCEINLINE uint8_t __CLZ(uint32_t value)
+{
+    return (value == 0U) ? 32U : (uint8_t)__builtin_clz(value);
+}
+
+#endif /* __HOST_CMSIS_H */
@@ -0,0 +1,762 @@
+/**
+  ******************************************************************************
+  * @file           : host_hal.c
+  * @brief          : 主机构建用的HAL仿真层源文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 只实现 Core 模块实际调用到的HAL函数, 行为以固件依赖的部分为准:
+  * 状态机字段 (gState/RxState)、DMA剩余计数、回调时机。初始化类函数
+  * (时钟、NVIC、DMA) 只返回 HAL_OK。
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "host_hal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Private types -------------------------------------------------------------*/
+
+/**
+  * @brief  时钟钩子登记项
+  */
+typedef struct {
+    Host_ClockHook_t hook;
+    void *ctx;
+} Host_HookEntry_t;
+
+/**
+  * @brief  仿真串口
+  */
+typedef struct {
+    UART_HandleTypeDef *huart;      /**< 对应的HAL句柄 */
+    Host_UartTxHandler_t txHandler; /**< 发送处理函数 */
+    void *txCtx;                    /**< 发送处理函数上下文 */
+    Host_UartIrqHook_t irqHook;     /**< 中断入口钩子 */
+    uint32_t txDoneTick;            /**< DMA发送完成时刻 */
+    uint8_t txPending;              /**< DMA发送进行中 */
+    uint8_t *rxBuf;                 /**< ReceiveToIdle_DMA 缓冲区 */
+    uint16_t rxSize;                /**< 缓冲区大小 */
+    uint16_t rxPos;                 /**< 已写入字节数 */
+    uint8_t rxActive;               /**< 接收进行中 */
+    Host_UartStats_t stats;         /**< 统计 */
+} Host_Uart_t;
+
+/* Exported variables --------------------------------------------------------*/
+
+/* 模拟的外设/内核地址空间 (见 stm32f4xx_hal_conf.h) */
+uint8_t hostPeriphMem[HOST_PERIPH_SIZE] __attribute__((aligned(1024)));
+uint8_t hostPeriphBitband[HOST_PERIPH_BB_SIZE] __attribute__((aligned(1024)));
+uint8_t hostCoreMem[HOST_CORE_SIZE] __attribute__((aligned(1024)));
+uint8_t hostSysMem[HOST_SYS_SIZE] __attribute__((aligned(16)));
+
+/* 模拟的 PRIMASK / IPSR (见 host_cmsis.h) */
+volatile uint32_t hostPrimask = 0;
+volatile uint32_t hostIpsr = 0;
+
+/* HAL 全局变量 (stm32f4xx_hal.c / system_stm32f4xx.c) */
+__IO uint32_t uwTick = 0;
+uint32_t uwTickPrio = (1UL << __NVIC_PRIO_BITS);
+HAL_TickFreqTypeDef uwTickFreq = HAL_TICK_FREQ_DEFAULT;
+uint32_t SystemCoreClock = 168000000UL;
+
+/* Private variables ---------------------------------------------------------*/
+
+static Host_HookEntry_t hostHooks[HOST_CLOCK_HOOKS_MAX];
+static Host_Uart_t hostUarts[HOST_UART_MAX];
+
+/* 时钟未推进时的 HAL_GetTick 查询次数 */
+static uint32_t hostSpinPolls = 0;
+
+/* 正在推进时钟 (钩子/回调中不再自动推进) */
+static uint8_t hostAdvancing = 0;
+
+static Host_GpioHook_t hostGpioHook = NULL;
+static void *hostGpioCtx = NULL;
+
+/* Private function prototypes -----------------------------------------------*/
+static Host_Uart_t* Host_UartFind(UART_HandleTypeDef *huart, uint8_t create);
+static uint32_t Host_UartIrq(UART_HandleTypeDef *huart);
+static void Host_UartDeliver(Host_Uart_t *uart, const uint8_t *data, uint16_t len);
+static void Host_UartRxEvent(Host_Uart_t *uart);
+static void Host_Tick(void);
+static void Host_SysMemInit(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  查找仿真串口
+  * @param  create 不存在时分配
+  */
+static Host_Uart_t* Host_UartFind(UART_HandleTypeDef *huart, uint8_t create)
+{
+    uint8_t i;
+
+    for (i = 0; i < HOST_UART_MAX; i++) {
+        if (hostUarts[i].huart == huart) {
+            return &hostUarts[i];
+        }
+    }
+
+    if (!create) {
+        return NULL;
+    }
+
+    for (i = 0; i < HOST_UART_MAX; i++) {
+        if (hostUarts[i].huart == NULL) {
+            memset(&hostUarts[i], 0, sizeof(Host_Uart_t));
+            hostUarts[i].huart = huart;
+            return &hostUarts[i];
+        }
+    }
+
+    fprintf(stderr, "host_hal: too many UARTs\n");
+    abort();
+}
+
+/**
+  * @brief  串口对应的异常号 (回调期间 __get_IPSR 的返回值)
+  */
+static uint32_t Host_UartIrq(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance == USART1) return 16U + USART1_IRQn;
+    if (huart->Instance == USART2) return 16U + USART2_IRQn;
+    if (huart->Instance == USART3) return 16U + USART3_IRQn;
+    return 16U;
+}
+
+/**
+  * @brief  把发出的数据交给对端
+  */
+static void Host_UartDeliver(Host_Uart_t *uart, const uint8_t *data, uint16_t len)
+{
+    uart->stats.txBytes += len;
+    uart->stats.txFrames++;
+
+    if (uart->txHandler != NULL) {
+        uart->txHandler(uart->huart, data, len, uart->txCtx);
+    }
+}
+
+/**
+  * @brief  结束本次 ReceiveToIdle 接收并回调 (中断上下文)
+  */
+static void Host_UartRxEvent(Host_Uart_t *uart)
+{
+    uint32_t ipsr = hostIpsr;
+    uint16_t size = uart->rxPos;
+
+    /* HAL 在IDLE/传输完成事件后停止接收, 回调中重新启动 */
+    uart->rxActive = 0;
+    uart->huart->RxState = HAL_UART_STATE_READY;
+    uart->stats.rxEvents++;
+
+    hostIpsr = Host_UartIrq(uart->huart);
+    if (uart->irqHook != NULL) {
+        uart->irqHook();
+    }
+    HAL_UARTEx_RxEventCallback(uart->huart, size);
+    hostIpsr = ipsr;
+}
+
+/**
+  * @brief  推进1ms: 计数, 完成到期的发送, 调用钩子
+  */
+static void Host_Tick(void)
+{
+    uint32_t ipsr;
+    uint8_t i;
+
+    uwTick += uwTickFreq;
+    hostSpinPolls = 0;
+
+    for (i = 0; i < HOST_UART_MAX; i++) {
+        Host_Uart_t *uart = &hostUarts[i];
+
+        if (uart->huart == NULL || !uart->txPending || (int32_t)(uwTick - uart->txDoneTick) < 0) {
+            continue;
+        }
+
+        uart->txPending = 0;
+        uart->huart->gState = HAL_UART_STATE_READY;
+
+        ipsr = hostIpsr;
+        hostIpsr = Host_UartIrq(uart->huart);
+        HAL_UART_TxCpltCallback(uart->huart);
+        hostIpsr = ipsr;
+    }
+
+    ipsr = hostIpsr;
+    hostIpsr = 16U + (uint32_t)SysTick_IRQn;
+    for (i = 0; i < HOST_CLOCK_HOOKS_MAX; i++) {
+        if (hostHooks[i].hook != NULL) {
+            hostHooks[i].hook(uwTick, hostHooks[i].ctx);
+        }
+    }
+    hostIpsr = ipsr;
+}
+
+/**
+  * @brief  系统存储区: UID 与典型的出厂校准值
+  */
+static void Host_SysMemInit(void)
+{
+    static const uint32_t uid[3] = { 0x00420037UL, 0x3233510DUL, 0x38363938UL };
+
+    memset(hostSysMem, 0, sizeof(hostSysMem));
+    memcpy((void *)UID_BASE, uid, sizeof(uid));
+    *(uint16_t *)FLASHSIZE_BASE = 1024;                 /* KB */
+    *(uint16_t *)(UID_BASE + 0x1AU) = 1500;             /* VREFINT_CAL (3.3V) */
+    *(uint16_t *)(UID_BASE + 0x1CU) = 940;              /* TS_CAL1 (30°C) */
+    *(uint16_t *)(UID_BASE + 0x1EU) = 1200;             /* TS_CAL2 (110°C) */
+}
+
+/* Exported functions: 仿真接口 ----------------------------------------------*/
+
+/**
+  * @brief  复位仿真层
+  */
+void Host_Init(void)
+{
+    memset(hostPeriphMem, 0, sizeof(hostPeriphMem));
+    memset(hostCoreMem, 0, sizeof(hostCoreMem));
+    Host_SysMemInit();
+    memset(hostHooks, 0, sizeof(hostHooks));
+    memset(hostUarts, 0, sizeof(hostUarts));
+
+    uwTick = 0;
+    uwTickFreq = HAL_TICK_FREQ_DEFAULT;
+    hostPrimask = 0;
+    hostIpsr = 0;
+    hostSpinPolls = 0;
+    hostAdvancing = 0;
+    hostGpioHook = NULL;
+    hostGpioCtx = NULL;
+}
+
+/**
+  * @brief  推进虚拟时钟
+  */
+void Host_ClockAdvance(uint32_t ms)
+{
+    uint8_t advancing = hostAdvancing;
+
+    hostAdvancing = 1;
+    while (ms--) {
+        Host_Tick();
+    }
+    hostAdvancing = advancing;
+}
+
+/**
+  * @brief  登记时钟钩子
+  */
+uint8_t Host_ClockAddHook(Host_ClockHook_t hook, void *ctx)
+{
+    uint8_t i;
+
+    for (i = 0; i < HOST_CLOCK_HOOKS_MAX; i++) {
+        if (hostHooks[i].hook == NULL) {
+            hostHooks[i].hook = hook;
+            hostHooks[i].ctx = ctx;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+  * @brief  注销时钟钩子
+  */
+void Host_ClockRemoveHook(Host_ClockHook_t hook, void *ctx)
+{
+    uint8_t i;
+
+    for (i = 0; i < HOST_CLOCK_HOOKS_MAX; i++) {
+        if (hostHooks[i].hook == hook && hostHooks[i].ctx == ctx) {
+            hostHooks[i].hook = NULL;
+            hostHooks[i].ctx = NULL;
+        }
+    }
+}
+
+/**
+  * @brief  登记串口发送处理函数
+  */
+void Host_UartAttach(UART_HandleTypeDef *huart, Host_UartTxHandler_t handler, void *ctx)
+{
+    Host_Uart_t *uart = Host_UartFind(huart, 1);
+
+    uart->txHandler = handler;
+    uart->txCtx = ctx;
+}
+
+/**
+  * @brief  登记串口中断入口钩子
+  */
+void Host_UartSetIrqHook(UART_HandleTypeDef *huart, Host_UartIrqHook_t hook)
+{
+    Host_Uart_t *uart = Host_UartFind(huart, 1);
+
+    uart->irqHook = hook;
+}
+
+/**
+  * @brief  发送处理函数: 写到标准输出
+  */
+void Host_UartToStdout(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t len, void *ctx)
+{
+    (void)huart;
+    (void)ctx;
+    fwrite(data, 1, len, stdout);
+}
+
+/**
+  * @brief  模拟对端发来一段数据
+  */
+uint16_t Host_UartInject(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t len)
+{
+    Host_Uart_t *uart = Host_UartFind(huart, 1);
+    uint16_t accepted = 0;
+    uint16_t n;
+
+    while (len > 0) {
+        if (!uart->rxActive) {
+            uart->stats.rxDropped += len;
+            break;
+        }
+
+        n = uart->rxSize - uart->rxPos;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(uart->rxBuf + uart->rxPos, data, n);
+        uart->rxPos += n;
+        uart->stats.rxBytes += n;
+        if (huart->hdmarx != NULL) {
+            huart->hdmarx->Instance->NDTR = uart->rxSize - uart->rxPos;
+        }
+        data += n;
+        len -= n;
+        accepted += n;
+
+        /* 缓冲区满: DMA传输完成事件 */
+        if (uart->rxPos == uart->rxSize) {
+            Host_UartRxEvent(uart);
+        }
+    }
+
+    /* 一次注入结束后线路空闲: IDLE事件 */
+    if (uart->rxActive && uart->rxPos > 0) {
+        Host_UartRxEvent(uart);
+    }
+
+    return accepted;
+}
+
+/**
+  * @brief  是否正在接收
+  */
+uint8_t Host_UartRxActive(UART_HandleTypeDef *huart)
+{
+    Host_Uart_t *uart = Host_UartFind(huart, 0);
+
+    return (uart != NULL) ? uart->rxActive : 0;
+}
+
+/**
+  * @brief  获取串口仿真统计
+  */
+void Host_UartGetStats(UART_HandleTypeDef *huart, Host_UartStats_t *stats)
+{
+    Host_Uart_t *uart = Host_UartFind(huart, 0);
+
+    if (uart != NULL) {
+        *stats = uart->stats;
+    } else {
+        memset(stats, 0, sizeof(Host_UartStats_t));
+    }
+}
+
+/**
+  * @brief  按波特率计算线上时间
+  */
+uint32_t Host_UartWireUs(UART_HandleTypeDef *huart, uint32_t len)
+{
+    uint32_t baud = huart->Init.BaudRate;
+
+    if (baud == 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)len * HOST_UART_BITS_PER_BYTE * 1000000ULL + baud - 1) / baud);
+}
+
+/**
+  * @brief  设置GPIO输入电平
+  */
+void Host_GpioSetInput(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state)
+{
+    if (state != GPIO_PIN_RESET) {
+        port->IDR |= pin;
+    } else {
+        port->IDR &= ~(uint32_t)pin;
+    }
+}
+
+/**
+  * @brief  登记GPIO写钩子
+  */
+void Host_GpioSetWriteHook(Host_GpioHook_t hook, void *ctx)
+{
+    hostGpioHook = hook;
+    hostGpioCtx = ctx;
+}
+
+/**
+  * @brief  设置ADC转换结果
+  */
+void Host_AdcSetValue(ADC_HandleTypeDef *hadc, uint32_t value)
+{
+    hadc->Instance->DR = value;
+}
+
+/* Exported functions: HAL 基础 -----------------------------------------------*/
+
+uint32_t HAL_GetTick(void)
+{
+    /* 忙等循环: 查询足够多次仍未推进则视为过了1ms */
+    if (!hostAdvancing && ++hostSpinPolls >= HOST_TICK_SPIN_POLLS) {
+        Host_ClockAdvance(1);
+    }
+    return uwTick;
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+    uint32_t tickstart = uwTick;
+    uint32_t wait = Delay;
+
+    /* 与HAL相同: 至少等待一个完整的节拍 */
+    if (wait < HAL_MAX_DELAY) {
+        wait += (uint32_t)uwTickFreq;
+    }
+
+    if (hostAdvancing) {
+        return;
+    }
+    while ((uwTick - tickstart) < wait) {
+        Host_ClockAdvance(1);
+    }
+}
+
+void HAL_IncTick(void)
+{
+    uwTick += uwTickFreq;
+}
+
+void HAL_SuspendTick(void)
+{
+}
+
+void HAL_ResumeTick(void)
+{
+}
+
+void Error_Handler(void)
+{
+    fprintf(stderr, "host_hal: Error_Handler at tick %lu\n", (unsigned long)uwTick);
+    abort();
+}
+
+/* Exported functions: RCC / PWR / NVIC / DMA ---------------------------------*/
+
+uint32_t HAL_RCC_GetHCLKFreq(void)
+{
+    return SystemCoreClock;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+    return SystemCoreClock / 4U;
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq(void)
+{
+    return SystemCoreClock / 2U;
+}
+
+void HAL_PWR_EnableBkUpAccess(void)
+{
+}
+
+void HAL_PWR_EnterSLEEPMode(uint32_t Regulator, uint8_t SLEEPEntry)
+{
+    (void)Regulator;
+    (void)SLEEPEntry;
+
+    /* WFI: 睡到下一个节拍 */
+    Host_ClockAdvance(1);
+}
+
+void HAL_PWR_EnterSTOPMode(uint32_t Regulator, uint8_t STOPEntry)
+{
+    (void)Regulator;
+    (void)STOPEntry;
+    Host_ClockAdvance(1);
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+    (void)IRQn;
+    (void)PreemptPriority;
+    (void)SubPriority;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    (void)IRQn;
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    (void)IRQn;
+}
+
+void HAL_NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+    (void)IRQn;
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma)
+{
+    if (hdma == NULL) {
+        return HAL_ERROR;
+    }
+    hdma->State = HAL_DMA_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma)
+{
+    if (hdma == NULL) {
+        return HAL_ERROR;
+    }
+    hdma->State = HAL_DMA_STATE_RESET;
+    return HAL_OK;
+}
+
+/* Exported functions: GPIO ---------------------------------------------------*/
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+    (void)GPIOx;
+    (void)GPIO_Init;
+}
+
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin)
+{
+    (void)GPIOx;
+    (void)GPIO_Pin;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    return (GPIOx->IDR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    if (PinState != GPIO_PIN_RESET) {
+        GPIOx->ODR |= GPIO_Pin;
+    } else {
+        GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+    }
+
+    /* 输出引脚的输入寄存器反映输出电平 */
+    Host_GpioSetInput(GPIOx, GPIO_Pin, PinState);
+
+    if (hostGpioHook != NULL) {
+        hostGpioHook(GPIOx, GPIO_Pin, PinState, hostGpioCtx);
+    }
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    HAL_GPIO_WritePin(GPIOx, GPIO_Pin, (GPIOx->ODR & GPIO_Pin) ? GPIO_PIN_RESET : GPIO_PIN_SET);
+}
+
+/* Exported functions: ADC ----------------------------------------------------*/
+
+HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef *hadc)
+{
+    if (hadc == NULL) {
+        return HAL_ERROR;
+    }
+    if (hadc->State == HAL_ADC_STATE_RESET) {
+        HAL_ADC_MspInit(hadc);
+    }
+    hadc->State = HAL_ADC_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_ConfigChannel(ADC_HandleTypeDef *hadc, ADC_ChannelConfTypeDef *sConfig)
+{
+    (void)hadc;
+    (void)sConfig;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Start(ADC_HandleTypeDef *hadc)
+{
+    hadc->State = HAL_ADC_STATE_REG_BUSY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Stop(ADC_HandleTypeDef *hadc)
+{
+    hadc->State = HAL_ADC_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_PollForConversion(ADC_HandleTypeDef *hadc, uint32_t Timeout)
+{
+    (void)Timeout;
+    hadc->State |= HAL_ADC_STATE_REG_EOC;
+    return HAL_OK;
+}
+
+uint32_t HAL_ADC_GetValue(ADC_HandleTypeDef *hadc)
+{
+    return hadc->Instance->DR;
+}
+
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *hadc, uint32_t *pData, uint32_t Length)
+{
+    uint16_t *buf = (uint16_t *)pData;
+    uint32_t i;
+
+    /* 循环DMA的缓冲区一次填满当前DR值, 之后由 Host_AdcSetValue 改变 DR 不会回写 */
+    for (i = 0; i < Length; i++) {
+        buf[i] = (uint16_t)hadc->Instance->DR;
+    }
+    hadc->State = HAL_ADC_STATE_REG_BUSY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Stop_DMA(ADC_HandleTypeDef *hadc)
+{
+    hadc->State = HAL_ADC_STATE_READY;
+    return HAL_OK;
+}
+
+/* Exported functions: UART ---------------------------------------------------*/
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+    if (huart == NULL) {
+        return HAL_ERROR;
+    }
+    if (huart->gState == HAL_UART_STATE_RESET) {
+        HAL_UART_MspInit(huart);
+    }
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    Host_UartFind(huart, 1);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void)Timeout;
+
+    if (pData == NULL || Size == 0) {
+        return HAL_ERROR;
+    }
+    if (huart->gState != HAL_UART_STATE_READY) {
+        return HAL_BUSY;
+    }
+
+    Host_UartDeliver(Host_UartFind(huart, 1), pData, Size);
+
+    /* 阻塞发送: 调用者等完线上时间 */
+    Host_ClockAdvance(Host_UartWireUs(huart, Size) / 1000U);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+    Host_Uart_t *uart;
+    uint32_t wireMs;
+
+    if (pData == NULL || Size == 0) {
+        return HAL_ERROR;
+    }
+    if (huart->gState != HAL_UART_STATE_READY) {
+        return HAL_BUSY;
+    }
+
+    uart = Host_UartFind(huart, 1);
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    Host_UartDeliver(uart, pData, Size);
+
+    /* 传输完成中断最早在下一个节拍处理 */
+    wireMs = (Host_UartWireUs(huart, Size) + 999U) / 1000U;
+    uart->txDoneTick = uwTick + (wireMs > 0 ? wireMs : 1U);
+    uart->txPending = 1;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef *huart)
+{
+    Host_Uart_t *uart = Host_UartFind(huart, 0);
+
+    if (uart != NULL) {
+        uart->txPending = 0;
+    }
+    huart->gState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_DMAStop(UART_HandleTypeDef *huart)
+{
+    Host_Uart_t *uart = Host_UartFind(huart, 0);
+
+    if (uart != NULL) {
+        uart->txPending = 0;
+        uart->rxActive = 0;
+    }
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    Host_Uart_t *uart;
+
+    if (pData == NULL || Size == 0) {
+        return HAL_ERROR;
+    }
+    if (huart->RxState != HAL_UART_STATE_READY) {
+        return HAL_BUSY;
+    }
+
+    uart = Host_UartFind(huart, 1);
+    uart->rxBuf = pData;
+    uart->rxSize = Size;
+    uart->rxPos = 0;
+    uart->rxActive = 1;
+
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+    huart->ReceptionType = HAL_UART_RECEPTION_TOIDLE;
+    if (huart->hdmarx != NULL) {
+        huart->hdmarx->Instance->NDTR = Size;
+    }
+    return HAL_OK;
+}
+
+/* End of file ---------------------------------------------------------------*/
@@ -0,0 +1,177 @@
+/**
+  ******************************************************************************
+  * @file           : host_hal.h
+  * @brief          : 主机构建用的HAL仿真层头文件
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 在Linux上链接 Core 模块所需的最小HAL实现, 以及测试/仿真程序驱动它的接口:
+  *
+  *   - 虚拟时钟: HAL_GetTick/HAL_Delay 不读真实时间, 由 Host_ClockAdvance 推进。
+  *     每推进1ms依次完成到期的UART DMA发送, 再调用登记的时钟钩子 (外部模块的
+  *     仿真逻辑在钩子里运行)。忙等 HAL_GetTick 的循环在连续查询
+  *     HOST_TICK_SPIN_POLLS 次后自动推进1ms, 固件的超时循环因此总能结束。
+  *     同一输入下运行结果与主机速度无关。
+  *
+  *   - UART管道: HAL_UART_Transmit_DMA 把数据立即交给该串口登记的发送处理函数,
+  *     按波特率计算线上时间后在时钟推进中完成发送 (TxCpltCallback)。
+  *     Host_UartInject 模拟对端发来的字节: 写入 ReceiveToIdle_DMA 的缓冲区,
+  *     更新DMA剩余计数, 缓冲区满或一次注入结束时 (相当于IDLE) 调用
+  *     HAL_UARTEx_RxEventCallback。
+  *
+  *   - GPIO/ADC: 寄存器在内存中 (见 stm32f4xx_hal_conf.h), WritePin 同时更新
+  *     ODR/IDR, Host_GpioSetInput 设置输入电平; ADC 转换结果取自 DR,
+  *     由 Host_AdcSetValue 设置。
+  *
+  * 中断上下文: 发送完成、接收事件和时钟钩子运行时 __get_IPSR() 返回对应的
+  * 异常号, 依赖它区分中断/线程上下文的代码 (log_mqtt) 行为与目标板一致。
+  * 不模拟 PRIMASK 造成的中断延迟。
+  *
+  ******************************************************************************
+  */
+
+#ifndef __HOST_HAL_H
+#define __HOST_HAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 时钟未推进时连续查询 HAL_GetTick 多少次后自动推进1ms */
+#define HOST_TICK_SPIN_POLLS        1000
+
+/* 最多时钟钩子数 */
+#define HOST_CLOCK_HOOKS_MAX        8
+
+/* 最多仿真串口数 */
+#define HOST_UART_MAX               4
+
+/* 每字节线上位数 (起始位 + 8数据位 + 停止位) */
+#define HOST_UART_BITS_PER_BYTE     10
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  时钟钩子, 每推进1ms调用一次
+  * @param  tick 推进后的 uwTick
+  * @param  ctx 登记时的上下文
+  */
+typedef void (*Host_ClockHook_t)(uint32_t tick, void *ctx);
+
+/**
+  * @brief  串口发送处理函数 (对端收到数据)
+  * @param  huart 发送的串口
+  * @param  data 数据
+  * @param  len 长度
+  * @param  ctx 登记时的上下文
+  */
+typedef void (*Host_UartTxHandler_t)(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t len, void *ctx);
+
+/**
+  * @brief  串口中断入口钩子 (对应 USARTx_IRQHandler 的 USER CODE 0, 在 RxEvent 回调之前调用)
+  */
+typedef void (*Host_UartIrqHook_t)(void);
+
+/**
+  * @brief  GPIO写钩子 (HAL_GPIO_WritePin 后调用)
+  */
+typedef void (*Host_GpioHook_t)(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state, void *ctx);
+
+/**
+  * @brief  串口仿真统计
+  */
+typedef struct {
+    uint32_t txBytes;               /**< 发出字节数 */
+    uint32_t txFrames;              /**< 发送调用次数 (DMA + 阻塞) */
+    uint32_t rxBytes;               /**< 写入接收缓冲区的字节数 */
+    uint32_t rxEvents;              /**< RxEvent 回调次数 */
+    uint32_t rxDropped;             /**< 未在接收中而丢弃的字节数 */
+} Host_UartStats_t;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  复位仿真层 (时钟清零, 清空钩子/串口登记/外设寄存器)
+  */
+void Host_Init(void);
+
+/**
+  * @brief  推进虚拟时钟
+  * @param  ms 毫秒数
+  */
+void Host_ClockAdvance(uint32_t ms);
+
+/**
+  * @brief  登记时钟钩子
+  * @retval uint8_t 1=成功 0=表满
+  */
+uint8_t Host_ClockAddHook(Host_ClockHook_t hook, void *ctx);
+
+/**
+  * @brief  注销时钟钩子
+  */
+void Host_ClockRemoveHook(Host_ClockHook_t hook, void *ctx);
+
+/**
+  * @brief  登记串口发送处理函数 (NULL: 丢弃发送数据)
+  */
+void Host_UartAttach(UART_HandleTypeDef *huart, Host_UartTxHandler_t handler, void *ctx);
+
+/**
+  * @brief  登记串口中断入口钩子 (NULL: 取消)
+  */
+void Host_UartSetIrqHook(UART_HandleTypeDef *huart, Host_UartIrqHook_t hook);
+
+/**
+  * @brief  发送处理函数: 原样写到标准输出 (用于日志串口)
+  */
+void Host_UartToStdout(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t len, void *ctx);
+
+/**
+  * @brief  模拟对端发来一段数据, 结束时产生一次IDLE事件
+  * @retval uint16_t 写入接收缓冲区的字节数, 其余被丢弃
+  */
+uint16_t Host_UartInject(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t len);
+
+/**
+  * @brief  该串口是否正在 ReceiveToIdle_DMA 接收
+  */
+uint8_t Host_UartRxActive(UART_HandleTypeDef *huart);
+
+/**
+  * @brief  获取串口仿真统计
+  */
+void Host_UartGetStats(UART_HandleTypeDef *huart, Host_UartStats_t *stats);
+
+/**
+  * @brief  按波特率计算 len 字节的线上时间 (us)
+  */
+uint32_t Host_UartWireUs(UART_HandleTypeDef *huart, uint32_t len);
+
+/**
+  * @brief  设置GPIO输入电平 (写IDR)
+  */
+void Host_GpioSetInput(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+
+/**
+  * @brief  登记GPIO写钩子 (NULL: 取消)
+  */
+void Host_GpioSetWriteHook(Host_GpioHook_t hook, void *ctx);
+
+/**
+  * @brief  设置ADC转换结果 (写DR)
+  */
+void Host_AdcSetValue(ADC_HandleTypeDef *hadc, uint32_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HOST_HAL_H */
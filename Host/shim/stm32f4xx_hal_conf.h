@@ -0,0 +1,72 @@
+/**
+  ******************************************************************************
+  * @file           : stm32f4xx_hal_conf.h
+  * @brief          : 主机构建用的HAL配置包装 (外设地址重定位到内存)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * Host/shim 排在 Core/Inc 之前, stm32f4xx_hal.h 包含配置头时先进入本文件,
+  * 再用 #include_next 取得 Core/Inc 下真正的配置。此时器件头已经展开, 这里把
+  * 外设基址改指向 host_hal.c 中的内存数组, 所有 GPIOx/USARTx/DMAx/RCC/RTC/
+  * DWT/SCB 的寄存器访问都落在普通内存上:
+  *   - 0x4000_0000 ~ 0x4007_FFFF (APB1/APB2/AHB1) -> hostPeriphMem
+  *   - 外设位带别名区                              -> hostPeriphBitband
+  *   - 0xE000_0000 ~ 0xE000_FFFF (ITM/DWT/SCS)     -> hostCoreMem
+  *   - 0x1FFF_7A00 ~ 0x1FFF_7BFF (UID/出厂校准值)   -> hostSysMem
+  *
+  * 寄存器只是存储单元, 没有硬件行为; 需要行为的地方 (DMA剩余计数、GPIO输入)
+  * 由 host_hal.c 的桩函数和 Host_xxx 接口维护。
+  *
+  ******************************************************************************
+  */
+
+#ifndef __HOST_STM32F4xx_HAL_CONF_H
+#define __HOST_STM32F4xx_HAL_CONF_H
+
+/* Includes ------------------------------------------------------------------*/
+#include_next "stm32f4xx_hal_conf.h"
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 模拟地址空间大小 */
+#define HOST_PERIPH_SIZE            0x00080000UL
+#define HOST_PERIPH_BB_SIZE         (HOST_PERIPH_SIZE * 32UL)
+#define HOST_CORE_SIZE              0x00010000UL
+#define HOST_SYS_SIZE               0x00000200UL
+
+/* Exported variables --------------------------------------------------------*/
+extern uint8_t hostPeriphMem[HOST_PERIPH_SIZE];
+extern uint8_t hostPeriphBitband[HOST_PERIPH_BB_SIZE];
+extern uint8_t hostCoreMem[HOST_CORE_SIZE];
+extern uint8_t hostSysMem[HOST_SYS_SIZE];
+
+/* 外设基址重定位 --------------------------------------------------------------*/
+#undef PERIPH_BASE
+#define PERIPH_BASE                 ((uintptr_t)hostPeriphMem)
+
+#undef PERIPH_BB_BASE
+#define PERIPH_BB_BASE              ((uintptr_t)hostPeriphBitband)
+
+#undef ITM_BASE
+#define ITM_BASE                    ((uintptr_t)hostCoreMem + 0x0000UL)
+
+#undef DWT_BASE
+#define DWT_BASE                    ((uintptr_t)hostCoreMem + 0x1000UL)
+
+#undef SCS_BASE
+#define SCS_BASE                    ((uintptr_t)hostCoreMem + 0xE000UL)
+
+#undef CoreDebug_BASE
+#define CoreDebug_BASE              ((uintptr_t)hostCoreMem + 0xEDF0UL)
+
+#undef UID_BASE
+#define UID_BASE                    ((uintptr_t)hostSysMem + 0x010UL)
+
+#undef FLASHSIZE_BASE
+#define FLASHSIZE_BASE              ((uintptr_t)hostSysMem + 0x022UL)
+
+#undef PACKAGE_BASE
+#define PACKAGE_BASE                ((uintptr_t)hostSysMem + 0x1F0UL)
+
+#endif /* __HOST_STM32F4xx_HAL_CONF_H */
@@ -0,0 +1,213 @@
+/**
+  ******************************************************************************
+  * @file           : broker_sim.c
+  * @brief          : 进程内MQTT代理替身源文件 (主机仿真)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 分发在发布调用中同步完成, 订阅者回调里可以再次发布 (嵌套深度由调用者
+  * 保证有限)。
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "broker_sim.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Exported variables --------------------------------------------------------*/
+
+/* 代理句柄实例 */
+BrokerSim_Handle_t brokerSim = {0};
+
+/* Private function prototypes -----------------------------------------------*/
+static void BrokerSim_Retain(const char *topic, const uint8_t *payload, uint16_t len, uint8_t qos);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  更新保留消息
+  */
+static void BrokerSim_Retain(const char *topic, const uint8_t *payload, uint16_t len, uint8_t qos)
+{
+    BrokerSim_Retained_t *slot = NULL;
+    uint8_t i;
+
+    for (i = 0; i < BROKER_SIM_MAX_RETAINED; i++) {
+        if (strcmp(brokerSim.retained[i].topic, topic) == 0) {
+            slot = &brokerSim.retained[i];
+            break;
+        }
+        if (slot == NULL && brokerSim.retained[i].topic[0] == '\0') {
+            slot = &brokerSim.retained[i];
+        }
+    }
+    if (slot == NULL) {
+        return;
+    }
+
+    free(slot->payload);
+    memset(slot, 0, sizeof(BrokerSim_Retained_t));
+
+    /* 空负载删除保留消息 */
+    if (len == 0) {
+        return;
+    }
+
+    slot->payload = (uint8_t *)malloc(len);
+    if (slot->payload == NULL) {
+        return;
+    }
+    memcpy(slot->payload, payload, len);
+    strncpy(slot->topic, topic, BROKER_SIM_TOPIC_LEN - 1);
+    slot->len = len;
+    slot->qos = qos;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  复位
+  */
+void BrokerSim_Reset(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < BROKER_SIM_MAX_RETAINED; i++) {
+        free(brokerSim.retained[i].payload);
+    }
+    memset(&brokerSim, 0, sizeof(BrokerSim_Handle_t));
+}
+
+/**
+  * @brief  订阅
+  */
+uint8_t BrokerSim_Subscribe(const char *filter, uint8_t qos, BrokerSim_Deliver_t deliver, void *ctx)
+{
+    BrokerSim_Sub_t *sub = NULL;
+    uint8_t i;
+
+    if (filter == NULL || deliver == NULL || strlen(filter) >= BROKER_SIM_TOPIC_LEN) {
+        return 0;
+    }
+
+    for (i = 0; i < BROKER_SIM_MAX_SUBS; i++) {
+        BrokerSim_Sub_t *s = &brokerSim.subs[i];
+
+        if (s->deliver == deliver && s->ctx == ctx && strcmp(s->filter, filter) == 0) {
+            s->qos = qos;
+            return 1;
+        }
+        if (sub == NULL && s->deliver == NULL) {
+            sub = s;
+        }
+    }
+    if (sub == NULL) {
+        return 0;
+    }
+
+    strcpy(sub->filter, filter);
+    sub->qos = qos;
+    sub->deliver = deliver;
+    sub->ctx = ctx;
+
+    for (i = 0; i < BROKER_SIM_MAX_RETAINED; i++) {
+        BrokerSim_Retained_t *r = &brokerSim.retained[i];
+
+        if (r->topic[0] != '\0' && BrokerSim_TopicMatch(filter, r->topic)) {
+            deliver(r->topic, r->payload, r->len, r->qos < qos ? r->qos : qos, 1, ctx);
+            brokerSim.stats.delivered++;
+        }
+    }
+    return 1;
+}
+
+/**
+  * @brief  取消订阅
+  */
+void BrokerSim_Unsubscribe(const char *filter, BrokerSim_Deliver_t deliver, void *ctx)
+{
+    uint8_t i;
+
+    for (i = 0; i < BROKER_SIM_MAX_SUBS; i++) {
+        BrokerSim_Sub_t *s = &brokerSim.subs[i];
+
+        if (s->deliver == deliver && s->ctx == ctx && (filter == NULL || strcmp(s->filter, filter) == 0)) {
+            memset(s, 0, sizeof(BrokerSim_Sub_t));
+        }
+    }
+}
+
+/**
+  * @brief  发布
+  */
+uint16_t BrokerSim_Publish(const char *topic, const uint8_t *payload, uint16_t len,
+                           uint8_t qos, uint8_t retain)
+{
+    uint16_t deliveries = 0;
+    uint8_t i;
+
+    if (topic == NULL || (payload == NULL && len > 0)) {
+        return 0;
+    }
+
+    brokerSim.stats.published++;
+    brokerSim.stats.publishedBytes += len;
+
+    if (retain) {
+        BrokerSim_Retain(topic, payload, len, qos);
+    }
+
+    for (i = 0; i < BROKER_SIM_MAX_SUBS; i++) {
+        BrokerSim_Sub_t *s = &brokerSim.subs[i];
+
+        if (s->deliver != NULL && BrokerSim_TopicMatch(s->filter, topic)) {
+            /* 按订阅QoS降级, 转发给订阅者时清除保留标志 */
+            s->deliver(topic, payload, len, qos < s->qos ? qos : s->qos, 0, s->ctx);
+            deliveries++;
+        }
+    }
+
+    brokerSim.stats.delivered += deliveries;
+    if (deliveries == 0) {
+        brokerSim.stats.dropped++;
+    }
+    return deliveries;
+}
+
+/**
+  * @brief  主题过滤器匹配
+  */
+uint8_t BrokerSim_TopicMatch(const char *filter, const char *topic)
+{
+    while (*filter != '\0') {
+        if (*filter == '#') {
+            return 1;
+        }
+
+        if (*filter == '+') {
+            /* 匹配一级, 不跨越 '/' */
+            while (*topic != '\0' && *topic != '/') {
+                topic++;
+            }
+            filter++;
+            continue;
+        }
+
+        if (*topic == '\0') {
+            /* "a/#" 同时匹配父级 "a" */
+            return (strcmp(filter, "/#") == 0) ? 1 : 0;
+        }
+        if (*filter != *topic) {
+            return 0;
+        }
+        filter++;
+        topic++;
+    }
+
+    return (*topic == '\0') ? 1 : 0;
+}
+
+/* End of file ---------------------------------------------------------------*/
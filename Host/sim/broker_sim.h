@@ -0,0 +1,124 @@
+/**
+  ******************************************************************************
+  * @file           : broker_sim.h
+  * @brief          : 进程内MQTT代理替身头文件 (主机仿真)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 只实现主题路由: 订阅 (支持 + / # 通配符)、发布时同步分发给匹配的订阅者、
+  * 保留消息。没有会话、QoS重传和网络延时, 延时由订阅者 (esp8266_sim) 自己
+  * 建模。测试/基准程序以订阅者身份观察设备发出的消息, 或以 BrokerSim_Publish
+  * 模拟云端下发。
+  *
+  ******************************************************************************
+  */
+
+#ifndef __BROKER_SIM_H
+#define __BROKER_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 最大订阅数 */
+#define BROKER_SIM_MAX_SUBS         32
+
+/* 最大保留消息数 */
+#define BROKER_SIM_MAX_RETAINED     16
+
+/* 主题/过滤器最大长度 */
+#define BROKER_SIM_TOPIC_LEN        128
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  消息分发回调
+  */
+typedef void (*BrokerSim_Deliver_t)(const char *topic, const uint8_t *payload, uint16_t len,
+                                    uint8_t qos, uint8_t retain, void *ctx);
+
+/**
+  * @brief  订阅项
+  */
+typedef struct {
+    char filter[BROKER_SIM_TOPIC_LEN];  /**< 主题过滤器 */
+    uint8_t qos;                        /**< 订阅QoS */
+    BrokerSim_Deliver_t deliver;        /**< 分发回调, NULL 表示空闲项 */
+    void *ctx;                          /**< 回调上下文 */
+} BrokerSim_Sub_t;
+
+/**
+  * @brief  保留消息
+  */
+typedef struct {
+    char topic[BROKER_SIM_TOPIC_LEN];   /**< 主题, 空串表示空闲项 */
+    uint8_t *payload;                   /**< 负载 (堆上分配) */
+    uint16_t len;                       /**< 负载长度 */
+    uint8_t qos;                        /**< 发布QoS */
+} BrokerSim_Retained_t;
+
+/**
+  * @brief  统计
+  */
+typedef struct {
+    uint32_t published;                 /**< 收到的发布数 */
+    uint32_t publishedBytes;            /**< 收到的负载字节数 */
+    uint32_t delivered;                 /**< 分发次数 */
+    uint32_t dropped;                   /**< 无订阅者的发布数 */
+} BrokerSim_Stats_t;
+
+/**
+  * @brief  代理句柄
+  */
+typedef struct {
+    BrokerSim_Sub_t subs[BROKER_SIM_MAX_SUBS];              /**< 订阅表 */
+    BrokerSim_Retained_t retained[BROKER_SIM_MAX_RETAINED]; /**< 保留消息 */
+    BrokerSim_Stats_t stats;                                /**< 统计 */
+} BrokerSim_Handle_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern BrokerSim_Handle_t brokerSim;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  清空订阅、保留消息和统计
+  */
+void BrokerSim_Reset(void);
+
+/**
+  * @brief  订阅 (同一回调/上下文重复订阅同一过滤器只更新QoS), 随后分发匹配的保留消息
+  * @retval uint8_t 1=成功 0=订阅表满或参数错误
+  */
+uint8_t BrokerSim_Subscribe(const char *filter, uint8_t qos, BrokerSim_Deliver_t deliver, void *ctx);
+
+/**
+  * @brief  取消订阅 (filter 为NULL时取消该回调/上下文的全部订阅)
+  */
+void BrokerSim_Unsubscribe(const char *filter, BrokerSim_Deliver_t deliver, void *ctx);
+
+/**
+  * @brief  发布并同步分发
+  * @param  retain 1: 替换保留消息 (空负载删除保留消息)
+  * @retval uint16_t 分发次数
+  */
+uint16_t BrokerSim_Publish(const char *topic, const uint8_t *payload, uint16_t len,
+                           uint8_t qos, uint8_t retain);
+
+/**
+  * @brief  主题过滤器匹配 (MQTT 3.1.1 规则, 含 + / #)
+  * @retval uint8_t 1=匹配
+  */
+uint8_t BrokerSim_TopicMatch(const char *filter, const char *topic);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BROKER_SIM_H */
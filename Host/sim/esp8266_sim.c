@@ -0,0 +1,1170 @@
+/**
+  ******************************************************************************
+  * @file           : esp8266_sim.c
+  * @brief          : ESP8266 AT固件仿真源文件 (主机仿真)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 输入 (MCU->模块) 在 host_hal 的发送处理函数中同步解析, 输出写入按开始
+  * 时刻排序的段队列, 由时钟钩子在每段最后一个字节发完时注入UART。
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "esp8266_sim.h"
+#include "broker_sim.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+#define ESP_SIM_OK                  "\r\nOK\r\n"
+#define ESP_SIM_ERROR               "\r\nERROR\r\n"
+#define ESP_SIM_BUSY                "busy p...\r\n"
+
+/* 单条格式化应答的最大长度 */
+#define ESP_SIM_REPLY_MAX           256
+
+/* Private types -------------------------------------------------------------*/
+
+/**
+  * @brief  命令处理函数
+  * @param  args 动词之后的部分 ("=..." / "?" / "")
+  */
+typedef void (*EspSim_CmdHandler_t)(const char *args);
+
+/**
+  * @brief  命令表项
+  */
+typedef struct {
+    const char *verb;
+    EspSim_CmdHandler_t handler;
+} EspSim_Cmd_t;
+
+/* Exported variables --------------------------------------------------------*/
+
+/* 仿真句柄实例 */
+EspSim_Handle_t espSim = {0};
+
+/* Private variables ---------------------------------------------------------*/
+
+/* 当前命令的应答计入 busyUntilUs */
+static uint8_t espSimInCommand = 0;
+
+/* 复位完成时刻 (booting 期间有效) */
+static uint64_t espSimBootDoneUs = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint64_t EspSim_NowUs(void);
+static uint32_t EspSim_Rand(void);
+static uint32_t EspSim_WireUs(uint32_t len);
+static uint64_t EspSim_EmitBurst(uint64_t atUs, const uint8_t *data, uint16_t len);
+static void EspSim_Emit(uint64_t atUs, const uint8_t *data, uint16_t len);
+static void EspSim_Reply(uint32_t offsetUs, const char *format, ...);
+static void EspSim_Verb(const char *line, char *verb);
+static uint32_t EspSim_LatencyOf(const char *verb);
+static EspSim_Fault_t EspSim_TakeFault(const char *verb);
+static uint8_t EspSim_BeginReply(const char *verb, uint64_t arriveUs);
+static void EspSim_Command(const char *line, uint64_t arriveUs);
+static void EspSim_DataDone(uint64_t arriveUs);
+static void EspSim_RebootAt(uint64_t atUs);
+static void EspSim_Deliver(const char *topic, const uint8_t *payload, uint16_t len,
+                           uint8_t qos, uint8_t retain, void *ctx);
+static void EspSim_UartTx(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t len, void *ctx);
+static void EspSim_Tick(uint32_t tick, void *ctx);
+static const char* EspSim_ArgStr(const char *p, char *out, uint16_t size);
+static const char* EspSim_ArgInt(const char *p, int *value);
+
+static void EspSim_CmdOk(const char *args);
+static void EspSim_CmdEcho(const char *args);
+static void EspSim_CmdReset(const char *args);
+static void EspSim_CmdGmr(const char *args);
+static void EspSim_CmdCwmode(const char *args);
+static void EspSim_CmdUartCur(const char *args);
+static void EspSim_CmdCwjap(const char *args);
+static void EspSim_CmdCwqap(const char *args);
+static void EspSim_CmdCwautoconn(const char *args);
+static void EspSim_CmdCifsr(const char *args);
+static void EspSim_CmdCipsta(const char *args);
+static void EspSim_CmdCwdhcp(const char *args);
+static void EspSim_CmdCipmux(const char *args);
+static void EspSim_CmdCipstart(const char *args);
+static void EspSim_CmdCipsend(const char *args);
+static void EspSim_CmdCipclose(const char *args);
+static void EspSim_CmdCipstatus(const char *args);
+static void EspSim_CmdPing(const char *args);
+static void EspSim_CmdMqttUserCfg(const char *args);
+static void EspSim_CmdMqttConnCfg(const char *args);
+static void EspSim_CmdMqttConn(const char *args);
+static void EspSim_CmdMqttPub(const char *args);
+static void EspSim_CmdMqttPubRaw(const char *args);
+static void EspSim_CmdMqttSub(const char *args);
+static void EspSim_CmdMqttUnsub(const char *args);
+static void EspSim_CmdMqttClean(const char *args);
+
+/* 命令表 (动词与驱动统计用的一致: "AT+XXX" -> "XXX", "ATE0" -> "ATE0") */
+static const EspSim_Cmd_t espSimCmds[] = {
+    { "AT",             EspSim_CmdOk },
+    { "ATE0",           EspSim_CmdEcho },
+    { "ATE1",           EspSim_CmdEcho },
+    { "RST",            EspSim_CmdReset },
+    { "RESTORE",        EspSim_CmdReset },
+    { "GMR",            EspSim_CmdGmr },
+    { "CWMODE",         EspSim_CmdCwmode },
+    { "CWJAP",          EspSim_CmdCwjap },
+    { "CWQAP",          EspSim_CmdCwqap },
+    { "CWAUTOCONN",     EspSim_CmdCwautoconn },
+    { "CWDHCP",         EspSim_CmdCwdhcp },
+    { "CWSAP",          EspSim_CmdOk },
+    { "CIFSR",          EspSim_CmdCifsr },
+    { "CIPSTA",         EspSim_CmdCipsta },
+    { "CIPAP",          EspSim_CmdOk },
+    { "CIPSTAMAC",      EspSim_CmdOk },
+    { "CIPAPMAC",       EspSim_CmdOk },
+    { "CIPMUX",         EspSim_CmdCipmux },
+    { "CIPMODE",        EspSim_CmdOk },
+    { "CIPSTO",         EspSim_CmdOk },
+    { "CIPSERVER",      EspSim_CmdOk },
+    { "CIPSTART",       EspSim_CmdCipstart },
+    { "CIPSEND",        EspSim_CmdCipsend },
+    { "CIPCLOSE",       EspSim_CmdCipclose },
+    { "CIPSTATUS",      EspSim_CmdCipstatus },
+    { "PING",           EspSim_CmdPing },
+    { "SLEEP",          EspSim_CmdOk },
+    { "UART_CUR",       EspSim_CmdUartCur },
+    { "WAKEUPGPIO",     EspSim_CmdOk },
+    { "MQTTUSERCFG",    EspSim_CmdMqttUserCfg },
+    { "MQTTCONNCFG",    EspSim_CmdMqttConnCfg },
+    { "MQTTCONN",       EspSim_CmdMqttConn },
+    { "MQTTPUB",        EspSim_CmdMqttPub },
+    { "MQTTPUBRAW",     EspSim_CmdMqttPubRaw },
+    { "MQTTSUB",        EspSim_CmdMqttSub },
+    { "MQTTUNSUB",      EspSim_CmdMqttUnsub },
+    { "MQTTCLEAN",      EspSim_CmdMqttClean },
+};
+
+/* Private functions: 时序与输出 ----------------------------------------------*/
+
+/**
+  * @brief  当前虚拟时刻 (us)
+  */
+static uint64_t EspSim_NowUs(void)
+{
+    return (uint64_t)uwTick * 1000ULL;
+}
+
+/**
+  * @brief  xorshift32, 同一种子结果可复现
+  */
+static uint32_t EspSim_Rand(void)
+{
+    uint32_t x = espSim.rng;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    espSim.rng = x;
+    return x;
+}
+
+/**
+  * @brief  模块->MCU 方向 len 字节的线上时间
+  */
+static uint32_t EspSim_WireUs(uint32_t len)
+{
+    uint32_t baud = espSim.config.baud ? espSim.config.baud : espSim.huart->Init.BaudRate;
+
+    if (baud == 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)len * HOST_UART_BITS_PER_BYTE * 1000000ULL + baud - 1) / baud);
+}
+
+/**
+  * @brief  插入一段输出, 与已排队的段不重叠
+  * @retval uint64_t 该段发完的时刻
+  */
+static uint64_t EspSim_EmitBurst(uint64_t atUs, const uint8_t *data, uint16_t len)
+{
+    EspSim_Burst_t *burst;
+    uint64_t start = atUs;
+    uint32_t wire = EspSim_WireUs(len);
+    uint16_t i, pos;
+
+    if (espSim.burstCount >= ESP_SIM_MAX_BURSTS) {
+        espSim.stats.overflows++;
+        return atUs;
+    }
+
+    /* 队列按开始时刻排序且互不重叠, 一趟即可找到空档 */
+    for (i = 0; i < espSim.burstCount; i++) {
+        burst = &espSim.bursts[i];
+        if (start < burst->endUs && start + wire > burst->startUs) {
+            start = burst->endUs;
+        }
+    }
+
+    for (pos = espSim.burstCount; pos > 0 && espSim.bursts[pos - 1].startUs > start; pos--) {
+    }
+    memmove(&espSim.bursts[pos + 1], &espSim.bursts[pos], (espSim.burstCount - pos) * sizeof(EspSim_Burst_t));
+
+    burst = &espSim.bursts[pos];
+    burst->startUs = start;
+    burst->endUs = start + wire;
+    burst->len = len;
+    burst->data = (uint8_t *)malloc(len);
+    memcpy(burst->data, data, len);
+    espSim.burstCount++;
+
+    if (espSimInCommand && burst->endUs > espSim.busyUntilUs) {
+        espSim.busyUntilUs = burst->endUs;
+    }
+    return burst->endUs;
+}
+
+/**
+  * @brief  输出: 丢字节、分段后排队
+  */
+static void EspSim_Emit(uint64_t atUs, const uint8_t *data, uint16_t len)
+{
+    static uint8_t kept[ESP_SIM_DATA_MAX + ESP_SIM_REPLY_MAX];
+    uint16_t n = 0, i, piece, dropAt;
+
+    if (len == 0 || len > sizeof(kept)) {
+        return;
+    }
+
+    dropAt = espSimInCommand && espSim.dropNext ? (uint16_t)(EspSim_Rand() % len) : len;
+    espSim.dropNext = 0;
+
+    for (i = 0; i < len; i++) {
+        espSim.stats.bytesOut++;
+        if (i == dropAt || (espSim.config.dropPpm && EspSim_Rand() % 1000000UL < espSim.config.dropPpm)) {
+            espSim.stats.droppedBytes++;
+            continue;
+        }
+        kept[n++] = data[i];
+    }
+
+    for (i = 0; i < n; i += piece) {
+        piece = n - i;
+        if (espSim.config.fragMax && piece > 1) {
+            uint16_t max = piece < espSim.config.fragMax ? piece : espSim.config.fragMax;
+            piece = 1 + (uint16_t)(EspSim_Rand() % max);
+        }
+
+        atUs = EspSim_EmitBurst(atUs, &kept[i], piece) + espSim.config.fragGapUs;
+        espSim.stats.bursts++;
+    }
+}
+
+/**
+  * @brief  格式化应答, 在命令应答基准时刻之后 offsetUs 输出
+  */
+static void EspSim_Reply(uint32_t offsetUs, const char *format, ...)
+{
+    char buf[ESP_SIM_REPLY_MAX];
+    va_list args;
+    int len;
+
+    va_start(args, format);
+    len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+
+    if (len > 0) {
+        EspSim_Emit(espSim.cmdUs + offsetUs, (const uint8_t *)buf,
+                    (uint16_t)(len < (int)sizeof(buf) ? len : (int)sizeof(buf) - 1));
+    }
+}
+
+/* Private functions: 命令解析 ------------------------------------------------*/
+
+/**
+  * @brief  提取命令动词 (规则同 esp8266.c 的统计)
+  */
+static void EspSim_Verb(const char *line, char *verb)
+{
+    uint8_t i = 0;
+
+    if (strncmp(line, "AT+", 3) == 0) {
+        line += 3;
+    }
+    while (line[i] && line[i] != '=' && line[i] != '?' && i < ESP_SIM_VERB_LEN - 1) {
+        verb[i] = line[i];
+        i++;
+    }
+    verb[i] = '\0';
+}
+
+/**
+  * @brief  命令处理延时 (含抖动)
+  */
+static uint32_t EspSim_LatencyOf(const char *verb)
+{
+    uint32_t us = espSim.config.cmdLatencyUs;
+    uint8_t i;
+
+    for (i = 0; i < ESP_SIM_MAX_LATENCY; i++) {
+        if (espSim.latency[i].verb[0] && strcmp(espSim.latency[i].verb, verb) == 0) {
+            us = espSim.latency[i].us;
+            break;
+        }
+    }
+
+    if (espSim.config.jitterUs) {
+        us += EspSim_Rand() % (espSim.config.jitterUs + 1);
+    }
+    return us;
+}
+
+/**
+  * @brief  取本次应答的故障 (脚本优先, 其次随机)
+  */
+static EspSim_Fault_t EspSim_TakeFault(const char *verb)
+{
+    uint32_t r;
+    uint8_t i;
+
+    for (i = 0; i < ESP_SIM_MAX_FAULTS; i++) {
+        EspSim_ScriptFault_t *f = &espSim.faults[i];
+
+        if (f->count && (strcmp(f->verb, "*") == 0 || strcmp(f->verb, verb) == 0)) {
+            f->count--;
+            return (EspSim_Fault_t)f->fault;
+        }
+    }
+
+    r = EspSim_Rand() % 1000;
+    if (r < espSim.config.busyPermille) {
+        return ESP_SIM_FAULT_BUSY;
+    }
+    if (r < (uint32_t)espSim.config.busyPermille + espSim.config.errorPermille) {
+        return ESP_SIM_FAULT_ERROR;
+    }
+    return ESP_SIM_FAULT_NONE;
+}
+
+/**
+  * @brief  确定应答基准时刻并处理故障
+  * @retval uint8_t 1=继续正常应答 0=已按故障应答
+  */
+static uint8_t EspSim_BeginReply(const char *verb, uint64_t arriveUs)
+{
+    espSim.stats.roundTrips++;
+    espSim.cmdUs = arriveUs + EspSim_LatencyOf(verb);
+
+    switch (EspSim_TakeFault(verb)) {
+    case ESP_SIM_FAULT_BUSY:
+        espSim.stats.busy++;
+        EspSim_Reply(0, ESP_SIM_BUSY);
+        return 0;
+    case ESP_SIM_FAULT_ERROR:
+        espSim.stats.errors++;
+        EspSim_Reply(0, ESP_SIM_ERROR);
+        return 0;
+    case ESP_SIM_FAULT_SILENT:
+        espSim.stats.silent++;
+        return 0;
+    case ESP_SIM_FAULT_DROP:
+        espSim.dropNext = 1;
+        return 1;
+    default:
+        return 1;
+    }
+}
+
+/**
+  * @brief  处理一条命令
+  */
+static void EspSim_Command(const char *line, uint64_t arriveUs)
+{
+    char verb[ESP_SIM_VERB_LEN];
+    uint8_t busy = (arriveUs < espSim.busyUntilUs) ? 1 : 0;
+    size_t i;
+
+    espSim.stats.commands++;
+    espSimInCommand = 1;
+
+    if (espSim.echo) {
+        char echo[ESP_SIM_LINE_MAX + 2];
+        int len = snprintf(echo, sizeof(echo), "%s\r\n", line);
+        EspSim_Emit(arriveUs, (const uint8_t *)echo, (uint16_t)len);
+    }
+
+    /* 上一条命令的应答尚未发完 */
+    if (busy) {
+        espSim.stats.busy++;
+        espSim.cmdUs = arriveUs;
+        EspSim_Reply(0, ESP_SIM_BUSY);
+        espSimInCommand = 0;
+        return;
+    }
+
+    EspSim_Verb(line, verb);
+    if (strncmp(line, "AT", 2) != 0) {
+        strcpy(verb, "raw");
+    }
+
+    if (EspSim_BeginReply(verb, arriveUs)) {
+        for (i = 0; i < sizeof(espSimCmds) / sizeof(espSimCmds[0]); i++) {
+            if (strcmp(espSimCmds[i].verb, verb) == 0) {
+                espSimCmds[i].handler(line + (strncmp(line, "AT+", 3) == 0 ? 3 : 0) + strlen(verb));
+                break;
+            }
+        }
+        if (i == sizeof(espSimCmds) / sizeof(espSimCmds[0])) {
+            espSim.stats.errors++;
+            EspSim_Reply(0, ESP_SIM_ERROR);
+        }
+    }
+
+    espSimInCommand = 0;
+}
+
+/**
+  * @brief  透传数据收齐
+  */
+static void EspSim_DataDone(uint64_t arriveUs)
+{
+    uint8_t kind = espSim.dataKind;
+    uint16_t len = espSim.dataLen;
+
+    espSim.dataKind = ESP_SIM_DATA_NONE;
+    espSimInCommand = 1;
+
+    if (kind == ESP_SIM_DATA_CIPSEND) {
+        espSim.cmdUs = arriveUs;
+        EspSim_Reply(0, "\r\nRecv %u bytes\r\n", len);
+        if (EspSim_BeginReply("CIPSEND.data", arriveUs)) {
+            EspSim_Reply(0, "\r\nSEND OK\r\n");
+        }
+    } else if (kind == ESP_SIM_DATA_PUBRAW) {
+        if (EspSim_BeginReply("MQTTPUBRAW.data", arriveUs)) {
+            espSim.stats.published++;
+            BrokerSim_Publish(espSim.pubTopic, espSim.data, len, espSim.pubQos, espSim.pubRetain);
+            EspSim_Reply(espSim.pubQos * espSim.config.brokerRttUs, "\r\n+MQTTPUB:OK\r\n");
+        }
+    }
+
+    espSimInCommand = 0;
+}
+
+/**
+  * @brief  模块复位: 清状态, atUs 之后输出 ready
+  */
+static void EspSim_RebootAt(uint64_t atUs)
+{
+    static const char ready[] = "\r\nready\r\n";
+
+    BrokerSim_Unsubscribe(NULL, EspSim_Deliver, &espSim);
+
+    espSim.echo = 1;
+    espSim.wifiConnected = 0;
+    espSim.tcpConnected = 0;
+    espSim.multiConn = 0;
+    espSim.mqttState = 0;
+    espSim.lineLen = 0;
+    espSim.dataKind = ESP_SIM_DATA_NONE;
+    espSim.booting = 1;
+
+    espSimBootDoneUs = atUs + espSim.config.bootUs;
+    EspSim_Emit(espSimBootDoneUs, (const uint8_t *)ready, sizeof(ready) - 1);
+
+    /* 用保存的AP自动重连 (AP已更换时连不上) */
+    espSim.autoConnUs = 0;
+    if (espSim.autoConnect && espSim.savedSsid[0] &&
+        (espSim.config.ssid[0] == '\0' || strcmp(espSim.savedSsid, espSim.config.ssid) == 0)) {
+        espSim.autoConnUs = espSimBootDoneUs + espSim.config.joinUs;
+    }
+}
+
+/**
+  * @brief  代理分发: 输出 +MQTTSUBRECV
+  */
+static void EspSim_Deliver(const char *topic, const uint8_t *payload, uint16_t len,
+                           uint8_t qos, uint8_t retain, void *ctx)
+{
+    static uint8_t urc[ESP_SIM_DATA_MAX + ESP_SIM_REPLY_MAX];
+    uint8_t inCommand = espSimInCommand;
+    int n;
+
+    if (espSim.mqttState < 4 || len > ESP_SIM_DATA_MAX) {
+        return;
+    }
+
+    n = snprintf((char *)urc, ESP_SIM_REPLY_MAX, "+MQTTSUBRECV:0,\"%s\",%u,", topic, len);
+    memcpy(urc + n, payload, len);
+    memcpy(urc + n + len, "\r\n", 2);
+
+    /* 下行消息不属于当前命令的应答 */
+    espSimInCommand = 0;
+    espSim.stats.received++;
+    EspSim_Emit(EspSim_NowUs() + espSim.config.brokerRttUs / 2, urc, (uint16_t)(n + len + 2));
+    espSimInCommand = inCommand;
+}
+
+/**
+  * @brief  MCU发来的数据
+  */
+static void EspSim_UartTx(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t len, void *ctx)
+{
+    uint64_t arriveUs = EspSim_NowUs() + Host_UartWireUs(huart, len);
+    uint16_t i;
+
+    espSim.stats.bytesIn += len;
+    if (espSim.booting) {
+        return;
+    }
+
+    for (i = 0; i < len; i++) {
+        if (espSim.dataKind != ESP_SIM_DATA_NONE) {
+            espSim.data[espSim.dataLen++] = data[i];
+            if (espSim.dataLen == espSim.dataExpected) {
+                EspSim_DataDone(arriveUs);
+            }
+            continue;
+        }
+
+        if (data[i] == '\n') {
+            if (espSim.lineLen > 0 && espSim.line[espSim.lineLen - 1] == '\r') {
+                espSim.lineLen--;
+            }
+            espSim.line[espSim.lineLen] = '\0';
+            if (espSim.lineLen > 0) {
+                EspSim_Command(espSim.line, arriveUs);
+            }
+            espSim.lineLen = 0;
+        } else if (espSim.lineLen < ESP_SIM_LINE_MAX - 1) {
+            espSim.line[espSim.lineLen++] = (char)data[i];
+        }
+    }
+
+    /* 退出透传的 "+++" 不带换行 */
+    if (espSim.lineLen == 3 && memcmp(espSim.line, "+++", 3) == 0) {
+        espSim.lineLen = 0;
+    }
+}
+
+/**
+  * @brief  时钟钩子: 投递发完的输出段
+  */
+static void EspSim_Tick(uint32_t tick, void *ctx)
+{
+    uint64_t now = (uint64_t)tick * 1000ULL;
+    EspSim_Burst_t burst;
+
+    if (espSim.booting && now >= espSimBootDoneUs) {
+        espSim.booting = 0;
+    }
+    if (espSim.autoConnUs != 0 && now >= espSim.autoConnUs) {
+        espSim.autoConnUs = 0;
+        EspSim_WifiConnect();
+    }
+
+    while (espSim.burstCount > 0 && espSim.bursts[0].endUs <= now) {
+        burst = espSim.bursts[0];
+        espSim.burstCount--;
+        memmove(&espSim.bursts[0], &espSim.bursts[1], espSim.burstCount * sizeof(EspSim_Burst_t));
+
+        Host_UartInject(espSim.huart, burst.data, burst.len);
+        free(burst.data);
+    }
+}
+
+/**
+  * @brief  解析带引号的字符串参数 (跳过前导的 '=' / ',')
+  * @retval 参数之后的位置
+  */
+static const char* EspSim_ArgStr(const char *p, char *out, uint16_t size)
+{
+    uint16_t n = 0;
+
+    while (*p == '=' || *p == ',') {
+        p++;
+    }
+    if (*p == '"') {
+        p++;
+        while (*p && *p != '"') {
+            if (*p == '\\' && p[1]) {
+                p++;
+            }
+            if (n < size - 1) {
+                out[n++] = *p;
+            }
+            p++;
+        }
+        if (*p == '"') {
+            p++;
+        }
+    }
+    out[n] = '\0';
+    return p;
+}
+
+/**
+  * @brief  解析整数参数
+  */
+static const char* EspSim_ArgInt(const char *p, int *value)
+{
+    char *end;
+
+    while (*p == '=' || *p == ',') {
+        p++;
+    }
+    *value = (int)strtol(p, &end, 10);
+    return end;
+}
+
+/* Private functions: 命令 ----------------------------------------------------*/
+
+static void EspSim_CmdOk(const char *args)
+{
+    EspSim_Reply(0, ESP_SIM_OK);
+}
+
+static void EspSim_CmdEcho(const char *args)
+{
+    espSim.echo = (espSim.line[2] == 'E' && espSim.line[3] == '1') ? 1 : 0;
+    EspSim_Reply(0, ESP_SIM_OK);
+}
+
+static void EspSim_CmdReset(const char *args)
+{
+    EspSim_Reply(0, ESP_SIM_OK);
+    EspSim_RebootAt(espSim.cmdUs);
+}
+
+static void EspSim_CmdGmr(const char *args)
+{
+    EspSim_Reply(0, "AT version:1.7.5.0(host sim)\r\nSDK version:3.0.5\r\n" ESP_SIM_OK);
+}
+
+static void EspSim_CmdCwmode(const char *args)
+{
+    if (args[0] == '?') {
+        EspSim_Reply(0, "+CWMODE:1\r\n" ESP_SIM_OK);
+    } else {
+        EspSim_Reply(0, ESP_SIM_OK);
+    }
+}
+
+/**
+  * @brief  AT+UART_CUR: 按旧波特率回 OK, 之后的输出按新波特率计算线上时间
+  */
+static void EspSim_CmdUartCur(const char *args)
+{
+    int baud = 0;
+
+    EspSim_ArgInt(args, &baud);
+    if (baud <= 0) {
+        EspSim_Reply(0, ESP_SIM_ERROR);
+        return;
+    }
+
+    EspSim_Reply(0, ESP_SIM_OK);
+    espSim.config.baud = (uint32_t)baud;
+}
+
+static void EspSim_CmdCwjap(const char *args)
+{
+    char ssid[33], password[65], bssid[18];
+    uint32_t joinUs = espSim.config.joinUs;
+    uint32_t dhcpUs = espSim.staticIp ? 0 : espSim.config.dhcpUs;
+
+    if (args[0] == '?') {
+        if (espSim.wifiConnected) {
+            EspSim_Reply(0, "+CWJAP:\"%s\",\"%s\",%u,%d\r\n" ESP_SIM_OK, espSim.config.ssid,
+                         espSim.config.bssid, espSim.config.channel, espSim.config.rssi);
+        } else {
+            EspSim_Reply(0, "No AP\r\n" ESP_SIM_OK);
+        }
+        return;
+    }
+
+    args = EspSim_ArgStr(args, ssid, sizeof(ssid));
+    args = EspSim_ArgStr(args, password, sizeof(password));
+    EspSim_ArgStr(args, bssid, sizeof(bssid));
+    espSim.autoConnUs = 0;
+
+    if (espSim.wifiConnected) {
+        EspSim_Reply(0, "WIFI DISCONNECT\r\n");
+        espSim.wifiConnected = 0;
+    }
+
+    /* +CWJAP:<错误码> 2=密码错误 3=找不到AP */
+    if (espSim.config.ssid[0] && strcmp(ssid, espSim.config.ssid) != 0) {
+        espSim.stats.errors++;
+        EspSim_Reply(joinUs, "+CWJAP:3\r\n\r\nFAIL\r\n");
+        return;
+    }
+    if (espSim.config.ssid[0] && strcmp(password, espSim.config.password) != 0) {
+        espSim.stats.errors++;
+        EspSim_Reply(joinUs, "+CWJAP:2\r\n\r\nFAIL\r\n");
+        return;
+    }
+
+    /* 指定BSSID: 直接认证, 不扫描; AP已更换时扫不到该BSSID */
+    if (bssid[0]) {
+        if (strcmp(bssid, espSim.config.bssid) != 0) {
+            espSim.stats.errors++;
+            EspSim_Reply(joinUs, "+CWJAP:3\r\n\r\nFAIL\r\n");
+            return;
+        }
+        joinUs = espSim.config.joinBssidUs;
+    }
+
+    EspSim_Reply(joinUs, "WIFI CONNECTED\r\n");
+    EspSim_Reply(joinUs + dhcpUs, "WIFI GOT IP\r\n" ESP_SIM_OK);
+    espSim.wifiConnected = 1;
+    strcpy(espSim.savedSsid, ssid);
+}
+
+static void EspSim_CmdCwqap(const char *args)
+{
+    espSim.autoConnUs = 0;
+    EspSim_Reply(0, ESP_SIM_OK);
+    if (espSim.wifiConnected) {
+        EspSim_Reply(0, "WIFI DISCONNECT\r\n");
+    }
+    espSim.wifiConnected = 0;
+    espSim.tcpConnected = 0;
+}
+
+static void EspSim_CmdCwautoconn(const char *args)
+{
+    int enable = 0;
+
+    EspSim_ArgInt(args, &enable);
+    espSim.autoConnect = enable ? 1 : 0;
+    EspSim_Reply(0, ESP_SIM_OK);
+}
+
+static void EspSim_CmdCifsr(const char *args)
+{
+    EspSim_Reply(0, "+CIFSR:STAIP,\"%s\"\r\n+CIFSR:STAMAC,\"5c:cf:7f:00:00:01\"\r\n" ESP_SIM_OK,
+                 espSim.wifiConnected ? espSim.ip : "0.0.0.0");
+}
+
+static void EspSim_CmdCipsta(const char *args)
+{
+    char gateway[16], netmask[16];
+
+    if (args[0] == '?') {
+        EspSim_Reply(0, "+CIPSTA:ip:\"%s\"\r\n+CIPSTA:gateway:\"%s\"\r\n+CIPSTA:netmask:\"%s\"\r\n" ESP_SIM_OK,
+                     espSim.ip, espSim.gateway, espSim.netmask);
+        return;
+    }
+    args = EspSim_ArgStr(args, espSim.ip, sizeof(espSim.ip));
+    args = EspSim_ArgStr(args, gateway, sizeof(gateway));
+    EspSim_ArgStr(args, netmask, sizeof(netmask));
+    if (gateway[0]) {
+        strcpy(espSim.gateway, gateway);
+    }
+    if (netmask[0]) {
+        strcpy(espSim.netmask, netmask);
+    }
+    espSim.staticIp = 1;
+    EspSim_Reply(0, ESP_SIM_OK);
+}
+
+/* AT+CWDHCP=<mode>,<en>, mode 1/2 含Station; 打开DHCP时恢复DHCP分配的地址 */
+static void EspSim_CmdCwdhcp(const char *args)
+{
+    int mode = 0, enable = 0;
+
+    args = EspSim_ArgInt(args, &mode);
+    EspSim_ArgInt(args, &enable);
+    if (enable && (mode == 1 || mode == 2)) {
+        espSim.staticIp = 0;
+        strcpy(espSim.ip, espSim.config.ip);
+        strcpy(espSim.gateway, espSim.config.gateway);
+        strcpy(espSim.netmask, espSim.config.netmask);
+    }
+    EspSim_Reply(0, ESP_SIM_OK);
+}
+
+static void EspSim_CmdCipmux(const char *args)
+{
+    int mode = 0;
+
+    EspSim_ArgInt(args, &mode);
+    espSim.multiConn = mode ? 1 : 0;
+    EspSim_Reply(0, ESP_SIM_OK);
+}
+
+static void EspSim_CmdCipstart(const char *args)
+{
+    if (!espSim.wifiConnected) {
+        espSim.stats.errors++;
+        EspSim_Reply(0, ESP_SIM_ERROR);
+        return;
+    }
+    espSim.tcpConnected = 1;
+    EspSim_Reply(espSim.config.tcpConnectUs, "%sCONNECT\r\n" ESP_SIM_OK, espSim.multiConn ? "0," : "");
+}
+
+static void EspSim_CmdCipsend(const char *args)
+{
+    int linkId = 0, len = 0;
+
+    if (espSim.multiConn) {
+        args = EspSim_ArgInt(args, &linkId);
+    }
+    EspSim_ArgInt(args, &len);
+
+    if (!espSim.tcpConnected) {
+        espSim.stats.errors++;
+        EspSim_Reply(0, "link is not valid\r\n" ESP_SIM_ERROR);
+        return;
+    }
+    if (len <= 0 || len > ESP_SIM_DATA_MAX) {
+        espSim.stats.errors++;
+        EspSim_Reply(0, ESP_SIM_ERROR);
+        return;
+    }
+
+    espSim.dataKind = ESP_SIM_DATA_CIPSEND;
+    espSim.dataLen = 0;
+    espSim.dataExpected = (uint16_t)len;
+    EspSim_Reply(0, ESP_SIM_OK "> ");
+}
+
+static void EspSim_CmdCipclose(const char *args)
+{
+    espSim.tcpConnected = 0;
+    EspSim_Reply(0, "CLOSED\r\n" ESP_SIM_OK);
+}
+
+static void EspSim_CmdCipstatus(const char *args)
+{
+    EspSim_Reply(0, "STATUS:%d\r\n" ESP_SIM_OK, espSim.tcpConnected ? 3 : (espSim.wifiConnected ? 2 : 5));
+}
+
+static void EspSim_CmdPing(const char *args)
+{
+    if (!espSim.wifiConnected) {
+        espSim.stats.errors++;
+        EspSim_Reply(0, ESP_SIM_ERROR);
+        return;
+    }
+    EspSim_Reply(espSim.config.brokerRttUs, "+PING:%lu\r\n" ESP_SIM_OK,
+                 (unsigned long)(espSim.config.brokerRttUs / 1000));
+}
+
+static void EspSim_CmdMqttUserCfg(const char *args)
+{
+    if (espSim.mqttState < 1) {
+        espSim.mqttState = 1;
+    }
+    EspSim_Reply(0, ESP_SIM_OK);
+}
+
+static void EspSim_CmdMqttConnCfg(const char *args)
+{
+    if (espSim.mqttState == 1) {
+        espSim.mqttState = 2;
+    }
+    EspSim_Reply(0, ESP_SIM_OK);
+}
+
+static void EspSim_CmdMqttConn(const char *args)
+{
+    int linkId = 0, port = 0;
+
+    if (args[0] == '?') {
+        EspSim_Reply(0, "+MQTTCONN:0,%u,1,\"%s\",\"%u\",\"\",1\r\n" ESP_SIM_OK,
+                     espSim.mqttState, espSim.mqttHost, espSim.mqttPort);
+        return;
+    }
+
+    args = EspSim_ArgInt(args, &linkId);
+    args = EspSim_ArgStr(args, espSim.mqttHost, sizeof(espSim.mqttHost));
+    EspSim_ArgInt(args, &port);
+    espSim.mqttPort = (uint16_t)port;
+
+    if (!espSim.wifiConnected || espSim.mqttState == 0) {
+        espSim.stats.errors++;
+        EspSim_Reply(espSim.wifiConnected ? 0 : espSim.config.tcpConnectUs, ESP_SIM_ERROR);
+        return;
+    }
+
+    espSim.mqttState = 4;
+    EspSim_Reply(espSim.config.tcpConnectUs + espSim.config.brokerRttUs,
+                 "+MQTTCONNECTED:0,1,\"%s\",\"%u\",\"\",1\r\n" ESP_SIM_OK, espSim.mqttHost, espSim.mqttPort);
+}
+
+static void EspSim_CmdMqttPub(const char *args)
+{
+    char topic[128], message[ESP_SIM_LINE_MAX];
+    int linkId = 0, qos = 0, retain = 0;
+
+    args = EspSim_ArgInt(args, &linkId);
+    args = EspSim_ArgStr(args, topic, sizeof(topic));
+    args = EspSim_ArgStr(args, message, sizeof(message));
+    args = EspSim_ArgInt(args, &qos);
+    EspSim_ArgInt(args, &retain);
+
+    if (espSim.mqttState < 4) {
+        espSim.stats.errors++;
+        EspSim_Reply(0, ESP_SIM_ERROR);
+        return;
+    }
+
+    espSim.stats.published++;
+    BrokerSim_Publish(topic, (const uint8_t *)message, (uint16_t)strlen(message), (uint8_t)qos, (uint8_t)retain);
+    EspSim_Reply((uint32_t)qos * espSim.config.brokerRttUs, ESP_SIM_OK);
+}
+
+static void EspSim_CmdMqttPubRaw(const char *args)
+{
+    int linkId = 0, len = 0, qos = 0, retain = 0;
+
+    args = EspSim_ArgInt(args, &linkId);
+    args = EspSim_ArgStr(args, espSim.pubTopic, sizeof(espSim.pubTopic));
+    args = EspSim_ArgInt(args, &len);
+    args = EspSim_ArgInt(args, &qos);
+    EspSim_ArgInt(args, &retain);
+
+    if (espSim.mqttState < 4 || len <= 0 || len > ESP_SIM_DATA_MAX) {
+        espSim.stats.errors++;
+        EspSim_Reply(0, ESP_SIM_ERROR);
+        return;
+    }
+
+    espSim.pubQos = (uint8_t)qos;
+    espSim.pubRetain = (uint8_t)retain;
+    espSim.dataKind = ESP_SIM_DATA_PUBRAW;
+    espSim.dataLen = 0;
+    espSim.dataExpected = (uint16_t)len;
+    EspSim_Reply(0, ESP_SIM_OK "\r\n>");
+}
+
+static void EspSim_CmdMqttSub(const char *args)
+{
+    char topic[BROKER_SIM_TOPIC_LEN];
+    int linkId = 0, qos = 0;
+
+    args = EspSim_ArgInt(args, &linkId);
+    args = EspSim_ArgStr(args, topic, sizeof(topic));
+    EspSim_ArgInt(args, &qos);
+
+    if (espSim.mqttState < 4 || !BrokerSim_Subscribe(topic, (uint8_t)qos, EspSim_Deliver, &espSim)) {
+        espSim.stats.errors++;
+        EspSim_Reply(0, ESP_SIM_ERROR);
+        return;
+    }
+
+    espSim.mqttState = 6;
+    EspSim_Reply(espSim.config.brokerRttUs, ESP_SIM_OK);
+}
+
+static void EspSim_CmdMqttUnsub(const char *args)
+{
+    char topic[BROKER_SIM_TOPIC_LEN];
+    int linkId = 0;
+
+    args = EspSim_ArgInt(args, &linkId);
+    EspSim_ArgStr(args, topic, sizeof(topic));
+    BrokerSim_Unsubscribe(topic, EspSim_Deliver, &espSim);
+    EspSim_Reply(espSim.config.brokerRttUs, ESP_SIM_OK);
+}
+
+static void EspSim_CmdMqttClean(const char *args)
+{
+    BrokerSim_Unsubscribe(NULL, EspSim_Deliver, &espSim);
+    espSim.mqttState = 0;
+    EspSim_Reply(0, ESP_SIM_OK);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  典型配置
+  */
+void EspSim_DefaultConfig(EspSim_Config_t *config)
+{
+    memset(config, 0, sizeof(EspSim_Config_t));
+    config->cmdLatencyUs = 2000;
+    config->bootUs = 300000;
+    config->joinUs = 2500000;
+    config->dhcpUs = 500000;
+    config->joinBssidUs = 600000;
+    config->tcpConnectUs = 80000;
+    config->brokerRttUs = 40000;
+    config->seed = 1;
+    strcpy(config->bssid, "2c:3a:fd:12:34:56");
+    config->channel = 6;
+    config->rssi = -55;
+    strcpy(config->ip, "192.168.1.100");
+    strcpy(config->gateway, "192.168.1.1");
+    strcpy(config->netmask, "255.255.255.0");
+}
+
+/**
+  * @brief  接入串口并开始仿真
+  */
+void EspSim_Init(UART_HandleTypeDef *huart, const EspSim_Config_t *config)
+{
+    EspSim_DeInit();
+    memset(&espSim, 0, sizeof(EspSim_Handle_t));
+
+    if (config != NULL) {
+        espSim.config = *config;
+    } else {
+        EspSim_DefaultConfig(&espSim.config);
+    }
+
+    espSim.huart = huart;
+    espSim.echo = 1;
+    espSim.autoConnect = 1;
+    espSim.rng = espSim.config.seed ? espSim.config.seed : 1;
+    strcpy(espSim.ip, espSim.config.ip);
+    strcpy(espSim.gateway, espSim.config.gateway);
+    strcpy(espSim.netmask, espSim.config.netmask);
+    espSim.data = (uint8_t *)malloc(ESP_SIM_DATA_MAX);
+
+    Host_UartAttach(huart, EspSim_UartTx, &espSim);
+    Host_ClockAddHook(EspSim_Tick, &espSim);
+    espSim.attached = 1;
+}
+
+/**
+  * @brief  停止仿真
+  */
+void EspSim_DeInit(void)
+{
+    uint16_t i;
+
+    if (!espSim.attached) {
+        return;
+    }
+
+    Host_UartAttach(espSim.huart, NULL, NULL);
+    Host_ClockRemoveHook(EspSim_Tick, &espSim);
+    BrokerSim_Unsubscribe(NULL, EspSim_Deliver, &espSim);
+
+    for (i = 0; i < espSim.burstCount; i++) {
+        free(espSim.bursts[i].data);
+    }
+    free(espSim.data);
+    memset(&espSim, 0, sizeof(EspSim_Handle_t));
+}
+
+/**
+  * @brief  设置命令处理延时
+  */
+uint8_t EspSim_SetLatency(const char *verb, uint32_t us)
+{
+    uint8_t i;
+
+    for (i = 0; i < ESP_SIM_MAX_LATENCY; i++) {
+        if (espSim.latency[i].verb[0] == '\0' || strcmp(espSim.latency[i].verb, verb) == 0) {
+            strncpy(espSim.latency[i].verb, verb, ESP_SIM_VERB_LEN - 1);
+            espSim.latency[i].us = us;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+  * @brief  注入脚本故障
+  */
+uint8_t EspSim_InjectFault(const char *verb, EspSim_Fault_t fault, uint16_t count)
+{
+    uint8_t i;
+
+    for (i = 0; i < ESP_SIM_MAX_FAULTS; i++) {
+        if (espSim.faults[i].count == 0) {
+            strncpy(espSim.faults[i].verb, verb, ESP_SIM_VERB_LEN - 1);
+            espSim.faults[i].fault = (uint8_t)fault;
+            espSim.faults[i].count = count;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+  * @brief  模块复位
+  */
+void EspSim_Reboot(void)
+{
+    espSim.busyUntilUs = 0;
+    EspSim_RebootAt(EspSim_NowUs());
+}
+
+/**
+  * @brief  WiFi掉线
+  */
+void EspSim_WifiDisconnect(void)
+{
+    static const char disconnect[] = "WIFI DISCONNECT\r\n";
+    static const char both[] = "WIFI DISCONNECT\r\n+MQTTDISCONNECTED:0\r\n";
+
+    if (!espSim.wifiConnected) {
+        return;
+    }
+
+    /* 两条URC之间没有空闲, MCU一次IDLE事件收到 */
+    if (espSim.mqttState >= 4) {
+        EspSim_Emit(EspSim_NowUs(), (const uint8_t *)both, sizeof(both) - 1);
+        espSim.mqttState = 3;
+        BrokerSim_Unsubscribe(NULL, EspSim_Deliver, &espSim);
+    } else {
+        EspSim_Emit(EspSim_NowUs(), (const uint8_t *)disconnect, sizeof(disconnect) - 1);
+    }
+
+    espSim.wifiConnected = 0;
+    espSim.tcpConnected = 0;
+}
+
+/**
+  * @brief  自动重连成功
+  */
+void EspSim_WifiConnect(void)
+{
+    static const char connected[] = "WIFI CONNECTED\r\n";
+    static const char gotIp[] = "WIFI GOT IP\r\n";
+    uint64_t now = EspSim_NowUs();
+
+    if (espSim.wifiConnected) {
+        return;
+    }
+
+    EspSim_Emit(now, (const uint8_t *)connected, sizeof(connected) - 1);
+    EspSim_Emit(now + (espSim.staticIp ? 0 : espSim.config.dhcpUs), (const uint8_t *)gotIp, sizeof(gotIp) - 1);
+    espSim.wifiConnected = 1;
+}
+
+/**
+  * @brief  TCP数据到达
+  */
+void EspSim_SendIpd(const uint8_t *data, uint16_t len)
+{
+    static uint8_t ipd[ESP_SIM_DATA_MAX + 32];
+    int n;
+
+    if (len == 0 || len > ESP_SIM_DATA_MAX) {
+        return;
+    }
+
+    n = espSim.multiConn ? snprintf((char *)ipd, 32, "\r\n+IPD,0,%u:", len)
+                         : snprintf((char *)ipd, 32, "\r\n+IPD,%u:", len);
+    memcpy(ipd + n, data, len);
+    EspSim_Emit(EspSim_NowUs(), ipd, (uint16_t)(n + len));
+}
+
+/**
+  * @brief  是否空闲
+  */
+uint8_t EspSim_Idle(void)
+{
+    return (espSim.burstCount == 0 && EspSim_NowUs() >= espSim.busyUntilUs) ? 1 : 0;
+}
+
+/* End of file ---------------------------------------------------------------*/
@@ -0,0 +1,284 @@
+/**
+  ******************************************************************************
+  * @file           : esp8266_sim.h
+  * @brief          : ESP8266 AT固件仿真头文件 (主机仿真)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 挂在 host_hal 的UART管道上, 扮演串口另一端的ESP8266, 实现 esp8266.c /
+  * esp8266_mqtt.c 用到的AT子集:
+  *   - 基础:   AT / ATE0 / ATE1 / AT+RST / AT+GMR / AT+CWMODE / AT+SLEEP ...
+  *   - WiFi:   AT+CWJAP (含 WIFI CONNECTED / WIFI GOT IP) / AT+CWJAP? / AT+CWQAP /
+  *             AT+CIFSR / AT+CIPSTA / AT+CWDHCP
+  *   - 快速重连: CWJAP 第三个参数指定BSSID时不扫描 (joinBssidUs), BSSID不符回
+  *             +CWJAP:3 FAIL; CIPSTA 设置静态地址后关闭DHCP (复位不丢),
+  *             入网不再等 dhcpUs, AT+CWDHCP=1,1 恢复
+  *   - TCP:    AT+CIPSTART / AT+CIPSEND (> 提示符 + 数据) / AT+CIPCLOSE / +IPD
+  *   - MQTT:   AT+MQTTUSERCFG / AT+MQTTCONNCFG / AT+MQTTCONN / AT+MQTTPUB /
+  *             AT+MQTTPUBRAW / AT+MQTTSUB / AT+MQTTUNSUB / AT+MQTTCLEAN /
+  *             +MQTTSUBRECV / +MQTTDISCONNECTED
+  *   - 事件:   ready (复位) / WIFI DISCONNECT (掉线)
+  *   - 自动重连: CWJAP 成功后保存SSID (与真实固件的Flash配置一样, 复位不丢),
+  *             AT+CWAUTOCONN=1 (默认) 时复位后 bootUs + joinUs 自动连上
+  * 未知命令回 ERROR。
+  *
+  * 时序模型 (微秒精度, 按虚拟时钟每1ms投递一次):
+  *   - 命令在最后一个字节到达 (按MCU侧波特率) 后开始处理, 经过该命令的处理
+  *     延时 (EspSim_SetLatency 或默认值) 加随机抖动后应答
+  *   - 模块到MCU的每段输出按 baud 计算线上时间, 各段不重叠; 一段发完线路
+  *     空闲, 对应MCU一次IDLE事件
+  *   - 命令的应答全部发完之前收到新命令, 回 "busy p..." (与真实固件相同)
+  *   - MQTT: 发布在数据收齐时交给 broker_sim, QoS1/2 的 +MQTTPUB:OK 再等
+  *     1/2 个代理往返; 订阅消息在代理分发后半个往返到达
+  *
+  * 故障注入:
+  *   - 随机: busyPermille / errorPermille 按命令, dropPpm 按输出字节
+  *   - 脚本: EspSim_InjectFault 指定命令动词的后 N 次应答 BUSY/ERROR/不应答/丢字节
+  *   - 分段: fragMax 把每段输出在随机字节边界切开, 段间隔 fragGapUs
+  *
+  * 注意: 驱动每次IDLE事件覆盖 rxBuffer, 期望串 ("OK" 等) 被切开时会等到超时,
+  * 这正是分段测试要暴露的行为。
+  *
+  ******************************************************************************
+  */
+
+#ifndef __ESP8266_SIM_H
+#define __ESP8266_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "host_hal.h"
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 命令行最大长度 */
+#define ESP_SIM_LINE_MAX            1100
+
+/* 透传数据最大长度 (CIPSEND / MQTTPUBRAW) */
+#define ESP_SIM_DATA_MAX            8192
+
+/* 待发送输出段数 */
+#define ESP_SIM_MAX_BURSTS          256
+
+/* 单独设置处理延时的命令数 / 脚本故障数 */
+#define ESP_SIM_MAX_LATENCY         16
+#define ESP_SIM_MAX_FAULTS          8
+
+/* 命令动词最大长度 */
+#define ESP_SIM_VERB_LEN            16
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  故障类型
+  */
+typedef enum {
+    ESP_SIM_FAULT_NONE = 0,         /**< 正常应答 */
+    ESP_SIM_FAULT_BUSY,             /**< 回 "busy p..." */
+    ESP_SIM_FAULT_ERROR,            /**< 回 ERROR */
+    ESP_SIM_FAULT_SILENT,           /**< 不应答 */
+    ESP_SIM_FAULT_DROP              /**< 应答中随机丢一个字节 */
+} EspSim_Fault_t;
+
+/**
+  * @brief  仿真配置 (EspSim_DefaultConfig 给出典型值)
+  */
+typedef struct {
+    uint32_t baud;                  /**< 模块->MCU 波特率, 0: 跟随 huart->Init.BaudRate */
+    uint32_t cmdLatencyUs;          /**< 默认命令处理延时 */
+    uint32_t jitterUs;              /**< 附加随机延时上限 */
+    uint32_t bootUs;                /**< 复位到 ready */
+    uint32_t joinUs;                /**< CWJAP 到 WIFI CONNECTED */
+    uint32_t dhcpUs;                /**< WIFI CONNECTED 到 WIFI GOT IP */
+    uint32_t joinBssidUs;           /**< 指定BSSID的 CWJAP 到 WIFI CONNECTED (不扫描) */
+    uint32_t tcpConnectUs;          /**< CIPSTART / MQTTCONN 建立TCP */
+    uint32_t brokerRttUs;           /**< 到代理的往返时间 */
+    uint16_t fragMax;               /**< 每段输出最多字节数, 0: 不分段 */
+    uint32_t fragGapUs;             /**< 分段之间的额外间隔 */
+    uint16_t busyPermille;          /**< 命令随机回 busy 的概率 (千分之) */
+    uint16_t errorPermille;         /**< 命令随机回 ERROR 的概率 (千分之) */
+    uint32_t dropPpm;               /**< 输出字节丢失概率 (百万分之) */
+    uint32_t seed;                  /**< 随机数种子 */
+    char ssid[33];                  /**< 可接入的AP, 空串: 任意SSID/密码都能接入 */
+    char password[65];              /**< AP密码 */
+    char bssid[18];                 /**< AP的BSSID */
+    uint8_t channel;                /**< AP信道 */
+    int8_t rssi;                    /**< 信号强度 */
+    char ip[16];                    /**< DHCP分配的地址 */
+    char gateway[16];               /**< DHCP分配的网关 */
+    char netmask[16];               /**< DHCP分配的子网掩码 */
+} EspSim_Config_t;
+
+/**
+  * @brief  统计
+  */
+typedef struct {
+    uint32_t commands;              /**< 收到的AT命令 */
+    uint32_t roundTrips;            /**< 命令 + 透传数据块 (每次都等一次应答) */
+    uint32_t busy;                  /**< 回 busy 的次数 */
+    uint32_t errors;                /**< 回 ERROR/FAIL 的次数 */
+    uint32_t silent;                /**< 故意不应答的次数 */
+    uint32_t droppedBytes;          /**< 丢弃的输出字节 */
+    uint32_t bytesIn;               /**< MCU发来的字节 */
+    uint32_t bytesOut;              /**< 发往MCU的字节 (含丢弃) */
+    uint32_t bursts;                /**< 输出段数 (= MCU侧IDLE事件数) */
+    uint32_t overflows;             /**< 输出队列满丢弃的段 */
+    uint32_t published;             /**< 转交代理的发布 */
+    uint32_t received;              /**< 下发的 +MQTTSUBRECV */
+} EspSim_Stats_t;
+
+/**
+  * @brief  待发送的输出段
+  */
+typedef struct {
+    uint64_t startUs;               /**< 第一个字节开始发送 */
+    uint64_t endUs;                 /**< 最后一个字节发完 (此时投递) */
+    uint16_t len;                   /**< 长度 */
+    uint8_t *data;                  /**< 数据 (堆上分配) */
+} EspSim_Burst_t;
+
+/**
+  * @brief  单独设置的命令处理延时
+  */
+typedef struct {
+    char verb[ESP_SIM_VERB_LEN];    /**< 命令动词, 如 "MQTTPUBRAW" */
+    uint32_t us;                    /**< 处理延时 */
+} EspSim_Latency_t;
+
+/**
+  * @brief  脚本故障
+  */
+typedef struct {
+    char verb[ESP_SIM_VERB_LEN];    /**< 命令动词, "*" 匹配任意命令 */
+    uint8_t fault;                  /**< EspSim_Fault_t */
+    uint16_t count;                 /**< 剩余次数 */
+} EspSim_ScriptFault_t;
+
+/**
+  * @brief  透传数据的去向
+  */
+typedef enum {
+    ESP_SIM_DATA_NONE = 0,
+    ESP_SIM_DATA_CIPSEND,
+    ESP_SIM_DATA_PUBRAW
+} EspSim_DataKind_t;
+
+/**
+  * @brief  仿真句柄
+  */
+typedef struct {
+    UART_HandleTypeDef *huart;      /**< 所连串口 */
+    EspSim_Config_t config;         /**< 配置 */
+    EspSim_Stats_t stats;           /**< 统计 */
+
+    /* 模块状态 */
+    uint8_t echo;                   /**< 回显 */
+    uint8_t booting;                /**< 复位中, 忽略输入 */
+    uint8_t wifiConnected;          /**< 已获取IP */
+    uint8_t tcpConnected;           /**< TCP连接已建立 */
+    uint8_t multiConn;              /**< CIPMUX=1 */
+    uint8_t mqttState;              /**< +MQTTCONN 状态 (0~6) */
+    char mqttHost[64];              /**< MQTTCONN 的主机 */
+    uint16_t mqttPort;              /**< MQTTCONN 的端口 */
+    char ip[16];                    /**< 当前IP */
+    char gateway[16];               /**< 当前网关 */
+    char netmask[16];               /**< 当前子网掩码 */
+    uint8_t staticIp;               /**< CIPSTA 设置了静态地址, DHCP关闭 (复位保持) */
+    uint8_t autoConnect;            /**< AT+CWAUTOCONN (复位保持, 默认1) */
+    char savedSsid[33];             /**< 上次 CWJAP 成功的SSID (复位保持) */
+    uint64_t autoConnUs;            /**< 复位后自动连上的时刻, 0=不会自动连接 */
+
+    /* 输入解析 */
+    char line[ESP_SIM_LINE_MAX];    /**< 命令行 */
+    uint16_t lineLen;               /**< 命令行长度 */
+    uint8_t dataKind;               /**< EspSim_DataKind_t */
+    uint8_t *data;                  /**< 透传数据 */
+    uint16_t dataLen;               /**< 已收字节 */
+    uint16_t dataExpected;          /**< 期望字节 */
+    char pubTopic[128];             /**< MQTTPUBRAW 主题 */
+    uint8_t pubQos;                 /**< MQTTPUBRAW QoS */
+    uint8_t pubRetain;              /**< MQTTPUBRAW 保留 */
+
+    /* 时序 */
+    uint64_t cmdUs;                 /**< 当前命令的应答基准时刻 */
+    uint64_t busyUntilUs;           /**< 当前命令的应答发完时刻 */
+    uint8_t dropNext;               /**< 当前命令的应答丢一个字节 */
+
+    /* 输出队列 (按 startUs 排序) */
+    EspSim_Burst_t bursts[ESP_SIM_MAX_BURSTS];
+    uint16_t burstCount;
+
+    EspSim_Latency_t latency[ESP_SIM_MAX_LATENCY];
+    EspSim_ScriptFault_t faults[ESP_SIM_MAX_FAULTS];
+    uint32_t rng;                   /**< xorshift32 状态 */
+    uint8_t attached;               /**< 已接入UART */
+} EspSim_Handle_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern EspSim_Handle_t espSim;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  填入典型配置 (115200跟随串口, 命令2ms, 入网2.5s+0.5s, 指定BSSID 0.6s, 代理往返40ms)
+  */
+void EspSim_DefaultConfig(EspSim_Config_t *config);
+
+/**
+  * @brief  接入串口并开始仿真 (模块处于已启动、未联网状态)
+  * @param  config NULL: 使用默认配置
+  */
+void EspSim_Init(UART_HandleTypeDef *huart, const EspSim_Config_t *config);
+
+/**
+  * @brief  断开串口与时钟钩子, 释放队列
+  */
+void EspSim_DeInit(void);
+
+/**
+  * @brief  设置某个命令动词的处理延时 (如 "MQTTPUBRAW", "MQTTPUBRAW.data")
+  * @retval uint8_t 1=成功 0=表满
+  */
+uint8_t EspSim_SetLatency(const char *verb, uint32_t us);
+
+/**
+  * @brief  让指定命令动词的后 count 次应答出现故障 ("*": 任意命令)
+  * @retval uint8_t 1=成功 0=表满
+  */
+uint8_t EspSim_InjectFault(const char *verb, EspSim_Fault_t fault, uint16_t count);
+
+/**
+  * @brief  模块复位: 丢弃状态, bootUs 后输出 ready
+  */
+void EspSim_Reboot(void);
+
+/**
+  * @brief  WiFi掉线: 输出 WIFI DISCONNECT (MQTT已连接时还有 +MQTTDISCONNECTED)
+  */
+void EspSim_WifiDisconnect(void);
+
+/**
+  * @brief  自动重连成功: 输出 WIFI CONNECTED / WIFI GOT IP
+  */
+void EspSim_WifiConnect(void);
+
+/**
+  * @brief  TCP连接收到数据: 输出 +IPD
+  */
+void EspSim_SendIpd(const uint8_t *data, uint16_t len);
+
+/**
+  * @brief  所有输出都已投递且没有进行中的命令
+  */
+uint8_t EspSim_Idle(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ESP8266_SIM_H */
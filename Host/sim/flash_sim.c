@@ -0,0 +1,158 @@
+/**
+  ******************************************************************************
+  * @file           : flash_sim.c
+  * @brief          : 文件模拟的Flash扇区对源文件 (主机仿真)
+  * @version        : V1.0.0
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "flash_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Exported variables --------------------------------------------------------*/
+
+/* 模拟Flash句柄实例 */
+FlashSim_Handle_t flashSim = {0};
+
+/* Private function prototypes -----------------------------------------------*/
+static void FlashSim_Save(void);
+static const uint8_t* FlashSim_Sector(uint8_t index);
+static ConfigStore_Status_t FlashSim_Erase(uint8_t index);
+static ConfigStore_Status_t FlashSim_Program(uint8_t index, uint32_t offset, const void *data, uint32_t len);
+
+/* Private variables ---------------------------------------------------------*/
+
+static ConfigStore_Flash_t flashSimOps = {
+    0,
+    FlashSim_Sector,
+    FlashSim_Erase,
+    FlashSim_Program
+};
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  映像写回文件
+  */
+static void FlashSim_Save(void)
+{
+    FILE *f;
+
+    if (flashSim.path[0] == '\0') {
+        return;
+    }
+    f = fopen(flashSim.path, "wb");
+    if (f != NULL) {
+        fwrite(flashSim.image, 1, flashSim.sectorSize * 2, f);
+        fclose(f);
+    }
+}
+
+static const uint8_t* FlashSim_Sector(uint8_t index)
+{
+    return flashSim.image + (index ? flashSim.sectorSize : 0);
+}
+
+static ConfigStore_Status_t FlashSim_Erase(uint8_t index)
+{
+    if (index > 1 || flashSim.powerBudget == 0) {
+        return CONFIG_STORE_ERROR;
+    }
+    memset(flashSim.image + (index ? flashSim.sectorSize : 0), 0xFF, flashSim.sectorSize);
+    flashSim.erases[index]++;
+    FlashSim_Save();
+    return CONFIG_STORE_OK;
+}
+
+static ConfigStore_Status_t FlashSim_Program(uint8_t index, uint32_t offset, const void *data, uint32_t len)
+{
+    uint8_t *dst = flashSim.image + (index ? flashSim.sectorSize : 0) + offset;
+    const uint8_t *src = (const uint8_t *)data;
+    ConfigStore_Status_t status = CONFIG_STORE_OK;
+    uint32_t i, j;
+
+    if (index > 1 || (offset & 3U) != 0 || (len & 3U) != 0 || offset + len > flashSim.sectorSize) {
+        return CONFIG_STORE_INVALID_PARAM;
+    }
+
+    for (i = 0; i < len; i += 4) {
+        if (flashSim.powerBudget == 0) {
+            status = CONFIG_STORE_ERROR;
+            break;
+        }
+        for (j = i; j < i + 4; j++) {
+            if ((dst[j] & src[j]) != src[j]) {
+                flashSim.violations++;
+                status = CONFIG_STORE_ERROR;
+            }
+            dst[j] &= src[j];
+        }
+        flashSim.programmed++;
+        if (flashSim.powerBudget > 0) {
+            flashSim.powerBudget--;
+        }
+    }
+
+    FlashSim_Save();
+    return status;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  打开映像文件
+  */
+const ConfigStore_Flash_t* FlashSim_Open(const char *path, uint32_t sectorSize)
+{
+    FILE *f;
+
+    FlashSim_Close();
+    if (sectorSize == 0 || sectorSize > FLASH_SIM_SECTOR_MAX || (sectorSize & 3U) != 0 ||
+        (path != NULL && strlen(path) >= sizeof(flashSim.path))) {
+        return NULL;
+    }
+
+    flashSim.image = malloc(sectorSize * 2);
+    if (flashSim.image == NULL) {
+        return NULL;
+    }
+    flashSim.sectorSize = sectorSize;
+    flashSim.powerBudget = -1;
+    memset(flashSim.image, 0xFF, sectorSize * 2);
+
+    if (path != NULL) {
+        strcpy(flashSim.path, path);
+        f = fopen(path, "rb");
+        if (f != NULL) {
+            if (fread(flashSim.image, 1, sectorSize * 2, f) != sectorSize * 2) {
+                memset(flashSim.image, 0xFF, sectorSize * 2);
+            }
+            fclose(f);
+        }
+    }
+
+    flashSimOps.sectorSize = sectorSize;
+    return &flashSimOps;
+}
+
+/**
+  * @brief  释放映像
+  */
+void FlashSim_Close(void)
+{
+    free(flashSim.image);
+    memset(&flashSim, 0, sizeof(flashSim));
+}
+
+/**
+  * @brief  掉电注入
+  */
+void FlashSim_PowerFailAfter(int32_t words)
+{
+    flashSim.powerBudget = words;
+}
+
+/* End of file ---------------------------------------------------------------*/
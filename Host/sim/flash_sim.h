@@ -0,0 +1,77 @@
+/**
+  ******************************************************************************
+  * @file           : flash_sim.h
+  * @brief          : 文件模拟的Flash扇区对头文件 (主机仿真, 配置存储用)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 给 config_store 提供 ConfigStore_Flash_t: 两个扇区的映像放在内存中,
+  * 每次擦除/编程后整体写回文件, 重新 Open 同一个文件即相当于重启。
+  *
+  *   - 按 NOR Flash 的规则: 擦除为 0xFF, 编程只能把 1 写成 0, 违反时返回错误
+  *     并计入 violations (存储层的写入顺序有误时测试能发现)
+  *   - 掉电注入: FlashSim_PowerFailAfter(n) 之后只再编程 n 个字, 其余编程和
+  *     擦除全部失败且不改变映像, 相当于写到一半断电
+  *
+  ******************************************************************************
+  */
+
+#ifndef __FLASH_SIM_H
+#define __FLASH_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "config_store.h"
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* 最大扇区大小 */
+#define FLASH_SIM_SECTOR_MAX        0x10000UL
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  模拟Flash句柄
+  */
+typedef struct {
+    char path[256];                 /**< 映像文件, 空串=只在内存中 */
+    uint32_t sectorSize;            /**< 扇区大小 */
+    uint8_t *image;                 /**< 两个扇区的映像 */
+    uint32_t erases[2];             /**< 各扇区擦除次数 */
+    uint32_t programmed;            /**< 已编程字数 */
+    uint32_t violations;            /**< 把0写成1的次数 */
+    int32_t powerBudget;            /**< 剩余可编程字数, -1=不限 */
+} FlashSim_Handle_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern FlashSim_Handle_t flashSim;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  打开映像文件 (不存在或大小不符时为全擦除状态)
+  * @param  path: 文件路径, NULL=只在内存中
+  * @retval 扇区对, 失败返回 NULL
+  */
+const ConfigStore_Flash_t* FlashSim_Open(const char *path, uint32_t sectorSize);
+
+/**
+  * @brief  释放映像 (文件保留)
+  */
+void FlashSim_Close(void);
+
+/**
+  * @brief  掉电注入: 再编程 words 个字后全部失败, -1 取消
+  */
+void FlashSim_PowerFailAfter(int32_t words);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FLASH_SIM_H */
@@ -0,0 +1,255 @@
+/**
+  ******************************************************************************
+  * @file           : test_boot.c
+  * @brief          : 启动编排测试 (esp8266_sim + broker_sim + 文件模拟的Flash)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 五次启动:
+  *   1. 冷启动, 模块与MCU同时上电, 没有保存过签名     -> WiFi join, MQTT connect
+  *   2. 只复位MCU (重新运行启动代码, 仿真模块不动)     -> WiFi kept, MQTT kept
+  *   3. 模块也复位, 有BSSID/地址缓存                   -> WiFi fast, MQTT connect
+  *   4. 模块复位, 缓存被清除, 凭据未变                 -> WiFi auto, MQTT connect
+  *   5. 模块复位, AP已更换 (BSSID变了)                 -> fast 失败, 改用 join
+  * 检查各阶段时间递增、快速路径确实更快、等待期间运行了后台任务、
+  * DHT11 上电稳定期不再阻塞、各入网路径记录了到获得IP的耗时。
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "host_hal.h"
+#include "usart.h"
+#include "dma.h"
+#include "gpio.h"
+#include "boot.h"
+#include "config_store.h"
+#include "dht11.h"
+#include "esp8266_sim.h"
+#include "broker_sim.h"
+#include "flash_sim.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1; \
+        } \
+    } while (0)
+
+/* 映像文件 (ctest 在构建目录中运行) */
+#define TEST_IMAGE          "boot_test.bin"
+
+/* Private variables ---------------------------------------------------------*/
+
+static const Boot_Topic_t testTopics[] = {
+    { "stm32/control",      MQTT_QOS_1 },
+    { "stm32/prof/query",   MQTT_QOS_0 },
+};
+
+static uint32_t backgroundCount = 0;
+
+/* Private functions ---------------------------------------------------------*/
+
+static void Test_Background(void)
+{
+    backgroundCount++;
+}
+
+/**
+  * @brief  运行一次启动代码 (与 main.c 的顺序相同), 返回复位到订阅完成的时间
+  */
+static int RunBoot(uint32_t *elapsed)
+{
+    MQTT_UserConfig_t userConfig = { .scheme = MQTT_SCHEME_TCP };
+    uint32_t start = HAL_GetTick();
+    char json[256];
+
+    backgroundCount = 0;
+    Boot_Init(Test_Background);
+    CHECK(DHT11_Init() == DHT11_OK);
+    CHECK(HAL_GetTick() == start);
+    CHECK(!DHT11_IsReady());
+    Boot_Mark(BOOT_STAGE_SENSORS);
+
+    CHECK(Boot_Wifi(&huart3, "lab", "secret") == ESP8266_OK);
+    CHECK(ESP8266_IsWifiConnected());
+    CHECK(strcmp(esp8266.ipInfo.ip, "192.168.1.100") == 0);
+
+    CHECK(MQTT_Init() == MQTT_OK);
+    strcpy(userConfig.clientId, "stm32");
+    strcpy(userConfig.username, "user");
+    strcpy(userConfig.password, "pass");
+    CHECK(Boot_Mqtt(&userConfig, "broker.local", 1883, 120, testTopics, 2) == MQTT_OK);
+    Boot_Finish();
+    CHECK(MQTT_IsConnected());
+    CHECK(espSim.mqttState == 6);
+    CHECK(strcmp(mqtt.brokerConfig.host, "broker.local") == 0);
+    CHECK(strcmp(mqtt.userConfig.clientId, "stm32") == 0);
+
+    /* 订阅仍然有效 */
+    CHECK(MQTT_Publish("stm32/control", "{\"led1\":true}", MQTT_QOS_0, 0) == MQTT_OK);
+
+    /* 时间线: 阶段依次完成, 第一次发布后得到总时长 */
+    Boot_Mark(BOOT_STAGE_PUBLISH);
+    CHECK(boot.stamp[BOOT_STAGE_INIT] <= boot.stamp[BOOT_STAGE_SENSORS]);
+    CHECK(boot.stamp[BOOT_STAGE_SENSORS] <= boot.stamp[BOOT_STAGE_ESP]);
+    CHECK(boot.stamp[BOOT_STAGE_ESP] <= boot.stamp[BOOT_STAGE_WIFI]);
+    CHECK(boot.stamp[BOOT_STAGE_WIFI] <= boot.stamp[BOOT_STAGE_MQTT]);
+    CHECK(boot.stamp[BOOT_STAGE_MQTT] <= boot.stamp[BOOT_STAGE_SUB]);
+    CHECK(boot.totalMs == boot.stamp[BOOT_STAGE_PUBLISH]);
+    CHECK(Boot_FormatJson(json, sizeof(json)) > 0);
+    CHECK(strstr(json, "\"publish\":") != NULL);
+    CHECK(Boot_FormatJson(json, 32) == 0 && json[0] == '\0');
+    CHECK(boot.backgroundRuns == backgroundCount && backgroundCount > 0);
+
+    /* 钩子已取消 */
+    ESP8266_Delay(10);
+    CHECK(boot.backgroundRuns == backgroundCount);
+
+    *elapsed = boot.stamp[BOOT_STAGE_SUB] - start;
+    return 0;
+}
+
+static int Test_Cold(uint32_t *elapsed)
+{
+    EspSim_Config_t config;
+
+    EspSim_DefaultConfig(&config);
+    strcpy(config.ssid, "lab");
+    strcpy(config.password, "secret");
+    EspSim_Init(&huart3, &config);
+    EspSim_Reboot();
+
+    CHECK(RunBoot(elapsed) == 0);
+    CHECK(boot.wifiPath == BOOT_WIFI_JOIN);
+    CHECK(boot.mqttPath == BOOT_MQTT_CONNECT);
+    CHECK(ConfigStore_GetU32(CONFIG_KEY_BOOT_WIFI_SIG, 0) != 0);
+    CHECK(ConfigStore_GetU32(CONFIG_KEY_BOOT_MQTT_SIG, 0) != 0);
+    CHECK(strcmp(espSim.savedSsid, "lab") == 0);
+    CHECK(DHT11_IsReady());
+
+    /* 完整入网计时, 缓存写入配置存储 */
+    CHECK(esp8266.lastJoinPath == ESP8266_JOIN_FULL);
+    CHECK(esp8266.joinStats[ESP8266_JOIN_FULL].count == 1);
+    CHECK(esp8266.lastJoinMs >= 3000);
+    CHECK(strcmp(ConfigStore_GetStr(CONFIG_KEY_WIFI_BSSID, ""), "2c:3a:fd:12:34:56") == 0);
+    CHECK(ConfigStore_GetU32(CONFIG_KEY_WIFI_CHANNEL, 0) == 6);
+    CHECK(strcmp(ConfigStore_GetStr(CONFIG_KEY_WIFI_IP, ""), "192.168.1.100") == 0);
+    CHECK(strcmp(ConfigStore_GetStr(CONFIG_KEY_WIFI_GATEWAY, ""), "192.168.1.1") == 0);
+    CHECK(strcmp(ConfigStore_GetStr(CONFIG_KEY_WIFI_NETMASK, ""), "255.255.255.0") == 0);
+    return 0;
+}
+
+static int Test_McuReset(uint32_t *elapsed)
+{
+    uint32_t writes = configStore.writes;
+
+    CHECK(RunBoot(elapsed) == 0);
+    CHECK(boot.wifiPath == BOOT_WIFI_KEPT);
+    CHECK(boot.mqttPath == BOOT_MQTT_KEPT);
+
+    /* 签名未变, 不写Flash */
+    CHECK(configStore.writes == writes);
+    return 0;
+}
+
+static int Test_ModuleReset(uint32_t *elapsed)
+{
+    uint32_t writes;
+    char json[256];
+
+    EspSim_Reboot();
+    writes = configStore.writes;
+
+    CHECK(RunBoot(elapsed) == 0);
+    CHECK(boot.wifiPath == BOOT_WIFI_FAST);
+    CHECK(boot.mqttPath == BOOT_MQTT_CONNECT);
+
+    /* 静态地址, 指定BSSID, 不等DHCP */
+    CHECK(espSim.staticIp);
+    CHECK(esp8266.lastJoinPath == ESP8266_JOIN_FAST);
+    CHECK(esp8266.joinStats[ESP8266_JOIN_FAST].count == 1);
+    CHECK(esp8266.joinStats[ESP8266_JOIN_FAST].fail == 0);
+    CHECK(esp8266.joinStats[ESP8266_JOIN_FULL].count == 0);
+    CHECK(esp8266.lastJoinMs < 1000);
+    CHECK(ESP8266_FormatJoinJson(json, sizeof(json)) > 0);
+    CHECK(strstr(json, "\"path\":\"fast\"") != NULL);
+    CHECK(strstr(json, "\"ch\":6") != NULL);
+    CHECK(ESP8266_FormatJoinJson(json, 32) == 0 && json[0] == '\0');
+
+    /* 缓存未变, 不写Flash */
+    CHECK(configStore.writes == writes);
+    return 0;
+}
+
+static int Test_AutoConnect(uint32_t *elapsed)
+{
+    CHECK(ConfigStore_Delete(CONFIG_KEY_WIFI_BSSID) == CONFIG_STORE_OK);
+    EspSim_Reboot();
+
+    CHECK(RunBoot(elapsed) == 0);
+    CHECK(boot.wifiPath == BOOT_WIFI_AUTO);
+
+    /* 从模块重新读出缓存 */
+    CHECK(strcmp(ConfigStore_GetStr(CONFIG_KEY_WIFI_BSSID, ""), "2c:3a:fd:12:34:56") == 0);
+    return 0;
+}
+
+static int Test_ApReplaced(void)
+{
+    uint32_t elapsed;
+
+    strcpy(espSim.config.bssid, "2c:3a:fd:ab:cd:ef");
+    EspSim_Reboot();
+
+    CHECK(RunBoot(&elapsed) == 0);
+    CHECK(boot.wifiPath == BOOT_WIFI_JOIN);
+    CHECK(esp8266.joinStats[ESP8266_JOIN_FAST].fail == 1);
+    CHECK(esp8266.joinStats[ESP8266_JOIN_FULL].count == 1);
+    CHECK(esp8266.joinFallbacks == 1);
+    CHECK(!espSim.staticIp);
+    CHECK(strcmp(ConfigStore_GetStr(CONFIG_KEY_WIFI_BSSID, ""), "2c:3a:fd:ab:cd:ef") == 0);
+    return 0;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+int main(void)
+{
+    uint32_t cold, mcu, fast, autoConn;
+
+    Host_Init();
+    MX_GPIO_Init();
+    MX_DMA_Init();
+    MX_USART3_UART_Init();
+    BrokerSim_Reset();
+
+    remove(TEST_IMAGE);
+    if (ConfigStore_Init(FlashSim_Open(TEST_IMAGE, 2048)) != CONFIG_STORE_OK) {
+        return 1;
+    }
+
+    if (Test_Cold(&cold) || Test_McuReset(&mcu) || Test_ModuleReset(&fast) ||
+        Test_AutoConnect(&autoConn) || Test_ApReplaced()) {
+        return 1;
+    }
+
+    /* 保持 < 快速重连 < 自动重连 < CWJAP 扫描 + DHCP */
+    if (!(mcu < fast && fast < autoConn && autoConn < cold)) {
+        fprintf(stderr, "unexpected boot times: cold %lu, mcu reset %lu, fast %lu, auto %lu ms\n",
+                (unsigned long)cold, (unsigned long)mcu, (unsigned long)fast, (unsigned long)autoConn);
+        return 1;
+    }
+
+    printf("boot: OK (to subscribed: cold %lu ms, mcu reset %lu ms, fast %lu ms, auto %lu ms)\n",
+           (unsigned long)cold, (unsigned long)mcu, (unsigned long)fast, (unsigned long)autoConn);
+    EspSim_DeInit();
+    FlashSim_Close();
+    remove(TEST_IMAGE);
+    return 0;
+}
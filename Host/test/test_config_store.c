@@ -0,0 +1,236 @@
+/**
+  ******************************************************************************
+  * @file           : test_config_store.c
+  * @brief          : 配置存储测试 (文件模拟的Flash扇区对)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 扇区取 512 字节, 几十次写入就会压缩。重新打开映像文件并 ConfigStore_Init
+  * 相当于重启。覆盖: 读写与持久化、压缩与两扇区擦除次数均衡、写记录和压缩
+  * 时掉电、最新记录损坏时回退到上一条、MQTT JSON 写入与查询。
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "host_hal.h"
+#include "config_store.h"
+#include "flash_sim.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1; \
+        } \
+    } while (0)
+
+/* 映像文件 (ctest 在构建目录中运行) */
+#define TEST_IMAGE          "config_store_test.bin"
+
+/* 模拟扇区大小 */
+#define TEST_SECTOR_SIZE    512
+
+/* Private variables ---------------------------------------------------------*/
+
+static const ConfigStore_Flash_t *testFlash = NULL;
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  重启: 重新打开映像文件并建立索引
+  */
+static int Reboot(void)
+{
+    testFlash = FlashSim_Open(TEST_IMAGE, TEST_SECTOR_SIZE);
+    return testFlash != NULL && ConfigStore_Init(testFlash) == CONFIG_STORE_OK;
+}
+
+static int Test_Basic(void)
+{
+    uint32_t writes;
+
+    remove(TEST_IMAGE);
+    CHECK(Reboot());
+    CHECK(configStore.seq == 1 && configStore.writeOffset == CONFIG_STORE_HEADER_SIZE);
+    CHECK(strcmp(ConfigStore_GetStr(CONFIG_KEY_WIFI_SSID, "default"), "default") == 0);
+    CHECK(ConfigStore_GetU32(CONFIG_KEY_MQTT_PORT, 1883) == 1883);
+
+    CHECK(ConfigStore_SetStr(CONFIG_KEY_WIFI_SSID, "lab") == CONFIG_STORE_OK);
+    CHECK(ConfigStore_SetU32(CONFIG_KEY_MQTT_PORT, 8883) == CONFIG_STORE_OK);
+    CHECK(ConfigStore_SetFloat(CONFIG_KEY_DEAD_TEMP, 0.25f) == CONFIG_STORE_OK);
+    CHECK(strcmp(ConfigStore_GetStr(CONFIG_KEY_WIFI_SSID, NULL), "lab") == 0);
+
+    /* 类型不符、未结尾的字符串 */
+    CHECK(ConfigStore_SetU32(CONFIG_KEY_WIFI_SSID, 1) == CONFIG_STORE_INVALID_PARAM);
+    CHECK(ConfigStore_Set(CONFIG_KEY_WIFI_SSID, "abc", 3) == CONFIG_STORE_INVALID_PARAM);
+    CHECK(ConfigStore_GetU32(CONFIG_KEY_DEAD_TEMP, 7) == 7);
+
+    /* 值未变时不写 */
+    writes = configStore.writes;
+    CHECK(ConfigStore_SetU32(CONFIG_KEY_MQTT_PORT, 8883) == CONFIG_STORE_OK);
+    CHECK(configStore.writes == writes);
+
+    CHECK(Reboot());
+    CHECK(strcmp(ConfigStore_GetStr(CONFIG_KEY_WIFI_SSID, NULL), "lab") == 0);
+    CHECK(ConfigStore_GetU32(CONFIG_KEY_MQTT_PORT, 0) == 8883);
+    CHECK(ConfigStore_GetFloat(CONFIG_KEY_DEAD_TEMP, 0.0f) == 0.25f);
+    CHECK(configStore.skipped == 0);
+
+    /* 删除后恢复默认值, 重启后仍为删除状态 */
+    CHECK(ConfigStore_Delete(CONFIG_KEY_MQTT_PORT) == CONFIG_STORE_OK);
+    CHECK(ConfigStore_GetU32(CONFIG_KEY_MQTT_PORT, 1883) == 1883);
+    CHECK(Reboot());
+    CHECK(ConfigStore_GetU32(CONFIG_KEY_MQTT_PORT, 1883) == 1883);
+    return 0;
+}
+
+static int Test_Compaction(void)
+{
+    char ssid[16];
+    uint32_t i;
+
+    for (i = 0; i < 300; i++) {
+        snprintf(ssid, sizeof(ssid), "ap-%lu", (unsigned long)i);
+        CHECK(ConfigStore_SetStr(CONFIG_KEY_WIFI_SSID, ssid) == CONFIG_STORE_OK);
+        CHECK(ConfigStore_SetU32(CONFIG_KEY_SAMPLE_DHT11, i) == CONFIG_STORE_OK);
+    }
+    CHECK(configStore.compactions >= 10);
+    CHECK(flashSim.violations == 0);
+
+    /* 两个扇区轮流擦除 */
+    CHECK(flashSim.erases[0] + flashSim.erases[1] == configStore.compactions);
+    CHECK(flashSim.erases[0] <= flashSim.erases[1] + 1 && flashSim.erases[1] <= flashSim.erases[0] + 1);
+
+    CHECK(Reboot());
+    CHECK(strcmp(ConfigStore_GetStr(CONFIG_KEY_WIFI_SSID, NULL), "ap-299") == 0);
+    CHECK(ConfigStore_GetU32(CONFIG_KEY_SAMPLE_DHT11, 0) == 299);
+    CHECK(ConfigStore_GetFloat(CONFIG_KEY_DEAD_TEMP, 0.0f) == 0.25f);
+    return 0;
+}
+
+static int Test_PowerLossRecord(void)
+{
+    /* key/len 和 value 已写入, crc 未写入 */
+    FlashSim_PowerFailAfter(2);
+    CHECK(ConfigStore_SetU32(CONFIG_KEY_SAMPLE_DHT11, 12345) == CONFIG_STORE_ERROR);
+
+    CHECK(Reboot());
+    CHECK(ConfigStore_GetU32(CONFIG_KEY_SAMPLE_DHT11, 0) == 299);
+    CHECK(configStore.skipped == 1);
+
+    /* 跳过的记录之后继续追加 */
+    CHECK(ConfigStore_SetU32(CONFIG_KEY_SAMPLE_DHT11, 300) == CONFIG_STORE_OK);
+    CHECK(Reboot());
+    CHECK(ConfigStore_GetU32(CONFIG_KEY_SAMPLE_DHT11, 0) == 300);
+    CHECK(flashSim.violations == 0);
+    return 0;
+}
+
+static int Test_PowerLossCompaction(void)
+{
+    uint8_t active;
+    uint32_t seq;
+    uint32_t i = 0;
+
+    /* 填到下一次写入需要压缩 */
+    while (configStore.writeOffset + CONFIG_STORE_RECORD_HEAD + 4 <= TEST_SECTOR_SIZE) {
+        CHECK(ConfigStore_SetU32(CONFIG_KEY_SAMPLE_CHIP, 1000 + i++) == CONFIG_STORE_OK);
+    }
+    active = configStore.active;
+    seq = configStore.seq;
+
+    /* 擦除完成, 搬运到一半断电 */
+    FlashSim_PowerFailAfter(3);
+    CHECK(ConfigStore_SetU32(CONFIG_KEY_SAMPLE_CHIP, 1) == CONFIG_STORE_ERROR);
+
+    CHECK(Reboot());
+    CHECK(configStore.active == active && configStore.seq == seq);
+    CHECK(ConfigStore_GetU32(CONFIG_KEY_SAMPLE_CHIP, 0) == 1000 + i - 1);
+    CHECK(strcmp(ConfigStore_GetStr(CONFIG_KEY_WIFI_SSID, NULL), "ap-299") == 0);
+
+    /* 重新压缩成功 */
+    CHECK(ConfigStore_SetU32(CONFIG_KEY_SAMPLE_CHIP, 1) == CONFIG_STORE_OK);
+    CHECK(configStore.active != active && configStore.seq == seq + 1);
+    CHECK(Reboot());
+    CHECK(ConfigStore_GetU32(CONFIG_KEY_SAMPLE_CHIP, 0) == 1);
+    CHECK(ConfigStore_GetU32(CONFIG_KEY_SAMPLE_DHT11, 0) == 300);
+    return 0;
+}
+
+static int Test_Corrupt(void)
+{
+    uint8_t *sector;
+
+    CHECK(ConfigStore_Erase() == CONFIG_STORE_OK);
+    CHECK(ConfigStore_GetStr(CONFIG_KEY_WIFI_SSID, NULL) == NULL);
+    CHECK(ConfigStore_SetStr(CONFIG_KEY_WIFI_SSID, "old") == CONFIG_STORE_OK);
+    CHECK(ConfigStore_SetStr(CONFIG_KEY_WIFI_SSID, "new") == CONFIG_STORE_OK);
+
+    /* 最新记录的值被改坏 (只改内存映像后重新建立索引): 回退到上一条完好的记录 */
+    sector = flashSim.image + (configStore.active ? flashSim.sectorSize : 0);
+    sector[configStore.index[CONFIG_KEY_WIFI_SSID] + CONFIG_STORE_RECORD_HEAD] ^= 0x01;
+    CHECK(ConfigStore_Init(testFlash) == CONFIG_STORE_OK);
+    CHECK(strcmp(ConfigStore_GetStr(CONFIG_KEY_WIFI_SSID, NULL), "old") == 0);
+    CHECK(configStore.skipped == 1);
+    return 0;
+}
+
+static int Test_Json(void)
+{
+    char reply[64];
+    char json[CONFIG_JSON_SIZE];
+
+    CHECK(Reboot());
+    CHECK(ConfigStore_Erase() == CONFIG_STORE_OK);
+
+    CHECK(ConfigStore_ApplyJson("{\"wifi.ssid\":\"lab \\\"2\\\"\", \"wifi.pass\":\"secret\","
+                                "\"mqtt.port\":8883,\"dead.temp\":0.5,\"mqtt.user\":null,\"bogus\":1}",
+                                reply, sizeof(reply)) == 5);
+    CHECK(strcmp(reply, "{\"set\":5,\"err\":\"bogus\"}") == 0);
+    CHECK(strcmp(ConfigStore_GetStr(CONFIG_KEY_WIFI_SSID, NULL), "lab \"2\"") == 0);
+    CHECK(ConfigStore_GetU32(CONFIG_KEY_MQTT_PORT, 0) == 8883);
+    CHECK(ConfigStore_GetFloat(CONFIG_KEY_DEAD_TEMP, 0.0f) == 0.5f);
+
+    /* 类型不符 */
+    CHECK(ConfigStore_ApplyJson("{\"mqtt.port\":\"x\",\"sample.dht11\":1.5}", reply, sizeof(reply)) == 0);
+    CHECK(strcmp(reply, "{\"set\":0,\"err\":\"mqtt.port\"}") == 0);
+    CHECK(ConfigStore_GetU32(CONFIG_KEY_SAMPLE_DHT11, 7) == 7);
+    CHECK(ConfigStore_ApplyJson("wifi.ssid=lab", reply, sizeof(reply)) == -1);
+    CHECK(ConfigStore_ApplyJson("{\"wifi.ssid\":\"unterminated}", reply, sizeof(reply)) == -1);
+
+    /* 后面有格式错误时前面的键也不写入 */
+    CHECK(ConfigStore_ApplyJson("{\"wifi.pass\":\"new\",\"mqtt.host\":\"evil\",\"mqtt.port\":1 2}",
+                                reply, sizeof(reply)) == -1);
+    CHECK(strcmp(ConfigStore_GetStr(CONFIG_KEY_WIFI_PASS, NULL), "secret") == 0);
+    CHECK(ConfigStore_GetStr(CONFIG_KEY_MQTT_HOST, NULL) == NULL);
+
+    CHECK(ConfigStore_FormatJson(json, sizeof(json)) > 0);
+    CHECK(strcmp(json, "{\"wifi.ssid\":\"lab \\\"2\\\"\",\"wifi.pass\":\"***\","
+                       "\"mqtt.port\":8883,\"dead.temp\":0.5}") == 0);
+    CHECK(ConfigStore_FormatJson(json, 16) == 0 && json[0] == '\0');
+    return 0;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+int main(void)
+{
+    Host_Init();
+
+    if (Test_Basic() || Test_Compaction() || Test_PowerLossRecord() ||
+        Test_PowerLossCompaction() || Test_Corrupt() || Test_Json()) {
+        return 1;
+    }
+
+    printf("config store: OK (%lu compactions, erases %lu/%lu)\n",
+           (unsigned long)configStore.compactions, (unsigned long)flashSim.erases[0],
+           (unsigned long)flashSim.erases[1]);
+    FlashSim_Close();
+    remove(TEST_IMAGE);
+    return 0;
+}
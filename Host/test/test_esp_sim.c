@@ -0,0 +1,388 @@
+/**
+  ******************************************************************************
+  * @file           : test_esp_sim.c
+  * @brief          : ESP8266仿真 + 驱动端到端测试 (主机仿真)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 真实的 esp8266.c / esp8266_mqtt.c 对接 esp8266_sim, MQTT侧由 broker_sim
+  * 路由: 入网、连接代理、订阅、上行发布、下行控制消息、+IPD、掉线、复位,
+  * 以及脚本故障 (ERROR / busy / 不应答), MQTT日志出口发布失败后的重试。最后打印上行发布吞吐。
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "host_hal.h"
+#include "usart.h"
+#include "dma.h"
+#include "gpio.h"
+#include "esp8266.h"
+#include "esp8266_mqtt.h"
+#include "log_mqtt.h"
+#include "esp8266_sim.h"
+#include "broker_sim.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1; \
+        } \
+    } while (0)
+
+/* 吞吐测试的发布次数 */
+#define THROUGHPUT_COUNT    100
+
+/* Private variables ---------------------------------------------------------*/
+
+/* 代理侧观察到的上行消息 */
+static uint32_t cloudCount = 0;
+static char cloudTopic[BROKER_SIM_TOPIC_LEN];
+static char cloudPayload[256];
+
+/* 设备侧收到的下行消息 */
+static uint32_t deviceCount = 0;
+static char deviceTopic[MQTT_TOPIC_MAX_LEN];
+static char deviceData[64];
+
+/* +IPD */
+static uint32_t ipdCount = 0;
+static uint16_t ipdLength = 0;
+
+/* Private functions ---------------------------------------------------------*/
+
+static void Cloud_Deliver(const char *topic, const uint8_t *payload, uint16_t len,
+                          uint8_t qos, uint8_t retain, void *ctx)
+{
+    cloudCount++;
+    strncpy(cloudTopic, topic, sizeof(cloudTopic) - 1);
+    if (len >= sizeof(cloudPayload)) {
+        len = sizeof(cloudPayload) - 1;
+    }
+    memcpy(cloudPayload, payload, len);
+    cloudPayload[len] = '\0';
+}
+
+static void Device_OnMessage(MQTT_Message_t *message)
+{
+    deviceCount++;
+    strncpy(deviceTopic, message->topic, sizeof(deviceTopic) - 1);
+    strncpy(deviceData, (const char *)message->data, sizeof(deviceData) - 1);
+}
+
+static void Device_OnIpd(ESP8266_RxData_t *rxData)
+{
+    ipdCount++;
+    ipdLength = rxData->length;
+}
+
+static int Test_Bringup(void)
+{
+    EspSim_Config_t config;
+
+    EspSim_DefaultConfig(&config);
+    strcpy(config.ssid, "lab");
+    strcpy(config.password, "secret");
+    EspSim_Init(&huart3, &config);
+
+    CHECK(ESP8266_Init(&huart3) == ESP8266_OK);
+    CHECK(espSim.echo == 0);
+
+    CHECK(ESP8266_ConnectAP("lab", "wrong") == ESP8266_CONNECT_FAIL);
+    CHECK(ESP8266_ConnectAP("lab", "secret") == ESP8266_OK);
+    CHECK(ESP8266_IsWifiConnected());
+    CHECK(strcmp(esp8266.ipInfo.ip, "192.168.1.100") == 0);
+
+    CHECK(MQTT_Init() == MQTT_OK);
+    MQTT_SetOnMessageReceived(Device_OnMessage);
+    CHECK(MQTT_SetUserConfigSimple("stm32", "user", "pass") == MQTT_OK);
+    CHECK(MQTT_SetBroker("broker.local", 1883, 1) == MQTT_OK);
+    CHECK(MQTT_Connect() == MQTT_OK);
+    CHECK(MQTT_Subscribe("stm32/control", MQTT_QOS_0) == MQTT_OK);
+    CHECK(espSim.mqttState == 6);
+    return 0;
+}
+
+static int Test_PubSub(void)
+{
+    static const uint8_t raw[] = "{\"temp\":25.5}";
+    static const char command[] = "{\"led1\":true}";
+
+    CHECK(BrokerSim_Subscribe("stm32/#", 1, Cloud_Deliver, NULL));
+
+    /* 上行 */
+    CHECK(MQTT_PublishRaw("stm32/data", raw, sizeof(raw) - 1, MQTT_QOS_1, 0) == MQTT_OK);
+    CHECK(cloudCount == 1);
+    CHECK(strcmp(cloudTopic, "stm32/data") == 0);
+    CHECK(strcmp(cloudPayload, (const char *)raw) == 0);
+
+    CHECK(MQTT_Publish("stm32/status", "online", MQTT_QOS_0, 1) == MQTT_OK);
+    CHECK(cloudCount == 2);
+    CHECK(strcmp(cloudPayload, "online") == 0);
+
+    /* 下行: 云端发到控制主题, 半个往返后到达设备 */
+    BrokerSim_Publish("stm32/control", (const uint8_t *)command, sizeof(command) - 1, 0, 0);
+    HAL_Delay(espSim.config.brokerRttUs / 2000 + 5);
+    MQTT_ProcessData();
+    ESP8266_ClearBuffer();
+    CHECK(deviceCount >= 1);
+    CHECK(strcmp(deviceTopic, "stm32/control") == 0);
+    CHECK(strcmp(deviceData, command) == 0);
+    CHECK(espSim.stats.received == 1);
+
+    BrokerSim_Unsubscribe(NULL, Cloud_Deliver, NULL);
+    return 0;
+}
+
+static int Test_Faults(void)
+{
+    ESP8266_CmdStats_t stats;
+
+    CHECK(EspSim_InjectFault("CWMODE", ESP_SIM_FAULT_ERROR, 1));
+    CHECK(ESP8266_SendCommand("AT+CWMODE?\r\n", "OK", 500) == ESP8266_ERROR);
+    CHECK(ESP8266_SendCommand("AT+CWMODE?\r\n", "OK", 500) == ESP8266_OK);
+
+    /* 真实固件回 "busy p...", 计入该动词的 busy 而不是超时 */
+    CHECK(EspSim_InjectFault("*", ESP_SIM_FAULT_BUSY, 1));
+    CHECK(ESP8266_SendCommand("AT\r\n", "OK", 100) == ESP8266_BUSY);
+    CHECK(espSim.stats.busy == 1);
+    CHECK(ESP8266_GetCmdStats("AT", &stats) == ESP8266_OK);
+    CHECK(stats.busy == 1 && stats.timeout == 0);
+
+    CHECK(EspSim_InjectFault("MQTTPUBRAW.data", ESP_SIM_FAULT_SILENT, 1));
+    CHECK(MQTT_PublishRaw("stm32/data", (const uint8_t *)"x", 1, MQTT_QOS_0, 0) == MQTT_PUBLISH_FAIL);
+    CHECK(espSim.stats.silent == 1);
+    CHECK(ESP8266_GetCmdStats("MQTTPUBRAW.data", &stats) == ESP8266_OK);
+
+    /* 设置了处理延时的命令超过超时时间 */
+    CHECK(EspSim_SetLatency("GMR", 300000));
+    CHECK(ESP8266_SendCommand("AT+GMR\r\n", "OK", 200) == ESP8266_TIMEOUT);
+    HAL_Delay(200);
+    CHECK(EspSim_SetLatency("GMR", 2000));
+    CHECK(ESP8266_SendCommand("AT+GMR\r\n", "OK", 200) == ESP8266_OK);
+    return 0;
+}
+
+static void Log_Write(uint8_t level, const char *message)
+{
+    LOG_Record_t record = {0};
+
+    record.type = LOG_RECORD_TEXT;
+    record.level = level;
+    record.tag = "T";
+    record.timestamp = HAL_GetTick();
+    record.message = message;
+    record.messageLen = (uint16_t)strlen(message);
+    logMqtt.sink.write(&record);
+}
+
+static int Test_LogMqtt(void)
+{
+    uint32_t before;
+
+    CHECK(LogMqtt_Init("stm32/log"));
+    CHECK(BrokerSim_Subscribe("stm32/log", 0, Cloud_Deliver, NULL));
+
+    /* ERROR 行触发提前发布; 第6行超出突发被限速 */
+    Log_Write(LOG_LEVEL_ERROR, "boom");
+    Log_Write(LOG_LEVEL_INFO, "n1");
+    Log_Write(LOG_LEVEL_INFO, "n2");
+    Log_Write(LOG_LEVEL_INFO, "n3");
+    Log_Write(LOG_LEVEL_INFO, "n4");
+    Log_Write(LOG_LEVEL_INFO, "n5");
+    CHECK(logMqtt.stats.rateLimited == 1);
+
+    /* 发布失败: 整批与限速计数保留, 重试间隔内不再发布 */
+    before = cloudCount;
+    CHECK(EspSim_InjectFault("MQTTPUBRAW", ESP_SIM_FAULT_ERROR, 1));
+    LogMqtt_Poll();
+    CHECK(logMqtt.stats.publishFailures == 1);
+    CHECK(logMqtt.urgent && logMqtt.batchLen > 0 && logMqtt.buckets[0].dropped == 1);
+    LogMqtt_Poll();
+    CHECK(cloudCount == before);
+
+    HAL_Delay(LOG_MQTT_RETRY_MS);
+    LogMqtt_Poll();
+    CHECK(cloudCount == before + 1);
+    CHECK(strstr(cloudPayload, "boom") != NULL && strstr(cloudPayload, "n4") != NULL);
+    CHECK(strstr(cloudPayload, "-- rate-limited T: 1") != NULL);
+    CHECK(logMqtt.batchLen == 0 && logMqtt.stats.publishes == 1);
+
+    LOG_SetSinkEnable("mqtt", 0);
+    BrokerSim_Unsubscribe("stm32/log", Cloud_Deliver, NULL);
+    return 0;
+}
+
+static int Test_ModemSleep(void)
+{
+    ESP8266_CmdStats_t stats;
+    uint8_t i;
+
+    /* Modem-sleep 只在第一轮结束发一次 AT+SLEEP, 之后的发布不唤醒也不重复进入 */
+    ESP8266_ResetCmdStats();
+    CHECK(ESP8266_SetSleepPolicy(ESP8266_SLEEP_MODEM) == ESP8266_OK);
+    for (i = 0; i < 3; i++) {
+        CHECK(MQTT_Publish("stm32/status", "tick", MQTT_QOS_0, 0) == MQTT_OK);
+        ESP8266_SleepPoll();
+        CHECK(esp8266.asleep);
+        CHECK(ESP8266_SleepTimeToNext() == UINT32_MAX);
+    }
+    CHECK(ESP8266_GetCmdStats("SLEEP", &stats) == ESP8266_OK);
+    CHECK(stats.issued == 1);
+    CHECK(ESP8266_GetCmdStats("WAKE", &stats) != ESP8266_OK);
+
+    /* 回到不休眠时才发 AT+SLEEP=0 */
+    CHECK(ESP8266_SetSleepPolicy(ESP8266_SLEEP_NONE) == ESP8266_OK);
+    CHECK(!esp8266.asleep);
+    CHECK(ESP8266_GetCmdStats("SLEEP", &stats) == ESP8266_OK);
+    CHECK(stats.issued == 2);
+
+    /* 发布应答未到时不休眠, 也不要求主循环空转等待 */
+    CHECK(ESP8266_SetSleepPolicy(ESP8266_SLEEP_MODEM) == ESP8266_OK);
+    mqtt.ackPending = 1;
+    ESP8266_SleepPoll();
+    CHECK(!esp8266.asleep);
+    CHECK(ESP8266_SleepTimeToNext() == UINT32_MAX);
+    mqtt.ackPending = 0;
+    ESP8266_SleepPoll();
+    CHECK(esp8266.asleep);
+
+    CHECK(ESP8266_SetSleepPolicy(ESP8266_SLEEP_NONE) == ESP8266_OK);
+    return 0;
+}
+
+static int Test_StatsOverflow(void)
+{
+    ESP8266_CmdStats_t stats, gmr;
+    uint8_t used = ESP8266_GetCmdStatsCount();
+    uint8_t free = ESP8266_STATS_MAX_VERBS - 1 - used;
+    char cmd[32];
+    uint8_t i;
+
+    CHECK(used < ESP8266_STATS_MAX_VERBS - 1);
+    CHECK(ESP8266_GetCmdStats("GMR", &gmr) == ESP8266_OK);
+
+    /* 具体动词只占前 MAX-1 项, 之后的新动词计入保留的 "other" 项 */
+    for (i = 0; i < free + 1; i++) {
+        snprintf(cmd, sizeof(cmd), "AT+X%02u\r\n", i);
+        ESP8266_SendCommand(cmd, "OK", 100);
+    }
+    CHECK(ESP8266_GetCmdStatsCount() == ESP8266_STATS_MAX_VERBS);
+    CHECK(ESP8266_GetCmdStats("other", &stats) == ESP8266_OK);
+    CHECK(stats.issued == 1 && stats.error == 1);
+    ESP8266_SendCommand("AT+Y\r\n", "OK", 100);
+    CHECK(ESP8266_GetCmdStats("other", &stats) == ESP8266_OK);
+    CHECK(stats.issued == 2);
+    for (i = 0; i < free; i++) {
+        snprintf(cmd, sizeof(cmd), "X%02u", i);
+        CHECK(ESP8266_GetCmdStats(cmd, &stats) == ESP8266_OK);
+        CHECK(stats.issued == 1);
+    }
+
+    /* 已有动词继续计入自己的项 */
+    ESP8266_SendCommand("AT+GMR\r\n", "OK", 200);
+    CHECK(ESP8266_GetCmdStats("GMR", &stats) == ESP8266_OK);
+    CHECK(stats.issued == gmr.issued + 1);
+    return 0;
+}
+
+static int Test_Events(void)
+{
+    static const uint8_t ipd[] = "hello";
+
+    ESP8266_SetOnDataReceived(Device_OnIpd);
+    CHECK(ESP8266_Connect(ESP8266_TCP, "192.168.1.2", 8080, NULL) == ESP8266_OK);
+    EspSim_SendIpd(ipd, sizeof(ipd) - 1);
+    HAL_Delay(5);
+    ESP8266_ProcessData();
+    CHECK(ipdCount == 1 && ipdLength == 5);
+
+    /* 掉线: 同一次IDLE事件里有 WIFI DISCONNECT 和 +MQTTDISCONNECTED */
+    EspSim_WifiDisconnect();
+    HAL_Delay(5);
+    ESP8266_ProcessData();
+    MQTT_ProcessData();
+    CHECK(!ESP8266_IsWifiConnected());
+    CHECK(!MQTT_IsConnected());
+    CHECK(MQTT_Connect() == MQTT_CONNECT_FAIL);
+
+    EspSim_WifiConnect();
+    HAL_Delay(5);
+    ESP8266_ProcessData();
+    CHECK(ESP8266_IsWifiConnected());
+
+    /* 复位 */
+    CHECK(ESP8266_Reset() == ESP8266_OK);
+    CHECK(espSim.wifiConnected == 0 && espSim.echo == 1);
+    CHECK(ESP8266_Test() == ESP8266_OK);
+    return 0;
+}
+
+static int Test_Fragmented(void)
+{
+    Host_UartStats_t before, after;
+    uint32_t bursts = espSim.stats.bursts;
+
+    Host_UartGetStats(&huart3, &before);
+    espSim.config.fragMax = 3;
+    ESP8266_SendCommand("AT+GMR\r\n", "OK", 100);
+    espSim.config.fragMax = 0;
+    HAL_Delay(20);
+
+    /* 每个分段都是一次IDLE事件 */
+    Host_UartGetStats(&huart3, &after);
+    CHECK(espSim.stats.bursts - bursts >= 10);
+    CHECK(after.rxEvents - before.rxEvents == espSim.stats.bursts - bursts);
+    return 0;
+}
+
+static int Test_Throughput(void)
+{
+    static const uint8_t payload[64] = "{\"temp\":25.5,\"humi\":60.0,\"light\":512,\"seq\":0000000000000000}";
+    uint32_t start, elapsed, i, before;
+
+    CHECK(ESP8266_ConnectAP("lab", "secret") == ESP8266_OK);
+    CHECK(MQTT_SetUserConfigSimple("stm32", "user", "pass") == MQTT_OK);
+    CHECK(MQTT_Connect() == MQTT_OK);
+    CHECK(BrokerSim_Subscribe("stm32/data", 0, Cloud_Deliver, NULL));
+
+    before = cloudCount;
+    start = HAL_GetTick();
+    for (i = 0; i < THROUGHPUT_COUNT; i++) {
+        CHECK(MQTT_PublishRaw("stm32/data", payload, sizeof(payload), MQTT_QOS_0, 0) == MQTT_OK);
+    }
+    elapsed = HAL_GetTick() - start;
+    CHECK(cloudCount - before == THROUGHPUT_COUNT);
+
+    printf("esp sim: %u x %u B PUBRAW QoS0 in %lu ms (%.1f msg/s)\n",
+           THROUGHPUT_COUNT, (unsigned)sizeof(payload), (unsigned long)elapsed,
+           elapsed ? THROUGHPUT_COUNT * 1000.0 / elapsed : 0.0);
+    return 0;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+int main(void)
+{
+    Host_Init();
+    MX_GPIO_Init();
+    MX_DMA_Init();
+    MX_USART3_UART_Init();
+    BrokerSim_Reset();
+
+    if (Test_Bringup() || Test_PubSub() || Test_Faults() || Test_LogMqtt() || Test_Events() ||
+        Test_Fragmented() || Test_Throughput() || Test_StatsOverflow() || Test_ModemSleep()) {
+        return 1;
+    }
+
+    printf("esp sim: OK (virtual %lu ms, %lu commands, %lu bytes out)\n",
+           (unsigned long)HAL_GetTick(), (unsigned long)espSim.stats.commands,
+           (unsigned long)espSim.stats.bytesOut);
+    EspSim_DeInit();
+    return 0;
+}
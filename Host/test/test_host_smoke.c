@@ -0,0 +1,203 @@
+/**
+  ******************************************************************************
+  * @file           : test_host_smoke.c
+  * @brief          : 主机构建冒烟测试 (HAL仿真层 + ESP8266驱动)
+  * @version        : V1.0.0
+  ******************************************************************************
+  * @attention
+  *
+  * 串口对端是最简单的应答器: 收到以 "AT" 开头的命令, 2ms 后回 "OK"。
+  * 覆盖虚拟时钟、UART DMA管道、忙等超时、GPIO/ADC桩、__atomic 回退、共享区和栈水位扫描。
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "host_hal.h"
+#include "usart.h"
+#include "dma.h"
+#include "adc.h"
+#include "gpio.h"
+#include "esp8266.h"
+#include "light_sensor.h"
+#include "atomic_ops.h"
+#include "scratch.h"
+#include "stack_mon.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1; \
+        } \
+    } while (0)
+
+/* 应答延时 (ms) */
+#define RESPONDER_DELAY_MS  2
+
+/* Private variables ---------------------------------------------------------*/
+
+static uint8_t responderMute = 0;
+static uint32_t responderDue = 0;
+static uint8_t responderArmed = 0;
+static uint32_t responderCommands = 0;
+
+/* Private functions ---------------------------------------------------------*/
+
+static void Responder_Tx(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t len, void *ctx)
+{
+    if (len >= 2 && memcmp(data, "AT", 2) == 0) {
+        responderCommands++;
+        if (!responderMute) {
+            responderDue = uwTick + RESPONDER_DELAY_MS;
+            responderArmed = 1;
+        }
+    }
+}
+
+static void Responder_Tick(uint32_t tick, void *ctx)
+{
+    static const char reply[] = "\r\nOK\r\n";
+
+    if (responderArmed && (int32_t)(tick - responderDue) >= 0) {
+        responderArmed = 0;
+        Host_UartInject(&huart3, (const uint8_t *)reply, sizeof(reply) - 1);
+    }
+}
+
+static int Test_Clock(void)
+{
+    uint32_t start = HAL_GetTick();
+
+    HAL_Delay(10);
+    CHECK(HAL_GetTick() - start == 11);
+
+    /* 忙等也会推进 */
+    start = HAL_GetTick();
+    while (HAL_GetTick() - start < 5) {
+    }
+    CHECK(HAL_GetTick() - start == 5);
+    return 0;
+}
+
+static int Test_Esp8266(void)
+{
+    Host_UartStats_t stats;
+    uint32_t start;
+
+    Host_UartAttach(&huart3, Responder_Tx, NULL);
+    CHECK(Host_ClockAddHook(Responder_Tick, NULL));
+
+    CHECK(ESP8266_Init(&huart3) == ESP8266_OK);
+    CHECK(Host_UartRxActive(&huart3));
+    CHECK(responderCommands == 4);      /* AT, ATE0, AT+CWMODE? (无 +CWMODE: 应答), AT+CWMODE=1 */
+
+    /* 对端不应答: 超时按虚拟时间结束 */
+    responderMute = 1;
+    start = HAL_GetTick();
+    CHECK(ESP8266_SendCommand("AT\r\n", "OK", 200) == ESP8266_TIMEOUT);
+    CHECK(HAL_GetTick() - start >= 200);
+    CHECK(HAL_GetTick() - start < 300);
+    responderMute = 0;
+
+    Host_UartGetStats(&huart3, &stats);
+    CHECK(stats.rxEvents == 4);
+    CHECK(stats.rxDropped == 0);
+    return 0;
+}
+
+static int Test_GpioAdc(void)
+{
+    HAL_GPIO_WritePin(LED1_GPIO_Port, LED1_Pin, GPIO_PIN_SET);
+    CHECK(HAL_GPIO_ReadPin(LED1_GPIO_Port, LED1_Pin) == GPIO_PIN_SET);
+    HAL_GPIO_TogglePin(LED1_GPIO_Port, LED1_Pin);
+    CHECK(HAL_GPIO_ReadPin(LED1_GPIO_Port, LED1_Pin) == GPIO_PIN_RESET);
+
+    Host_AdcSetValue(&hadc3, 1234);
+    CHECK(LightSensor_Init() == LIGHT_SENSOR_OK);
+    CHECK(LightSensor_Read() == LIGHT_SENSOR_OK);
+    CHECK(LightSensor_GetRawValue() == 1234);
+    return 0;
+}
+
+static int Test_Atomic(void)
+{
+    volatile uint32_t value = 5;
+
+    CHECK(Atomic_Add32(&value, 3) == 8);
+    CHECK(Atomic_Sub32(&value, 10) == 0xFFFFFFFEUL);
+    CHECK(!Atomic_Cas32(&value, 1, 2));
+    CHECK(Atomic_Cas32(&value, 0xFFFFFFFEUL, 2) && value == 2);
+    return 0;
+}
+
+static int Test_Scratch(void)
+{
+    Scratch_Mark_t outer = Scratch_Mark();
+    Scratch_Mark_t inner;
+    uint8_t *a, *b;
+    uint32_t fail = scratch.fail;
+
+    a = Scratch_Alloc(3);
+    CHECK(a != NULL && ((uintptr_t)a % SCRATCH_ALIGN) == 0);
+    inner = Scratch_Mark();
+    b = Scratch_Alloc(100);
+    CHECK(b == a + SCRATCH_ALIGN);
+    Scratch_Release(inner);
+    CHECK(Scratch_Alloc(1) == b);           /* 内层释放后重复使用 */
+
+    CHECK(Scratch_Alloc(SCRATCH_SIZE) == NULL);
+    hostIpsr = 30;                          /* 中断上下文不允许申请 */
+    CHECK(Scratch_Alloc(1) == NULL);
+    hostIpsr = 0;
+    CHECK(scratch.fail == fail + 2);
+
+    Scratch_Release(outer);
+    CHECK(scratch.used == outer);
+    CHECK(scratch.peak >= SCRATCH_ALIGN + 104);
+    return 0;
+}
+
+static int Test_StackMon(void)
+{
+    static uint32_t fakeStack[64];
+    char json[96];
+
+    /* 当前SP不在区间内: 整块填充, 高水位为0 */
+    StackMon_InitRegion(fakeStack, sizeof(fakeStack));
+    CHECK(stackMon.size == sizeof(fakeStack) && stackMon.peak == 0);
+    CHECK(fakeStack[0] == STACK_MON_PATTERN && fakeStack[63] == STACK_MON_PATTERN);
+
+    /* 栈从高地址向下增长: 改写第48个字, 深度为顶部的16个字 */
+    fakeStack[48] = 0;
+    CHECK(StackMon_HighWater() == 16 * sizeof(uint32_t));
+    fakeStack[48] = STACK_MON_PATTERN;      /* 高水位只增不减 */
+    CHECK(StackMon_HighWater() == 16 * sizeof(uint32_t));
+
+    CHECK(StackMon_FormatJson(json, sizeof(json)) > 0);
+    CHECK(strcmp(json, "{\"stack\":{\"size\":256,\"peak\":64,\"free\":192}}") == 0);
+    CHECK(StackMon_FormatJson(json, 10) == 0 && json[0] == '\0');
+    return 0;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+int main(void)
+{
+    Host_Init();
+    MX_GPIO_Init();
+    MX_DMA_Init();
+    MX_USART3_UART_Init();
+    MX_ADC3_Init();
+
+    if (Test_Clock() || Test_Esp8266() || Test_GpioAdc() || Test_Atomic() ||
+        Test_Scratch() || Test_StackMon()) {
+        return 1;
+    }
+
+    printf("host smoke: OK (virtual %lu ms)\n", (unsigned long)HAL_GetTick());
+    return 0;
+}
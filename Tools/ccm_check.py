@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+检查 DMA 缓冲区没有放进 CCM RAM
+
+STM32F407 的 CCM (0x10000000-0x1000FFFF) DMA 访问不到, 缓冲区放错时 DMA 不报错,
+只是读写不到数据。本工具从源码中找出 DMA 缓冲区, 再到链接结果中确认它们的位置:
+
+  1. 源码: HAL_xxx_DMA(handle, buffer, ...) 的 buffer 参数取根标识符
+     (esp8266.dmaRxBuffer -> esp8266, &logRing[i] -> logRing), 以及用 DMA_BUFFER
+     声明的变量。函数参数/局部变量在链接结果中找不到, 忽略
+  2. 链接结果:
+     - Keil .map: 符号表中的地址落在 CCM 范围内即为错误
+     - GNU 目标文件/静态库: objdump -t 中符号所在段为 .ccmram* 即为错误
+
+用法:
+    python3 Tools/ccm_check.py --src Core/Src MDK-ARM/two/two.map
+    python3 Tools/ccm_check.py --src Core/Src build/libcore_host.a   (主机构建的 ctest)
+"""
+
+import argparse
+import glob
+import os
+import re
+import subprocess
+import sys
+
+CCM_START = 0x10000000
+CCM_END = 0x1000FFFF
+
+DMA_CALL_RE = re.compile(r"\bHAL_\w+_DMA\s*\(\s*[^,]+,\s*([^,]+),")
+DMA_DECL_RE = re.compile(r"\b(\w+)\s*(?:\[[^\]]*\]\s*)*DMA_BUFFER\b")
+CAST_RE = re.compile(r"\(\s*(?:const\s+|volatile\s+)*\w+(?:\s+\w+)*\s*\*+\s*\)")
+ROOT_RE = re.compile(r"^[&\s(]*([A-Za-z_]\w*)")
+
+# Keil map 符号表: "    logRing   0x20000123   Data   4096  log.o(.dma_buffer)"
+MAP_SYMBOL_RE = re.compile(r"^\s*(\w+)\s+0x([0-9a-fA-F]+)\s+Data\s+(\d+)\s+(\S+)")
+
+
+def dma_symbols(src_dirs):
+    """源码中的 DMA 缓冲区: {符号: 出处}"""
+    found = {}
+    for src in src_dirs:
+        for path in sorted(glob.glob(os.path.join(src, "*.c"))):
+            if path.endswith("_example.c"):
+                continue
+            with open(path, "r", errors="replace") as f:
+                text = f.read()
+            for lineno, line in enumerate(text.splitlines(), 1):
+                where = "{}:{}".format(os.path.basename(path), lineno)
+                for m in DMA_CALL_RE.finditer(line):
+                    root = ROOT_RE.match(CAST_RE.sub("", m.group(1)))
+                    if root:
+                        found.setdefault(root.group(1), where)
+                for m in DMA_DECL_RE.finditer(line):
+                    if not line.lstrip().startswith("#define"):
+                        found.setdefault(m.group(1), where)
+    return found
+
+
+def locate_map(path):
+    """Keil .map: {符号: (地址, 段)}"""
+    located = {}
+    with open(path, "r", errors="replace") as f:
+        for line in f:
+            m = MAP_SYMBOL_RE.match(line)
+            if m:
+                located.setdefault(m.group(1), (int(m.group(2), 16), m.group(4)))
+    return located
+
+
+def locate_objects(paths, objdump):
+    """GNU 目标文件/静态库: {符号: (None, 段)}"""
+    located = {}
+    try:
+        out = subprocess.run([objdump, "-t"] + paths, check=True,
+                             capture_output=True, text=True).stdout
+    except (OSError, subprocess.CalledProcessError) as exc:
+        sys.exit("ccm_check: {} failed: {}".format(objdump, exc))
+    for line in out.splitlines():
+        # "0000000000000000 l     O .ccmram.bss\t0000000000000e58 timeSeries"
+        if "\t" not in line:
+            continue
+        left, right = line.split("\t", 1)
+        fields = left.split()
+        parts = right.split()
+        if len(fields) < 2 or len(parts) != 2 or "O" not in fields[1:-1]:
+            continue
+        located.setdefault(parts[1], (None, fields[-1]))
+    return located
+
+
+def in_ccm(address, section):
+    if address is not None:
+        return CCM_START <= address <= CCM_END
+    return "ccmram" in section
+
+
+def main():
+    parser = argparse.ArgumentParser(description="检查 DMA 缓冲区没有放进 CCM RAM")
+    parser.add_argument("inputs", nargs="+", help="Keil .map, 或 GNU 目标文件/静态库")
+    parser.add_argument("--src", action="append", required=True, help="源码目录 (可重复)")
+    parser.add_argument("--objdump", default="objdump", help="objdump 程序")
+    args = parser.parse_args()
+
+    buffers = dma_symbols(args.src)
+    if len(args.inputs) == 1 and args.inputs[0].endswith(".map"):
+        located = locate_map(args.inputs[0])
+    else:
+        located = locate_objects(args.inputs, args.objdump)
+
+    errors = 0
+    for name, where in sorted(buffers.items()):
+        if name not in located:
+            continue
+        address, section = located[name]
+        if in_ccm(address, section):
+            print("ERROR: DMA buffer {} ({}) is in CCM ({})".format(name, where, section))
+            errors += 1
+        else:
+            print("ok    {:<20} {:<24} {}".format(name, section, where))
+
+    if errors:
+        return 1
+    print("ccm_check: {} DMA buffers outside CCM".format(
+        sum(1 for n in buffers if n in located)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
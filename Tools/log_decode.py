@@ -0,0 +1,265 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+令牌化日志解码器
+
+把串口上混合的 文本日志 + 令牌化日志帧 还原为文本。格式串从固件ELF中读取:
+帧中的 token 是格式串记录的地址, 记录内容为 "级别字母\\x1f标签\\x1f格式串"。
+
+帧格式见 Core/Inc/log.h:
+    0xFE | len | token(4) | timestamp(4) | nargs | strMask | args(4 x nargs) | 字符串...
+
+用法:
+    python3 Tools/log_decode.py MDK-ARM/two/two.axf capture.bin
+    python3 Tools/log_decode.py MDK-ARM/two/two.axf --port /dev/ttyUSB0 --baud 115200
+    cat capture.bin | python3 Tools/log_decode.py two.axf -
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SYNC = 0xFE
+HEADER_SIZE = 12
+FIELD_SEP = "\x1f"
+
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+
+LEVEL_COLORS = {
+    "E": "\033[31m",
+    "W": "\033[33m",
+    "I": "\033[32m",
+    "D": "\033[36m",
+    "V": "\033[37m",
+}
+COLOR_RESET = "\033[0m"
+
+# printf 转换说明: %[flags][width][.precision][length]conversion
+CONVERSION_RE = re.compile(
+    r"%(?P<flags>[-+ #0]*)(?P<width>\*|\d+)?(?:\.(?P<prec>\*|\d+))?"
+    r"(?P<length>hh|h|ll|l|z|j|t|L)?(?P<conv>[diouxXeEfFgGcsp%])"
+)
+
+
+class Elf:
+    """只读取解码所需的节: .logfmt 以及所有占用目标内存的节"""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF":
+            raise ValueError("%s: not an ELF file" % path)
+
+        is64 = self.data[4] == 2
+        endian = "<" if self.data[5] == 1 else ">"
+        if is64:
+            shoff, = struct.unpack_from(endian + "Q", self.data, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", self.data, 0x3A)
+            sh_fmt = endian + "IIQQQQIIQQ"
+        else:
+            shoff, = struct.unpack_from(endian + "I", self.data, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", self.data, 0x2E)
+            sh_fmt = endian + "IIIIIIIIII"
+
+        headers = []
+        for i in range(shnum):
+            fields = struct.unpack_from(sh_fmt, self.data, shoff + i * shentsize)
+            name, sh_type, flags, addr, offset, size = fields[:6]
+            headers.append((name, sh_type, flags, addr, offset, size))
+
+        strtab_offset = headers[shstrndx][4]
+        self.logfmt = None
+        self.loaded = []
+        for name, sh_type, flags, addr, offset, size in headers:
+            if sh_type == SHT_NOBITS:
+                continue
+            section = (addr, offset, size)
+            if self._cstr(strtab_offset + name) == ".logfmt":
+                self.logfmt = section
+            elif flags & SHF_ALLOC:
+                self.loaded.append(section)
+
+    def _cstr(self, offset):
+        end = self.data.find(b"\0", offset)
+        return self.data[offset:end].decode("latin-1")
+
+    def _lookup(self, address, sections):
+        for addr, offset, size in sections:
+            if addr <= address < addr + size:
+                return self._cstr(offset + address - addr)
+        return None
+
+    def format_record(self, token):
+        """token -> (级别, 标签, 格式串); .logfmt 为 INFO 段时地址独立编址, 优先查找"""
+        sections = ([self.logfmt] if self.logfmt else []) + self.loaded
+        for section in sections:
+            text = self._lookup(token, [section])
+            if text and text.count(FIELD_SEP) >= 2:
+                level, tag, fmt = text.split(FIELD_SEP, 2)
+                return level, tag, fmt
+        return None
+
+    def string_at(self, address):
+        """读取Flash中的字符串参数 (字符串字面量, 常量表)"""
+        return self._lookup(address, self.loaded)
+
+
+def to_signed(word):
+    return word - 0x100000000 if word & 0x80000000 else word
+
+
+def format_message(fmt, words, strings, elf):
+    """按格式串逐个消费参数字, 还原 printf 输出"""
+    out = []
+    pos = 0
+    index = 0
+
+    def next_arg():
+        nonlocal index
+        if index >= len(words):
+            index += 1
+            return None, None
+        word, inline = words[index], strings.get(index)
+        index += 1
+        return word, inline
+
+    for m in CONVERSION_RE.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        conv = m.group("conv")
+        if conv == "%":
+            out.append("%")
+            continue
+
+        flags = m.group("flags")
+        width = m.group("width") or ""
+        prec = m.group("prec")
+        if width == "*":
+            word, _ = next_arg()
+            width = str(to_signed(word)) if word is not None else ""
+        if prec == "*":
+            word, _ = next_arg()
+            prec = str(to_signed(word)) if word is not None else None
+        spec = "%" + flags + width + ("." + prec if prec is not None else "")
+
+        word, inline = next_arg()
+        if word is None:
+            out.append("<missing>")
+            continue
+
+        if conv in "di":
+            out.append((spec + "d") % to_signed(word))
+        elif conv in "ouxX":
+            out.append((spec + conv) % word)
+        elif conv in "eEfFgG":
+            value, = struct.unpack("<f", struct.pack("<I", word))
+            out.append((spec + conv) % value)
+        elif conv == "c":
+            out.append((spec + "c") % chr(word & 0xFF))
+        elif conv == "p":
+            out.append("0x%08x" % word)
+        elif conv == "s":
+            text = inline if inline is not None else elf.string_at(word)
+            if text is None:
+                text = "<0x%08x>" % word
+            out.append((spec + "s") % text)
+
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+class Decoder:
+    """流式解码: 帧外字节原样输出, 帧按 len 字段切分"""
+
+    def __init__(self, elf, color):
+        self.elf = elf
+        self.color = color
+        self.buf = bytearray()
+        self.frames = 0
+        self.unknown = 0
+
+    def feed(self, data, write):
+        self.buf.extend(data)
+        while self.buf:
+            sync = self.buf.find(SYNC)
+            if sync != 0:
+                text = self.buf if sync < 0 else self.buf[:sync]
+                write(bytes(text).decode("utf-8", "replace"))
+                del self.buf[:len(text)]
+                continue
+            if len(self.buf) < 2 or len(self.buf) < 2 + self.buf[1]:
+                return
+            frame = bytes(self.buf[:2 + self.buf[1]])
+            del self.buf[:len(frame)]
+            write(self.decode_frame(frame) + "\r\n")
+
+    def decode_frame(self, frame):
+        if len(frame) < HEADER_SIZE:
+            return "<short frame>"
+        token, timestamp = struct.unpack_from("<II", frame, 2)
+        nargs, mask = frame[10], frame[11]
+        words = list(struct.unpack_from("<%dI" % nargs, frame, HEADER_SIZE))
+
+        strings = {}
+        pos = HEADER_SIZE + 4 * nargs
+        for i in range(nargs):
+            if mask & (1 << i) and pos < len(frame):
+                length = frame[pos]
+                strings[i] = frame[pos + 1:pos + 1 + length].decode("utf-8", "replace")
+                pos += 1 + length
+
+        self.frames += 1
+        record = self.elf.format_record(token)
+        if record is None:
+            self.unknown += 1
+            return "[%d] <unknown token 0x%08x> %s" % (
+                timestamp, token, " ".join("0x%08x" % w for w in words))
+
+        level, tag, fmt = record
+        line = "[%d] [%s][%s] %s" % (timestamp, level, tag,
+                                     format_message(fmt, words, strings, self.elf))
+        if self.color and level in LEVEL_COLORS:
+            line = LEVEL_COLORS[level] + line + COLOR_RESET
+        return line
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode tokenized STM32 log output")
+    parser.add_argument("elf", help="firmware ELF (.axf / .elf) matching the running image")
+    parser.add_argument("input", nargs="?", default="-",
+                        help="captured binary log file, '-' for stdin")
+    parser.add_argument("--port", help="read from a serial port instead (needs pyserial)")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--color", action="store_true", help="colorize decoded lines")
+    args = parser.parse_args()
+
+    decoder = Decoder(Elf(args.elf), args.color)
+    write = sys.stdout.write
+
+    if args.port:
+        import serial
+        with serial.Serial(args.port, args.baud, timeout=0.1) as port:
+            try:
+                while True:
+                    decoder.feed(port.read(256), write)
+                    sys.stdout.flush()
+            except KeyboardInterrupt:
+                pass
+    else:
+        stream = sys.stdin.buffer if args.input == "-" else open(args.input, "rb")
+        with stream:
+            while True:
+                chunk = stream.read(4096)
+                if not chunk:
+                    break
+                decoder.feed(chunk, write)
+
+    if decoder.unknown:
+        sys.stderr.write("%d of %d frames had unknown tokens (ELF does not match image?)\n"
+                         % (decoder.unknown, decoder.frames))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+按模块统计静态RAM占用 (.data + .bss)
+
+输入可以是:
+  - Keil 链接生成的 .map 文件 (读取 "Image component sizes" 表的 RW Data / ZI Data 列)
+  - GNU 工具链的目标文件或静态库 (用 nm -S 读取数据符号, 主机构建自动生成报告)
+
+输出按占用从大到小排列, 每个模块附最大的几个符号, 末尾为合计。
+主机构建是64位的, 指针和对齐与目标板不同, 但大缓冲区占绝大部分, 排序和量级可信;
+最终数字以目标板的 .map 为准。缓冲区大小集中在 Core/Inc/mem_config.h。
+
+用法:
+    python3 Tools/ram_report.py MDK-ARM/two/two.map
+    python3 Tools/ram_report.py build/libcore_host.a --exclude host_hal -o ram_report.txt
+"""
+
+import argparse
+import re
+import subprocess
+import sys
+
+# nm 的数据符号类型: d/D 已初始化, b/B/c/C 未初始化 (小写为文件内静态)
+NM_DATA_TYPES = "dD"
+NM_BSS_TYPES = "bBcC"
+
+# Keil map: "Code (inc. data)   RO Data    RW Data    ZI Data      Debug   Object Name"
+MAP_HEADER_RE = re.compile(r"^\s*Code\s+\(inc\. data\)\s+RO Data\s+RW Data\s+ZI Data\s+Debug\s+(Object|Library Member) Name")
+MAP_ROW_RE = re.compile(r"^\s*(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s+(\S+\.o)\s*$")
+MAP_SYMBOL_RE = re.compile(r"^\s*(\w+)\s+0x[0-9a-fA-F]+\s+Data\s+(\d+)\s+(\S+\.o)\(")
+
+
+class Module:
+    def __init__(self, name):
+        self.name = name
+        self.data = 0
+        self.bss = 0
+        self.symbols = []
+
+    @property
+    def total(self):
+        return self.data + self.bss
+
+
+def module_name(path):
+    name = path.rsplit("/", 1)[-1]
+    for suffix in (".c.o", ".c.obj", ".o", ".obj"):
+        if name.endswith(suffix):
+            return name[: -len(suffix)]
+    return name
+
+
+def parse_map(path):
+    """Keil .map: 模块表 + 本地/全局符号表中的数据符号"""
+    modules = {}
+    in_table = False
+    with open(path, "r", errors="replace") as f:
+        for line in f:
+            if MAP_HEADER_RE.match(line):
+                in_table = True
+                continue
+            sym = MAP_SYMBOL_RE.match(line)
+            if sym:
+                mod = modules.setdefault(module_name(sym.group(3)), Module(module_name(sym.group(3))))
+                mod.symbols.append((sym.group(1), int(sym.group(2))))
+                continue
+            if not in_table:
+                continue
+            row = MAP_ROW_RE.match(line)
+            if row:
+                name = module_name(row.group(7))
+                mod = modules.setdefault(name, Module(name))
+                mod.data += int(row.group(4))
+                mod.bss += int(row.group(5))
+            elif line.strip().startswith("-----"):
+                continue
+            elif line.strip() and not line.strip()[0].isdigit():
+                in_table = False
+    return modules
+
+
+def parse_nm(paths, nm):
+    """GNU 目标文件/静态库: nm -S 输出中带大小的数据符号"""
+    modules = {}
+    try:
+        out = subprocess.run([nm, "-S", "--defined-only"] + paths,
+                             check=True, capture_output=True, text=True).stdout
+    except (OSError, subprocess.CalledProcessError) as exc:
+        sys.exit("ram_report: {} failed: {}".format(nm, exc))
+
+    current = module_name(paths[0]) if len(paths) == 1 else None
+    for line in out.splitlines():
+        line = line.strip()
+        if not line:
+            continue
+        if line.endswith(":"):
+            current = module_name(line[:-1])
+            continue
+        fields = line.split()
+        if len(fields) != 4 or current is None:
+            continue
+        size, kind, name = int(fields[1], 16), fields[2], fields[3]
+        if kind not in NM_DATA_TYPES + NM_BSS_TYPES or size == 0:
+            continue
+        mod = modules.setdefault(current, Module(current))
+        if kind in NM_DATA_TYPES:
+            mod.data += size
+        else:
+            mod.bss += size
+        mod.symbols.append((name, size))
+    return modules
+
+
+def format_report(modules, top):
+    rows = sorted((m for m in modules.values() if m.total > 0), key=lambda m: (-m.total, m.name))
+    lines = ["{:<20} {:>8} {:>8} {:>8}  {}".format("module", "data", "bss", "total", "largest")]
+    total_data = total_bss = 0
+    for mod in rows:
+        largest = sorted(mod.symbols, key=lambda s: -s[1])[:top]
+        lines.append("{:<20} {:>8} {:>8} {:>8}  {}".format(
+            mod.name, mod.data, mod.bss, mod.total,
+            ", ".join("{}={}".format(n, s) for n, s in largest)))
+        total_data += mod.data
+        total_bss += mod.bss
+    lines.append("{:<20} {:>8} {:>8} {:>8}".format("TOTAL", total_data, total_bss, total_data + total_bss))
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="按模块统计静态RAM占用")
+    parser.add_argument("inputs", nargs="+", help="Keil .map, 或 GNU 目标文件/静态库")
+    parser.add_argument("--nm", default="nm", help="nm 程序 (交叉编译时如 arm-none-eabi-nm)")
+    parser.add_argument("--top", type=int, default=3, help="每个模块列出的最大符号数")
+    parser.add_argument("--exclude", action="append", default=[], help="不计入的模块 (如主机仿真层 host_hal)")
+    parser.add_argument("-o", "--output", help="写入文件 (默认 stdout)")
+    args = parser.parse_args()
+
+    if len(args.inputs) == 1 and args.inputs[0].endswith(".map"):
+        modules = parse_map(args.inputs[0])
+    else:
+        modules = parse_nm(args.inputs, args.nm)
+    for name in args.exclude:
+        modules.pop(name, None)
+
+    report = format_report(modules, args.top)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(report)
+    else:
+        sys.stdout.write(report)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,294 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+最坏情况栈深度分析 (GCC -fstack-usage / -fcallgraph-info=su)
+
+GCC 用 -fstack-usage -fcallgraph-info=su 编译时, 每个目标文件旁边生成:
+  - .su: 每个函数的栈帧大小和类型 (static / dynamic / dynamic,bounded)
+  - .ci: 调用图 (VCG格式), 节点带栈帧大小, 函数指针调用记为 __indirect_call
+本工具合并全部 .ci (没有 .ci 时只读 .su, 只能列出栈帧), 对每个入口函数
+(没有调用者的函数, 或 --root 指定) 求最深的调用链, 并列出值得移到静态区
+或共享区 (scratch.h) 的大栈帧。
+
+函数指针调用 (MQTT/ESP8266 回调、日志出口、传感器驱动表) 编译器看不到目标,
+在调用表文件中手工补充, 同时可以给没有 .su 的库函数 (vsnprintf 等) 指定估计值:
+
+    # 调用者 -> 被调用者 ("-" 表示本固件没有设置这个回调)
+    MQTT_ParseSubMessage -> OnMQTTMessageReceived
+    ESP8266_ProcessData -> -
+    # 函数 = 字节
+    vsnprintf = 128
+
+中断与主循环共用主栈: 名字匹配 --isr 的入口作为中断处理, 总深度按
+"主循环最深链 + 每个中断最深链 + 异常压栈帧" 计算 (假设全部可以嵌套, 偏保守)。
+
+主机构建是64位未优化代码, 栈帧比目标板大, 只用于找出最深的链和最大的帧;
+栈大小以目标板 (arm-none-eabi-gcc -Os) 的报告为准。
+
+用法:
+    python3 Tools/stack_report.py build --calls Tools/stack_calls.txt
+    python3 Tools/stack_report.py build --calls Tools/stack_calls.txt --root main \\
+            --isr '_IRQHandler$' --limit 4096 -o stack_report.txt
+"""
+
+import argparse
+import os
+import re
+import sys
+
+INDIRECT = "__indirect_call"
+
+# node: { title: "esp8266.c:ESP8266_ParseIPD" label: "ESP8266_ParseIPD\nesp8266.c:530:13\n48 bytes (static)" }
+CI_NODE_RE = re.compile(r'^node:\s*\{\s*title:\s*"([^"]+)"\s*label:\s*"([^"]*)"')
+CI_EDGE_RE = re.compile(r'^edge:\s*\{\s*sourcename:\s*"([^"]+)"\s*targetname:\s*"([^"]+)"')
+CI_SIZE_RE = re.compile(r"\\n(\d+) bytes \(([^)]*)\)")
+# esp8266.c:530:13:ESP8266_ParseIPD	48	static
+SU_LINE_RE = re.compile(r"^(.*):(\d+):(\d+):(\S+)\t(\d+)\t(\S+)")
+CALL_RE = re.compile(r"^(\S+)\s*->\s*(\S+)$")
+FRAME_RE = re.compile(r"^(\S+)\s*=\s*(\d+)$")
+
+
+class Function:
+    def __init__(self, name):
+        self.name = name
+        self.frame = None           # None: 没有栈帧信息 (库函数等)
+        self.kind = ""
+        self.where = ""
+        self.unit = ""              # 定义所在的编译单元 (.ci/.su 文件名)
+        self.callees = set()
+        self.indirect = False       # 有未补充目标的函数指针调用
+        self.called = False
+
+
+class Graph:
+    def __init__(self):
+        self.funcs = {}
+        self.aliases = {}           # .ci 中 static 函数的标题 "file.c:name" -> name
+
+    def get(self, name):
+        name = self.aliases.get(name, name)
+        if name not in self.funcs:
+            self.funcs[name] = Function(name)
+        return self.funcs[name]
+
+    def add_ci(self, path):
+        edges = []
+        with open(path, "r", errors="replace") as f:
+            for line in f:
+                line = line.strip()
+                m = CI_NODE_RE.match(line)
+                if m:
+                    title, label = m.group(1), m.group(2)
+                    if title == INDIRECT:
+                        continue
+                    name = label.split("\\n", 1)[0] or title
+                    if title != name:
+                        self.aliases[title] = name
+                    size = CI_SIZE_RE.search(label)
+                    if size:
+                        func = self.get(name)
+                        func.frame = int(size.group(1))
+                        func.kind = size.group(2)
+                        func.where = os.path.basename(label.split("\\n")[1]) if label.count("\\n") >= 2 else ""
+                        func.unit = os.path.basename(path)
+                    continue
+                m = CI_EDGE_RE.match(line)
+                if m:
+                    edges.append((m.group(1), m.group(2)))
+        for src, dst in edges:
+            caller = self.get(src)
+            if dst == INDIRECT:
+                caller.indirect = True
+            else:
+                callee = self.get(dst)
+                caller.callees.add(callee.name)
+                callee.called = True
+
+    def add_su(self, path):
+        with open(path, "r", errors="replace") as f:
+            for line in f:
+                m = SU_LINE_RE.match(line.rstrip("\n"))
+                if not m:
+                    continue
+                func = self.get(m.group(4))
+                if func.frame is None:
+                    func.frame = int(m.group(5))
+                    func.kind = m.group(6)
+                    func.where = "{}:{}".format(os.path.basename(m.group(1)), m.group(2))
+                    func.unit = os.path.basename(path)
+
+    def add_calls(self, path):
+        """手工调用表: 补充函数指针调用的目标和库函数的栈帧估计"""
+        resolved = set()
+        with open(path, "r", errors="replace") as f:
+            for lineno, line in enumerate(f, 1):
+                line = line.split("#", 1)[0].strip()
+                if not line:
+                    continue
+                m = CALL_RE.match(line)
+                if m:
+                    caller = self.get(m.group(1))
+                    resolved.add(caller.name)
+                    if m.group(2) != "-":
+                        callee = self.get(m.group(2))
+                        caller.callees.add(callee.name)
+                        callee.called = True
+                    continue
+                m = FRAME_RE.match(line)
+                if m:
+                    func = self.get(m.group(1))
+                    if func.frame is None:
+                        func.frame = int(m.group(2))
+                        func.kind = "assumed"
+                    continue
+                sys.exit("stack_report: {}:{}: bad line: {}".format(path, lineno, line))
+        for name in resolved:
+            self.funcs[name].indirect = False
+
+
+class Analyzer:
+    def __init__(self, graph):
+        self.graph = graph
+        self.memo = {}
+        self.recursive = set()
+
+    def worst(self, name, active=None):
+        """(深度, 调用链) 记忆化深度优先, 递归的环按一次计算并记录"""
+        if name in self.memo:
+            return self.memo[name]
+        active = active if active is not None else set()
+        func = self.graph.funcs[name]
+        active.add(name)
+        best = (0, [])
+        for callee in sorted(func.callees):
+            if callee in active:
+                self.recursive.add(name)
+                continue
+            depth, chain = self.worst(callee, active)
+            if depth > best[0]:
+                best = (depth, chain)
+        active.discard(name)
+        result = ((func.frame or 0) + best[0], [name] + best[1])
+        self.memo[name] = result
+        return result
+
+
+def collect(paths):
+    ci, su = [], []
+    for path in paths:
+        if os.path.isdir(path):
+            for root, _dirs, files in os.walk(path):
+                for name in sorted(files):
+                    if name.endswith(".ci"):
+                        ci.append(os.path.join(root, name))
+                    elif name.endswith(".su"):
+                        su.append(os.path.join(root, name))
+        elif path.endswith(".ci"):
+            ci.append(path)
+        elif path.endswith(".su"):
+            su.append(path)
+    return sorted(ci), sorted(su)
+
+
+def format_chain(graph, chain):
+    parts = []
+    for name in chain:
+        func = graph.funcs[name]
+        parts.append("  {:>6}  {:<36} {}{}".format(
+            "?" if func.frame is None else func.frame, name, func.where,
+            "  (" + func.kind + ")" if func.kind and func.kind != "static" else ""))
+    return parts
+
+
+def main():
+    parser = argparse.ArgumentParser(description="最坏情况栈深度分析 (GCC -fstack-usage)")
+    parser.add_argument("inputs", nargs="+", help="构建目录, 或 .ci/.su 文件")
+    parser.add_argument("--calls", action="append", default=[], help="手工调用表 (可重复)")
+    parser.add_argument("--root", action="append", default=[], help="入口函数 (默认: 所有没有调用者的函数)")
+    parser.add_argument("--isr", help="中断入口的名字 (正则), 如 '_IRQHandler$'")
+    parser.add_argument("--exception-frame", type=int, default=104,
+                        help="每层中断的硬件压栈字节 (Cortex-M4F 扩展帧 104)")
+    parser.add_argument("--exclude", action="append", default=[], help="不参与分析的函数 (正则, 匹配函数名或编译单元, 如主机仿真层 host_hal)")
+    parser.add_argument("--chains", type=int, default=5, help="列出的最深调用链数")
+    parser.add_argument("--frame-min", type=int, default=256, help="列出不小于此值的栈帧")
+    parser.add_argument("--limit", type=int, help="总深度超过此值时返回1")
+    parser.add_argument("-o", "--output", help="写入文件 (默认 stdout)")
+    args = parser.parse_args()
+
+    ci_files, su_files = collect(args.inputs)
+    if not ci_files and not su_files:
+        sys.exit("stack_report: no .ci/.su files (compile with -fstack-usage -fcallgraph-info=su)")
+
+    graph = Graph()
+    for path in ci_files:
+        graph.add_ci(path)
+    for path in su_files:
+        graph.add_su(path)
+    for path in args.calls:
+        graph.add_calls(path)
+    for pattern in args.exclude:
+        regex = re.compile(pattern)
+        for name in [f.name for f in graph.funcs.values() if regex.search(f.name) or regex.search(f.unit)]:
+            del graph.funcs[name]
+        for func in graph.funcs.values():
+            func.callees = set(c for c in func.callees if c in graph.funcs)
+
+    analyzer = Analyzer(graph)
+    isr = re.compile(args.isr) if args.isr else None
+    if args.root:
+        roots = [r for r in args.root if r in graph.funcs]
+    else:
+        roots = [f.name for f in graph.funcs.values() if not f.called and f.callees]
+    results = sorted(((analyzer.worst(r), r) for r in roots), key=lambda x: (-x[0][0], x[1]))
+    if isr is not None:
+        results += sorted(((analyzer.worst(f.name), f.name) for f in graph.funcs.values()
+                           if isr.search(f.name) and f.name not in roots), key=lambda x: (-x[0][0], x[1]))
+
+    main_results = [r for r in results if isr is None or not isr.search(r[1])]
+    isr_results = [r for r in results if isr is not None and isr.search(r[1])]
+    main_depth = main_results[0][0][0] if main_results else 0
+    isr_depth = sum(r[0][0] + args.exception_frame for r in isr_results)
+    total = main_depth + isr_depth
+
+    lines = ["worst-case stack: {} bytes (main {} + interrupts {})".format(total, main_depth, isr_depth), ""]
+    for (depth, chain), root in main_results[:args.chains] + isr_results:
+        lines.append("{} {} bytes, {} frames:".format(root, depth, len(chain)))
+        lines.extend(format_chain(graph, chain))
+        lines.append("")
+
+    worst_chain = set(main_results[0][0][1]) if main_results else set()
+    big = sorted((f for f in graph.funcs.values() if f.frame is not None and f.frame >= args.frame_min),
+                 key=lambda f: (-f.frame, f.name))
+    lines.append("frames >= {} bytes (* on the worst chain):".format(args.frame_min))
+    for func in big:
+        lines.append("  {:>6}  {:<36} {}{}".format(func.frame, func.name, func.where,
+                                                   "  *" if func.name in worst_chain else ""))
+    lines.append("")
+
+    dynamic = sorted(f.name for f in graph.funcs.values() if f.kind.startswith("dynamic"))
+    indirect = sorted(f.name for f in graph.funcs.values() if f.indirect)
+    unknown = sorted(f.name for f in graph.funcs.values() if f.frame is None and f.called)
+    if analyzer.recursive:
+        lines.append("recursive (counted once): " + ", ".join(sorted(analyzer.recursive)))
+    if dynamic:
+        lines.append("dynamic frames (alloca/VLA): " + ", ".join(dynamic))
+    if indirect:
+        lines.append("unresolved indirect calls (add to --calls): " + ", ".join(indirect))
+    if unknown:
+        lines.append("no frame size (library, counted as 0): " + ", ".join(unknown))
+
+    report = "\n".join(lines).rstrip("\n") + "\n"
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(report)
+    else:
+        sys.stdout.write(report)
+
+    if args.limit is not None and total > args.limit:
+        sys.stderr.write("stack_report: worst-case {} bytes exceeds limit {}\n".format(total, args.limit))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())